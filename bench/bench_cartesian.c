@@ -0,0 +1,164 @@
+/**
+ * @file bench_cartesian.c
+ * @brief Benchmark of cartesian path streaming (accuracy of incremental inverse kinematics, setpoint latency with and without prefetch)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../common/crane_x7_comm.h"
+#include "../common/cartesian_path.h"
+#include "bench_util.h"
+
+#define CONTROL_FREQUENCY (200.0)
+#define DEFAULT_PREFETCH (16)
+#define PATH_SPEED (0.2) // peak speed of the end effector [m/s]
+
+/**
+ * @fn static void makePath(CARTESIAN_PATH *, const KINEMATICS_CACHE *)
+ * @brief Line, half circle, line and line back to the start in the horizontal plane, keeping the orientation of the hand
+ */
+static void makePath(CARTESIAN_PATH *path, const KINEMATICS_CACHE *cache)
+{
+    VECTOR_3D start, point, center, up = {0, 0, 1};
+    MATRIX_3D rotation;
+
+    getEndEffectorPose(cache, &start, &rotation);
+    initCartesianPath(path, &start, &rotation);
+    point = start;
+    point.y += 0.08;
+    addCartesianLine(path, &point, PATH_SPEED);
+    center = point;
+    center.x -= 0.05;
+    addCartesianArc(path, &center, &up, PI, PATH_SPEED);
+    point = path->position;
+    point.y -= 0.08;
+    addCartesianLine(path, &point, PATH_SPEED);
+    addCartesianLine(path, &start, PATH_SPEED);
+}
+
+/**
+ * @fn static double checkAccuracy(const CARTESIAN_PATH *, const double *, int *)
+ * @brief Solve every sample of the path and compare the forward kinematics of the solution with the path
+ * @return maximum position error [m]
+ */
+static double checkAccuracy(const CARTESIAN_PATH *path, const double *initial_theta, int *samples)
+{
+    CARTESIAN_STREAM stream;
+    KINEMATICS_CACHE cache;
+    double theta[JOINT_NUM], error = 0;
+
+    initKinematicsCache(&cache);
+    startCartesianStream(&stream, path, initial_theta, 1.0 / CONTROL_FREQUENCY, 0);
+    for (*samples = 0; getCartesianSetpoint(&stream, theta) == CARTESIAN_SETPOINT_OK; (*samples)++)
+    {
+        VECTOR_3D target, position;
+
+        evaluateCartesianPath(path, *samples / CONTROL_FREQUENCY, &target);
+        forwardKinematics7Dof(&cache, theta);
+        getEndEffectorPose(&cache, &position, NULL);
+        error = fmax(error, sqrt(pow(position.x - target.x, 2) + pow(position.y - target.y, 2) + pow(position.z - target.z, 2)));
+    }
+    stopCartesianStream(&stream);
+    return error;
+}
+
+/**
+ * @fn static void measureLatency(const CARTESIAN_PATH *, const double *, int, BENCH_RESULT *)
+ * @brief Time to take the setpoint of each control period (the period is emulated by sleep)
+ */
+static void measureLatency(const CARTESIAN_PATH *path, const double *initial_theta, int prefetch, BENCH_RESULT *result)
+{
+    static double latency[CARTESIAN_PATH_MAX_SEGMENTS * 1000];
+    struct timespec period = {0, (long)(1e9 / CONTROL_FREQUENCY)};
+    CARTESIAN_STREAM stream;
+    double theta[JOINT_NUM];
+    int n = 0, status = CARTESIAN_SETPOINT_OK;
+
+    startCartesianStream(&stream, path, initial_theta, 1.0 / CONTROL_FREQUENCY, prefetch);
+    while ((status != CARTESIAN_SETPOINT_FINISHED) && (n < (int)(sizeof(latency) / sizeof(latency[0]))))
+    {
+        uint64_t start = getBenchTimeNs();
+        status = getCartesianSetpoint(&stream, theta);
+        latency[n++] = (double)(getBenchTimeNs() - start);
+        nanosleep(&period, NULL);
+    }
+    stopCartesianStream(&stream);
+    summarizeBenchSamples(latency, n, result);
+}
+
+int main(int argc, char **argv)
+{
+    double start_theta[JOINT_NUM] = {0, 0.5, 0, -1.8, 0, -0.8, 0, 0};
+    double waypoint[2][JOINT_NUM] = {{0}};
+    uint8_t operating_mode[JOINT_NUM];
+    double zero[JOINT_NUM] = {0};
+    int prefetch = DEFAULT_PREFETCH, samples;
+    double error;
+    BENCH_RESULT inline_latency, prefetch_latency;
+    KINEMATICS_CACHE cache;
+    CARTESIAN_PATH path;
+    TRAJECTORY approach;
+    TRAJECTORY_LIMIT limit;
+    CONTROL_LOOP_CONFIG loop_config;
+    CONTROL_LOOP_STATS loop_stats;
+
+    if (argc > 1)
+    {
+        prefetch = atoi(argv[1]);
+        if ((prefetch <= 0) || (prefetch > CARTESIAN_PATH_MAX_PREFETCH))
+        {
+            fprintf(stderr, "usage: %s [prefetch (1 - %d)]\n", argv[0], CARTESIAN_PATH_MAX_PREFETCH);
+            return 1;
+        }
+    }
+    initKinematicsCache(&cache);
+    forwardKinematics7Dof(&cache, start_theta);
+    makePath(&path, &cache);
+    printf("cartesian path : %d segments, %.3f [s]\n", path.segment_num, path.duration);
+    error = checkAccuracy(&path, start_theta, &samples);
+    printf("  max position error of IK solutions %.3e [m] (%d samples at %.0f Hz)\n", error, samples, CONTROL_FREQUENCY);
+    measureLatency(&path, start_theta, 0, &inline_latency);
+    measureLatency(&path, start_theta, prefetch, &prefetch_latency);
+    printf("time to take a setpoint per control period [ns]\n");
+    printBenchResult("IK in the control loop", &inline_latency);
+    printBenchResult("prefetch thread", &prefetch_latency);
+
+    // streaming to the simulator
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        operating_mode[i] = POSITION_CONTROL_MODE;
+        waypoint[1][i] = start_theta[i];
+    }
+    if (initilizeCranex7(operating_mode))
+    {
+        return 1;
+    }
+    setCranex7TorqueEnable(TORQUE_ENABLE);
+    setCranex7ProfileVelocity(zero);
+    getDefaultControlLoopConfig(&loop_config, CONTROL_FREQUENCY);
+    getDefaultTrajectoryLimit(&limit);
+    planTrajectory(&approach, waypoint, 2, &limit);
+    runTrajectory(&approach, &loop_config, setCranex7Angle, NULL);
+    runCartesianPath(&path, start_theta, prefetch, &loop_config, setCranex7Angle, &loop_stats);
+    printControlLoopStats(&loop_stats);
+    closeCranex7Port();
+    return 0;
+}
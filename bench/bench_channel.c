@@ -0,0 +1,243 @@
+/**
+ * @file bench_channel.c
+ * @brief Benchmark of the bus thread with lock-free channels (cost of the channel, servo cycle timing with a slow planner
+ *        and with several arms on the simulator)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../common/bus_channel.h"
+#include "bench_util.h"
+
+#define CONTROL_FREQUENCY (500.0)
+#define RUN_TIME (4.0)         // duration of each run [s]
+#define STALL_INTERVAL (50)    // number of planner cycles between slow computations
+#define STALL_TIME (15e-3)     // duration of a slow computation of the planner (e.g. IK batch, blocking printf) [s]
+#define CHANNEL_CALLS (100000)
+#define MULTI_ARM_NUM (3)      // number of arms driven by one process, each with its own bus thread
+
+/**
+ * @fn static void spin(double)
+ * @brief Busy computation of the planner for the given time [s]
+ */
+static void spin(double seconds)
+{
+    uint64_t end = getBenchTimeNs() + (uint64_t)(seconds * 1e9);
+
+    while (getBenchTimeNs() < end)
+    {
+    }
+}
+
+/**
+ * @fn static void planSetpoint(double, double *)
+ * @brief Setpoint of the planner: joint 1 swings around the initial posture
+ */
+static void planSetpoint(double time, double *command)
+{
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        command[i] = 0;
+    }
+    command[0] = 0.3 * sin(2 * PI * 0.5 * time);
+    command[1] = 0.5;
+    command[3] = -1.0;
+}
+
+/**
+ * @fn static int inlineCycle(uint64_t, double, void *)
+ * @brief Control loop callback of the single thread version: the planner runs in the servo cycle
+ */
+static int inlineCycle(uint64_t cycle, double time, void *user_data)
+{
+    double command[JOINT_NUM], angle[JOINT_NUM], angvel[JOINT_NUM], torque[JOINT_NUM];
+
+    planSetpoint(time, command);
+    cycleCranex7(command, angle, angvel, torque);
+    if (cycle % STALL_INTERVAL == STALL_INTERVAL - 1)
+        spin(STALL_TIME);
+    return (time >= RUN_TIME);
+}
+
+/**
+ * @fn static void runPlanner(BUS_CHANNEL *, uint64_t *)
+ * @brief Planner thread of the channel version: the same setpoints and slow computations at the control rate
+ * @param[out] *stale number of planner cycles whose state snapshot was not updated
+ */
+static void runPlanner(BUS_CHANNEL *channel, uint64_t *stale)
+{
+    struct timespec period = {0, (long)(1e9 / CONTROL_FREQUENCY)};
+    double command[JOINT_NUM];
+    uint64_t start = getBenchTimeNs();
+    BUS_STATE state;
+
+    *stale = 0;
+    for (int n = 1;; n++)
+    {
+        double time = (double)(getBenchTimeNs() - start) * 1e-9;
+
+        if (time >= RUN_TIME)
+            break;
+        *stale += readBusState(channel, &state);
+        planSetpoint(time, command);
+        publishBusCommand(channel, command);
+        if (n % STALL_INTERVAL == 0)
+            spin(STALL_TIME);
+        nanosleep(&period, NULL);
+    }
+}
+
+/**
+ * @fn static int runMultiArm(CONTROL_LOOP_CONFIG *, uint8_t *)
+ * @brief Drive MULTI_ARM_NUM arms in parallel: one bus thread per arm and one planner which commands all of them
+ * @return 0: success, 1: failure
+ */
+static int runMultiArm(CONTROL_LOOP_CONFIG *loop_config, uint8_t *operating_mode)
+{
+    static BUS_CHANNEL channel[MULTI_ARM_NUM];
+    static const char *serial_port[MULTI_ARM_NUM] = {"/dev/ttyUSB0", "/dev/ttyUSB1", "/dev/ttyUSB2"};
+    struct timespec period = {0, (long)(1e9 / CONTROL_FREQUENCY)};
+    CRANE_X7_ARM *arm[MULTI_ARM_NUM] = {NULL};
+    CONTROL_LOOP_STATS stats[MULTI_ARM_NUM];
+    BUS_STATE state[MULTI_ARM_NUM];
+    double command[JOINT_NUM];
+    uint64_t start;
+    int started = 0, result = 0;
+
+    // all arms are opened before their bus threads start
+    for (int a = 0; a < MULTI_ARM_NUM && !result; a++)
+    {
+        CRANE_X7_ARM_CONFIG config;
+
+        getDefaultCranex7ArmConfig(&config);
+        config.serial_port = serial_port[a];
+        result = openCranex7Arm(&arm[a], &config, operating_mode);
+    }
+    for (int a = 0; a < MULTI_ARM_NUM && !result; a++)
+    {
+        setCranex7ArmTorqueEnable(arm[a], TORQUE_ENABLE);
+        result = startBusChannelArm(&channel[a], arm[a], loop_config);
+        started += !result;
+    }
+    start = getBenchTimeNs();
+    while (!result && (double)(getBenchTimeNs() - start) * 1e-9 < RUN_TIME)
+    {
+        planSetpoint((double)(getBenchTimeNs() - start) * 1e-9, command);
+        for (int a = 0; a < MULTI_ARM_NUM; a++)
+        {
+            readBusState(&channel[a], &state[a]);
+            publishBusCommand(&channel[a], command);
+        }
+        nanosleep(&period, NULL);
+    }
+    for (int a = 0; a < started; a++)
+    {
+        stopBusChannel(&channel[a], &stats[a]);
+        readBusState(&channel[a], &state[a]);
+    }
+    if (!result)
+    {
+        printf("servo cycle of %d arms (one bus thread per arm)\n", MULTI_ARM_NUM);
+        for (int a = 0; a < MULTI_ARM_NUM; a++)
+        {
+            printf("arm %d (%s) : bus cycles %" PRIu64 ", communication failures %" PRIu64 "\n",
+                   a + 1, serial_port[a], state[a].cycle + 1, state[a].comm_failures);
+            printControlLoopStats(&stats[a]);
+        }
+    }
+    for (int a = 0; a < MULTI_ARM_NUM; a++)
+    {
+        if (arm[a] != NULL)
+            closeCranex7Arm(arm[a]);
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    static double latency[CHANNEL_CALLS];
+    uint8_t operating_mode[JOINT_NUM];
+    double command[JOINT_NUM];
+    CONTROL_LOOP_CONFIG loop_config;
+    CONTROL_LOOP_STATS inline_stats, channel_stats;
+    BENCH_RESULT channel_result;
+    BUS_CHANNEL channel;
+    BUS_STATE state, latest;
+    uint64_t stale;
+
+    getDefaultControlLoopConfig(&loop_config, CONTROL_FREQUENCY);
+    if (argc > 1)
+    {
+        // SCHED_FIFO priority of the servo cycle (needs the privilege)
+        loop_config.priority = atoi(argv[1]);
+    }
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        operating_mode[i] = POSITION_CONTROL_MODE;
+    }
+    if (initilizeCranex7(operating_mode))
+    {
+        return 1;
+    }
+    setCranex7TorqueEnable(TORQUE_ENABLE);
+
+    // bus thread: the planner publishes the command and reads the state through the channel
+    if (startBusChannel(&channel, &loop_config))
+    {
+        closeCranex7Port();
+        return 1;
+    }
+    runPlanner(&channel, &stale);
+    readBusState(&channel, &state);
+    for (int n = 0; n < CHANNEL_CALLS; n++)
+    {
+        uint64_t start = getBenchTimeNs();
+
+        readBusState(&channel, &latest);
+        planSetpoint(latest.time, command);
+        publishBusCommand(&channel, command);
+        latency[n] = (double)(getBenchTimeNs() - start);
+    }
+    stopBusChannel(&channel, &channel_stats);
+    summarizeBenchSamples(latency, CHANNEL_CALLS, &channel_result);
+
+    // single thread: the slow computation delays the servo cycle
+    // (after the bus thread, because runControlLoop leaves the calling thread in SCHED_FIFO when the priority is given)
+    if (runControlLoop(&loop_config, inlineCycle, NULL, &inline_stats))
+    {
+        closeCranex7Port();
+        return 1;
+    }
+
+    printf("planner stalls %.1f [ms] every %d cycles at %.0f [Hz]\n", STALL_TIME * 1e3, STALL_INTERVAL, CONTROL_FREQUENCY);
+    printf("servo cycle of the bus thread\n");
+    printControlLoopStats(&channel_stats);
+    printf("  bus cycles %" PRIu64 ", commands sent %" PRIu64 ", communication failures %" PRIu64 ", planner cycles without new state %" PRIu64 "\n",
+           state.cycle + 1, state.sequence + 1, state.comm_failures,
+           stale);
+    printf("servo cycle with the planner in the same thread\n");
+    printControlLoopStats(&inline_stats);
+    printf("time of readBusState + publishBusCommand [ns]\n");
+    printBenchResult("channel", &channel_result);
+    closeCranex7Port();
+    return runMultiArm(&loop_config, operating_mode);
+}
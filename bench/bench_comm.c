@@ -0,0 +1,171 @@
+/**
+ * @file bench_comm.c
+ * @brief Benchmark of the bus cycle of CRANE-X7 (getCranex7JointState, cycleCranex7)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef DXL_NATIVE
+#include "../common/dxl_native.h"
+#else
+#include "dynamixel_sdk.h"
+#endif
+#include "../common/crane_x7_comm.h"
+#include "bench_util.h"
+
+#define DEFAULT_CYCLES (1000)
+#define WARMUP_CYCLES (50)
+#define BRAKE_CALLS (100)
+
+static const uint8_t bench_id_array[JOINT_NUM] = {2, 3, 4, 5, 6, 7, 8, 9};
+
+/**
+ * @fn static void benchGroupSetup(int, double *)
+ * @brief Measure the cost of creating a bulk read group and registering all joints.
+ *        This was paid on every getCranex7JointState call before the group was made persistent.
+ * @param[in] cycles number of measurements
+ * @param[out] samples[] measured time [ns]
+ */
+static void benchGroupSetup(int cycles, double *samples)
+{
+  int port = portHandler(SERIAL_PORT); // the port is not opened, the group only needs a handle
+
+  for (int n = 0; n < cycles; n++)
+  {
+    uint64_t start = getBenchTimeNs();
+    int group = groupBulkRead(port, PROTOCOL_VERSION);
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+      groupBulkReadAddParam(group, bench_id_array[i], PRESENT_VALUE_ADDRESS, PRESENT_VALUE_DATA_LENGTH);
+    }
+    samples[n] = (double)(getBenchTimeNs() - start);
+    groupBulkReadClearParam(group);
+#ifdef DXL_NATIVE
+    // the groups of dxl_native.c come from a static pool which is released by closePort
+    closePort(port);
+    port = portHandler(SERIAL_PORT);
+#endif
+  }
+#ifdef DXL_NATIVE
+  closePort(port);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+  uint8_t operating_mode[JOINT_NUM] = {POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE};
+  double present_theta[JOINT_NUM] = {0};
+  double present_angvel[JOINT_NUM] = {0};
+  double present_torque[JOINT_NUM] = {0};
+  int cycles = DEFAULT_CYCLES;
+  int failures = 0;
+  double *samples;
+  BENCH_RESULT setup_result = {0};
+  BENCH_RESULT cycle_result = {0};
+
+  if (argc > 1)
+  {
+    cycles = atoi(argv[1]);
+    if (cycles <= 0)
+    {
+      fprintf(stderr, "usage: %s [cycles]\n", argv[0]);
+      return 1;
+    }
+  }
+  samples = (double *)malloc(sizeof(double) * ((cycles > BRAKE_CALLS) ? cycles : BRAKE_CALLS));
+  if (samples == NULL)
+  {
+    return 1;
+  }
+
+  // per-cycle setup cost that was removed from getCranex7JointState (hardware is not needed)
+  benchGroupSetup(cycles, samples);
+  summarizeBenchSamples(samples, cycles, &setup_result);
+  printBenchResult("bulk read group setup", &setup_result);
+
+  // bus cycle with the persistent bulk read group (needs CRANE-X7)
+  if (initilizeCranex7(operating_mode))
+  {
+    printf("CRANE-X7 is not connected. Skip the bus cycle benchmark.\n");
+    free(samples);
+    return 0;
+  }
+  for (int n = 0; n < WARMUP_CYCLES; n++)
+  {
+    getCranex7JointState(present_theta, present_angvel, present_torque);
+  }
+  for (int n = 0; n < cycles; n++)
+  {
+    uint64_t start = getBenchTimeNs();
+    failures += getCranex7JointState(present_theta, present_angvel, present_torque);
+    samples[n] = (double)(getBenchTimeNs() - start);
+  }
+  summarizeBenchSamples(samples, cycles, &cycle_result);
+  printBenchResult("getCranex7JointState (after)", &cycle_result);
+  printf("%-32s failed=%d/%d\n", "", failures, cycles);
+  printf("%-32s median=%10.0f [ns] (persistent cycle + removed setup)\n", "getCranex7JointState (before)", cycle_result.median + setup_result.median);
+
+  // separate bulk write and bulk read vs. combined cycle (torque stays disabled, the present angle is commanded)
+  failures = 0;
+  for (int n = 0; n < cycles; n++)
+  {
+    uint64_t start = getBenchTimeNs();
+    failures += setCranex7Angle(present_theta);
+    failures += getCranex7JointState(present_theta, present_angvel, present_torque);
+    samples[n] = (double)(getBenchTimeNs() - start);
+  }
+  summarizeBenchSamples(samples, cycles, &cycle_result);
+  printBenchResult("setCranex7Angle + getJointState", &cycle_result);
+  printf("%-32s failed=%d/%d\n", "", failures, cycles);
+  failures = 0;
+  for (int n = 0; n < cycles; n++)
+  {
+    uint64_t start = getBenchTimeNs();
+    failures += cycleCranex7(present_theta, present_theta, present_angvel, present_torque);
+    samples[n] = (double)(getBenchTimeNs() - start);
+  }
+  summarizeBenchSamples(samples, cycles, &cycle_result);
+  printBenchResult("cycleCranex7", &cycle_result);
+  printf("%-32s failed=%d/%d\n", "", failures, cycles);
+
+  // emergency brake: time until the packets are sent (including EMERGENCY_BRAKE_REPEAT - 1 intervals)
+  failures = 0;
+  for (int n = 0; n < BRAKE_CALLS; n++)
+  {
+    uint64_t start = getBenchTimeNs();
+    failures += emergencyBrakeCranex7();
+    samples[n] = (double)(getBenchTimeNs() - start);
+  }
+  summarizeBenchSamples(samples, BRAKE_CALLS, &cycle_result);
+  printBenchResult("emergencyBrakeCranex7", &cycle_result);
+  printf("%-32s failed=%d/%d\n", "", failures, BRAKE_CALLS);
+  failures = 0;
+  for (int n = 0; n < BRAKE_CALLS; n++)
+  {
+    uint64_t start = getBenchTimeNs();
+    brakeCranex7Joint();
+    samples[n] = (double)(getBenchTimeNs() - start);
+  }
+  summarizeBenchSamples(samples, BRAKE_CALLS, &cycle_result);
+  printBenchResult("brakeCranex7Joint", &cycle_result);
+
+  closeCranex7Port();
+  free(samples);
+  return 0;
+}
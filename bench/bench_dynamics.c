@@ -0,0 +1,281 @@
+/**
+ * @file bench_dynamics.c
+ * @brief Benchmark of the rigid body dynamics of 7DOF arm
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../common/dynamics.h"
+#include "bench_util.h"
+
+#define DEFAULT_CALLS (200000)
+#define CHECKS (1000)
+#define ENERGY_STEP (1e-6)
+#define ROLLOUTS (256)
+#define ROLLOUT_DURATION (0.5)
+#define ROLLOUT_DT (0.0005)
+
+static unsigned int random_seed = 1; // seed of rand_r (the same samples every run)
+
+/**
+ * @fn static double randomRange(double, double)
+ * @brief Uniform random number in [min, max]
+ */
+static double randomRange(double min, double max)
+{
+    return min + (max - min) * rand_r(&random_seed) / RAND_MAX;
+}
+
+/**
+ * @fn static void randomState(double *, double *, double *)
+ * @brief Random joint angles (inside the movable range), velocities and accelerations
+ */
+static void randomState(double *theta, double *angvel, double *angacc)
+{
+    const double range[KINEMATICS_DOF] = {1.5, 1.4, 1.0, 2.2, 1.0, 1.2, 1.5};
+
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        theta[i] = angvel[i] = angacc[i] = 0;
+    }
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        theta[i] = randomRange(-range[i], range[i]);
+        angvel[i] = randomRange(-2.0, 2.0);
+        angacc[i] = randomRange(-5.0, 5.0);
+    }
+    theta[1] = fabs(theta[1]);
+    theta[3] = -fabs(theta[3]);
+}
+
+/**
+ * @fn static double potentialEnergy(KINEMATICS_CACHE *, const double *)
+ * @brief Potential energy of the links [J] (for verification of gravity torque)
+ */
+static double potentialEnergy(KINEMATICS_CACHE *cache, const double *theta)
+{
+    LINK_PARAM link[LINK_NUM_7DOF];
+    double energy = 0;
+
+    getLinkParam7Dof(link);
+    forwardKinematics7Dof(cache, theta);
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        const MATRIX_4D *T = &cache->frame[i];
+        double z = T->a[2][0] * link[i].com.x + T->a[2][1] * link[i].com.y + T->a[2][2] * link[i].com.z + T->a[2][3];
+        energy += link[i].mass * GRAVITY_ACCELERATION * z;
+    }
+    return energy;
+}
+
+/**
+ * @fn static void holdPolicy(const DYNAMICS_ROLLOUT *, int, double, double *, void *)
+ * @brief PD control around the initial posture with gravity compensation (policy for the rollout benchmark)
+ */
+static void holdPolicy(const DYNAMICS_ROLLOUT *rollout, int index, double time, double *torque, void *user_data)
+{
+    DYNAMICS_ROLLOUT *initial = (DYNAMICS_ROLLOUT *)user_data;
+    KINEMATICS_CACHE cache;
+
+    initKinematicsCache(&cache);
+    calcGravityTorque7Dof(&cache, rollout->theta, torque);
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        torque[i] += 20.0 * (initial[index].theta[i] - rollout->theta[i]) - 1.0 * rollout->angvel[i];
+    }
+}
+
+/**
+ * @fn static double benchRollouts(THREAD_POOL *, DYNAMICS_ROLLOUT *, DYNAMICS_ROLLOUT *)
+ * @brief Run rollouts from the initial states and measure the time
+ * @return rollouts per second
+ */
+static double benchRollouts(THREAD_POOL *pool, DYNAMICS_ROLLOUT *initial, DYNAMICS_ROLLOUT *rollouts)
+{
+    uint64_t start;
+
+    for (int n = 0; n < ROLLOUTS; n++)
+    {
+        rollouts[n] = initial[n];
+    }
+    start = getBenchTimeNs();
+    runDynamicsRollouts(pool, rollouts, ROLLOUTS, ROLLOUT_DURATION, ROLLOUT_DT, holdPolicy, initial);
+    return ROLLOUTS / ((double)(getBenchTimeNs() - start) * 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+    KINEMATICS_CACHE cache;
+    double theta[JOINT_NUM], angvel[JOINT_NUM], angacc[JOINT_NUM], torque[JOINT_NUM], gravity[JOINT_NUM];
+    double checksum = 0, rnea_time, gravity_time, aba_time, gravity_error = 0, energy_error = 0, aba_error = 0;
+    double single_rate, pool_rate, drift = 0;
+    double mass_time, joint_space_time, cycle_time, mass_error = 0, coriolis_error = 0;
+    double jacobian[KINEMATICS_TASK_DIM][KINEMATICS_DOF];
+    JOINT_SPACE_DYNAMICS dynamics;
+    static DYNAMICS_ROLLOUT initial[ROLLOUTS], rollouts[ROLLOUTS];
+    THREAD_POOL single, pool;
+    int calls = DEFAULT_CALLS;
+    uint64_t start;
+
+    if (argc > 1)
+    {
+        calls = atoi(argv[1]);
+        if (calls <= 0)
+        {
+            fprintf(stderr, "usage: %s [calls]\n", argv[0]);
+            return 1;
+        }
+    }
+    initKinematicsCache(&cache);
+    initDynamics();
+    random_seed = 1;
+
+    // recursive Newton-Euler (joint 1 changes every call, so the whole chain is recomputed)
+    randomState(theta, angvel, angacc);
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        theta[0] = n * 1e-6;
+        inverseDynamics7Dof(&cache, theta, angvel, angacc, torque);
+        checksum += torque[1];
+    }
+    rnea_time = (double)(getBenchTimeNs() - start) / calls;
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        theta[0] = n * 1e-6;
+        calcGravityTorque7Dof(&cache, theta, torque);
+        checksum += torque[1];
+    }
+    gravity_time = (double)(getBenchTimeNs() - start) / calls;
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        theta[0] = n * 1e-6;
+        forwardDynamics7Dof(&cache, theta, angvel, torque, angacc);
+        checksum += angacc[1];
+    }
+    aba_time = (double)(getBenchTimeNs() - start) / calls;
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        theta[0] = n * 1e-6;
+        calcMassMatrix7Dof(&cache, theta, dynamics.mass_matrix);
+        checksum += dynamics.mass_matrix[1][1];
+    }
+    mass_time = (double)(getBenchTimeNs() - start) / calls;
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        theta[0] = n * 1e-6;
+        calcJointSpaceDynamics7Dof(&cache, theta, angvel, &dynamics);
+        checksum += dynamics.coriolis[1];
+    }
+    joint_space_time = (double)(getBenchTimeNs() - start) / calls;
+    // one control cycle: FK, jacobian and M, C dq, g of the same angles (kinematics is calculated once)
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        theta[0] = n * 1e-6;
+        forwardKinematics7Dof(&cache, theta);
+        calcJacobian7Dof(&cache, jacobian);
+        calcJointSpaceDynamics7Dof(&cache, theta, angvel, &dynamics);
+        checksum += jacobian[0][1] + dynamics.gravity[1];
+    }
+    cycle_time = (double)(getBenchTimeNs() - start) / calls;
+
+    // verification: gravity fast path = RNEA at rest = gradient of potential energy
+    for (int n = 0; n < CHECKS; n++)
+    {
+        double zero[JOINT_NUM] = {0};
+        randomState(theta, angvel, angacc);
+        inverseDynamics7Dof(&cache, theta, zero, zero, torque);
+        calcGravityTorque7Dof(&cache, theta, gravity);
+        for (int i = 0; i < KINEMATICS_DOF; i++)
+        {
+            double q = theta[i], plus, minus, e;
+            gravity_error = fmax(gravity_error, fabs(torque[i] - gravity[i]));
+            theta[i] = q + ENERGY_STEP;
+            plus = potentialEnergy(&cache, theta);
+            theta[i] = q - ENERGY_STEP;
+            minus = potentialEnergy(&cache, theta);
+            theta[i] = q;
+            e = fabs((plus - minus) / (2 * ENERGY_STEP) - gravity[i]);
+            energy_error = fmax(energy_error, e);
+        }
+        // M ddq + C dq + g = RNEA torques
+        calcJointSpaceDynamics7Dof(&cache, theta, angvel, &dynamics);
+        inverseDynamics7Dof(&cache, theta, angvel, zero, torque);
+        inverseDynamics7Dof(&cache, theta, angvel, angacc, gravity);
+        for (int i = 0; i < KINEMATICS_DOF; i++)
+        {
+            double tau = dynamics.coriolis[i] + dynamics.gravity[i];
+            coriolis_error = fmax(coriolis_error, fabs(torque[i] - tau));
+            for (int j = 0; j < KINEMATICS_DOF; j++)
+            {
+                tau += dynamics.mass_matrix[i][j] * angacc[j];
+            }
+            mass_error = fmax(mass_error, fabs(gravity[i] - tau));
+        }
+        // forward dynamics of the RNEA torques gives back the accelerations
+        inverseDynamics7Dof(&cache, theta, angvel, angacc, torque);
+        forwardDynamics7Dof(&cache, theta, angvel, torque, gravity);
+        for (int i = 0; i < KINEMATICS_DOF; i++)
+        {
+            aba_error = fmax(aba_error, fabs(gravity[i] - angacc[i]));
+        }
+    }
+
+    // rollouts: PD hold around random postures, caller thread only and thread pool
+    for (int n = 0; n < ROLLOUTS; n++)
+    {
+        randomState(initial[n].theta, initial[n].angvel, torque);
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            initial[n].angvel[i] *= 0.1;
+            initial[n].torque[i] = 0;
+        }
+    }
+    initThreadPool(&single, 0);
+    initThreadPool(&pool, getThreadPoolDefaultSize());
+    single_rate = benchRollouts(&single, initial, rollouts);
+    pool_rate = benchRollouts(&pool, initial, rollouts);
+    for (int n = 0; n < ROLLOUTS; n++)
+    {
+        for (int i = 0; i < KINEMATICS_DOF; i++)
+        {
+            drift = fmax(drift, fabs(rollouts[n].theta[i] - initial[n].theta[i]));
+        }
+    }
+    closeThreadPool(&single);
+    closeThreadPool(&pool);
+
+    printf("inverse dynamics 7DOF [ns/call] (checksum %.3f)\n", checksum);
+    printf("  RNEA %8.2f  gravity only %8.2f\n", rnea_time, gravity_time);
+    printf("  max error: gravity only to RNEA %.3e [Nm], gravity to potential energy gradient %.3e [Nm]\n", gravity_error, energy_error);
+    printf("joint space dynamics 7DOF [ns/call]\n");
+    printf("  M only (CRBA) %8.2f  M, C dq, g %8.2f  FK + jacobian + M, C dq, g %8.2f\n", mass_time, joint_space_time, cycle_time);
+    printf("  max error to RNEA: M ddq + C dq + g %.3e [Nm], C dq + g %.3e [Nm]\n", mass_error, coriolis_error);
+    printf("forward dynamics 7DOF [ns/call]\n");
+    printf("  ABA  %8.2f  max error to RNEA %.3e [rad/s^2]\n", aba_time, aba_error);
+    printf("rollouts (%d x %.2f s, dt %.4f s) [rollouts/s]\n", ROLLOUTS, ROLLOUT_DURATION, ROLLOUT_DT);
+    printf("  1 thread %8.1f  %d threads %8.1f  max drift from posture %.3e [rad]\n", single_rate, getThreadPoolDefaultSize() + 1, pool_rate, drift);
+    return 0;
+}
@@ -0,0 +1,386 @@
+/**
+ * @file bench_kinematics.c
+ * @brief Benchmark of the kinematics (3DOF scalar loop vs. batch functions of ch03, 7DOF forward/inverse kinematics and Jacobian)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../common/arm_parameter.h"
+#include "../common/kinematics.h"
+#include "../ch03/myCX7_KDL_library.h"
+#include "bench_util.h"
+
+#define DEFAULT_POINTS (100000)
+#define REPEAT (21)
+#define FK7_CALLS (1000000)
+#define JACOBIAN_CHECKS (1000)
+#define JACOBIAN_STEP (1e-6)
+#define IK7_TARGETS (1000)
+#define PATH_POINTS (1000) // 1 s of 1 kHz control cycle
+#define PATH_RADIUS (0.05)
+
+//// Arrays of points (structure of arrays) ////
+static double *theta1, *theta2, *theta3;
+static double *pos_x, *pos_y, *pos_z;
+static double *out1, *out2, *out3;
+static int *status;
+
+static unsigned int random_seed = 1; // seed of rand_r (the same samples every run)
+
+/**
+ * @fn static double randomRange(double, double)
+ * @brief Uniform random number in [min, max]
+ */
+static double randomRange(double min, double max)
+{
+    return min + (max - min) * rand_r(&random_seed) / RAND_MAX;
+}
+
+/**
+ * @fn static double benchForwardScalar(int)
+ * @brief Solve FK of all points with forwardKinematics3Dof
+ * @return time per point [ns]
+ */
+static double benchForwardScalar(int num)
+{
+    double theta[JOINT_NUM] = {0};
+    VECTOR_3D p;
+    uint64_t start = getBenchTimeNs();
+
+    for (int i = 0; i < num; i++)
+    {
+        theta[0] = theta1[i];
+        theta[1] = theta2[i];
+        theta[3] = theta3[i];
+        forwardKinematics3Dof(&p, theta);
+        out1[i] = p.x;
+        out2[i] = p.y;
+        out3[i] = p.z;
+    }
+    return (double)(getBenchTimeNs() - start) / num;
+}
+
+/**
+ * @fn static double benchInverseScalar(int)
+ * @brief Solve IK of all points with inverseKinematics3Dof
+ * @return time per point [ns]
+ */
+static double benchInverseScalar(int num)
+{
+    double theta[JOINT_NUM];
+    VECTOR_3D p;
+    uint64_t start = getBenchTimeNs();
+
+    for (int i = 0; i < num; i++)
+    {
+        p.x = pos_x[i];
+        p.y = pos_y[i];
+        p.z = pos_z[i];
+        status[i] = inverseKinematics3Dof(p, theta);
+        out1[i] = theta[0];
+        out2[i] = theta[1];
+        out3[i] = theta[3];
+    }
+    return (double)(getBenchTimeNs() - start) / num;
+}
+
+/**
+ * @fn static double maxError(const double *, const double *, int)
+ * @brief Maximum absolute difference of two arrays
+ */
+static double maxError(const double *a, const double *b, int num)
+{
+    double error = 0;
+    for (int i = 0; i < num; i++)
+    {
+        if (fabs(a[i] - b[i]) > error)
+            error = fabs(a[i] - b[i]);
+    }
+    return error;
+}
+
+/**
+ * @fn static void benchForward7Dof(void)
+ * @brief Compare full recomputation of forwardKinematics7Dof with the update of the wrist joint only
+ */
+static void benchForward7Dof(void)
+{
+    KINEMATICS_CACHE cache;
+    double theta[JOINT_NUM] = {0.3, 0.8, -0.2, -1.2, 0.4, -0.5, 0.6, 0};
+    double theta_3dof[JOINT_NUM] = {0};
+    VECTOR_3D p7, p3;
+    double full, wrist, error = 0;
+    uint64_t start;
+
+    initKinematicsCache(&cache);
+    start = getBenchTimeNs();
+    for (int n = 0; n < FK7_CALLS; n++)
+    {
+        cache.valid = 0;
+        theta[6] = n * 1e-6;
+        forwardKinematics7Dof(&cache, theta);
+    }
+    full = (double)(getBenchTimeNs() - start) / FK7_CALLS;
+    start = getBenchTimeNs();
+    for (int n = 0; n < FK7_CALLS; n++)
+    {
+        theta[6] = n * 1e-6;
+        forwardKinematics7Dof(&cache, theta);
+    }
+    wrist = (double)(getBenchTimeNs() - start) / FK7_CALLS;
+
+    // with joint 3, 5, 6 and 7 at 0, the wrist position equals the 3DOF model (which has the origin at joint 2)
+    for (int i = 0; i < 1000; i++)
+    {
+        theta_3dof[0] = theta1[i];
+        theta_3dof[1] = theta2[i];
+        theta_3dof[3] = theta3[i];
+        forwardKinematics7Dof(&cache, theta_3dof);
+        forwardKinematics3Dof(&p3, theta_3dof);
+        getEndEffectorPose(&cache, &p7, NULL);
+        error = fmax(error, fmax(fabs(p7.x - p3.x), fmax(fabs(p7.y - p3.y), fabs(p7.z - cache.frame[1].a[2][3] - p3.z))));
+    }
+    printf("forward kinematics 7DOF [ns/call]\n");
+    printf("  full %8.2f  joint 7 only %8.2f  max error to 3DOF %.3e [m]\n", full, wrist, error);
+}
+
+/**
+ * @fn static void randomPosture(double *)
+ * @brief Random joint angles of 7DOF arm (inside the movable range)
+ */
+static void randomPosture(double *theta)
+{
+    theta[0] = randomRange(-1.5, 1.5);
+    theta[1] = randomRange(0.2, 1.4);
+    theta[2] = randomRange(-1.0, 1.0);
+    theta[3] = randomRange(-2.2, -0.3);
+    theta[4] = randomRange(-1.0, 1.0);
+    theta[5] = randomRange(-1.2, 1.2);
+    theta[6] = randomRange(-1.5, 1.5);
+    theta[7] = 0;
+}
+
+/**
+ * @fn static void benchJacobian7Dof(void)
+ * @brief Measure calcJacobian7Dof (with and without forward kinematics) and verify it by finite difference
+ */
+static void benchJacobian7Dof(void)
+{
+    KINEMATICS_CACHE cache;
+    double theta[JOINT_NUM];
+    double J[KINEMATICS_TASK_DIM][KINEMATICS_DOF];
+    double jacobian_only, with_fk, error = 0, sum = 0;
+    uint64_t start;
+
+    initKinematicsCache(&cache);
+    randomPosture(theta);
+    forwardKinematics7Dof(&cache, theta);
+    start = getBenchTimeNs();
+    for (int n = 0; n < FK7_CALLS; n++)
+    {
+        calcJacobian7Dof(&cache, J);
+        sum += J[0][n % KINEMATICS_DOF];
+    }
+    jacobian_only = (double)(getBenchTimeNs() - start) / FK7_CALLS;
+    start = getBenchTimeNs();
+    for (int n = 0; n < FK7_CALLS; n++)
+    {
+        theta[0] = n * 1e-6;
+        forwardKinematics7Dof(&cache, theta);
+        calcJacobian7Dof(&cache, J);
+        sum += J[0][n % KINEMATICS_DOF];
+    }
+    with_fk = (double)(getBenchTimeNs() - start) / FK7_CALLS;
+
+    for (int n = 0; n < JACOBIAN_CHECKS; n++)
+    {
+        double e;
+        randomPosture(theta);
+        e = checkJacobian7Dof(theta, JACOBIAN_STEP);
+        error = (e > error) ? e : error;
+    }
+    printf("Jacobian 7DOF [ns/call] (checksum %.3f)\n", sum);
+    printf("  cached frames %8.2f  with full FK %8.2f  max error to finite difference %.3e (%d postures)\n",
+           jacobian_only, with_fk, error, JACOBIAN_CHECKS);
+}
+
+/**
+ * @fn static void benchInverse7Dof(void)
+ * @brief Solve random reachable poses from a fixed posture, and track a circle with warm start
+ */
+static void benchInverse7Dof(void)
+{
+    KINEMATICS_CACHE cache;
+    IK_CONFIG config;
+    IK_RESULT result;
+    const double home[JOINT_NUM] = {0, 0.5, 0, -1.5, 0, -0.5, 0, 0};
+    double theta[JOINT_NUM], solution[JOINT_NUM];
+    double samples[IK7_TARGETS];
+    BENCH_RESULT time_result;
+    VECTOR_3D center, target;
+    MATRIX_3D rotation;
+    int failed = 0, iterations = 0, max_iterations = 0;
+    double max_time = 0;
+
+    initKinematicsCache(&cache);
+    getDefaultIkConfig(&config);
+
+    // cold start from the home posture
+    for (int n = 0; n < IK7_TARGETS; n++)
+    {
+        randomPosture(theta);
+        forwardKinematics7Dof(&cache, theta);
+        getEndEffectorPose(&cache, &target, &rotation);
+        failed += inverseKinematics7Dof(&cache, &target, &rotation, home, solution, &config, &result);
+        iterations += result.iterations;
+        samples[n] = result.time * 1e9;
+    }
+    summarizeBenchSamples(samples, IK7_TARGETS, &time_result);
+    printf("inverse kinematics 7DOF, cold start (%d random poses)\n", IK7_TARGETS);
+    printf("  failed %d  mean iterations %.1f\n", failed, (double)iterations / IK7_TARGETS);
+    printBenchResult("  time", &time_result);
+
+    // warm start along a circle (1 kHz), the orientation is kept
+    forwardKinematics7Dof(&cache, home);
+    getEndEffectorPose(&cache, &center, &rotation);
+    center.y -= PATH_RADIUS;
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        theta[i] = home[i];
+    }
+    failed = 0;
+    iterations = 0;
+    for (int n = 0; n <= PATH_POINTS; n++)
+    {
+        double phase = 2 * M_PI * n / PATH_POINTS;
+        target.x = center.x;
+        target.y = center.y + PATH_RADIUS * cos(phase);
+        target.z = center.z + PATH_RADIUS * sin(phase);
+        failed += inverseKinematics7Dof(&cache, &target, &rotation, theta, solution, &config, &result);
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            theta[i] = solution[i];
+        }
+        iterations += result.iterations;
+        max_iterations = (result.iterations > max_iterations) ? result.iterations : max_iterations;
+        max_time = (result.time > max_time) ? result.time : max_time;
+    }
+    printf("inverse kinematics 7DOF, warm start (circle r=%.2f m, %d points)\n", PATH_RADIUS, PATH_POINTS);
+    printf("  failed %d  mean iterations %.2f  max iterations %d  max time %.0f [ns]\n",
+           failed, (double)iterations / (PATH_POINTS + 1), max_iterations, max_time * 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    int points = DEFAULT_POINTS;
+    double samples[REPEAT];
+    double *ref1, *ref2, *ref3;
+    BENCH_RESULT scalar_result, batch_result;
+    double fk_error, ik_error;
+    int failed = 0;
+
+    if (argc > 1)
+    {
+        points = atoi(argv[1]);
+        if (points <= 0)
+        {
+            fprintf(stderr, "usage: %s [points]\n", argv[0]);
+            return 1;
+        }
+    }
+    theta1 = (double *)malloc(sizeof(double) * points * 12);
+    status = (int *)malloc(sizeof(int) * points);
+    if ((theta1 == NULL) || (status == NULL))
+    {
+        return 1;
+    }
+    theta2 = theta1 + points;
+    theta3 = theta2 + points;
+    pos_x = theta3 + points;
+    pos_y = pos_x + points;
+    pos_z = pos_y + points;
+    out1 = pos_z + points;
+    out2 = out1 + points;
+    out3 = out2 + points;
+    ref1 = out3 + points;
+    ref2 = ref1 + points;
+    ref3 = ref2 + points;
+
+    initParam();
+    random_seed = 1;
+    for (int i = 0; i < points; i++)
+    {
+        theta1[i] = randomRange(-2.5, 2.5);
+        theta2[i] = randomRange(0.1, 1.4);
+        theta3[i] = randomRange(-2.5, -0.1);
+    }
+
+    // forward kinematics
+    for (int n = 0; n < REPEAT; n++)
+        samples[n] = benchForwardScalar(points);
+    summarizeBenchSamples(samples, REPEAT, &scalar_result);
+    for (int i = 0; i < points; i++)
+    {
+        ref1[i] = out1[i];
+        ref2[i] = out2[i];
+        ref3[i] = out3[i];
+    }
+    for (int n = 0; n < REPEAT; n++)
+    {
+        uint64_t start = getBenchTimeNs();
+        forwardKinematics3DofBatch(points, theta1, theta2, theta3, pos_x, pos_y, pos_z);
+        samples[n] = (double)(getBenchTimeNs() - start) / points;
+    }
+    summarizeBenchSamples(samples, REPEAT, &batch_result);
+    fk_error = fmax(maxError(ref1, pos_x, points), fmax(maxError(ref2, pos_y, points), maxError(ref3, pos_z, points)));
+    printf("forward kinematics (%d points) [ns/point]\n", points);
+    printf("  scalar %8.2f  batch %8.2f  speedup %5.2f  max error %.3e [m]\n",
+           scalar_result.median, batch_result.median, scalar_result.median / batch_result.median, fk_error);
+
+    // inverse kinematics (every point is reachable, so the scalar version does not print errors)
+    for (int n = 0; n < REPEAT; n++)
+        samples[n] = benchInverseScalar(points);
+    summarizeBenchSamples(samples, REPEAT, &scalar_result);
+    for (int i = 0; i < points; i++)
+    {
+        ref1[i] = out1[i];
+        ref2[i] = out2[i];
+        ref3[i] = out3[i];
+    }
+    for (int n = 0; n < REPEAT; n++)
+    {
+        uint64_t start = getBenchTimeNs();
+        failed = inverseKinematics3DofBatch(points, pos_x, pos_y, pos_z, out1, out2, out3, status);
+        samples[n] = (double)(getBenchTimeNs() - start) / points;
+    }
+    summarizeBenchSamples(samples, REPEAT, &batch_result);
+    ik_error = fmax(maxError(ref1, out1, points), fmax(maxError(ref2, out2, points), maxError(ref3, out3, points)));
+    printf("inverse kinematics (%d points) [ns/point]\n", points);
+    printf("  scalar %8.2f  batch %8.2f  speedup %5.2f  max error %.3e [rad]  failed %d\n",
+           scalar_result.median, batch_result.median, scalar_result.median / batch_result.median, ik_error, failed);
+
+    benchForward7Dof();
+    benchJacobian7Dof();
+    benchInverse7Dof();
+
+    free(theta1);
+    free(status);
+    return 0;
+}
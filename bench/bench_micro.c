@@ -0,0 +1,512 @@
+/**
+ * @file bench_micro.c
+ * @brief Microbenchmark of the routines called every control cycle (matrix.c, 2DOF/3DOF kinematics, unit conversions) with a JSON report
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../common/crane_x7_comm.h"
+#include "../common/dxl_unit.h"
+#include "../common/matrix.h"
+#include "../ch03/myCX7_KDL_library.h"
+#include "bench_util.h"
+
+#define DEFAULT_REPORT "bench_micro.json"
+#define WARMUP_OPS (200000) // calls before the measurement (CPU frequency, caches, branch predictors)
+#define REPETITIONS (101)   // number of samples of each routine
+#define BATCH_OPS (2000)    // calls per sample (the clock is read once per sample)
+#define POOL_SIZE (64)      // number of inputs cycled by the calls (power of 2)
+
+/**
+ * @brief Benchmark function: call the routine ops times and return a value depending on the results
+ */
+typedef double (*MICRO_BENCH_FUNC)(int ops);
+
+/**
+ * @struct MICRO_BENCH
+ * @brief Measured routine
+ */
+typedef struct
+{
+    const char *group;
+    const char *name;
+    MICRO_BENCH_FUNC func;
+} MICRO_BENCH;
+
+//// Inputs (the same values every run) ////
+static MATRIX_3D mat3_pool[POOL_SIZE];
+static VECTOR_3D vec3_pool[POOL_SIZE];
+static MATRIX_4D mat4_pool[POOL_SIZE];
+static VECTOR_4D vec4_pool[POOL_SIZE];
+static double scalar_pool[POOL_SIZE];
+static double theta_pool[POOL_SIZE][JOINT_NUM]; // joint angles in the range of inverseKinematics2Dof/3Dof
+static VECTOR_3D pos2_pool[POOL_SIZE];          // forwardKinematics2Dof of theta_pool
+static VECTOR_3D pos3_pool[POOL_SIZE];          // forwardKinematics3Dof of theta_pool
+static volatile double sink;                    // keeps the results alive
+
+static unsigned int random_seed = 1; // seed of rand_r (the same samples every run)
+
+/**
+ * @fn static double randomRange(double, double)
+ * @brief Uniform random number in [min, max]
+ */
+static double randomRange(double min, double max)
+{
+    return min + (max - min) * rand_r(&random_seed) / RAND_MAX;
+}
+
+/**
+ * @fn static void initPools(void)
+ * @brief Fill the inputs with random values
+ */
+static void initPools(void)
+{
+    for (int n = 0; n < POOL_SIZE; n++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                mat4_pool[n].a[i][j] = randomRange(-1.0, 1.0);
+                if ((i < 3) && (j < 3))
+                    mat3_pool[n].a[i][j] = mat4_pool[n].a[i][j] + ((i == j) ? 2.0 : 0.0); // invertible
+            }
+            vec4_pool[n].x[i] = randomRange(-1.0, 1.0);
+        }
+        vec3_pool[n].x = randomRange(-1.0, 1.0);
+        vec3_pool[n].y = randomRange(-1.0, 1.0);
+        vec3_pool[n].z = randomRange(-1.0, 1.0);
+        scalar_pool[n] = randomRange(-2.0, 2.0);
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            theta_pool[n][i] = 0;
+        }
+        theta_pool[n][0] = randomRange(-2.5, 2.5);
+        theta_pool[n][1] = randomRange(0.1, 1.4);
+        theta_pool[n][3] = randomRange(-2.5, -0.1);
+        forwardKinematics2Dof(&pos2_pool[n], theta_pool[n]);
+        pos2_pool[n].z = 0;
+        forwardKinematics3Dof(&pos3_pool[n], theta_pool[n]);
+    }
+}
+
+//// matrix.c ////
+// Each benchmark function calls the routine ops times with the inputs cycled through the pools
+// and sums a part of the results, so that no call can be removed by the compiler.
+
+static double benchMulMatMat3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulMatMat3D(mat3_pool[i & (POOL_SIZE - 1)], mat3_pool[(i + 1) & (POOL_SIZE - 1)]).a[2][2];
+    return sum;
+}
+
+static double benchMulMatVec3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulMatVec3D(mat3_pool[i & (POOL_SIZE - 1)], vec3_pool[(i + 1) & (POOL_SIZE - 1)]).z;
+    return sum;
+}
+
+static double benchMulScoMat3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulScoMat3D(scalar_pool[i & (POOL_SIZE - 1)], mat3_pool[(i + 1) & (POOL_SIZE - 1)]).a[2][2];
+    return sum;
+}
+
+static double benchMulScoVec3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulScoVec3D(scalar_pool[i & (POOL_SIZE - 1)], vec3_pool[(i + 1) & (POOL_SIZE - 1)]).z;
+    return sum;
+}
+
+static double benchCrsVecVec3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += crsVecVec3D(vec3_pool[i & (POOL_SIZE - 1)], vec3_pool[(i + 1) & (POOL_SIZE - 1)]).z;
+    return sum;
+}
+
+static double benchSumMatMat3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += sumMatMat3D(mat3_pool[i & (POOL_SIZE - 1)], mat3_pool[(i + 1) & (POOL_SIZE - 1)]).a[2][2];
+    return sum;
+}
+
+static double benchSumVecVec3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += sumVecVec3D(vec3_pool[i & (POOL_SIZE - 1)], vec3_pool[(i + 1) & (POOL_SIZE - 1)]).z;
+    return sum;
+}
+
+static double benchSubVecVec3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += subVecVec3D(vec3_pool[i & (POOL_SIZE - 1)], vec3_pool[(i + 1) & (POOL_SIZE - 1)]).z;
+    return sum;
+}
+
+static double benchTransposeMat3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += transeposeMat3D(mat3_pool[i & (POOL_SIZE - 1)]).a[2][0];
+    return sum;
+}
+
+static double benchInverseMat3D(int ops)
+{
+    MATRIX_3D inverse;
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        sum += inverseMat3D(mat3_pool[i & (POOL_SIZE - 1)], &inverse);
+        sum += inverse.a[2][2];
+    }
+    return sum;
+}
+
+static double benchMulMatMat4D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulMatMat4D(mat4_pool[i & (POOL_SIZE - 1)], mat4_pool[(i + 1) & (POOL_SIZE - 1)]).a[3][3];
+    return sum;
+}
+
+static double benchMulMatVec4D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulMatVec4D(mat4_pool[i & (POOL_SIZE - 1)], vec4_pool[(i + 1) & (POOL_SIZE - 1)]).x[3];
+    return sum;
+}
+
+// pointer API of the same operations (no copy of the arguments and the result)
+
+static double benchMulMatMat3DPtr(int ops)
+{
+    double sum = 0;
+    MATRIX_3D result;
+    for (int i = 0; i < ops; i++)
+    {
+        mulMatMat3DPtr(&mat3_pool[i & (POOL_SIZE - 1)], &mat3_pool[(i + 1) & (POOL_SIZE - 1)], &result);
+        sum += result.a[2][2];
+    }
+    return sum;
+}
+
+static double benchMulMatVec3DPtr(int ops)
+{
+    double sum = 0;
+    VECTOR_3D result;
+    for (int i = 0; i < ops; i++)
+    {
+        mulMatVec3DPtr(&mat3_pool[i & (POOL_SIZE - 1)], &vec3_pool[(i + 1) & (POOL_SIZE - 1)], &result);
+        sum += result.z;
+    }
+    return sum;
+}
+
+static double benchMulTransMatVec3DPtr(int ops)
+{
+    double sum = 0;
+    VECTOR_3D result;
+    for (int i = 0; i < ops; i++)
+    {
+        mulTransMatVec3DPtr(&mat3_pool[i & (POOL_SIZE - 1)], &vec3_pool[(i + 1) & (POOL_SIZE - 1)], &result);
+        sum += result.z;
+    }
+    return sum;
+}
+
+static double benchTransposeMulMatVec3D(int ops)
+{
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+        sum += mulMatVec3D(transeposeMat3D(mat3_pool[i & (POOL_SIZE - 1)]), vec3_pool[(i + 1) & (POOL_SIZE - 1)]).z;
+    return sum;
+}
+
+static double benchInverseMat3DPtr(int ops)
+{
+    double sum = 0;
+    MATRIX_3D inverse;
+    for (int i = 0; i < ops; i++)
+    {
+        if (inverseMat3DPtr(&mat3_pool[i & (POOL_SIZE - 1)], &inverse))
+            sum += inverse.a[2][2];
+    }
+    return sum;
+}
+
+static double benchMulMatMat4DPtr(int ops)
+{
+    double sum = 0;
+    MATRIX_4D result;
+    for (int i = 0; i < ops; i++)
+    {
+        mulMatMat4DPtr(&mat4_pool[i & (POOL_SIZE - 1)], &mat4_pool[(i + 1) & (POOL_SIZE - 1)], &result);
+        sum += result.a[3][3];
+    }
+    return sum;
+}
+
+static double benchMulMatMat4DInPlace(int ops)
+{
+    MATRIX_4D result = mat4_pool[0];
+    for (int i = 0; i < ops; i++)
+    {
+        // chained product restarted every POOL_SIZE calls, so that the values stay finite
+        if ((i & (POOL_SIZE - 1)) == 0)
+            result = mat4_pool[0];
+        mulMatMat4DInPlace(&result, &mat4_pool[(i + 1) & (POOL_SIZE - 1)]);
+    }
+    return result.a[3][3];
+}
+
+static double benchMulMatVec4DPtr(int ops)
+{
+    double sum = 0;
+    VECTOR_4D result;
+    for (int i = 0; i < ops; i++)
+    {
+        mulMatVec4DPtr(&mat4_pool[i & (POOL_SIZE - 1)], &vec4_pool[(i + 1) & (POOL_SIZE - 1)], &result);
+        sum += result.x[3];
+    }
+    return sum;
+}
+
+static double benchTransformPoint4DPtr(int ops)
+{
+    double sum = 0;
+    VECTOR_3D result;
+    for (int i = 0; i < ops; i++)
+    {
+        transformPoint4DPtr(&mat4_pool[i & (POOL_SIZE - 1)], &vec3_pool[(i + 1) & (POOL_SIZE - 1)], &result);
+        sum += result.z;
+    }
+    return sum;
+}
+
+//// Kinematics of ch03 ////
+
+static double benchForwardKinematics2Dof(int ops)
+{
+    VECTOR_3D p;
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        forwardKinematics2Dof(&p, theta_pool[i & (POOL_SIZE - 1)]);
+        sum += p.y;
+    }
+    return sum;
+}
+
+static double benchInverseKinematics2Dof(int ops)
+{
+    double theta[JOINT_NUM];
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        sum += inverseKinematics2Dof(pos2_pool[i & (POOL_SIZE - 1)], theta);
+        sum += theta[3];
+    }
+    return sum;
+}
+
+static double benchForwardKinematics3Dof(int ops)
+{
+    VECTOR_3D p;
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        forwardKinematics3Dof(&p, theta_pool[i & (POOL_SIZE - 1)]);
+        sum += p.z;
+    }
+    return sum;
+}
+
+static double benchInverseKinematics3Dof(int ops)
+{
+    double theta[JOINT_NUM];
+    double sum = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        sum += inverseKinematics3Dof(pos3_pool[i & (POOL_SIZE - 1)], theta);
+        sum += theta[3];
+    }
+    return sum;
+}
+
+//// Unit conversions of dxl_unit.c (direct calls, one function per conversion) ////
+
+#define DEFINE_UNIT_BENCH(bench, convert)                         \
+    static double bench(int ops)                                  \
+    {                                                             \
+        double sum = 0;                                           \
+        for (int i = 0; i < ops; i++)                             \
+            sum += convert(scalar_pool[i & (POOL_SIZE - 1)]);     \
+        return sum;                                               \
+    }
+
+DEFINE_UNIT_BENCH(benchRad2DxlValue, rad2dxlvalue)
+DEFINE_UNIT_BENCH(benchDxlValue2Rad, dxlvalue2rad)
+DEFINE_UNIT_BENCH(benchAngularVel2DxlValue, angularvel2dxlvalue)
+DEFINE_UNIT_BENCH(benchDxlValue2AngularVel, dxlvalue2angularvel)
+DEFINE_UNIT_BENCH(benchCurrent2DxlValue, current2dxlvalue)
+DEFINE_UNIT_BENCH(benchDxlValue2Current, dxlvalue2current)
+DEFINE_UNIT_BENCH(benchCurrent2TorqueXM430W350, current2torqueXM430W350)
+DEFINE_UNIT_BENCH(benchCurrent2TorqueXM540W270, current2torqueXM540W270)
+DEFINE_UNIT_BENCH(benchTorque2CurrentXM430W350, torque2currentXM430W350)
+DEFINE_UNIT_BENCH(benchTorque2CurrentXM540W270, torque2currentXM540W270)
+
+static const MICRO_BENCH micro_bench[] = {
+    {"matrix", "mulMatMat3D", benchMulMatMat3D},
+    {"matrix", "mulMatVec3D", benchMulMatVec3D},
+    {"matrix", "mulScoMat3D", benchMulScoMat3D},
+    {"matrix", "mulScoVec3D", benchMulScoVec3D},
+    {"matrix", "crsVecVec3D", benchCrsVecVec3D},
+    {"matrix", "sumMatMat3D", benchSumMatMat3D},
+    {"matrix", "sumVecVec3D", benchSumVecVec3D},
+    {"matrix", "subVecVec3D", benchSubVecVec3D},
+    {"matrix", "transeposeMat3D", benchTransposeMat3D},
+    {"matrix", "inverseMat3D", benchInverseMat3D},
+    {"matrix", "mulMatMat4D", benchMulMatMat4D},
+    {"matrix", "mulMatVec4D", benchMulMatVec4D},
+    {"matrix", "mulMatMat3DPtr", benchMulMatMat3DPtr},
+    {"matrix", "mulMatVec3DPtr", benchMulMatVec3DPtr},
+    {"matrix", "mulMatVec3D(transepose)", benchTransposeMulMatVec3D},
+    {"matrix", "mulTransMatVec3DPtr", benchMulTransMatVec3DPtr},
+    {"matrix", "inverseMat3DPtr", benchInverseMat3DPtr},
+    {"matrix", "mulMatMat4DPtr", benchMulMatMat4DPtr},
+    {"matrix", "mulMatMat4DInPlace", benchMulMatMat4DInPlace},
+    {"matrix", "mulMatVec4DPtr", benchMulMatVec4DPtr},
+    {"matrix", "transformPoint4DPtr", benchTransformPoint4DPtr},
+    {"kinematics", "forwardKinematics2Dof", benchForwardKinematics2Dof},
+    {"kinematics", "inverseKinematics2Dof", benchInverseKinematics2Dof},
+    {"kinematics", "forwardKinematics3Dof", benchForwardKinematics3Dof},
+    {"kinematics", "inverseKinematics3Dof", benchInverseKinematics3Dof},
+    {"unit", "rad2dxlvalue", benchRad2DxlValue},
+    {"unit", "dxlvalue2rad", benchDxlValue2Rad},
+    {"unit", "angularvel2dxlvalue", benchAngularVel2DxlValue},
+    {"unit", "dxlvalue2angularvel", benchDxlValue2AngularVel},
+    {"unit", "current2dxlvalue", benchCurrent2DxlValue},
+    {"unit", "dxlvalue2current", benchDxlValue2Current},
+    {"unit", "current2torqueXM430W350", benchCurrent2TorqueXM430W350},
+    {"unit", "current2torqueXM540W270", benchCurrent2TorqueXM540W270},
+    {"unit", "torque2currentXM430W350", benchTorque2CurrentXM430W350},
+    {"unit", "torque2currentXM540W270", benchTorque2CurrentXM540W270},
+};
+#define MICRO_BENCH_NUM ((int)(sizeof(micro_bench) / sizeof(micro_bench[0])))
+
+/**
+ * @fn static void runMicroBench(const MICRO_BENCH *, BENCH_RESULT *)
+ * @brief Warm up, then measure REPETITIONS samples of BATCH_OPS calls
+ * @param[out] *result time per call [ns/op]
+ */
+static void runMicroBench(const MICRO_BENCH *bench, BENCH_RESULT *result)
+{
+    double samples[REPETITIONS];
+
+    sink = bench->func(WARMUP_OPS);
+    for (int n = 0; n < REPETITIONS; n++)
+    {
+        uint64_t start = getBenchTimeNs();
+        sink = bench->func(BATCH_OPS);
+        samples[n] = (double)(getBenchTimeNs() - start) / BATCH_OPS;
+    }
+    summarizeBenchSamples(samples, REPETITIONS, result);
+}
+
+/**
+ * @fn static int writeJsonReport(const char *, const BENCH_RESULT *)
+ * @brief Write the results as JSON (one object per routine, times in ns/op)
+ * @return 0: success, 1: failure
+ */
+static int writeJsonReport(const char *filename, const BENCH_RESULT *result)
+{
+    FILE *fp = fopen(filename, "w");
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Failed to open %s\n", filename);
+        return 1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"benchmark\": \"bench_micro\",\n");
+    fprintf(fp, "  \"unit\": \"ns/op\",\n");
+    fprintf(fp, "  \"time\": %" PRId64 ",\n", (int64_t)time(NULL));
+    fprintf(fp, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(fp, "  \"warmup_ops\": %d,\n", WARMUP_OPS);
+    fprintf(fp, "  \"repetitions\": %d,\n", REPETITIONS);
+    fprintf(fp, "  \"batch_ops\": %d,\n", BATCH_OPS);
+    fprintf(fp, "  \"results\": [\n");
+    for (int i = 0; i < MICRO_BENCH_NUM; i++)
+    {
+        fprintf(fp, "    {\"group\": \"%s\", \"name\": \"%s\", \"median\": %.3f, \"p99\": %.3f, \"min\": %.3f, \"mean\": %.3f, \"max\": %.3f}%s\n",
+                micro_bench[i].group, micro_bench[i].name, result[i].median, result[i].p99, result[i].min, result[i].mean,
+                result[i].max, (i < MICRO_BENCH_NUM - 1) ? "," : "");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+    if (fclose(fp) != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", filename);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *report = (argc > 1) ? argv[1] : DEFAULT_REPORT;
+    BENCH_RESULT result[MICRO_BENCH_NUM];
+
+    initParam();
+    initPools();
+    printf("%-12s %-26s %10s %10s %10s [ns/op]\n", "group", "name", "min", "median", "p99");
+    for (int i = 0; i < MICRO_BENCH_NUM; i++)
+    {
+        runMicroBench(&micro_bench[i], &result[i]);
+        printf("%-12s %-26s %10.2f %10.2f %10.2f\n", micro_bench[i].group, micro_bench[i].name,
+               result[i].min, result[i].median, result[i].p99);
+    }
+    if (writeJsonReport(report, result))
+    {
+        return 1;
+    }
+    printf("report : %s\n", report);
+    return 0;
+}
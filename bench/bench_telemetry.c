@@ -0,0 +1,127 @@
+/**
+ * @file bench_telemetry.c
+ * @brief Benchmark of the telemetry recorder (timing of a 1 kHz control loop on the simulator without logging, with printf and with the recorder)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../common/crane_x7_comm.h"
+#include "../common/control_loop.h"
+#include "../common/telemetry.h"
+#include "bench_util.h"
+
+#define CONTROL_FREQUENCY (1000.0)
+#define RUN_TIME (3.0) // duration of each run [s]
+#define DEFAULT_FILE "/tmp/bench_telemetry.bin"
+#define TEXT_FILE "/tmp/bench_telemetry.txt"
+#define LOG_NONE (0)
+#define LOG_PRINTF (1)
+#define LOG_TELEMETRY (2)
+
+/**
+ * @struct LOG_RUN
+ * @brief Arguments of the control loop callback
+ */
+typedef struct
+{
+    int mode;
+    FILE *text;          // output of printf mode
+    TELEMETRY telemetry; // recorder of telemetry mode
+    double log_time_max; // maximum time to log a cycle [ns]
+} LOG_RUN;
+
+/**
+ * @fn static int logCycle(uint64_t, double, void *)
+ * @brief Control loop callback: send a setpoint, read the joint state and log it
+ */
+static int logCycle(uint64_t cycle, double time, void *user_data)
+{
+    LOG_RUN *run = (LOG_RUN *)user_data;
+    double command[JOINT_NUM] = {0}, angle[JOINT_NUM], angvel[JOINT_NUM], torque[JOINT_NUM];
+    uint64_t start;
+
+    command[0] = 0.3 * sin(2 * PI * 0.5 * time);
+    command[1] = 0.5;
+    command[3] = -1.0;
+    cycleCranex7(command, angle, angvel, torque);
+
+    start = getBenchTimeNs();
+    if (run->mode == LOG_PRINTF)
+    {
+        fprintf(run->text, "%" PRIu64 " %f", cycle, time);
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            fprintf(run->text, " %f %f %f %f", command[i], angle[i], angvel[i], torque[i]);
+        }
+        fprintf(run->text, "\n");
+        fflush(run->text);
+    }
+    else if (run->mode == LOG_TELEMETRY)
+    {
+        recordTelemetry(&run->telemetry, cycle, time, command, angle, angvel, torque);
+    }
+    run->log_time_max = fmax(run->log_time_max, (double)(getBenchTimeNs() - start));
+    return (time >= RUN_TIME);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name[3] = {"no logging", "printf every cycle", "telemetry recorder"};
+    const char *filename = (argc > 1) ? argv[1] : DEFAULT_FILE;
+    uint8_t operating_mode[JOINT_NUM];
+    CONTROL_LOOP_CONFIG loop_config;
+    CONTROL_LOOP_STATS loop_stats[3];
+    LOG_RUN run[3] = {{LOG_NONE}, {LOG_PRINTF}, {LOG_TELEMETRY}};
+
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        operating_mode[i] = POSITION_CONTROL_MODE;
+    }
+    if (initilizeCranex7(operating_mode))
+    {
+        return 1;
+    }
+    setCranex7TorqueEnable(TORQUE_ENABLE);
+    getDefaultControlLoopConfig(&loop_config, CONTROL_FREQUENCY);
+
+    // printf goes to a text file, so that the terminal is not flooded
+    run[LOG_PRINTF].text = fopen(TEXT_FILE, "w");
+    if ((run[LOG_PRINTF].text == NULL) || openTelemetry(&run[LOG_TELEMETRY].telemetry, filename, 0))
+    {
+        closeCranex7Port();
+        return 1;
+    }
+    for (int n = 0; n < 3; n++)
+    {
+        runControlLoop(&loop_config, logCycle, &run[n], &loop_stats[n]);
+    }
+    fclose(run[LOG_PRINTF].text);
+    closeTelemetry(&run[LOG_TELEMETRY].telemetry);
+
+    for (int n = 0; n < 3; n++)
+    {
+        printf("%s : max %.1f [us] to log a cycle\n", name[n], run[n].log_time_max * 1e-3);
+        printControlLoopStats(&loop_stats[n]);
+    }
+    printf("convert the record : ../../tools/bin/telemetry_csv %s\n", filename);
+    closeCranex7Port();
+    return 0;
+}
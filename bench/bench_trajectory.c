@@ -0,0 +1,230 @@
+/**
+ * @file bench_trajectory.c
+ * @brief Benchmark of jerk limited trajectory (planning time, settling time against fixed profile velocity on the simulator, streaming)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../common/crane_x7_comm.h"
+#include "../common/trajectory.h"
+#include "../ch03/myCX7_KDL_library.h"
+#include "bench_util.h"
+
+#define DEFAULT_CALLS (100000)
+#define TARGET_NUM (4)
+#define WAYPOINT_NUM (2 * TARGET_NUM + 2) // start posture and the 9 targets of the ch03 demo (2 rounds and back to the first)
+#define CHECK_STEP (1e-4)
+#define STREAM_FREQUENCY (200.0)
+#define DEMO_HOLD_TIME (3.0)      // time the demos of ch02 and ch03 held each target before they streamed the S-curve [s]
+#define DEMO_SETTLE_TIME (0.5)    // time the demos wait after the end of each streamed S-curve (SETTLE_TIME of ch02 and ch03) [s]
+#define SIM_STEP "0.005"          // lockstep mode of the simulator: simulated time advanced by each state read [s]
+#define SETTLE_TOLERANCE (0.1)    // joint angle error regarded as arrival (including steady state error by gravity) [rad]
+#define SETTLE_ANGVEL (0.05)      // joint angular velocity regarded as stop [rad/s]
+#define SETTLE_TIMEOUT (5.0)      // [s]
+
+static double tracking_error = 0; // maximum error between setpoint and present angle while streaming [rad]
+
+/**
+ * @fn static int streamOutput(double *)
+ * @brief Output of runTrajectory: send the setpoint and record the tracking error of the simulated arm
+ */
+static int streamOutput(double *angle_array)
+{
+    double angle[JOINT_NUM], angvel[JOINT_NUM], torque[JOINT_NUM];
+
+    getCranex7JointState(angle, angvel, torque);
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        tracking_error = fmax(tracking_error, fabs(angle[i] - angle_array[i]));
+    }
+    return setCranex7Angle(angle_array);
+}
+
+/**
+ * @fn static double settleMove(const TRAJECTORY_SEGMENT *, double, int)
+ * @brief Move the simulated arm by one segment and measure the time until it stops at the next waypoint
+ * @param[in] *segment segment of the trajectory
+ * @param[in] step simulated time of a state read [s]
+ * @param[in] stream 1: stream the S-curve setpoints, 0: send only the goal and let the fixed profile velocity move the arm
+ * @return settling time [s]
+ */
+static double settleMove(const TRAJECTORY_SEGMENT *segment, double step, int stream)
+{
+    TRAJECTORY single = {1, segment->duration, {*segment}};
+    double goal[JOINT_NUM], setpoint[JOINT_NUM], angle[JOINT_NUM], angvel[JOINT_NUM], torque[JOINT_NUM];
+    double time = 0;
+
+    single.segment[0].start_time = 0;
+    evaluateTrajectory(&single, single.duration, goal, NULL, NULL);
+    if (!stream)
+        setCranex7Angle(goal);
+    while (time < SETTLE_TIMEOUT)
+    {
+        int settled = 1;
+
+        if (stream)
+        {
+            evaluateTrajectory(&single, time, setpoint, NULL, NULL);
+            setCranex7Angle(setpoint);
+        }
+        getCranex7JointState(angle, angvel, torque);
+        time += step;
+        for (int i = 0; i < JOINT_NUM - 1; i++)
+        {
+            if ((fabs(angle[i] - goal[i]) > SETTLE_TOLERANCE) || (fabs(angvel[i]) > SETTLE_ANGVEL))
+                settled = 0;
+        }
+        if (settled && (time >= single.duration))
+            break;
+    }
+    return time;
+}
+
+int main(int argc, char **argv)
+{
+    const VECTOR_3D target[TARGET_NUM] = {{0.15, 0.15, 0.15}, {0.35, 0.15, 0.15}, {0.15, 0.15, 0.35}, {0., 0., 0.35}};
+    const double profile_velocity = PROFILE_VELOCITY * DXL_VALUE_TO_ANGULARVEL;
+    uint8_t operating_mode[JOINT_NUM];
+    double waypoint[WAYPOINT_NUM][JOINT_NUM] = {{0}};
+    double angle[JOINT_NUM], angvel[JOINT_NUM], angacc[JOINT_NUM], previous_angacc[JOINT_NUM], zero[JOINT_NUM] = {0};
+    double checksum = 0, plan_time, evaluate_time, scurve_total = 0, fixed_total = 0, fixed_profile[JOINT_NUM];
+    double velocity_ratio = 0, acceleration_ratio = 0, jerk_ratio = 0;
+    int calls = DEFAULT_CALLS;
+    double home[2][JOINT_NUM];
+    TRAJECTORY trajectory, homing;
+    TRAJECTORY_LIMIT limit;
+    CONTROL_LOOP_CONFIG loop_config;
+    CONTROL_LOOP_STATS loop_stats;
+    uint64_t start;
+
+    if (argc > 1)
+    {
+        calls = atoi(argv[1]);
+        if (calls <= 0)
+        {
+            fprintf(stderr, "usage: %s [calls]\n", argv[0]);
+            return 1;
+        }
+    }
+    initParam();
+    for (int n = 1; n < WAYPOINT_NUM; n++)
+    {
+        if (inverseKinematics3Dof(target[(n - 1) % TARGET_NUM], waypoint[n]))
+        {
+            return 1;
+        }
+    }
+    getDefaultTrajectoryLimit(&limit);
+
+    // planning and evaluation time
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        waypoint[0][0] = n * 1e-9;
+        planTrajectory(&trajectory, waypoint, WAYPOINT_NUM, &limit);
+        checksum += trajectory.duration;
+    }
+    plan_time = (double)(getBenchTimeNs() - start) / calls;
+    start = getBenchTimeNs();
+    for (int n = 0; n < calls; n++)
+    {
+        evaluateTrajectory(&trajectory, trajectory.duration * n / calls, angle, angvel, angacc);
+        checksum += angle[1];
+    }
+    evaluate_time = (double)(getBenchTimeNs() - start) / calls;
+
+    // verification: sampled velocity, acceleration and jerk stay within the limits
+    evaluateTrajectory(&trajectory, 0, angle, angvel, previous_angacc);
+    for (double t = CHECK_STEP; t < trajectory.duration + CHECK_STEP; t += CHECK_STEP)
+    {
+        evaluateTrajectory(&trajectory, t, angle, angvel, angacc);
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            velocity_ratio = fmax(velocity_ratio, fabs(angvel[i]) / limit.angvel[i]);
+            acceleration_ratio = fmax(acceleration_ratio, fabs(angacc[i]) / limit.angacc[i]);
+            jerk_ratio = fmax(jerk_ratio, fabs(angacc[i] - previous_angacc[i]) / CHECK_STEP / limit.jerk[i]);
+            previous_angacc[i] = angacc[i];
+        }
+    }
+
+    printf("jerk limited trajectory (%d waypoints) (checksum %.3f)\n", WAYPOINT_NUM, checksum);
+    printf("  plan %8.2f [ns/call]  evaluate %8.2f [ns/call]\n", plan_time, evaluate_time);
+    printf("  peak / limit: velocity %.3f  acceleration %.3f  jerk %.3f\n", velocity_ratio, acceleration_ratio, jerk_ratio);
+
+    // settling time on the simulator (lockstep): fixed profile velocity of the servo motors against streamed S-curve
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        operating_mode[i] = POSITION_CONTROL_MODE;
+        fixed_profile[i] = profile_velocity;
+    }
+    setenv("CRANE_X7_SIM_STEP", SIM_STEP, 1);
+    if (initilizeCranex7(operating_mode))
+    {
+        return 1;
+    }
+    setCranex7TorqueEnable(TORQUE_ENABLE);
+    printf("settling time on the simulator [s] : S-curve (streamed) / fixed profile velocity (%.3f [rad/s])\n", profile_velocity);
+    for (int n = 0; n < trajectory.segment_num; n++)
+    {
+        double step = atof(SIM_STEP), scurve, fixed;
+        TRAJECTORY_SEGMENT back;
+
+        setCranex7ProfileVelocity(fixed_profile);
+        fixed = settleMove(&trajectory.segment[n], step, 0);
+        // back to the start waypoint, then the same move with the S-curve
+        back = trajectory.segment[n];
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            back.start[i] += back.delta[i];
+            back.delta[i] = -back.delta[i];
+        }
+        settleMove(&back, step, 0);
+        setCranex7ProfileVelocity(zero);
+        scurve = settleMove(&trajectory.segment[n], step, 1);
+        scurve_total += scurve;
+        fixed_total += fixed;
+        printf("  move %d : %6.3f / %6.3f\n", n + 1, scurve, fixed);
+    }
+    printf("  total  : %6.3f / %6.3f (%.1f%% %s)\n", scurve_total, fixed_total, 100.0 * fabs(1.0 - scurve_total / fixed_total),
+           (scurve_total > fixed_total) ? "longer" : "shorter");
+    printf("  demos : %6.3f holding each target for %.1f [s] -> %6.3f streaming the S-curve with %.1f [s] settle\n",
+           DEMO_HOLD_TIME * trajectory.segment_num, DEMO_HOLD_TIME,
+           trajectory.duration + DEMO_SETTLE_TIME * trajectory.segment_num, DEMO_SETTLE_TIME);
+
+    // streaming the whole trajectory at the control rate
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        home[0][i] = waypoint[WAYPOINT_NUM - 1][i];
+        home[1][i] = waypoint[0][i];
+    }
+    planTrajectory(&homing, home, 2, &limit);
+    settleMove(&homing.segment[0], atof(SIM_STEP), 0);
+    tracking_error = 0;
+    getDefaultControlLoopConfig(&loop_config, STREAM_FREQUENCY);
+    if (runTrajectory(&trajectory, &loop_config, streamOutput, &loop_stats))
+    {
+        closeCranex7Port();
+        return 1;
+    }
+    printControlLoopStats(&loop_stats);
+    printf("  max tracking error while streaming %.4f [rad]\n", tracking_error);
+    closeCranex7Port();
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file bench_util.c
+ * @brief Timing and statistics helpers for benchmark programs
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench_util.h"
+
+/**
+ * @fn static int compareDouble(const void *, const void *)
+ * @brief Comparison function for qsort
+ */
+static int compareDouble(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * @fn uint64_t getBenchTimeNs(void)
+ * @brief Get monotonic time
+ * @return time[ns]
+ */
+uint64_t getBenchTimeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @fn void summarizeBenchSamples(double *, int, BENCH_RESULT *)
+ * @brief Calculate statistics of samples (samples are sorted in place)
+ * @param[in,out] samples[] measured values [ns]
+ * @param[in] num number of samples
+ * @param[out] *result summary of samples
+ */
+void summarizeBenchSamples(double *samples, int num, BENCH_RESULT *result)
+{
+    double sum = 0;
+
+    result->samples = num;
+    if (num <= 0)
+    {
+        result->min = result->median = result->mean = result->p99 = result->max = 0;
+        return;
+    }
+    qsort(samples, num, sizeof(double), compareDouble);
+    for (int i = 0; i < num; i++)
+    {
+        sum += samples[i];
+    }
+    result->min = samples[0];
+    result->median = samples[num / 2];
+    result->mean = sum / num;
+    result->p99 = samples[(int)((num - 1) * 0.99)];
+    result->max = samples[num - 1];
+}
+
+/**
+ * @fn void printBenchResult(const char *, BENCH_RESULT *)
+ * @brief Print summary of samples
+ * @param[in] *name name of measured item
+ * @param[in] *result summary of samples
+ */
+void printBenchResult(const char *name, BENCH_RESULT *result)
+{
+    printf("%-32s n=%-7d min=%10.0f median=%10.0f mean=%10.0f p99=%10.0f max=%10.0f [ns]\n",
+           name, result->samples, result->min, result->median, result->mean, result->p99, result->max);
+}
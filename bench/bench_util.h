@@ -0,0 +1,47 @@
+/**
+ * @file bench_util.h
+ * @brief Timing and statistics helpers for benchmark programs
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <stdint.h>
+
+//// Structure definition ////
+/**
+ * @struct BENCH_RESULT
+ * @brief Summary of measured samples [ns]
+ */
+typedef struct
+{
+    int samples;   // number of samples
+    double min;    // minimum
+    double median; // median
+    double mean;   // mean
+    double p99;    // 99th percentile
+    double max;    // maximum
+} BENCH_RESULT;
+
+//// Prototype declaration ////
+uint64_t getBenchTimeNs(void);
+void summarizeBenchSamples(double *, int, BENCH_RESULT *);
+void printBenchResult(const char *, BENCH_RESULT *);
+
+#endif
@@ -20,20 +20,69 @@
 // limitations under the License.
 
 #include <stdio.h>
-#include <unistd.h>
 #include "../common/crane_x7_comm.h"
+#include "../common/control_loop.h"
+
+#define CONTROL_FREQUENCY (100.0) //制御周波数[Hz]
+#define HOLD_TIME (3.0)           //1つの目標角度を保持する時間[s]
+#define HOLD_CYCLES ((uint64_t)(HOLD_TIME * CONTROL_FREQUENCY))
+
+static double *target_angle;                                                      //目標角度
+static double target_angle1[JOINT_NUM] = {0};                                     //目標角度1
+static double target_angle2[JOINT_NUM] = {0, 1.57, 0, 0, 0, 0, 0, 0};             //目標角度2
+static double target_angle3[JOINT_NUM] = {0.78, 1.57, 0.78, 0, 0.78, 0, 0.78, 0}; //目標角度3
+static double target_angle4[JOINT_NUM] = {0, 1.57, 0, 0.78, 0, 0, 0, 0};          //目標角度4
+
+static int state = 0; //目標位置を切り替えるための変数
+static int cnt = 0;   //目標角度の切り替え回数
+
+/**
+ * @fn static int controlCallback(uint64_t, double, void *)
+ * @brief 制御周期毎に呼ばれる関数。HOLD_TIME毎に目標角度を切り替える
+ * @return 0:継続, 1:終了
+ */
+static int controlCallback(uint64_t cycle, double time, void *user_data)
+{
+  if (cycle % HOLD_CYCLES != 0)
+  {
+    return 0;
+  }
+  if (cnt >= 5)
+  { //5回切り替えたらループを終了する
+    return 1;
+  }
+  cnt++;
+  setCranex7Angle(target_angle);
+
+  //target_angleを変更
+  if (state == 0)
+  {
+    state = 1;
+    target_angle = target_angle2;
+  }
+  else if (state == 1)
+  {
+    state = 2;
+    target_angle = target_angle3;
+  }
+  else if (state == 2)
+  {
+    state = 3;
+    target_angle = target_angle4;
+  }
+  else
+  {
+    state = 0;
+    target_angle = target_angle1;
+  }
+  return 0;
+}
 
 int main()
 {
   uint8_t operating_mode[JOINT_NUM] = {POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE};
-  double *target_angle;                                                      //目標角度
-  double target_angle1[JOINT_NUM] = {0};                                     //目標角度1
-  double target_angle2[JOINT_NUM] = {0, 1.57, 0, 0, 0, 0, 0, 0};             //目標角度2
-  double target_angle3[JOINT_NUM] = {0.78, 1.57, 0.78, 0, 0.78, 0, 0.78, 0}; //目標角度3
-  double target_angle4[JOINT_NUM] = {0, 1.57, 0, 0.78, 0, 0, 0, 0};          //目標角度4
-
-  int state = 0; //目標位置を切り替えるための変数
-  int cnt = 0;   //ループカウント
+  CONTROL_LOOP_CONFIG loop_config; //制御ループの設定
+  CONTROL_LOOP_STATS loop_stats;   //制御ループの周期統計
 
   printf("Press any key to start (or press q to quit)\n");
   if (getchar() == ('q'))
@@ -48,36 +97,10 @@ int main()
   setCranex7TorqueEnable(TORQUE_ENABLE);
 
   target_angle = target_angle1;
-  // main関数のループ
-  while (cnt < 5)
-  { //10回繰り返したらプログラムを終了する
-    cnt++;
-    setCranex7Angle(target_angle);
-
-    sleep(3);
-
-    //target_angleを変更
-    if (state == 0)
-    {
-      state = 1;
-      target_angle = target_angle2;
-    }
-    else if (state == 1)
-    {
-      state = 2;
-      target_angle = target_angle3;
-    }
-    else if (state == 2)
-    {
-      state = 3;
-      target_angle = target_angle4;
-    }
-    else
-    {
-      state = 0;
-      target_angle = target_angle1;
-    }
-  } //end main while
+  // 一定周期の制御ループ
+  getDefaultControlLoopConfig(&loop_config, CONTROL_FREQUENCY);
+  runControlLoop(&loop_config, controlCallback, NULL, &loop_stats);
+  printControlLoopStats(&loop_stats);
 
   brakeCranex7Joint(); //CRANE X7をブレーキにして終了
   closeCranex7Port();  //シリアルポートを閉じる
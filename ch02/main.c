@@ -20,27 +20,132 @@
 // limitations under the License.
 
 #include <stdio.h>
-#include <unistd.h>
+#include <stdlib.h>
 #include "../common/crane_x7_comm.h"
+#include "../common/control_loop.h"
+#include "../common/telemetry.h"
+#include "../common/trajectory.h"
 #include "myCX7_KDL_library.h"
 
-int main()
+#define CONTROL_FREQUENCY (100.0) //制御周波数[Hz]
+#define SETTLE_TIME (0.5)         //軌道の終了後、目標位置に収束するまで待つ時間[s]
+#define MOVE_NUM (9)              //目標位置間の移動回数
+
+static VECTOR_3D target_pos = {0};              //目標位置格納用の変数
+static VECTOR_3D target_pos1 = {0.25, 0.15, 0}; //目標位置1
+static VECTOR_3D target_pos2 = {0.35, 0.15, 0}; //目標位置2
+static VECTOR_3D target_pos3 = {0.35, 0.25, 0}; //目標位置3
+static VECTOR_3D target_pos4 = {0.25, 0.25, 0}; //目標位置4
+static VECTOR_3D present_pos = {0};             //現在位置格納用の変数
+
+static double target_theta[JOINT_NUM] = {0};    //目標角度格納用の変数
+static double present_theta[JOINT_NUM] = {0};   //現在角度を格納する変数
+static double present_angvel[JOINT_NUM] = {0};  //現在速度を格納する変数
+static double present_current[JOINT_NUM] = {0}; //現在トルクを格納する変数
+
+static TELEMETRY telemetry;       //全周期の関節状態の記録
+static int telemetry_enabled = 0; //1:環境変数CRANE_X7_TELEMETRYのファイルに記録する
+
+static TRAJECTORY trajectory;  //目標位置間の軌道
+static TRAJECTORY_LIMIT limit; //軌道の速度・加速度・躍度の上限
+static double move_start = 0;  //移動を開始した時刻[s]
+
+static int state = 0; //目標位置を切り替えるための変数
+static int cnt = 0;   //目標位置の切り替え回数
+
+/**
+ * @fn static int startMove(double)
+ * @brief 現在の目標角度からtarget_posまでの躍度制限付き軌道を計画する
+ * @return 0:成功, 1:失敗
+ */
+static int startMove(double time)
 {
-  uint8_t operating_mode[JOINT_NUM] = {POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE};
-  VECTOR_3D target_pos = {0};              //目標位置格納用の変数
-  VECTOR_3D target_pos1 = {0.25, 0.15, 0}; //目標位置1
-  VECTOR_3D target_pos2 = {0.35, 0.15, 0}; //目標位置2
-  VECTOR_3D target_pos3 = {0.35, 0.25, 0}; //目標位置3
-  VECTOR_3D target_pos4 = {0.25, 0.25, 0}; //目標位置4
-  VECTOR_3D present_pos = {0};             //現在位置格納用の変数
+  double waypoint[2][JOINT_NUM];
+
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    waypoint[0][i] = target_theta[i];
+  }
+  if (inverseKinematics2Dof(target_pos, waypoint[1]))
+  {
+    return 1;
+  }
+  move_start = time;
+  return planTrajectory(&trajectory, waypoint, 2, &limit);
+}
+
+/**
+ * @fn static int controlCallback(uint64_t, double, void *)
+ * @brief 制御周期毎に呼ばれる関数。毎周期関節状態を取得して軌道上の目標角度を送信し、軌道の終了からSETTLE_TIME後に目標位置を切り替える
+ * @return 0:継続, 1:終了
+ */
+static int controlCallback(uint64_t cycle, double time, void *user_data)
+{
+  getCranex7JointState(present_theta, present_angvel, present_current);
+  if (telemetry_enabled)
+  { //制御周期を乱さないよう、ファイルへの書き込みは別スレッドで行う
+    recordTelemetry(&telemetry, cycle, time, target_theta, present_theta, present_angvel, present_current);
+  }
+  if (cycle == 0)
+  { //現在角度から最初の目標位置への移動を開始する
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+      target_theta[i] = present_theta[i];
+    }
+    if (startMove(time))
+    {
+      return 1;
+    }
+  }
+  if (time - move_start < trajectory.duration + SETTLE_TIME)
+  { //軌道の終了後は最後の目標角度を送り続ける
+    evaluateTrajectory(&trajectory, time - move_start, target_theta, NULL, NULL);
+    setCranex7Angle(target_theta);
+    return 0;
+  }
 
-  double target_theta[JOINT_NUM] = {0};    //目標角度格納用の変数
-  double present_theta[JOINT_NUM] = {0};   //現在角度を格納する変数
-  double present_angvel[JOINT_NUM] = {0};  //現在速度を格納する変数
-  double present_current[JOINT_NUM] = {0}; //現在トルクを格納する変数
+  forwardKinematics2Dof(&present_pos, present_theta);
+  printf("Target position [x y]:[%lf %lf]\n", target_pos.x, target_pos.y);
+  printf("Present position [x y]:[%lf %lf]\n", present_pos.x, present_pos.y);
 
-  int state = 0; //目標位置を切り替えるための変数
-  int cnt = 0;   //ループのカウント
+  cnt++;
+  if (cnt >= MOVE_NUM)
+  { //MOVE_NUM回移動したらループを終了する
+    printf("%d moves in %.2f [s]\n", MOVE_NUM, time);
+    return 1;
+  }
+
+  //target_angleを変更
+  if (state == 0)
+  {
+    state = 1;
+    target_pos = target_pos2;
+  }
+  else if (state == 1)
+  {
+    state = 2;
+    target_pos = target_pos3;
+  }
+  else if (state == 2)
+  {
+    state = 3;
+    target_pos = target_pos4;
+  }
+  else
+  {
+    state = 0;
+    target_pos = target_pos1;
+  }
+  return startMove(time);
+}
+
+int main()
+{
+  uint8_t operating_mode[JOINT_NUM] = {POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE, POSITION_CONTROL_MODE};
+  CONTROL_LOOP_CONFIG loop_config; //制御ループの設定
+  CONTROL_LOOP_STATS loop_stats;   //制御ループの周期統計
+  double zero[JOINT_NUM] = {0};    //プロファイル速度0（無効）
+  const char *telemetry_file = getenv(TELEMETRY_ENV);
 
   printf("Press any key to start (or press q to quit)\n");
   if (getchar() == ('q'))
@@ -56,49 +161,27 @@ int main()
   }
   // CRANE-X7のトルクON
   setCranex7TorqueEnable(TORQUE_ENABLE);
+  // 目標角度を毎周期送信するので、サーボモータのプロファイル速度を無効にする
+  setCranex7ProfileVelocity(zero);
+  getDefaultTrajectoryLimit(&limit);
 
   target_pos = target_pos1;
 
-  // main関数のループ
-  while (cnt < 9)
-  { //10回繰り返したらプログラムを終了する
-    cnt++;
-
-    if (inverseKinematics2Dof(target_pos, target_theta))
-    {
-      break;
-    }
-    setCranex7Angle(target_theta);
-
-    sleep(3);
+  // 関節状態の記録の開始
+  if ((telemetry_file != NULL) && (openTelemetry(&telemetry, telemetry_file, 0) == 0))
+  {
+    telemetry_enabled = 1;
+  }
 
-    getCranex7JointState(present_theta, present_angvel, present_current);
-    forwardKinematics2Dof(&present_pos, present_theta);
-    printf("Target position [x y]:[%lf %lf]\n", target_pos.x, target_pos.y);
-    printf("Present position [x y]:[%lf %lf]\n", present_pos.x, present_pos.y);
+  // 一定周期の制御ループ
+  getDefaultControlLoopConfig(&loop_config, CONTROL_FREQUENCY);
+  runControlLoop(&loop_config, controlCallback, NULL, &loop_stats);
+  printControlLoopStats(&loop_stats);
 
-    //target_angleを変更
-    if (state == 0)
-    {
-      state = 1;
-      target_pos = target_pos2;
-    }
-    else if (state == 1)
-    {
-      state = 2;
-      target_pos = target_pos3;
-    }
-    else if (state == 2)
-    {
-      state = 3;
-      target_pos = target_pos4;
-    }
-    else
-    {
-      state = 0;
-      target_pos = target_pos1;
-    }
-  } //end main while
+  if (telemetry_enabled)
+  {
+    closeTelemetry(&telemetry);
+  }
 
   brakeCranex7Joint(); //CRANE X7をブレーキにして終了
   closeCranex7Port();  //シリアルポートを閉じる
@@ -142,4 +142,125 @@ int inverseKinematics3Dof(VECTOR_3D p, double *theta)
         }
     }
     return 0;
-}
\ No newline at end of file
+}
+
+//// 配列一括版の運動学 ////
+//ループ内で分岐・ライブラリ関数呼び出しを行わないことで、コンパイラの自動ベクトル化（SIMD化）を可能にする
+//sin/cos/atan2は多項式近似（誤差はdoubleの数ulp程度）で計算する
+
+#define PIO2_1 (1.57079632673412561417e+00)  //π/2の上位33bit
+#define PIO2_1T (6.07710050650619224932e-11) //π/2 - PIO2_1
+#define TWO_OVER_PI (6.36619772367581382433e-01)
+#define ROUND_MAGIC (6755399441055744.0) //2^52 + 2^51、加算・減算で最近接の整数に丸める
+#define M_PI_DOUBLE (3.14159265358979311600e+00)
+#define M_PI_2_DOUBLE (1.57079632679489655800e+00)
+#define M_PI_4_DOUBLE (7.85398163397448278999e-01)
+
+//|r| <= π/4 におけるsin, cos
+static inline double kernelSin(double r)
+{
+    double z = r * r;
+    return r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06 + z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+}
+
+static inline double kernelCos(double r)
+{
+    double z = r * r;
+    return 1.0 - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 + z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 + z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+}
+
+//sin, cosを同時に計算する（関節角度程度の大きさの入力を想定）
+static inline void batchSinCos(double x, double *s, double *c)
+{
+    double k = (x * TWO_OVER_PI + ROUND_MAGIC) - ROUND_MAGIC;
+    double r = (x - k * PIO2_1) - k * PIO2_1T;
+    int q = (int)k & 3;
+    double sr = kernelSin(r);
+    double cr = kernelCos(r);
+
+    *s = (q & 1) ? cr : sr;
+    *c = (q & 1) ? sr : cr;
+    *s = (q & 2) ? -*s : *s;
+    *c = ((q + 1) & 2) ? -*c : *c;
+}
+
+//atan2（Cephesのatanの有理関数近似を使用）
+static inline double batchAtan2(double y, double x)
+{
+    double ax = fabs(x);
+    double ay = fabs(y);
+    double num = (ax < ay) ? ax : ay;
+    double den = (ax < ay) ? ay : ax;
+    double t = num / ((den > 0) ? den : 1.0); // 0 <= t <= 1
+    double reduce = (t > 0.66) ? 1.0 : 0.0;
+    double u = (t - reduce) / (1.0 + reduce * t);
+    double z = u * u;
+    double p = (((-8.750608600031904122785e-01 * z - 1.615753718733365076637e+01) * z - 7.500855792314704667340e+01) * z - 1.228866684490136173410e+02) * z - 6.485021904942025371773e+01;
+    double q = ((((z + 2.485846490142306297962e+01) * z + 1.650270098316988542046e+02) * z + 4.328810604912902668951e+02) * z + 4.853903996359136964868e+02) * z + 1.945506571482613964425e+02;
+    double a = reduce * (M_PI_4_DOUBLE + 3.061616997868382943065e-17) + (u + u * z * p / q);
+
+    a = (ax < ay) ? M_PI_2_DOUBLE - a : a;
+    a = (x < 0) ? M_PI_DOUBLE - a : a;
+    return (y < 0) ? -a : a;
+}
+
+//n点の関節角度[θ1 θ2 θ3]（theta[0], theta[1], theta[3]に相当）から手先位置[x y z]を一括計算する
+__attribute__((target_clones("avx512f", "avx2", "default"))) int forwardKinematics3DofBatch(int n, const double *restrict theta1, const double *restrict theta2, const double *restrict theta3, double *restrict x, double *restrict y, double *restrict z)
+{
+    double L2 = link_parameter_3dof[1].length;
+    double L3 = link_parameter_3dof[2].length;
+
+    for (int i = 0; i < n; i++)
+    {
+        double S1, C1, S2, C2, S23, C23;
+
+        batchSinCos(theta1[i], &S1, &C1);
+        batchSinCos(theta2[i], &S2, &C2);
+        batchSinCos(theta2[i] + theta3[i], &S23, &C23);
+
+        x[i] = C1 * (L2 * C2 + L3 * C23);
+        y[i] = S1 * (L2 * C2 + L3 * C23);
+        z[i] = L2 * S2 + L3 * S23;
+    }
+    return 0;
+}
+
+//n点の手先位置[x y z]から関節角度[θ1 θ2 θ3]を一括計算する
+//status[i]にKINEMATICS_OK以外が入った点の関節角度は無効、戻り値は失敗した点の数
+__attribute__((target_clones("avx512f", "avx2", "default"))) int inverseKinematics3DofBatch(int n, const double *restrict x, const double *restrict y, const double *restrict z, double *restrict theta1, double *restrict theta2, double *restrict theta3, int *restrict status)
+{
+    double L2 = link_parameter_3dof[1].length;
+    double L3 = link_parameter_3dof[2].length;
+    double r2_min = (L2 - L3) * (L2 - L3);
+    double r2_max = (L2 + L3) * (L2 + L3);
+    int failed = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        double rxy = sqrt(x[i] * x[i] + y[i] * y[i]);
+        double r2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        double C3 = (r2 - L2 * L2 - L3 * L3) / (2 * L2 * L3);
+        double S3 = 1.0 - C3 * C3;
+        double C2, S2, t1, t2, t3;
+        int in_reach = (r2_min <= r2) & (r2 <= r2_max);
+        int in_range;
+
+        //acos(C3)をatan2で計算、CRANE-X7においてθ3の可動はマイナス方向のみ
+        S3 = (S3 > 0.0) ? S3 : 0.0; //可動範囲外の点でもsqrtの引数を負にしない
+        S3 = -sqrt(S3);
+        C2 = (L2 + L3 * C3) * rxy + (L3 * S3) * z[i];
+        S2 = -(L3 * S3) * rxy + (L2 + L3 * C3) * z[i];
+
+        t1 = batchAtan2(y[i], x[i]);
+        t2 = batchAtan2(S2, C2);
+        t3 = batchAtan2(S3, C3);
+        in_range = (joint_range[0].min <= t1) & (t1 <= joint_range[0].max) & (joint_range[1].min <= t2) & (t2 <= joint_range[1].max) & (joint_range[3].min <= t3) & (t3 <= joint_range[3].max);
+
+        theta1[i] = t1;
+        theta2[i] = t2;
+        theta3[i] = t3;
+        status[i] = in_reach ? (in_range ? KINEMATICS_OK : KINEMATICS_OUT_OF_JOINT_RANGE) : KINEMATICS_OUT_OF_REACH;
+        failed += (status[i] != KINEMATICS_OK);
+    }
+    return failed;
+}
@@ -17,6 +17,11 @@
 
 #include "../common/matrix.h"
 
+//// Status of batch kinematics ////
+#define KINEMATICS_OK (0)
+#define KINEMATICS_OUT_OF_REACH (1)
+#define KINEMATICS_OUT_OF_JOINT_RANGE (2)
+
 void initParam(void);
 
 //// Functions related to kinematics ////
@@ -24,5 +29,7 @@ int forwardKinematics2Dof(VECTOR_3D *, double *);
 int inverseKinematics2Dof(VECTOR_3D, double *);
 int forwardKinematics3Dof(VECTOR_3D *, double *);
 int inverseKinematics3Dof(VECTOR_3D, double *);
+int forwardKinematics3DofBatch(int, const double *, const double *, const double *, double *, double *, double *);
+int inverseKinematics3DofBatch(int, const double *, const double *, const double *, double *, double *, double *, int *);
 
 #endif
\ No newline at end of file
@@ -84,6 +84,27 @@ void getLinkParam3Dof(LINK_PARAM *link_parameter)
         }
 }
 
+/**
+ * @fn void getLinkParam7Dof(LINK_PARAM *)
+ * @brief get physical parameter of CRANE-X7 as 7 degrees of freedom arm (link i moves with joint i).
+ *        Each link extends its length to the next bending joint (along z for the 1st link, along x for others).
+ *        The twist joints (3, 5, 7) lie on the link axis, so their links have no length.
+ *        The mass of the links is lumped as in 3DOF: the upper arm moves with joint 2 and the lower arm with hand moves with joint 4.
+ * @param[out] *link_parameter
+ */
+void getLinkParam7Dof(LINK_PARAM *link_parameter)
+{
+        const LINK_PARAM empty_link = {0};
+
+        for (int i = 0; i < LINK_NUM_7DOF; i++)
+        {
+                link_parameter[i] = empty_link;
+        }
+        link_parameter[0] = link_parameter_3dof[0]; //shoulder (joint 1 - joint 2)
+        link_parameter[1] = link_parameter_3dof[1]; //upper arm (joint 2 - joint 4)
+        link_parameter[3] = link_parameter_3dof[2]; //lower arm and hand (joint 4 - joint 6)
+}
+
 void getJointRange(JOINT_RANGE *joint_parameter)
 {
         int i;
@@ -26,10 +26,12 @@
 
 #define LINK_NUM_2DOF (2)
 #define LINK_NUM_3DOF (3)
+#define LINK_NUM_7DOF (7)
 
 #ifndef JOINT_NUM
 #define JOINT_NUM (8)
 #endif
+#define XM540_W270_JOINT (1) // only 2nd joint servo motor is XM540_W270 (other XM430_W350)
 
 //// Structure definition ////
 /**
@@ -69,6 +71,7 @@ typedef struct
 void getLinkParamBase(LINK_PARAM *);
 void getLinkParam2Dof(LINK_PARAM *);
 void getLinkParam3Dof(LINK_PARAM *);
+void getLinkParam7Dof(LINK_PARAM *);
 void getJointRange(JOINT_RANGE *);
 
 #endif
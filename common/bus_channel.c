@@ -0,0 +1,202 @@
+/**
+ * @file bus_channel.c
+ * @brief Bus thread of CRANE-X7 and lock-free channels of the command and the joint state between the bus thread and a planner thread
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+#include "bus_channel.h"
+
+#define BUS_CHANNEL_FRESH (0x4) // flag of BUS_TRIPLE_BUFFER.latest: the latest slot has not been taken by the reader
+#define BUS_CHANNEL_SLOT_MASK (0x3)
+
+/**
+ * @fn static void initTripleBuffer(BUS_TRIPLE_BUFFER *)
+ * @brief Slot 0 is written, slot 1 is read, slot 2 is the latest (nothing is published yet)
+ */
+static void initTripleBuffer(BUS_TRIPLE_BUFFER *buffer)
+{
+  buffer->write_slot = 0;
+  buffer->read_slot = 1;
+  buffer->latest = 2;
+}
+
+/**
+ * @fn static void publishSlot(BUS_TRIPLE_BUFFER *)
+ * @brief Writer: publish the written slot as the latest value and take the old latest slot to write the next value
+ */
+static void publishSlot(BUS_TRIPLE_BUFFER *buffer)
+{
+  uint32_t previous = __atomic_exchange_n(&buffer->latest, (uint32_t)buffer->write_slot | BUS_CHANNEL_FRESH, __ATOMIC_ACQ_REL);
+
+  buffer->write_slot = (int)(previous & BUS_CHANNEL_SLOT_MASK);
+}
+
+/**
+ * @fn static int takeSlot(BUS_TRIPLE_BUFFER *)
+ * @brief Reader: take the latest slot if the writer has published a new value since the last take
+ * @return 1: read_slot holds a new value, 0: read_slot is not changed
+ */
+static int takeSlot(BUS_TRIPLE_BUFFER *buffer)
+{
+  uint32_t previous;
+
+  if (!(__atomic_load_n(&buffer->latest, __ATOMIC_RELAXED) & BUS_CHANNEL_FRESH))
+    return 0;
+  previous = __atomic_exchange_n(&buffer->latest, (uint32_t)buffer->read_slot, __ATOMIC_ACQ_REL);
+  buffer->read_slot = (int)(previous & BUS_CHANNEL_SLOT_MASK);
+  return 1;
+}
+
+/**
+ * @fn static int busCycle(uint64_t, double, void *)
+ * @brief Control loop callback of the bus thread: send the latest command and publish the joint state
+ */
+static int busCycle(uint64_t cycle, double time, void *user_data)
+{
+  BUS_CHANNEL *channel = (BUS_CHANNEL *)user_data;
+  BUS_COMMAND *command;
+  BUS_STATE *state = &channel->state[channel->state_buffer.write_slot];
+  int failed;
+
+  if (__atomic_load_n(&channel->stopping, __ATOMIC_ACQUIRE))
+    return 1;
+  // the slot taken last is kept until the planner publishes a newer command
+  takeSlot(&channel->command_buffer);
+  command = &channel->command[channel->command_buffer.read_slot];
+  if (command->sequence == BUS_CHANNEL_NO_COMMAND)
+    failed = getCranex7ArmJointState(channel->arm, state->angle, state->angvel, state->torque);
+  else
+    failed = cycleCranex7Arm(channel->arm, command->command, state->angle, state->angvel, state->torque);
+  if (failed)
+    channel->comm_failures++;
+  state->time = time;
+  state->cycle = cycle;
+  state->sequence = command->sequence;
+  state->comm_failures = channel->comm_failures;
+  publishSlot(&channel->state_buffer);
+  return 0;
+}
+
+/**
+ * @fn static void *busThread(void *)
+ * @brief Bus thread: run the bus cycle at the control rate until stopBusChannel
+ */
+static void *busThread(void *arg)
+{
+  BUS_CHANNEL *channel = (BUS_CHANNEL *)arg;
+
+  channel->result = runControlLoop(&channel->config, busCycle, channel, &channel->stats);
+  return NULL;
+}
+
+/**
+ * @fn int startBusChannel(BUS_CHANNEL *, CONTROL_LOOP_CONFIG *)
+ * @brief Start the bus thread of the arm opened by initilizeCranex7 (see startBusChannelArm)
+ * @param[out] *channel channel to be started
+ * @param[in] *config setting of the control loop of the bus thread (getDefaultControlLoopConfig)
+ * @return 0: success, 1: failure
+ */
+int startBusChannel(BUS_CHANNEL *channel, CONTROL_LOOP_CONFIG *config)
+{
+  return startBusChannelArm(channel, getDefaultCranex7Arm(), config);
+}
+
+/**
+ * @fn int startBusChannelArm(BUS_CHANNEL *, CRANE_X7_ARM *, CONTROL_LOOP_CONFIG *)
+ * @brief Start the bus thread which owns the serial port of the arm (openCranex7Arm and setCranex7ArmTorqueEnable must be called before).
+ *        Every cycle it sends the latest published command with cycleCranex7Arm (only reads the joint state until the first command)
+ *        and publishes the joint state. Until stopBusChannel, no other thread may call the functions of crane_x7_comm.h for the arm.
+ *        One planner thread publishes commands and reads the state, and neither side waits for the other.
+ *        Each arm can have its own bus thread (open all arms before starting them).
+ * @param[out] *channel channel to be started
+ * @param[in] *arm opened arm
+ * @param[in] *config setting of the control loop of the bus thread (getDefaultControlLoopConfig)
+ * @return 0: success, 1: failure
+ */
+int startBusChannelArm(BUS_CHANNEL *channel, CRANE_X7_ARM *arm, CONTROL_LOOP_CONFIG *config)
+{
+  memset(channel, 0, sizeof(BUS_CHANNEL));
+  if (arm == NULL)
+  {
+    printf("Bus thread needs an opened arm\n");
+    return 1;
+  }
+  initTripleBuffer(&channel->command_buffer);
+  initTripleBuffer(&channel->state_buffer);
+  for (int i = 0; i < 3; i++)
+  {
+    channel->command[i].sequence = BUS_CHANNEL_NO_COMMAND;
+    channel->state[i].sequence = BUS_CHANNEL_NO_COMMAND;
+  }
+  channel->arm = arm;
+  channel->config = *config;
+  if (pthread_create(&channel->thread, NULL, busThread, channel) != 0)
+  {
+    printf("Failed to create bus thread\n");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @fn void publishBusCommand(BUS_CHANNEL *, const double *)
+ * @brief Planner: publish the command sent from the next bus cycle (wait-free, a newer command replaces one not sent yet)
+ * @param[in,out] *channel started channel
+ * @param[in] *command_array command of all joints (JOINT_NUM elements, meaning depends on the operating mode)
+ */
+void publishBusCommand(BUS_CHANNEL *channel, const double *command_array)
+{
+  BUS_COMMAND *command = &channel->command[channel->command_buffer.write_slot];
+
+  memcpy(command->command, command_array, sizeof(command->command));
+  command->sequence = channel->published++;
+  publishSlot(&channel->command_buffer);
+}
+
+/**
+ * @fn int readBusState(BUS_CHANNEL *, BUS_STATE *)
+ * @brief Planner: copy the latest joint state snapshot (wait-free)
+ * @param[in,out] *channel started channel
+ * @param[out] *state latest snapshot (cycle and sequence are 0 and BUS_CHANNEL_NO_COMMAND before the first bus cycle)
+ * @return 0: new snapshot since the last call, 1: the same snapshot as the last call
+ */
+int readBusState(BUS_CHANNEL *channel, BUS_STATE *state)
+{
+  int fresh = takeSlot(&channel->state_buffer);
+
+  *state = channel->state[channel->state_buffer.read_slot];
+  return fresh ? 0 : 1;
+}
+
+/**
+ * @fn int stopBusChannel(BUS_CHANNEL *, CONTROL_LOOP_STATS *)
+ * @brief Stop the bus thread (the port is kept open, and the servo motors hold the last command)
+ * @param[in,out] *channel started channel
+ * @param[out] *stats timing statistics of the bus thread (NULL: not needed)
+ * @return 0: success, 1: failure of the control loop
+ */
+int stopBusChannel(BUS_CHANNEL *channel, CONTROL_LOOP_STATS *stats)
+{
+  __atomic_store_n(&channel->stopping, 1, __ATOMIC_RELEASE);
+  pthread_join(channel->thread, NULL);
+  if (stats != NULL)
+    *stats = channel->stats;
+  return channel->result;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file bus_channel.h
+ * @brief Bus thread of CRANE-X7 and lock-free channels of the command and the joint state between the bus thread and a planner thread
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BUS_CHANNEL_H_
+#define BUS_CHANNEL_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include "crane_x7_comm.h"
+#include "control_loop.h"
+
+#define BUS_CHANNEL_CACHE_LINE (64)
+#define BUS_CHANNEL_NO_COMMAND (UINT64_MAX) // sequence of BUS_STATE before the first command
+
+//// Structure definition ////
+/**
+ * @struct BUS_COMMAND
+ * @brief Command of all joints (the meaning depends on the operating mode, see cycleCranex7Arm)
+ */
+typedef struct
+{
+  double command[JOINT_NUM]; // angle[rad], angular velocity[rad/s] or torque[Nm]
+  uint64_t sequence;         // number of commands published before this one
+} BUS_COMMAND;
+
+/**
+ * @struct BUS_STATE
+ * @brief Snapshot of the joint state read by the bus thread
+ */
+typedef struct
+{
+  double angle[JOINT_NUM];  // present angle [rad]
+  double angvel[JOINT_NUM]; // present angular velocity [rad/s]
+  double torque[JOINT_NUM]; // present torque [Nm]
+  double time;              // time of the bus cycle from the start of the bus thread [s]
+  uint64_t cycle;           // bus cycle count
+  uint64_t sequence;        // sequence of the command sent in this cycle (BUS_CHANNEL_NO_COMMAND: only the state was read)
+  uint64_t comm_failures;   // number of bus cycles failed so far
+} BUS_STATE;
+
+/**
+ * @struct BUS_TRIPLE_BUFFER
+ * @brief Slot indices of a triple buffer: the writer and the reader own one slot each, the third one holds the latest value.
+ *        Both sides only exchange their own slot with the latest one, so neither of them waits for the other.
+ */
+typedef struct
+{
+  int write_slot __attribute__((aligned(BUS_CHANNEL_CACHE_LINE))); // owned by the writer
+  int read_slot __attribute__((aligned(BUS_CHANNEL_CACHE_LINE)));  // owned by the reader
+  uint32_t latest __attribute__((aligned(BUS_CHANNEL_CACHE_LINE))); // slot of the latest value | BUS_CHANNEL_FRESH (atomic)
+} BUS_TRIPLE_BUFFER;
+
+/**
+ * @struct BUS_CHANNEL
+ * @brief Bus thread and its channels (members are private to bus_channel.c)
+ */
+typedef struct
+{
+  BUS_COMMAND command[3] __attribute__((aligned(BUS_CHANNEL_CACHE_LINE)));
+  BUS_STATE state[3] __attribute__((aligned(BUS_CHANNEL_CACHE_LINE)));
+  BUS_TRIPLE_BUFFER command_buffer; // planner -> bus thread
+  BUS_TRIPLE_BUFFER state_buffer;   // bus thread -> planner
+  uint64_t published;               // number of published commands (planner thread)
+  uint64_t comm_failures;           // (bus thread)
+  CRANE_X7_ARM *arm;                // arm driven by the bus thread
+  CONTROL_LOOP_CONFIG config;
+  CONTROL_LOOP_STATS stats;
+  pthread_t thread;
+  int stopping; // 1: the bus thread exits (atomic)
+  int result;   // return value of runControlLoop
+} BUS_CHANNEL;
+
+//// Prototype declaration ////
+int startBusChannel(BUS_CHANNEL *, CONTROL_LOOP_CONFIG *);
+int startBusChannelArm(BUS_CHANNEL *, CRANE_X7_ARM *, CONTROL_LOOP_CONFIG *);
+void publishBusCommand(BUS_CHANNEL *, const double *);
+int readBusState(BUS_CHANNEL *, BUS_STATE *);
+int stopBusChannel(BUS_CHANNEL *, CONTROL_LOOP_STATS *);
+
+#endif
@@ -0,0 +1,353 @@
+/**
+ * @file bus_timing.c
+ * @brief Timing of the serial bus of CRANE-X7 (latency timer of the USB serial converter, baud rate and return delay time)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/serial.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "bus_timing.h"
+#include "comm_stats.h"
+
+#define BUS_TIMING_LINE_LENGTH (4096)
+
+/**
+ * @fn static void getBusTimingPath(char *, size_t)
+ * @brief Path of the file of the timing (BUS_TIMING_ENV, or BUS_TIMING_FILE in the home directory)
+ */
+static void getBusTimingPath(char *path, size_t size)
+{
+  const char *env = getenv(BUS_TIMING_ENV);
+  const char *home = getenv("HOME");
+
+  if (env != NULL)
+    snprintf(path, size, "%s", env);
+  else
+    snprintf(path, size, "%s/%s", (home != NULL) ? home : ".", BUS_TIMING_FILE);
+}
+
+/**
+ * @fn static int parseBusTiming(const char *, const char *, BUS_TIMING *)
+ * @brief Parse a line of the file of the timing "serial_port baudrate return_delay_time latency_timer"
+ * @return 1: the line is the setting of the serial port, 0: other line
+ */
+static int parseBusTiming(const char *line, const char *serial_port, BUS_TIMING *timing)
+{
+  char port[BUS_TIMING_LINE_LENGTH];
+  unsigned int baudrate, return_delay_time;
+  int latency_timer;
+
+  if (sscanf(line, "%4095s %u %u %d", port, &baudrate, &return_delay_time, &latency_timer) != 4)
+    return 0;
+  if ((port[0] == '#') || (strcmp(port, serial_port) != 0))
+    return 0;
+  if (timing != NULL)
+  {
+    memset(timing, 0, sizeof(BUS_TIMING));
+    timing->baudrate = baudrate;
+    timing->return_delay_time = (uint8_t)return_delay_time;
+    timing->latency_timer = latency_timer;
+  }
+  return 1;
+}
+
+/**
+ * @fn int setSerialLowLatency(const char *, int)
+ * @brief Make the serial port pass the received bytes without delay:
+ *        ASYNC_LOW_LATENCY of the serial driver and the latency timer of the USB serial converter (ftdi_sio, 16ms by default).
+ *        The latency timer is written to /sys/class/tty/ttyUSB?/device/latency_timer, which usually needs the root privilege or a udev rule.
+ * @param[in] *serial_port device of the serial port (symbolic links like /dev/serial/by-id/... are resolved)
+ * @param[in] latency_timer latency timer [ms] (0: not changed)
+ * @return 0: success, 1: not changed (not a USB serial converter, or no permission)
+ */
+int setSerialLowLatency(const char *serial_port, int latency_timer)
+{
+  char device[PATH_MAX], path[PATH_MAX + 64];
+  struct serial_struct serial;
+  const char *name;
+  FILE *fp;
+  int fd, result = 0;
+
+  fd = open(serial_port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0)
+    return 1;
+  if (ioctl(fd, TIOCGSERIAL, &serial) == 0)
+  {
+    serial.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &serial) != 0)
+      result = 1;
+  }
+  else
+  {
+    result = 1; // not a serial driver (e.g. pseudo terminal of dxl_emulator)
+  }
+  close(fd);
+  if (latency_timer <= 0)
+    return result;
+
+  if (realpath(serial_port, device) == NULL)
+    return 1;
+  name = strrchr(device, '/');
+  snprintf(path, sizeof(path), "/sys/class/tty/%s/device/latency_timer", (name != NULL) ? name + 1 : device);
+  fp = fopen(path, "w");
+  if (fp == NULL)
+    return 1;
+  if (fprintf(fp, "%d\n", latency_timer) < 0)
+    result = 1;
+  if (fclose(fp) != 0)
+    result = 1;
+  return result;
+}
+
+/**
+ * @fn int loadBusTiming(const char *, BUS_TIMING *)
+ * @brief Read the timing of the serial port saved by saveBusTiming (used by openCranex7Arm)
+ * @param[in] *serial_port device of the serial port
+ * @param[out] *timing baud rate, return delay time and latency timer
+ * @return 0: success, 1: not saved
+ */
+int loadBusTiming(const char *serial_port, BUS_TIMING *timing)
+{
+  char path[PATH_MAX], line[BUS_TIMING_LINE_LENGTH];
+  FILE *fp;
+  int result = 1;
+
+  getBusTimingPath(path, sizeof(path));
+  fp = fopen(path, "r");
+  if (fp == NULL)
+    return 1;
+  while (result && (fgets(line, sizeof(line), fp) != NULL))
+  {
+    result = !parseBusTiming(line, serial_port, timing);
+  }
+  fclose(fp);
+  return result;
+}
+
+/**
+ * @fn int saveBusTiming(const char *, const BUS_TIMING *)
+ * @brief Write the timing of the serial port to the file (the settings of the other ports are kept).
+ *        The file is replaced atomically, so openCranex7Arm of other processes never reads a partial file.
+ * @param[in] *serial_port device of the serial port
+ * @param[in] *timing baud rate, return delay time and latency timer
+ * @return 0: success, 1: failure
+ */
+int saveBusTiming(const char *serial_port, const BUS_TIMING *timing)
+{
+  char path[PATH_MAX], temporary[PATH_MAX + 32], line[BUS_TIMING_LINE_LENGTH];
+  FILE *fp, *old;
+  int result = 0;
+
+  getBusTimingPath(path, sizeof(path));
+  snprintf(temporary, sizeof(temporary), "%s.%d.tmp", path, (int)getpid());
+  fp = fopen(temporary, "w");
+  if (fp == NULL)
+  {
+    printf("Failed to open %s\n", temporary);
+    return 1;
+  }
+  fprintf(fp, "# serial_port baudrate[bps] return_delay_time[2us] latency_timer[ms] (written by bus_tuner)\n");
+  old = fopen(path, "r");
+  if (old != NULL)
+  {
+    while (fgets(line, sizeof(line), old) != NULL)
+    {
+      if ((line[0] != '#') && !parseBusTiming(line, serial_port, NULL))
+        fputs(line, fp);
+    }
+    fclose(old);
+  }
+  if (fprintf(fp, "%s %u %u %d\n", serial_port, timing->baudrate, timing->return_delay_time, timing->latency_timer) < 0)
+    result = 1;
+  if (fclose(fp) != 0)
+    result = 1;
+  if ((result == 0) && (rename(temporary, path) != 0))
+    result = 1;
+  if (result)
+  {
+    printf("Failed to write %s\n", path);
+    unlink(temporary);
+  }
+  return result;
+}
+
+/**
+ * @fn void getDefaultBusTimingSweep(BUS_TIMING_SWEEP *)
+ * @brief Settings of tuneCranex7Bus: 1 - 4Mbps and return delay time 0 - 500us (the factory setting is 250 = 500us)
+ * @param[out] *sweep settings
+ */
+void getDefaultBusTimingSweep(BUS_TIMING_SWEEP *sweep)
+{
+  static const uint32_t baudrate[] = {1000000, 2000000, 3000000, 4000000};
+  static const uint8_t return_delay_time[] = {0, 2, 10, 50, 250};
+
+  memset(sweep, 0, sizeof(BUS_TIMING_SWEEP));
+  sweep->baudrate_num = sizeof(baudrate) / sizeof(baudrate[0]);
+  memcpy(sweep->baudrate, baudrate, sizeof(baudrate));
+  sweep->return_delay_time_num = sizeof(return_delay_time) / sizeof(return_delay_time[0]);
+  memcpy(sweep->return_delay_time, return_delay_time, sizeof(return_delay_time));
+  sweep->trials = 500;
+}
+
+/**
+ * @fn static int measureBusTiming(CRANE_X7_ARM *, int, BUS_TIMING *)
+ * @brief Round trip time of the bulk read of the present value (getCranex7ArmJointState) with the present setting
+ * @param[in,out] *arm arm (the communication statistics are reset)
+ * @param[in] trials number of bulk reads
+ * @param[in,out] *timing failures, median and p99 are set
+ * @return number of failed bulk reads
+ */
+static int measureBusTiming(CRANE_X7_ARM *arm, int trials, BUS_TIMING *timing)
+{
+  static COMM_STATS stats;
+  double angle[JOINT_NUM], angvel[JOINT_NUM], torque[JOINT_NUM];
+  int warmup_failures = 0;
+
+  for (int n = 0; n < BUS_TIMING_WARMUP; n++)
+  {
+    warmup_failures += getCranex7ArmJointState(arm, angle, angvel, torque);
+  }
+  timing->failures = 0;
+  timing->median = 0;
+  timing->p99 = 0;
+  if (warmup_failures == BUS_TIMING_WARMUP)
+  {
+    // no servo motor answers: skip the timeouts of the measurement
+    timing->failures = trials;
+    return trials;
+  }
+  resetCranex7ArmCommStats(arm);
+  for (int n = 0; n < trials; n++)
+  {
+    timing->failures += getCranex7ArmJointState(arm, angle, angvel, torque);
+  }
+  getCranex7ArmCommStats(arm, &stats);
+  timing->median = getCommLatencyPercentile(&stats.function[COMM_STATS_BULK_READ], 50);
+  timing->p99 = getCommLatencyPercentile(&stats.function[COMM_STATS_BULK_READ], 99);
+  return timing->failures;
+}
+
+/**
+ * @fn static int restoreBusTiming(CRANE_X7_ARM *, const BUS_TIMING_SWEEP *, const BUS_TIMING *)
+ * @brief Set the timing and check that all servo motors answer.
+ *        If they do not, the servo motors may have switched to a baud rate which the port cannot use reliably,
+ *        so the timing is sent again from each baud rate of the sweep.
+ * @return 0: success, 1: the servo motors are lost
+ */
+static int restoreBusTiming(CRANE_X7_ARM *arm, const BUS_TIMING_SWEEP *sweep, const BUS_TIMING *timing)
+{
+  BUS_TIMING check;
+
+  if ((setCranex7ArmBusTiming(arm, timing->baudrate, timing->return_delay_time) == 0) &&
+      (measureBusTiming(arm, BUS_TIMING_WARMUP, &check) == 0))
+    return 0;
+  for (int i = 0; i < sweep->baudrate_num; i++)
+  {
+    if (sweep->baudrate[i] == timing->baudrate)
+      continue;
+    setCranex7ArmBusTiming(arm, sweep->baudrate[i], timing->return_delay_time);
+    if ((setCranex7ArmBusTiming(arm, timing->baudrate, timing->return_delay_time) == 0) &&
+        (measureBusTiming(arm, BUS_TIMING_WARMUP, &check) == 0))
+      return 0;
+  }
+  printf("Failed to restore baudrate %u and return delay time %u\n", timing->baudrate, timing->return_delay_time);
+  return 1;
+}
+
+/**
+ * @fn int tuneCranex7Bus(CRANE_X7_ARM *, const BUS_TIMING_SWEEP *, BUS_TIMING *)
+ * @brief Measure the round trip time of the bulk read of the present value for each baud rate and return delay time,
+ *        and set the fastest reliable one (no failed bulk read, the lowest 99 percentile) to the port and the servo motors.
+ *        The baud rate and the return delay time are EEPROM registers: the torque must be disabled (as after openCranex7Arm),
+ *        and no other thread may use the arm during the sweep.
+ * @param[in,out] *arm opened arm
+ * @param[in] *sweep settings to be measured (getDefaultBusTimingSweep)
+ * @param[out] *best the fastest reliable setting (give it to saveBusTiming to use it from the next openCranex7Arm)
+ * @return 0: success, 1: no reliable setting (the baud rate and the return delay time of each servo motor before the sweep are restored) or the servo motors are lost
+ */
+int tuneCranex7Bus(CRANE_X7_ARM *arm, const BUS_TIMING_SWEEP *sweep, BUS_TIMING *best)
+{
+  CRANE_X7_ARM_CONFIG config;
+  BUS_TIMING timing, good;
+  uint8_t original_return_delay_time[JOINT_NUM];
+  int found = 0;
+
+  getCranex7ArmConfig(arm, &config);
+  if (getCranex7ArmReturnDelayTime(arm, original_return_delay_time))
+  {
+    printf("Failed to read the return delay time\n");
+    return 1;
+  }
+  // until a reliable setting is found, the present baud rate with the longest present return delay time is restored
+  memset(&good, 0, sizeof(BUS_TIMING));
+  good.baudrate = config.baudrate;
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    if (original_return_delay_time[i] > good.return_delay_time)
+      good.return_delay_time = original_return_delay_time[i];
+  }
+  good.latency_timer = config.latency_timer;
+  printf("baudrate[bps] return_delay[us]  failures  median[us]     p99[us]\n");
+  for (int i = 0; i < sweep->baudrate_num; i++)
+  {
+    for (int j = 0; j < sweep->return_delay_time_num; j++)
+    {
+      timing = good;
+      timing.baudrate = sweep->baudrate[i];
+      timing.return_delay_time = sweep->return_delay_time[j];
+      if (setCranex7ArmBusTiming(arm, timing.baudrate, timing.return_delay_time))
+      {
+        printf("%13u %16d  not supported\n", timing.baudrate, timing.return_delay_time * 2);
+        if (restoreBusTiming(arm, sweep, &good))
+          return 1;
+        break;
+      }
+      measureBusTiming(arm, sweep->trials, &timing);
+      printf("%13u %16d %9d %11.1f %11.1f\n", timing.baudrate, timing.return_delay_time * 2, timing.failures, timing.median * 1e-3, timing.p99 * 1e-3);
+      if ((timing.failures == 0) && (!found || (timing.p99 < best->p99)))
+      {
+        *best = timing;
+        good = timing;
+        found = 1;
+      }
+      if (timing.failures == sweep->trials)
+      {
+        // no answer at this baud rate: the other return delay times are skipped
+        if (restoreBusTiming(arm, sweep, &good))
+          return 1;
+        break;
+      }
+    }
+  }
+  if (restoreBusTiming(arm, sweep, &good))
+    return 1;
+  if (!found)
+  {
+    // the sweep broadcast one return delay time to all servo motors: each one gets its own value back
+    setCranex7ArmReturnDelayTime(arm, original_return_delay_time);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file bus_timing.h
+ * @brief Timing of the serial bus of CRANE-X7 (latency timer of the USB serial converter, baud rate and return delay time)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BUS_TIMING_H_
+#define BUS_TIMING_H_
+
+#include <stdint.h>
+#include "crane_x7_comm.h"
+
+#define BUS_TIMING_ENV "CRANE_X7_BUS_TIMING"   // Environment variable of the file of the timing saved by bus_tuner
+#define BUS_TIMING_FILE ".crane_x7_bus_timing" // file in the home directory (if BUS_TIMING_ENV is not set)
+#define BUS_TIMING_MAX_SETTINGS (16)           // maximum number of baud rates (or return delay times) of a sweep
+#define BUS_TIMING_WARMUP (10)                 // bulk reads discarded after each change of the setting
+
+//// Structure definition ////
+/**
+ * @struct BUS_TIMING
+ * @brief Timing setting of a serial port and the result of the measurement
+ */
+typedef struct
+{
+  uint32_t baudrate;         // baud rate of the port and the servo motors [bps]
+  uint8_t return_delay_time; // return delay time of the servo motors [2us]
+  int latency_timer;         // latency timer of the USB serial converter [ms]
+  int failures;              // number of failed bulk reads of the measurement
+  double median;             // median of the round trip time of the bulk read [ns]
+  double p99;                // 99 percentile of the round trip time of the bulk read [ns]
+} BUS_TIMING;
+
+/**
+ * @struct BUS_TIMING_SWEEP
+ * @brief Settings measured by tuneCranex7Bus (getDefaultBusTimingSweep)
+ */
+typedef struct
+{
+  uint32_t baudrate[BUS_TIMING_MAX_SETTINGS];          // baud rates [bps] (supported by the servo motors, see setCranex7ArmBusTiming)
+  int baudrate_num;
+  uint8_t return_delay_time[BUS_TIMING_MAX_SETTINGS]; // return delay times [2us]
+  int return_delay_time_num;
+  int trials; // number of bulk reads of each setting
+} BUS_TIMING_SWEEP;
+
+//// Prototype declaration ////
+int setSerialLowLatency(const char *, int);
+int loadBusTiming(const char *, BUS_TIMING *);
+int saveBusTiming(const char *, const BUS_TIMING *);
+void getDefaultBusTimingSweep(BUS_TIMING_SWEEP *);
+int tuneCranex7Bus(CRANE_X7_ARM *, const BUS_TIMING_SWEEP *, BUS_TIMING *);
+
+#endif
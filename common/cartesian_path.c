@@ -0,0 +1,436 @@
+/**
+ * @file cartesian_path.c
+ * @brief Cartesian straight line and circular arc path of the end effector streamed by incremental inverse kinematics
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <inttypes.h>
+#include <math.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "cartesian_path.h"
+
+#define QUINTIC_PEAK_VELOCITY (1.875) // peak of ds/dt of s = 10t^3 - 15t^4 + 6t^5 (0 <= t <= 1)
+
+/**
+ * @struct CARTESIAN_RUNNER
+ * @brief Arguments of the control loop callback of runCartesianPath
+ */
+typedef struct
+{
+    CARTESIAN_STREAM *stream;
+    TRAJECTORY_OUTPUT output;
+    int result;
+} CARTESIAN_RUNNER;
+
+/**
+ * @fn static double getVectorNorm(VECTOR_3D)
+ * @brief Norm of 3 dimentional vector
+ */
+static double getVectorNorm(VECTOR_3D vec)
+{
+    return sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
+}
+
+/**
+ * @fn static VECTOR_3D rotateAroundAxis(const CARTESIAN_SEGMENT *, double)
+ * @brief Start position of the arc rotated around its axis (Rodrigues' rotation formula)
+ */
+static VECTOR_3D rotateAroundAxis(const CARTESIAN_SEGMENT *segment, double angle)
+{
+    VECTOR_3D p = subVecVec3D(segment->start, segment->center);
+    VECTOR_3D k = segment->normal;
+    double kp = k.x * p.x + k.y * p.y + k.z * p.z;
+    double c = cos(angle);
+
+    p = sumVecVec3D(sumVecVec3D(mulScoVec3D(c, p), mulScoVec3D(sin(angle), crsVecVec3D(k, p))), mulScoVec3D(kp * (1 - c), k));
+    return sumVecVec3D(segment->center, p);
+}
+
+/**
+ * @fn void initCartesianPath(CARTESIAN_PATH *, const VECTOR_3D *, const MATRIX_3D *)
+ * @brief Initialize an empty path
+ * @param[out] *path path to be initialized
+ * @param[in] *start start position of the end effector [m] (the present position)
+ * @param[in] *rotation orientation of the end effector kept along the path (NULL: position only)
+ */
+void initCartesianPath(CARTESIAN_PATH *path, const VECTOR_3D *start, const MATRIX_3D *rotation)
+{
+    memset(path, 0, sizeof(CARTESIAN_PATH));
+    path->position = *start;
+    if (rotation != NULL)
+    {
+        path->keep_rotation = 1;
+        path->rotation = *rotation;
+    }
+}
+
+/**
+ * @fn static int addCartesianSegment(CARTESIAN_PATH *, CARTESIAN_SEGMENT *, double)
+ * @brief Append a segment whose shape is set (duration is given by the speed)
+ */
+static int addCartesianSegment(CARTESIAN_PATH *path, CARTESIAN_SEGMENT *segment, double speed)
+{
+    if (path->segment_num >= CARTESIAN_PATH_MAX_SEGMENTS)
+    {
+        printf("Number of segments exceeds %d\n", CARTESIAN_PATH_MAX_SEGMENTS);
+        return 1;
+    }
+    if (speed <= 0)
+    {
+        printf("Speed must be positive (%f)\n", speed);
+        return 1;
+    }
+    segment->start_time = path->duration;
+    segment->duration = QUINTIC_PEAK_VELOCITY * segment->length / speed;
+    path->segment[path->segment_num++] = *segment;
+    path->duration += segment->duration;
+    path->position = segment->end;
+    return 0;
+}
+
+/**
+ * @fn int addCartesianLine(CARTESIAN_PATH *, const VECTOR_3D *, double)
+ * @brief Append a straight line from the end of the path
+ * @param[in,out] *path path
+ * @param[in] *end end position [m]
+ * @param[in] speed peak speed of the end effector [m/s]
+ * @return 0: success, 1: failure
+ */
+int addCartesianLine(CARTESIAN_PATH *path, const VECTOR_3D *end, double speed)
+{
+    CARTESIAN_SEGMENT segment;
+
+    memset(&segment, 0, sizeof(segment));
+    segment.type = CARTESIAN_LINE;
+    segment.start = path->position;
+    segment.end = *end;
+    segment.length = getVectorNorm(subVecVec3D(segment.end, segment.start));
+    return addCartesianSegment(path, &segment, speed);
+}
+
+/**
+ * @fn int addCartesianArc(CARTESIAN_PATH *, const VECTOR_3D *, const VECTOR_3D *, double, double)
+ * @brief Append a circular arc from the end of the path (rotation of the end position around an axis)
+ * @param[in,out] *path path
+ * @param[in] *center a point on the rotation axis [m]
+ * @param[in] *normal direction of the rotation axis (normalized inside)
+ * @param[in] angle rotation angle [rad] (right-handed around normal)
+ * @param[in] speed peak speed of the end effector [m/s]
+ * @return 0: success, 1: failure
+ */
+int addCartesianArc(CARTESIAN_PATH *path, const VECTOR_3D *center, const VECTOR_3D *normal, double angle, double speed)
+{
+    CARTESIAN_SEGMENT segment;
+    VECTOR_3D r;
+    double norm = getVectorNorm(*normal);
+
+    if (norm <= 0)
+    {
+        printf("Rotation axis of the arc is zero vector\n");
+        return 1;
+    }
+    memset(&segment, 0, sizeof(segment));
+    segment.type = CARTESIAN_ARC;
+    segment.start = path->position;
+    segment.center = *center;
+    segment.normal = mulScoVec3D(1.0 / norm, *normal);
+    segment.angle = angle;
+    // radius is the distance from the rotation axis
+    r = subVecVec3D(segment.start, segment.center);
+    r = subVecVec3D(r, mulScoVec3D(r.x * segment.normal.x + r.y * segment.normal.y + r.z * segment.normal.z, segment.normal));
+    segment.length = getVectorNorm(r) * fabs(angle);
+    segment.end = rotateAroundAxis(&segment, angle);
+    return addCartesianSegment(path, &segment, speed);
+}
+
+/**
+ * @fn int evaluateCartesianPath(const CARTESIAN_PATH *, double, VECTOR_3D *)
+ * @brief Position of the end effector on the path at the given time (quintic time scaling on each segment)
+ * @param[in] *path path
+ * @param[in] time time from the start of the path [s]
+ * @param[out] *position position of the end effector [m]
+ * @return 0: moving, 1: the path is finished (the end position is given)
+ */
+int evaluateCartesianPath(const CARTESIAN_PATH *path, double time, VECTOR_3D *position)
+{
+    const CARTESIAN_SEGMENT *segment;
+    double t, s;
+    int n = 0;
+
+    if ((path->segment_num == 0) || (time >= path->duration))
+    {
+        *position = path->position;
+        return 1;
+    }
+    while ((n < path->segment_num - 1) && (time >= path->segment[n + 1].start_time))
+    {
+        n++;
+    }
+    segment = &path->segment[n];
+    t = (segment->duration > 0) ? fmin(fmax((time - segment->start_time) / segment->duration, 0), 1) : 1;
+    s = t * t * t * (10 + t * (-15 + 6 * t));
+    if (segment->type == CARTESIAN_ARC)
+        *position = rotateAroundAxis(segment, segment->angle * s);
+    else
+        *position = sumVecVec3D(segment->start, mulScoVec3D(s, subVecVec3D(segment->end, segment->start)));
+    return 0;
+}
+
+//// Streaming ////
+
+/**
+ * @fn static void solveSample(CARTESIAN_STREAM *, uint64_t, CARTESIAN_SETPOINT *)
+ * @brief Solve inverse kinematics of a sample of the path, warm started from the previous solution
+ */
+static void solveSample(CARTESIAN_STREAM *stream, uint64_t sample, CARTESIAN_SETPOINT *setpoint)
+{
+    const CARTESIAN_PATH *path = stream->path;
+    VECTOR_3D position;
+    IK_RESULT result;
+
+    setpoint->last = evaluateCartesianPath(path, sample * stream->period, &position);
+    setpoint->converged = !inverseKinematics7Dof(&stream->cache, &position, path->keep_rotation ? &path->rotation : NULL,
+                                                 stream->theta, setpoint->theta, &stream->ik_config, &result);
+    memcpy(stream->theta, setpoint->theta, sizeof(stream->theta));
+    if (!setpoint->converged)
+        stream->ik_failures++;
+    if (result.time > stream->ik_time_max)
+        stream->ik_time_max = result.time;
+}
+
+/**
+ * @fn static void *prefetchThread(void *)
+ * @brief Prefetch thread: solve the samples of the path ahead while the buffer has room
+ */
+static void *prefetchThread(void *arg)
+{
+    CARTESIAN_STREAM *stream = (CARTESIAN_STREAM *)arg;
+    struct sched_param param = {0};
+    int last = 0;
+
+    // background batch work: waking this thread does not preempt the control loop on the same CPU
+    pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+
+    while (!last)
+    {
+        uint64_t sample = stream->produced; // written only by this thread
+
+        if (sample - __atomic_load_n(&stream->consumed, __ATOMIC_ACQUIRE) >= (uint64_t)stream->prefetch)
+        {
+            // wait until the buffer is half empty, so that the consumer wakes this thread once per prefetch / 2 setpoints
+            pthread_mutex_lock(&stream->mutex);
+            __atomic_store_n(&stream->waiting, 1, __ATOMIC_RELEASE);
+            while (__atomic_load_n(&stream->waiting, __ATOMIC_ACQUIRE) && !__atomic_load_n(&stream->stopping, __ATOMIC_ACQUIRE))
+            {
+                pthread_cond_wait(&stream->not_full, &stream->mutex);
+            }
+            pthread_mutex_unlock(&stream->mutex);
+        }
+        if (__atomic_load_n(&stream->stopping, __ATOMIC_ACQUIRE))
+            break;
+
+        // the slot is not read by the consumer until produced is published
+        solveSample(stream, sample, &stream->buffer[sample % stream->prefetch]);
+        last = stream->buffer[sample % stream->prefetch].last;
+        __atomic_store_n(&stream->produced, sample + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/**
+ * @fn int startCartesianStream(CARTESIAN_STREAM *, const CARTESIAN_PATH *, const double *, double, int)
+ * @brief Start computing the setpoints of the path. The first setpoints are solved before return, the rest by the prefetch thread.
+ * @param[out] *stream stream to be started
+ * @param[in] *path path (must be kept until stopCartesianStream)
+ * @param[in] *initial_theta present joint angles [rad] (JOINT_NUM elements, the start of warm start)
+ * @param[in] period sampling period of the path [s] (control period)
+ * @param[in] prefetch number of setpoints computed ahead (0: computed in getCartesianSetpoint, max CARTESIAN_PATH_MAX_PREFETCH)
+ * @return 0: success, 1: failure
+ */
+int startCartesianStream(CARTESIAN_STREAM *stream, const CARTESIAN_PATH *path, const double *initial_theta, double period, int prefetch)
+{
+    if ((prefetch < 0) || (prefetch > CARTESIAN_PATH_MAX_PREFETCH) || (period <= 0))
+    {
+        printf("Invalid prefetch (%d) or period (%f)\n", prefetch, period);
+        return 1;
+    }
+    memset(stream, 0, sizeof(CARTESIAN_STREAM));
+    stream->path = path;
+    stream->period = period;
+    stream->prefetch = prefetch;
+    initKinematicsCache(&stream->cache);
+    getDefaultIkConfig(&stream->ik_config);
+    memcpy(stream->theta, initial_theta, sizeof(stream->theta));
+    memcpy(stream->current.theta, initial_theta, sizeof(stream->current.theta));
+    if (prefetch == 0)
+        return 0;
+
+    // fill the buffer so that the first cycles do not wait for the prefetch thread
+    for (int n = 0; n < prefetch; n++)
+    {
+        solveSample(stream, stream->produced, &stream->buffer[n]);
+        stream->produced++;
+        if (stream->buffer[n].last)
+            return 0;
+    }
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->not_full, NULL);
+    if (pthread_create(&stream->thread, NULL, prefetchThread, stream) != 0)
+    {
+        printf("Failed to create prefetch thread\n");
+        pthread_cond_destroy(&stream->not_full);
+        pthread_mutex_destroy(&stream->mutex);
+        return 1;
+    }
+    stream->running = 1;
+    return 0;
+}
+
+/**
+ * @fn static void wakePrefetchThread(CARTESIAN_STREAM *)
+ * @brief Wake the prefetch thread waiting for the buffer to become half empty.
+ *        The mutex is only tried: if the prefetch thread holds it, the wake up is retried in the next control period.
+ */
+static void wakePrefetchThread(CARTESIAN_STREAM *stream)
+{
+    if (!stream->running || !__atomic_load_n(&stream->waiting, __ATOMIC_ACQUIRE))
+        return;
+    if (__atomic_load_n(&stream->produced, __ATOMIC_ACQUIRE) - stream->consumed > (uint64_t)stream->prefetch / 2)
+        return;
+    if (pthread_mutex_trylock(&stream->mutex) != 0)
+        return;
+    __atomic_store_n(&stream->waiting, 0, __ATOMIC_RELEASE);
+    pthread_cond_signal(&stream->not_full);
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+/**
+ * @fn int getCartesianSetpoint(CARTESIAN_STREAM *, double *)
+ * @brief Take the setpoint of the next control period (never blocks: the buffer is a single producer single consumer ring)
+ * @param[in,out] *stream started stream
+ * @param[out] *theta joint angles [rad] (JOINT_NUM elements)
+ * @return CARTESIAN_SETPOINT_OK, CARTESIAN_SETPOINT_FINISHED or CARTESIAN_SETPOINT_UNDERRUN
+ */
+int getCartesianSetpoint(CARTESIAN_STREAM *stream, double *theta)
+{
+    int status = CARTESIAN_SETPOINT_OK;
+
+    if (stream->finished)
+    {
+        status = CARTESIAN_SETPOINT_FINISHED;
+    }
+    else if (stream->prefetch == 0)
+    {
+        solveSample(stream, stream->consumed++, &stream->current);
+    }
+    else
+    {
+        uint64_t consumed = stream->consumed; // written only by the control thread
+
+        if (__atomic_load_n(&stream->produced, __ATOMIC_ACQUIRE) > consumed)
+        {
+            // the slot is not overwritten by the prefetch thread until consumed is published
+            stream->current = stream->buffer[consumed % stream->prefetch];
+            __atomic_store_n(&stream->consumed, consumed + 1, __ATOMIC_RELEASE);
+        }
+        else
+        {
+            stream->underruns++;
+            status = CARTESIAN_SETPOINT_UNDERRUN;
+        }
+        wakePrefetchThread(stream);
+    }
+    if ((status == CARTESIAN_SETPOINT_OK) && stream->current.last)
+        stream->finished = 1;
+    memcpy(theta, stream->current.theta, sizeof(stream->current.theta));
+    return status;
+}
+
+/**
+ * @fn void stopCartesianStream(CARTESIAN_STREAM *)
+ * @brief Stop the prefetch thread
+ * @param[in,out] *stream started stream
+ */
+void stopCartesianStream(CARTESIAN_STREAM *stream)
+{
+    if (!stream->running)
+        return;
+    pthread_mutex_lock(&stream->mutex);
+    __atomic_store_n(&stream->stopping, 1, __ATOMIC_RELEASE);
+    pthread_cond_signal(&stream->not_full);
+    pthread_mutex_unlock(&stream->mutex);
+    pthread_join(stream->thread, NULL);
+    pthread_cond_destroy(&stream->not_full);
+    pthread_mutex_destroy(&stream->mutex);
+    stream->running = 0;
+}
+
+/**
+ * @fn static int cartesianCallback(uint64_t, double, void *)
+ * @brief Control loop callback: send the setpoint of the path every control period
+ */
+static int cartesianCallback(uint64_t cycle, double time, void *user_data)
+{
+    CARTESIAN_RUNNER *runner = (CARTESIAN_RUNNER *)user_data;
+    double theta[JOINT_NUM];
+
+    getCartesianSetpoint(runner->stream, theta);
+    if (runner->output(theta))
+    {
+        runner->result = 1;
+        return 1;
+    }
+    return runner->stream->finished;
+}
+
+/**
+ * @fn int runCartesianPath(const CARTESIAN_PATH *, const double *, int, CONTROL_LOOP_CONFIG *, TRAJECTORY_OUTPUT, CONTROL_LOOP_STATS *)
+ * @brief Stream the path at the control rate. Inverse kinematics is solved ahead by the prefetch thread,
+ *        so that its calculation time does not delay the output of the control period.
+ *        The profile velocity of the servo motors should be 0 (setCranex7ProfileVelocity).
+ * @param[in] *path path
+ * @param[in] *initial_theta present joint angles [rad] (JOINT_NUM elements)
+ * @param[in] prefetch number of setpoints computed ahead (0: computed in the control loop)
+ * @param[in] *config setting of the control loop (getDefaultControlLoopConfig)
+ * @param[in] output function to send the setpoint (e.g. setCranex7Angle)
+ * @param[out] *stats timing statistics of the control loop (NULL: not needed)
+ * @return 0: success, 1: failure of the control loop or the output
+ */
+int runCartesianPath(const CARTESIAN_PATH *path, const double *initial_theta, int prefetch, CONTROL_LOOP_CONFIG *config,
+                     TRAJECTORY_OUTPUT output, CONTROL_LOOP_STATS *stats)
+{
+    CARTESIAN_STREAM stream;
+    CARTESIAN_RUNNER runner = {&stream, output, 0};
+
+    if (startCartesianStream(&stream, path, initial_theta, 1.0 / config->frequency, prefetch))
+    {
+        return 1;
+    }
+    if (runControlLoop(config, cartesianCallback, &runner, stats))
+    {
+        runner.result = 1;
+    }
+    stopCartesianStream(&stream);
+    printf("Cartesian path : %" PRIu64 " setpoints, %" PRIu64 " underruns, %" PRIu64 " IK not converged, max IK time %.1f [us]\n",
+           stream.consumed, stream.underruns,
+           stream.ik_failures, stream.ik_time_max * 1e6);
+    return runner.result;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file cartesian_path.h
+ * @brief Cartesian straight line and circular arc path of the end effector streamed by incremental inverse kinematics
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CARTESIAN_PATH_H_
+#define CARTESIAN_PATH_H_
+
+#include <pthread.h>
+#include "kinematics.h"
+#include "trajectory.h"
+
+#define CARTESIAN_PATH_MAX_SEGMENTS (32)
+#define CARTESIAN_PATH_MAX_PREFETCH (64)
+#define CARTESIAN_LINE (0)
+#define CARTESIAN_ARC (1)
+
+// Result of getCartesianSetpoint
+#define CARTESIAN_SETPOINT_OK (0)
+#define CARTESIAN_SETPOINT_FINISHED (1) // the last setpoint of the path was already given
+#define CARTESIAN_SETPOINT_UNDERRUN (2) // the prefetch thread is late (the previous setpoint is given again)
+
+//// Structure definition ////
+/**
+ * @struct CARTESIAN_SEGMENT
+ * @brief Straight line or circular arc of the end effector position (base frame of kinematics.h)
+ */
+typedef struct
+{
+    int type;          // CARTESIAN_LINE or CARTESIAN_ARC
+    VECTOR_3D start;   // start position [m]
+    VECTOR_3D end;     // end position [m]
+    VECTOR_3D center;  // center of the arc [m]
+    VECTOR_3D normal;  // unit rotation axis of the arc (right-handed)
+    double angle;      // rotation angle of the arc [rad]
+    double length;     // path length [m]
+    double start_time; // start time of the segment from the start of the path [s]
+    double duration;   // duration of the segment [s]
+} CARTESIAN_SEGMENT;
+
+/**
+ * @struct CARTESIAN_PATH
+ * @brief Sequence of lines and arcs (the end effector stops at the end of every segment)
+ */
+typedef struct
+{
+    int segment_num;
+    double duration;    // total duration [s]
+    int keep_rotation;  // 1: the end effector keeps rotation, 0: position only
+    MATRIX_3D rotation; // orientation of the end effector kept along the path
+    VECTOR_3D position; // end position of the last segment [m]
+    CARTESIAN_SEGMENT segment[CARTESIAN_PATH_MAX_SEGMENTS];
+} CARTESIAN_PATH;
+
+/**
+ * @struct CARTESIAN_SETPOINT
+ * @brief Joint angles solved for a sample of the path
+ */
+typedef struct
+{
+    double theta[JOINT_NUM]; // joint angles [rad]
+    int converged;           // 1: inverse kinematics converged
+    int last;                // 1: the last sample of the path
+} CARTESIAN_SETPOINT;
+
+/**
+ * @struct CARTESIAN_STREAM
+ * @brief Setpoints computed ahead by the prefetch thread (members are private to cartesian_path.c)
+ */
+typedef struct
+{
+    const CARTESIAN_PATH *path;
+    double period;                 // sampling period of the path [s] (control period)
+    int prefetch;                  // number of setpoints computed ahead (0: computed in getCartesianSetpoint)
+    KINEMATICS_CACHE cache;        // link frames of the previous solution (warm start)
+    IK_CONFIG ik_config;
+    double theta[JOINT_NUM];       // previous solution [rad]
+    uint64_t produced;             // number of solved samples (stored by the prefetch thread with release)
+    uint64_t consumed;             // number of given setpoints (stored by the control thread with release)
+    CARTESIAN_SETPOINT buffer[CARTESIAN_PATH_MAX_PREFETCH];
+    CARTESIAN_SETPOINT current;    // setpoint given last
+    pthread_t thread;
+    pthread_mutex_t mutex;         // only for not_full (the control thread uses trylock)
+    pthread_cond_t not_full;       // signaled when the buffer becomes half empty
+    int waiting;                   // 1: the prefetch thread waits for not_full (cleared under mutex)
+    int running;                   // 1: the prefetch thread is running
+    int stopping;                  // 1: the prefetch thread exits
+    int finished;                  // 1: the last setpoint was given
+    uint64_t underruns;            // number of periods in which the setpoint was not ready
+    uint64_t ik_failures;          // number of samples whose inverse kinematics did not converge
+    double ik_time_max;            // maximum calculation time of inverse kinematics [s]
+} CARTESIAN_STREAM;
+
+//// Prototype declaration ////
+void initCartesianPath(CARTESIAN_PATH *, const VECTOR_3D *, const MATRIX_3D *);
+int addCartesianLine(CARTESIAN_PATH *, const VECTOR_3D *, double);
+int addCartesianArc(CARTESIAN_PATH *, const VECTOR_3D *, const VECTOR_3D *, double, double);
+int evaluateCartesianPath(const CARTESIAN_PATH *, double, VECTOR_3D *);
+int startCartesianStream(CARTESIAN_STREAM *, const CARTESIAN_PATH *, const double *, double, int);
+int getCartesianSetpoint(CARTESIAN_STREAM *, double *);
+void stopCartesianStream(CARTESIAN_STREAM *);
+int runCartesianPath(const CARTESIAN_PATH *, const double *, int, CONTROL_LOOP_CONFIG *, TRAJECTORY_OUTPUT, CONTROL_LOOP_STATS *);
+
+#endif
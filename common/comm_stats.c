@@ -0,0 +1,173 @@
+/**
+ * @file comm_stats.c
+ * @brief Latency histograms and error counters of the communication functions (crane_x7_comm.c and crane_x7_sim.c)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include "comm_stats.h"
+
+static const char *function_name[COMM_STATS_FUNCTION_NUM] = {
+    "initilizeCranex7", "setCranex7TorqueEnable", "setCranex7Angle", "setCranex7AngularVelocity", "setCranex7Torque",
+    "setCranex7ProfileVelocity", "getCranex7JointState", "cycleCranex7", "brakeCranex7Joint",
+    "  register write", "  bulk write", "  bulk read", "  sync write", "  sync read"};
+
+/**
+ * @fn static int getBucketIndex(uint64_t)
+ * @brief Bucket of the latency: exact below 2^COMM_HISTOGRAM_SUB_BITS, then the top COMM_HISTOGRAM_SUB_BITS + 1 bits
+ */
+static int getBucketIndex(uint64_t latency)
+{
+  int exponent;
+
+  if (latency < (1 << COMM_HISTOGRAM_SUB_BITS))
+    return (int)latency;
+  exponent = 63 - __builtin_clzll(latency);
+  if (exponent >= COMM_HISTOGRAM_MAX_BITS)
+    return COMM_HISTOGRAM_BUCKETS - 1;
+  return ((exponent - COMM_HISTOGRAM_SUB_BITS + 1) << COMM_HISTOGRAM_SUB_BITS) +
+         (int)((latency >> (exponent - COMM_HISTOGRAM_SUB_BITS)) & ((1 << COMM_HISTOGRAM_SUB_BITS) - 1));
+}
+
+/**
+ * @fn static double getBucketValue(int)
+ * @brief Representative latency of the bucket (center of its range) [ns]
+ */
+static double getBucketValue(int index)
+{
+  int exponent = (index >> COMM_HISTOGRAM_SUB_BITS) + COMM_HISTOGRAM_SUB_BITS - 1;
+  uint64_t width;
+
+  if (index < (1 << COMM_HISTOGRAM_SUB_BITS))
+    return (double)index;
+  width = (uint64_t)1 << (exponent - COMM_HISTOGRAM_SUB_BITS);
+  return (double)(((uint64_t)(index & ((1 << COMM_HISTOGRAM_SUB_BITS) - 1)) + (1 << COMM_HISTOGRAM_SUB_BITS)) * width) + 0.5 * (double)(width - 1);
+}
+
+/**
+ * @fn uint64_t getCommStatsTime(void)
+ * @brief Timestamp for recordCommLatency (CLOCK_MONOTONIC, no system call with vDSO)
+ * @return time [ns]
+ */
+uint64_t getCommStatsTime(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @fn int recordCommLatency(COMM_STATS *, int, uint64_t, int)
+ * @brief Add the latency from start to now to the histogram of the function
+ * @param[in,out] *stats statistics of the arm (updated only by the thread calling its communication functions)
+ * @param[in] function COMM_STATS_INITIALIZE, ...
+ * @param[in] start timestamp of getCommStatsTime at the beginning of the call
+ * @param[in] result return value of the function (passed through)
+ * @return result
+ */
+int recordCommLatency(COMM_STATS *stats, int function, uint64_t start, int result)
+{
+  COMM_HISTOGRAM *histogram = &stats->function[function];
+  uint64_t latency = getCommStatsTime() - start;
+
+  if ((histogram->calls == 0) || (latency < histogram->min))
+    histogram->min = latency;
+  if (latency > histogram->max)
+    histogram->max = latency;
+  histogram->calls++;
+  histogram->total += latency;
+  histogram->bucket[getBucketIndex(latency)]++;
+  return result;
+}
+
+/**
+ * @fn void countCommFailure(COMM_STATS *, int)
+ * @brief Count a result other than COMM_SUCCESS
+ * @param[in,out] *stats statistics of the arm
+ * @param[in] function COMM_STATS_INITIALIZE, ...
+ */
+void countCommFailure(COMM_STATS *stats, int function)
+{
+  stats->function[function].comm_failures++;
+}
+
+/**
+ * @fn void countDxlError(COMM_STATS *, int)
+ * @brief Count a status packet with an error of dynamixel
+ * @param[in,out] *stats statistics of the arm
+ * @param[in] function COMM_STATS_INITIALIZE, ...
+ */
+void countDxlError(COMM_STATS *stats, int function)
+{
+  stats->function[function].dxl_errors++;
+}
+
+/**
+ * @fn double getCommLatencyPercentile(const COMM_HISTOGRAM *, double)
+ * @brief Latency below which the given percentage of the calls finished
+ * @param[in] *histogram histogram of a function
+ * @param[in] percentile percentage (0 - 100)
+ * @return latency [ns] (0 if there is no call)
+ */
+double getCommLatencyPercentile(const COMM_HISTOGRAM *histogram, double percentile)
+{
+  double threshold = histogram->calls * percentile / 100.0;
+  uint64_t count = 0;
+
+  if (histogram->calls == 0)
+    return 0;
+  for (int i = 0; i < COMM_HISTOGRAM_BUCKETS; i++)
+  {
+    count += histogram->bucket[i];
+    if ((count > 0) && ((double)count >= threshold))
+    {
+      // the bucket center can be outside of the measured range
+      double value = getBucketValue(i);
+      if (value < (double)histogram->min)
+        return (double)histogram->min;
+      if (value > (double)histogram->max)
+        return (double)histogram->max;
+      return value;
+    }
+  }
+  return (double)histogram->max;
+}
+
+/**
+ * @fn void printCranex7CommStats(const COMM_STATS *)
+ * @brief Print latency [us] and error counts of the called functions
+ * @param[in] *stats statistics
+ */
+void printCranex7CommStats(const COMM_STATS *stats)
+{
+  printf("Communication latency [us]     calls      mean       p50       p99     p99.9       max  failures dxl_errors\n");
+  for (int i = 0; i < COMM_STATS_FUNCTION_NUM; i++)
+  {
+    const COMM_HISTOGRAM *histogram = &stats->function[i];
+
+    if (histogram->calls == 0)
+      continue;
+    printf("%-27s %9" PRIu64 " %9.1f %9.1f %9.1f %9.1f %9.1f %9" PRIu64 " %10" PRIu64 "\n", function_name[i], histogram->calls,
+           (double)histogram->total / histogram->calls * 1e-3, getCommLatencyPercentile(histogram, 50) * 1e-3,
+           getCommLatencyPercentile(histogram, 99) * 1e-3, getCommLatencyPercentile(histogram, 99.9) * 1e-3,
+           (double)histogram->max * 1e-3, histogram->comm_failures, histogram->dxl_errors);
+  }
+}
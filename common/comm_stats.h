@@ -0,0 +1,83 @@
+/**
+ * @file comm_stats.h
+ * @brief Latency histograms and error counters of the communication functions (crane_x7_comm.c and crane_x7_sim.c)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMM_STATS_H_
+#define COMM_STATS_H_
+
+#include <stdint.h>
+
+// Public functions of crane_x7_comm.h
+#define COMM_STATS_INITIALIZE (0)
+#define COMM_STATS_TORQUE_ENABLE (1)
+#define COMM_STATS_SET_ANGLE (2)
+#define COMM_STATS_SET_ANGULAR_VELOCITY (3)
+#define COMM_STATS_SET_TORQUE (4)
+#define COMM_STATS_SET_PROFILE_VELOCITY (5)
+#define COMM_STATS_GET_JOINT_STATE (6)
+#define COMM_STATS_CYCLE (7)
+#define COMM_STATS_BRAKE (8)
+// Bus transactions of DynamixelSDK inside the public functions (not used by the simulator)
+#define COMM_STATS_REGISTER_WRITE (9) // write1ByteTxRx, write2ByteTxRx, write4ByteTxRx
+#define COMM_STATS_BULK_WRITE (10)    // groupBulkWriteTxPacket
+#define COMM_STATS_BULK_READ (11)     // groupBulkReadTxRxPacket
+#define COMM_STATS_SYNC_WRITE (12)    // groupSyncWriteTxPacket
+#define COMM_STATS_SYNC_READ (13)     // groupSyncReadTxRxPacket
+#define COMM_STATS_FUNCTION_NUM (14)
+
+// Log-linear buckets (HDR histogram): 2^COMM_HISTOGRAM_SUB_BITS buckets per power of 2 (relative error < 1/16)
+#define COMM_HISTOGRAM_SUB_BITS (4)
+#define COMM_HISTOGRAM_MAX_BITS (36) // latency up to 2^36 [ns] (69 s), longer latency is counted in the last bucket
+#define COMM_HISTOGRAM_BUCKETS ((COMM_HISTOGRAM_MAX_BITS - COMM_HISTOGRAM_SUB_BITS + 1) << COMM_HISTOGRAM_SUB_BITS)
+
+//// Structure definition ////
+/**
+ * @struct COMM_HISTOGRAM
+ * @brief Latency histogram and error counters of a function
+ */
+typedef struct
+{
+  uint64_t calls;                          // number of calls
+  uint64_t comm_failures;                  // number of results other than COMM_SUCCESS
+  uint64_t dxl_errors;                     // number of status packets with an error of dynamixel
+  uint64_t total;                          // sum of latency [ns]
+  uint64_t min;                            // minimum latency [ns]
+  uint64_t max;                            // maximum latency [ns]
+  uint64_t bucket[COMM_HISTOGRAM_BUCKETS]; // number of calls of each latency range
+} COMM_HISTOGRAM;
+
+/**
+ * @struct COMM_STATS
+ * @brief Histograms of all functions (index: COMM_STATS_INITIALIZE, ...)
+ */
+typedef struct
+{
+  COMM_HISTOGRAM function[COMM_STATS_FUNCTION_NUM];
+} COMM_STATS;
+
+//// Prototype declaration ////
+uint64_t getCommStatsTime(void);
+int recordCommLatency(COMM_STATS *, int, uint64_t, int);
+void countCommFailure(COMM_STATS *, int);
+void countDxlError(COMM_STATS *, int);
+double getCommLatencyPercentile(const COMM_HISTOGRAM *, double);
+void printCranex7CommStats(const COMM_STATS *);
+
+#endif
@@ -0,0 +1,215 @@
+/**
+ * @file control_loop.c
+ * @brief Fixed-rate periodic executor for control loops
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "control_loop.h"
+
+#define NSEC_PER_SEC (1000000000LL)
+
+/**
+ * @fn static int64_t timespec2ns(struct timespec *)
+ * @brief Convert timespec to nanoseconds
+ */
+static int64_t timespec2ns(struct timespec *ts)
+{
+  return (int64_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+/**
+ * @fn static void ns2timespec(int64_t, struct timespec *)
+ * @brief Convert nanoseconds to timespec
+ */
+static void ns2timespec(int64_t ns, struct timespec *ts)
+{
+  ts->tv_sec = ns / NSEC_PER_SEC;
+  ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+/**
+ * @fn static int64_t getMonotonicNs(void)
+ * @brief Get present time of CLOCK_MONOTONIC [ns]
+ */
+static int64_t getMonotonicNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return timespec2ns(&ts);
+}
+
+/**
+ * @fn void getDefaultControlLoopConfig(CONTROL_LOOP_CONFIG *, double)
+ * @brief Fill the setting with default values (normal scheduling, no pinning, no memory lock)
+ * @param[out] *config setting of periodic executor
+ * @param[in] frequency control frequency [Hz]
+ */
+void getDefaultControlLoopConfig(CONTROL_LOOP_CONFIG *config, double frequency)
+{
+  config->frequency = frequency;
+  config->priority = CONTROL_LOOP_NORMAL_PRIORITY;
+  config->cpu = CONTROL_LOOP_NO_CPU_PINNING;
+  config->lock_memory = 0;
+}
+
+/**
+ * @fn int setupControlLoopRealtime(CONTROL_LOOP_CONFIG *)
+ * @brief Apply memory lock, CPU pinning and SCHED_FIFO to the calling thread
+ * @param[in] *config setting of periodic executor
+ * @return Success or failure (failure of each setting is reported and the rest is still applied).
+ */
+int setupControlLoopRealtime(CONTROL_LOOP_CONFIG *config)
+{
+  int result = 0;
+
+  if (config->lock_memory)
+  {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+      printf("Failed to lock memory : %s\n", strerror(errno));
+      result = 1;
+    }
+  }
+  if (config->cpu != CONTROL_LOOP_NO_CPU_PINNING)
+  {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(config->cpu, &cpu_set);
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0)
+    {
+      printf("Failed to pin the loop to CPU %d : %s\n", config->cpu, strerror(errno));
+      result = 1;
+    }
+  }
+  if (config->priority != CONTROL_LOOP_NORMAL_PRIORITY)
+  {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = config->priority;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+    {
+      printf("Failed to set SCHED_FIFO priority %d : %s\n", config->priority, strerror(errno));
+      result = 1;
+    }
+  }
+  return result;
+}
+
+/**
+ * @fn int runControlLoop(CONTROL_LOOP_CONFIG *, CONTROL_LOOP_CALLBACK, void *, CONTROL_LOOP_STATS *)
+ * @brief Call the callback function at a fixed rate until it returns non-zero.
+ *        Wakeup times are absolute (clock_nanosleep with TIMER_ABSTIME), so the period does not drift.
+ *        If the callback overruns, the missed periods are skipped instead of being executed back to back.
+ * @param[in] *config setting of periodic executor
+ * @param[in] callback function called every control period
+ * @param[in] *user_data pointer passed to the callback
+ * @param[out] *stats timing statistics (can be NULL)
+ * @return Success or failure.
+ */
+int runControlLoop(CONTROL_LOOP_CONFIG *config, CONTROL_LOOP_CALLBACK callback, void *user_data, CONTROL_LOOP_STATS *stats)
+{
+  CONTROL_LOOP_STATS result;
+  struct timespec wakeup;
+  int64_t period, start, next, now, end;
+  double latency, exec, latency_sum = 0, latency_sq_sum = 0, exec_sum = 0;
+  int stop = 0;
+
+  if ((config->frequency <= 0) || (callback == NULL))
+  {
+    printf("Invalid control loop setting.\n");
+    return 1;
+  }
+  period = (int64_t)(NSEC_PER_SEC / config->frequency);
+  memset(&result, 0, sizeof(result));
+
+  setupControlLoopRealtime(config);
+
+  start = getMonotonicNs();
+  next = start;
+  while (!stop)
+  {
+    // sleep until the absolute wakeup time
+    ns2timespec(next, &wakeup);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR)
+    {
+    }
+    now = getMonotonicNs();
+
+    stop = callback(result.cycles, (double)(next - start) / NSEC_PER_SEC, user_data);
+    end = getMonotonicNs();
+
+    // timing statistics [us]
+    latency = (double)(now - next) / 1000.0;
+    exec = (double)(end - now) / 1000.0;
+    if ((result.cycles == 0) || (latency < result.jitter_min))
+      result.jitter_min = latency;
+    if (latency > result.jitter_max)
+      result.jitter_max = latency;
+    if (exec > result.exec_max)
+      result.exec_max = exec;
+    latency_sum += latency;
+    latency_sq_sum += latency * latency;
+    exec_sum += exec;
+    result.cycles++;
+
+    // next wakeup time (skip periods which have already passed)
+    next += period;
+    if (end > next)
+    {
+      int64_t missed = (end - next) / period + 1;
+      result.overruns++;
+      result.missed += missed;
+      next += missed * period;
+    }
+  }
+
+  if (result.cycles > 0)
+  {
+    result.jitter_mean = latency_sum / result.cycles;
+    result.jitter_stddev = sqrt(fmax(latency_sq_sum / result.cycles - result.jitter_mean * result.jitter_mean, 0.0));
+    result.exec_mean = exec_sum / result.cycles;
+  }
+  if (stats != NULL)
+  {
+    *stats = result;
+  }
+  return 0;
+}
+
+/**
+ * @fn void printControlLoopStats(CONTROL_LOOP_STATS *)
+ * @brief Print timing statistics of periodic executor
+ * @param[in] *stats timing statistics
+ */
+void printControlLoopStats(CONTROL_LOOP_STATS *stats)
+{
+  printf("Control loop : %" PRIu64 " cycles, %" PRIu64 " overruns (%" PRIu64 " periods skipped)\n",
+         stats->cycles, stats->overruns, stats->missed);
+  printf("Wakeup latency [us] : min %.1f, mean %.1f, max %.1f, stddev %.1f\n",
+         stats->jitter_min, stats->jitter_mean, stats->jitter_max, stats->jitter_stddev);
+  printf("Execution time [us] : mean %.1f, max %.1f\n", stats->exec_mean, stats->exec_max);
+}
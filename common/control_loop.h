@@ -0,0 +1,75 @@
+/**
+ * @file control_loop.h
+ * @brief Fixed-rate periodic executor for control loops
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROL_LOOP_H_
+#define CONTROL_LOOP_H_
+
+#include <stdint.h>
+
+#define CONTROL_LOOP_NO_CPU_PINNING (-1)
+#define CONTROL_LOOP_NORMAL_PRIORITY (0)
+
+//// Structure definition ////
+/**
+ * @struct CONTROL_LOOP_CONFIG
+ * @brief Setting of periodic executor
+ */
+typedef struct
+{
+  double frequency; // control frequency [Hz]
+  int priority;     // SCHED_FIFO priority (CONTROL_LOOP_NORMAL_PRIORITY: do not change scheduling policy)
+  int cpu;          // CPU number to pin the loop (CONTROL_LOOP_NO_CPU_PINNING: no pinning)
+  int lock_memory;  // 1: lock all pages with mlockall, 0: do nothing
+} CONTROL_LOOP_CONFIG;
+
+/**
+ * @struct CONTROL_LOOP_STATS
+ * @brief Timing statistics of periodic executor
+ */
+typedef struct
+{
+  uint64_t cycles;       // number of executed cycles
+  uint64_t overruns;     // number of cycles whose callback did not finish within the period
+  uint64_t missed;       // number of periods skipped because of overruns
+  double jitter_min;     // minimum wakeup latency [us]
+  double jitter_max;     // maximum wakeup latency [us]
+  double jitter_mean;    // mean wakeup latency [us]
+  double jitter_stddev;  // standard deviation of wakeup latency [us]
+  double exec_max;       // maximum execution time of callback [us]
+  double exec_mean;      // mean execution time of callback [us]
+} CONTROL_LOOP_STATS;
+
+/**
+ * @brief Callback function called every control period
+ * @param[in] cycle cycle count (starts from 0)
+ * @param[in] time elapsed time from the start of the loop [s]
+ * @param[in] *user_data pointer passed to runControlLoop
+ * @return 0: continue, otherwise: stop the loop
+ */
+typedef int (*CONTROL_LOOP_CALLBACK)(uint64_t cycle, double time, void *user_data);
+
+//// Prototype declaration ////
+void getDefaultControlLoopConfig(CONTROL_LOOP_CONFIG *, double);
+int setupControlLoopRealtime(CONTROL_LOOP_CONFIG *);
+int runControlLoop(CONTROL_LOOP_CONFIG *, CONTROL_LOOP_CALLBACK, void *, CONTROL_LOOP_STATS *);
+void printControlLoopStats(CONTROL_LOOP_STATS *);
+
+#endif
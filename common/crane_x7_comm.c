@@ -20,173 +20,444 @@
 // limitations under the License.
 
 //// Header files ////
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef DXL_NATIVE
+#include "dxl_native.h"
+#else
 #include "dynamixel_sdk.h"
+#endif
 #include "crane_x7_comm.h"
+#include "bus_timing.h"
+#include "comm_stats.h"
+#include "dxl_unit.h"
 
-//// Unique set values of each servo motor ////
+//// Unique set values of each servo motor (getDefaultCranex7ArmConfig) ////
 static const uint8_t id_array[JOINT_NUM] = {2, 3, 4, 5, 6, 7, 8, 9};                                  // ID (a unique value to identify each servo motor)
 static const uint32_t min_angle_array[JOINT_NUM] = {262, 1024, 262, 228, 262, 1024, 148, 1991};       // Min angle (expressed as raw value of the dynamixel motor)
 static const uint32_t max_angle_array[JOINT_NUM] = {3834, 3072, 3834, 2048, 3834, 3072, 3928, 3072};  // Max angle (expressed as raw value of the dynamixel motor)
 static const uint32_t home_angle_array[JOINT_NUM] = {2048, 1024, 2048, 2048, 2048, 2048, 2048, 2048}; // Values at 0 radian posture (expressed as raw value of the dynamixel motor)
 
+//// Baud rate register of dynamixel x (setCranex7ArmBusTiming) ////
+static const uint32_t baudrate_array[] = {9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000}; // value of the register is the index
+
+#define BRAKE_PACKET_SIZE (2 * 14 + JOINT_NUM * (2 + GAIN_DATA_LENGTH + GOAL_CURRENT_DATA_LENGTH))
+
+/**
+ * @struct CRANE_X7_ARM
+ * @brief Port, DynamixelSDK groups and state of an arm
+ */
+struct CRANE_X7_ARM
+{
+  CRANE_X7_ARM_CONFIG config;
+  int port_num;                            // PortHandler Structs number
+  int groupwrite_num;                      // Groupbulkwrite Struct number
+  int groupread_num;                       // Groupbulkread Struct number
+  int groupcycle_write_num;                // Groupsyncwrite Struct number (command part of cycleCranex7Arm)
+  int groupcycle_read_num;                 // Groupsyncread Struct number (state part of cycleCranex7Arm)
+  int groupinit_read_num;                  // Groupsyncread Struct number (control table block read by openCranex7Arm)
+  int groupinit_torque_num;                // Groupsyncwrite Struct number (torque enable written by openCranex7Arm)
+  int groupinit_mode_num;                  // Groupsyncwrite Struct number (operating mode written by openCranex7Arm)
+  int groupinit_indirect_num;              // Groupsyncwrite Struct number (indirect addresses written by openCranex7Arm)
+  int groupinit_profile_num;               // Groupsyncwrite Struct number (profile velocity written by openCranex7Arm)
+  int groupbrake_gain_num;                 // Groupsyncwrite Struct number (gains of brakeCranex7Arm)
+  int groupbrake_current_num;              // Groupsyncwrite Struct number (goal current of brakeCranex7Arm)
+  uint8_t joint_operating_mode[JOINT_NUM]; // Operating mode of each servo motor (set in openCranex7Arm)
+  uint8_t brake_packet[BRAKE_PACKET_SIZE]; // sync write packets of emergencyBrakeCranex7Arm (gains and goal current, all 0)
+  size_t brake_packet_length;
+  int brake_fd; // second file descriptor of the serial port (atomic)
+  COMM_STATS stats;
+};
+
 //// Variable for DynamixelSDK ////
-static int port_num = 0;                // PortHandler Structs number
-static int groupwrite_num = 0;          // Groupbulkwrite Struct number
-static int groupread_num = 0;           // Groupbulkread Struct number
-static int comm_result = COMM_TX_FAIL;  // Communication result
-static uint8_t addparam_result = False; // AddParam result
-static uint8_t getdata_result = False;  // GetParam result
-static uint8_t dxl_error;               // Dynamixel error
+// DynamixelSDK reallocates its tables of ports and groups when one is created: arms are opened and closed one at a time
+static pthread_mutex_t sdk_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CRANE_X7_ARM *default_arm = NULL; // arm of the single arm functions (atomic)
 
-//// Unit convertion functions for dynamixel ////
+//// Data conversion functions for CRANE-X7 ////
 
 /**
- * @fn static double rad2dxlvalue(double)
- * @brief Angle unit conversion function from rad to dynamixel value
- * @param[in] rad :angle[rad/s]
- * @return value :angle[dynamixel value]
+ * @fn static int32_t angle2goalposition(CRANE_X7_ARM *, int, double)
+ * @brief Conversion function from joint angle to goal position (with range check)
+ * @param[in] *arm arm
+ * @param[in] joint joint index
+ * @param[in] angle :angle[rad]
+ * @return goal position[dynamixel value]
  */
-static double rad2dxlvalue(double rad)
+static int32_t angle2goalposition(CRANE_X7_ARM *arm, int joint, double angle)
 {
-  double value = rad / (DXL_VALUE_TO_RADIAN);
-  return value;
+  int32_t goal_position = (int32_t)(rad2dxlvalue(angle)) + arm->config.home_angle[joint];
+
+  if ((goal_position > arm->config.max_angle[joint]) || (arm->config.min_angle[joint]) > goal_position)
+  {
+    printf("Out of angle range : joint %d \n", joint + 1);
+  }
+  return goal_position;
 }
 
 /**
- * @fn static double dxlvalue2rad(double)
- * @brief Angle unit conversion function from dynamixel value to rad
- * @param[in] value :angle[dynamixel value]
- * @return rad :angle[rad/s]
+ * @fn static int16_t torque2goalcurrent(int, double)
+ * @brief Conversion function from joint torque to goal current
+ * @param[in] joint joint index
+ * @param[in] torque :torque[Nm]
+ * @return goal current[dynamixel value]
  */
-static double dxlvalue2rad(double value)
+static int16_t torque2goalcurrent(int joint, double torque)
 {
-  double rad = value * (DXL_VALUE_TO_RADIAN);
-  return rad;
+  if (joint == XM540_W270_JOINT)
+  {
+    return (int16_t)current2dxlvalue(torque2currentXM540W270(torque));
+  }
+  return (int16_t)current2dxlvalue(torque2currentXM430W350(torque));
 }
 
 /**
- * @fn static double angularvel2dxlvalue(double)
- * @brief Anglular velocity unit conversion function from rad/s to dynamixel value
- * @param[in] angular_velocity :anglular velocity[rad/s]
- * @return value :anglular velocity[dynamixel value]
+ * @fn static void presentvalue2jointstate(CRANE_X7_ARM *, int, int32_t, int16_t, int16_t, double *, double *, double *)
+ * @brief Conversion function from present value of dynamixel to joint state
+ * @param[in] *arm arm
+ * @param[in] joint joint index
+ * @param[in] present_position :present position[dynamixel value]
+ * @param[in] present_velocity :present velocity[dynamixel value]
+ * @param[in] present_current :present current[dynamixel value]
+ * @param[out] *angle :angle[rad]
+ * @param[out] *angular_velocity :angular velocity[rad/s]
+ * @param[out] *torque :torque[Nm]
  */
-static double angularvel2dxlvalue(double angular_velocity)
+static void presentvalue2jointstate(CRANE_X7_ARM *arm, int joint, int32_t present_position, int16_t present_velocity, int16_t present_current,
+                                    double *angle, double *angular_velocity, double *torque)
 {
-  double value = angular_velocity / (DXL_VALUE_TO_ANGULARVEL);
-  return value;
+  *angle = dxlvalue2rad((double)(present_position - (int32_t)arm->config.home_angle[joint]));
+  *angular_velocity = dxlvalue2angularvel((double)present_velocity);
+  if (joint == XM540_W270_JOINT)
+  {
+    *torque = current2torqueXM540W270(dxlvalue2current((double)present_current));
+  }
+  else
+  {
+    *torque = current2torqueXM430W350(dxlvalue2current((double)present_current));
+  }
 }
 
 /**
- * @fn static double dxlvalue2angularvel(double)
- * @brief Anglular velocity unit conversion function from dynamixel value to rad/s
- * @param[in] value :anglular velocity[dynamixel value]
- * @return angular_velocity :anglular velocity[rad/s]
+ * @fn static int checkTxRxResult(CRANE_X7_ARM *, int, int, int)
+ * @brief Print and count the result of the last transaction
+ * @param[in,out] *arm arm
+ * @param[in] function public function of the transaction (COMM_STATS_INITIALIZE, ...)
+ * @param[in] transaction COMM_STATS_REGISTER_WRITE, ...
+ * @param[in] status_packet 1: check the error of the status packet too
+ * @return 0: success, 1: communication failure or dynamixel error
  */
-static double dxlvalue2angularvel(double value)
+static int checkTxRxResult(CRANE_X7_ARM *arm, int function, int transaction, int status_packet)
 {
-  double angular_velocity = value * (DXL_VALUE_TO_ANGULARVEL);
-  return angular_velocity;
+  int comm_result;
+  uint8_t dxl_error;
+
+  if ((comm_result = getLastTxRxResult(arm->port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
+  {
+    countCommFailure(&arm->stats, function);
+    countCommFailure(&arm->stats, transaction);
+    printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
+    return 1;
+  }
+  if (status_packet && ((dxl_error = getLastRxPacketError(arm->port_num, PROTOCOL_VERSION)) != 0))
+  {
+    countDxlError(&arm->stats, function);
+    countDxlError(&arm->stats, transaction);
+    printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+    return 1;
+  }
+  return 0;
 }
 
 /**
- * @fn static double current2dxlvalue(double)
- * @brief Current unit conversion function from A to dynamixel value
- * @param[in] current :current[A]
- * @return value :current[dynamixel value]
+ * @fn static int writeRegister(CRANE_X7_ARM *, int, int, uint16_t, int, uint32_t)
+ * @brief Write a register of a servo motor and wait for its status packet (write1ByteTxRx, write2ByteTxRx or write4ByteTxRx)
+ * @param[in,out] *arm arm
+ * @param[in] function public function of the transaction (COMM_STATS_INITIALIZE, ...)
+ * @param[in] joint joint index
+ * @param[in] address address of the control table
+ * @param[in] length data length (1, 2 or 4)
+ * @param[in] value data
+ * @return 0: success, 1: communication failure or dynamixel error
  */
-static double current2dxlvalue(double current)
+static int writeRegister(CRANE_X7_ARM *arm, int function, int joint, uint16_t address, int length, uint32_t value)
 {
-  double value = current / (DXL_VALUE_TO_CURRENT);
-  return value;
+  uint64_t start = getCommStatsTime();
+
+  if (length == 1)
+    write1ByteTxRx(arm->port_num, PROTOCOL_VERSION, arm->config.id[joint], address, (uint8_t)value);
+  else if (length == 2)
+    write2ByteTxRx(arm->port_num, PROTOCOL_VERSION, arm->config.id[joint], address, (uint16_t)value);
+  else
+    write4ByteTxRx(arm->port_num, PROTOCOL_VERSION, arm->config.id[joint], address, value);
+  recordCommLatency(&arm->stats, COMM_STATS_REGISTER_WRITE, start, 0);
+  return checkTxRxResult(arm, function, COMM_STATS_REGISTER_WRITE, 1);
 }
 
 /**
- * @fn static double dxlvalue2current(double)
- * @brief Current unit conversion function from dynamixel value to A
- * @param[in] value :current[dynamixel value]
- * @return current :current[A]
+ * @fn static int matchInitRegisters(CRANE_X7_ARM *, int, uint16_t, int, int, const uint32_t *)
+ * @brief Compare consecutive registers of a servo motor in the last block read by readInitRegisters
+ * @param[in] *arm arm
+ * @param[in] joint joint index
+ * @param[in] address address of the first register
+ * @param[in] length data length of each register (1, 2 or 4)
+ * @param[in] num number of registers
+ * @param[in] *value values of the registers (value[joint * num + register])
+ * @return 1: all registers have the value, 0: different
  */
-static double dxlvalue2current(double value)
+static int matchInitRegisters(CRANE_X7_ARM *arm, int joint, uint16_t address, int length, int num, const uint32_t *value)
 {
-  double current = value * (DXL_VALUE_TO_CURRENT);
-  return current;
+  for (int j = 0; j < num; j++)
+  {
+    if (groupSyncReadGetData(arm->groupinit_read_num, arm->config.id[joint], address + j * length, length) != value[joint * num + j])
+      return 0;
+  }
+  return 1;
 }
 
 /**
- * @fn static double current2torqueXM430W350(double)
- * @brief Conversion function from current[A] to torque[Nm] for XM430W350
- * @param[in] current :current[A]
- * @return torque :torque[Nm]
+ * @fn static int syncWriteRegisters(CRANE_X7_ARM *, int, int, const int *, uint16_t, int, int, const uint32_t *)
+ * @brief Write consecutive registers of all servo motors by one sync write (no status packet is returned).
+ *        With verify, the servo motors whose registers already have the value in the block read by openCranex7Arm are skipped.
+ * @param[in,out] *arm arm
+ * @param[in] function public function of the transaction (COMM_STATS_INITIALIZE, ...)
+ * @param[in] group_num Groupsyncwrite Struct number of the registers (created with address and length * num)
+ * @param[in] *verify verify[joint] 1: skip the servo motor if it already has the value (only in openCranex7Arm, NULL: write all)
+ * @param[in] address address of the first register
+ * @param[in] length data length of each register (1, 2 or 4)
+ * @param[in] num number of registers
+ * @param[in] *value values of the registers (value[joint * num + register])
+ * @return 0: success, 1: communication failure
  */
-static double current2torqueXM430W350(double current)
+static int syncWriteRegisters(CRANE_X7_ARM *arm, int function, int group_num, const int *verify, uint16_t address, int length, int num, const uint32_t *value)
 {
-  double torque = current * (CURRENT_TO_TORQUE_XM430W350);
-  return torque;
+  int servo_num = 0;
+  uint64_t start;
+
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    if ((verify != NULL) && verify[i] && matchInitRegisters(arm, i, address, length, num, value))
+      continue;
+    for (int j = 0; j < num; j++)
+    {
+      if (groupSyncWriteAddParam(group_num, arm->config.id[i], value[i * num + j], length) != True)
+      {
+        fprintf(stderr, "[ID:%03d] groupSyncWrite addparam failed", arm->config.id[i]);
+        groupSyncWriteClearParam(group_num);
+        return 1;
+      }
+    }
+    servo_num++;
+  }
+  if (servo_num == 0)
+    return 0;
+  start = getCommStatsTime();
+  groupSyncWriteTxPacket(group_num);
+  recordCommLatency(&arm->stats, COMM_STATS_SYNC_WRITE, start, 0);
+  groupSyncWriteClearParam(group_num);
+  return checkTxRxResult(arm, function, COMM_STATS_SYNC_WRITE, 0);
 }
 
 /**
- * @fn static double current2torqueXM540W270(double)
- * @brief Conversion function from current[A] to torque[Nm] for XM540W270
- * @param[in] current :current[A]
- * @return torque :torque[Nm]
+ * @fn static void getCycleIndirectAddress(CRANE_X7_ARM *, uint32_t *)
+ * @brief Indirect addresses which map the goal value and the present value of each servo motor to one contiguous indirect data block.
+ *        Command part : the goal register of the operating mode (position, velocity or current)
+ *        State part   : present current, present velocity and present position
+ *        Indirect addresses can be changed only while the torque is disabled.
+ * @param[in] *arm arm (joint_operating_mode is set)
+ * @param[out] *address indirect addresses (address[joint * CYCLE_DATA_LENGTH + byte])
  */
-static double current2torqueXM540W270(double current)
+static void getCycleIndirectAddress(CRANE_X7_ARM *arm, uint32_t *address)
 {
-  double torque = current * (CURRENT_TO_TORQUE_XM540W270);
-  return torque;
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    uint32_t *joint_address = &address[i * CYCLE_DATA_LENGTH];
+
+    // command part
+    for (int j = 0; j < CYCLE_COMMAND_DATA_LENGTH; j++)
+    {
+      if (arm->joint_operating_mode[i] == CURRENT_CONTROL_MODE)
+      {
+        joint_address[j] = GOAL_CURRENT_ADDRESS + (j % GOAL_CURRENT_DATA_LENGTH); // goal current (2byte) is mapped twice
+      }
+      else if (arm->joint_operating_mode[i] == VELOCITY_CONTROL_MODE)
+      {
+        joint_address[j] = GOAL_VELOCITY_ADDRESS + j;
+      }
+      else
+      {
+        joint_address[j] = GOAL_POSITION_ADDRESS + j;
+      }
+    }
+    // state part
+    for (int j = 0; j < CYCLE_STATE_DATA_LENGTH; j++)
+    {
+      joint_address[CYCLE_COMMAND_DATA_LENGTH + j] = PRESENT_VALUE_ADDRESS + j;
+    }
+  }
 }
 
 /**
- * @fn static double torque2currentXM430W350(double)
- * @brief Conversion function from torque[Nm] to current[A] for XM430W350
- * @param[in] torque :torque[Nm]
- * @return current :current[A]
+ * @fn static int readInitRegisters(CRANE_X7_ARM *)
+ * @brief Read the control table block of openCranex7Arm from all servo motors by one sync read (also checks the connection).
+ *        Read before the settings are written (verify) and after them (the sync writes return no status packet).
+ * @param[in,out] *arm arm
+ * @return 0: success, 1: communication failure or a servo motor did not respond
  */
-static double torque2currentXM430W350(double torque)
+static int readInitRegisters(CRANE_X7_ARM *arm)
 {
-  double current = torque / (CURRENT_TO_TORQUE_XM430W350);
-  return current;
+  uint64_t start = getCommStatsTime();
+
+  groupSyncReadTxRxPacket(arm->groupinit_read_num);
+  recordCommLatency(&arm->stats, COMM_STATS_SYNC_READ, start, 0);
+  if (checkTxRxResult(arm, COMM_STATS_INITIALIZE, COMM_STATS_SYNC_READ, 0))
+  {
+    return 1;
+  }
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    if (groupSyncReadIsAvailable(arm->groupinit_read_num, arm->config.id[i], INIT_READ_ADDRESS, INIT_READ_DATA_LENGTH) != True)
+    {
+      fprintf(stderr, "[ID:%03d] groupSyncRead getdata failed", arm->config.id[i]);
+      return 1;
+    }
+  }
+  return 0;
 }
 
 /**
- * @fn static double torque2currentXM540W270(double)
- * @brief Conversion function from torque[Nm] to current[A] for XM540W270
- * @param[in] torque :torque[Nm]
- * @return current :current[A]
+ * @fn static uint16_t calcPacketCrc(const uint8_t *, size_t)
+ * @brief CRC-16 of the dynamixel protocol 2.0 packet (polynomial 0x8005)
  */
-static double torque2currentXM540W270(double torque)
+static uint16_t calcPacketCrc(const uint8_t *data, size_t length)
 {
-  double current = torque / (CURRENT_TO_TORQUE_XM540W270);
-  return current;
+  uint16_t crc = 0;
+
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= (uint16_t)(data[i] << 8);
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
 }
 
-//// Communication functions for CRANE-X7 ////
+/**
+ * @fn static size_t buildZeroSyncWritePacket(const uint8_t *, uint8_t *, uint16_t, uint16_t)
+ * @brief Build a sync write packet of the protocol 2.0 which writes 0 to the registers of all servo motors.
+ *        No byte stuffing is needed: the IDs, the address and the data never make 0xFF 0xFF 0xFD.
+ * @param[in] *id ID of each servo motor
+ * @param[out] *packet packet (14 + JOINT_NUM * (1 + data_length) bytes)
+ * @param[in] address address of the registers
+ * @param[in] data_length data length of the registers of a servo motor
+ * @return packet length
+ */
+static size_t buildZeroSyncWritePacket(const uint8_t *id, uint8_t *packet, uint16_t address, uint16_t data_length)
+{
+  uint16_t length = 3 + 4 + JOINT_NUM * (1 + data_length); // instruction, parameters and CRC
+  uint16_t crc;
+  size_t n = 0;
+
+  packet[n++] = 0xFF; // header
+  packet[n++] = 0xFF;
+  packet[n++] = 0xFD;
+  packet[n++] = 0x00; // reserved
+  packet[n++] = BROADCAST_ID;
+  packet[n++] = (uint8_t)(length & 0xFF);
+  packet[n++] = (uint8_t)(length >> 8);
+  packet[n++] = SYNC_WRITE_INSTRUCTION;
+  packet[n++] = (uint8_t)(address & 0xFF);
+  packet[n++] = (uint8_t)(address >> 8);
+  packet[n++] = (uint8_t)(data_length & 0xFF);
+  packet[n++] = (uint8_t)(data_length >> 8);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    packet[n++] = id[i];
+    for (int j = 0; j < data_length; j++)
+    {
+      packet[n++] = 0;
+    }
+  }
+  crc = calcPacketCrc(packet, n);
+  packet[n++] = (uint8_t)(crc & 0xFF);
+  packet[n++] = (uint8_t)(crc >> 8);
+  return n;
+}
 
 /**
- * @fn int initilizeCranex7(uint8_t *)
- * @brief Initilizetion function of CRANE-X7
- * @param[in] *operationg_mode An array containing the operating modes of each servo motor.
- * @return Success or failure of initilizetion.
+ * @fn static void openEmergencyBrake(CRANE_X7_ARM *)
+ * @brief Prepare the packets of emergencyBrakeCranex7Arm and open the serial port again for them
+ *        (the line settings of DynamixelSDK are shared by the file descriptors of the same port)
+ * @param[in,out] *arm arm
  */
-int initilizeCranex7(uint8_t *operating_mode_array)
+static void openEmergencyBrake(CRANE_X7_ARM *arm)
+{
+  int fd;
+
+  arm->brake_packet_length = buildZeroSyncWritePacket(arm->config.id, arm->brake_packet, VELOCITY_I_GAIN_ADDRESS, GAIN_DATA_LENGTH);
+  arm->brake_packet_length += buildZeroSyncWritePacket(arm->config.id, arm->brake_packet + arm->brake_packet_length, GOAL_CURRENT_ADDRESS, GOAL_CURRENT_DATA_LENGTH);
+  fd = open(arm->config.serial_port, O_WRONLY | O_NOCTTY);
+  if (fd < 0)
+  {
+    printf("Emergency brake is not available : %s (%s)\n", arm->config.serial_port, strerror(errno));
+    return;
+  }
+  __atomic_store_n(&arm->brake_fd, fd, __ATOMIC_RELEASE);
+}
+
+/**
+ * @fn static int configureServos(CRANE_X7_ARM *, uint8_t *)
+ * @brief Open the port and set the operating mode, the indirect addresses, the gains and the profile velocity
+ *        (a sync write of each setting between two sync reads: the second one checks that the servo motors took the settings)
+ * @param[in,out] *arm arm whose groups are created (openCranex7Arm)
+ * @param[in] *operating_mode_array operating mode of each servo motor (NULL: only the torque is disabled, the other settings are kept)
+ * @return Success or failure.
+ */
+static int configureServos(CRANE_X7_ARM *arm, uint8_t *operating_mode_array)
 {
-  port_num = portHandler(SERIAL_PORT);                         // Initialize PortHandler Structs
-  packetHandler();                                             // Initialize PacketHandler Structs
-  groupwrite_num = groupBulkWrite(port_num, PROTOCOL_VERSION); // Initialize PortHandler Structs
-  //groupread_num = 0;
+  const char *verify_init = getenv(VERIFY_INIT_ENV);
+  int verify_enabled = ((verify_init != NULL) && (strcmp(verify_init, "1") == 0));
+  int verify[JOINT_NUM], verify_control[JOINT_NUM];
+  uint32_t torque_enable[JOINT_NUM], operating_mode[JOINT_NUM], profile_velocity[JOINT_NUM];
+  uint32_t gain[JOINT_NUM][GAIN_DATA_LENGTH / 2]; // in the order of the addresses
+  uint32_t indirect_address[JOINT_NUM * CYCLE_DATA_LENGTH];
+  const struct
+  {
+    const char *name;
+    uint16_t address;
+    int length;
+    int num;
+    const uint32_t *value;
+  } setting[] = {{"torque enable", TORQUE_ENABLE_ADDRESS, 1, 1, torque_enable},
+                 {"operating mode", OPERATING_MODE_ADDRESS, 1, 1, operating_mode},
+                 {"indirect address", INDIRECT_ADDRESS_1_ADDRESS, INDIRECT_ADDRESS_DATA_LENGTH, CYCLE_DATA_LENGTH, indirect_address},
+                 {"gains", VELOCITY_I_GAIN_ADDRESS, 2, GAIN_DATA_LENGTH / 2, &gain[0][0]},
+                 {"profile velocity", PROFILE_VELOCITY_ADDRESS, PROFILE_VELOCITY_DATA_LENGTH, 1, profile_velocity}};
+  int setting_num = (operating_mode_array != NULL) ? (int)(sizeof(setting) / sizeof(setting[0])) : 1; // NULL: only the torque
+  int result = 0;
 
   // open serial port
-  if (openPort(port_num))
+  if (openPort(arm->port_num))
   {
     printf("Succeeded to open the port.\n");
     // set baudrate
-    if (setBaudRate(port_num, BAUDRATE))
+    if (setBaudRate(arm->port_num, arm->config.baudrate))
     {
       printf("Succeeded to change the baudrate.\n");
+      openEmergencyBrake(arm);
+      if (setSerialLowLatency(arm->config.serial_port, arm->config.latency_timer))
+      {
+        printf("Latency timer of %s is not changed (ftdi_sio needs write permission of /sys/class/tty/*/device/latency_timer).\n", arm->config.serial_port);
+      }
     }
     else
     {
@@ -199,443 +470,864 @@ int initilizeCranex7(uint8_t *operating_mode_array)
     printf("Failed to open the port.\n");
     return 1;
   }
-  // Turn off the torque to change operating mode
+  // Read the present settings once (a servo motor which does not respond fails the initialization here)
+  if (readInitRegisters(arm))
+  {
+    return 1;
+  }
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    write1ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], TORQUE_ENABLE_ADDRESS, TORQUE_DISABLE);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
+    printf("DXL#%d has been successfully connected.\n", arm->config.id[i]);
+  }
+  // Each setting is one sync write for all servo motors
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    torque_enable[i] = TORQUE_DISABLE;
+    if (operating_mode_array != NULL)
+      operating_mode[i] = operating_mode_array[i];
+    else
+      operating_mode[i] = groupSyncReadGetData(arm->groupinit_read_num, arm->config.id[i], OPERATING_MODE_ADDRESS, 1);
+    arm->joint_operating_mode[i] = (uint8_t)operating_mode[i];
+    gain[i][0] = DEFAULT_VELOCITY_I_GAIN;
+    gain[i][1] = DEFAULT_VELOCITY_P_GAIN;
+    gain[i][2] = DEFAULT_POSITION_D_GAIN;
+    gain[i][3] = DEFAULT_POSITION_I_GAIN;
+    gain[i][4] = DEFAULT_POSITION_P_GAIN;
+    profile_velocity[i] = PROFILE_VELOCITY;
+    verify[i] = verify_enabled;
+    // the gains and the profile velocity are reset when the operating mode is changed: the read values are stale
+    verify_control[i] = verify_enabled &&
+                        (groupSyncReadGetData(arm->groupinit_read_num, arm->config.id[i], OPERATING_MODE_ADDRESS, 1) == operating_mode[i]);
+  }
+  getCycleIndirectAddress(arm, indirect_address);
+  // Turn off the torque to change operating mode
+  if (syncWriteRegisters(arm, COMM_STATS_INITIALIZE, arm->groupinit_torque_num, verify, TORQUE_ENABLE_ADDRESS, 1, 1, torque_enable))
+  {
+    return 1;
+  }
+  if (operating_mode_array != NULL)
+  {
+    // Set operating mode
+    if (syncWriteRegisters(arm, COMM_STATS_INITIALIZE, arm->groupinit_mode_num, verify, OPERATING_MODE_ADDRESS, 1, 1, operating_mode))
     {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
+      printf("Failed to set operating mode.\n");
       return 1;
     }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    // Map command and present value to the indirect data block used by cycleCranex7Arm
+    if (syncWriteRegisters(arm, COMM_STATS_INITIALIZE, arm->groupinit_indirect_num, verify, INDIRECT_ADDRESS_1_ADDRESS, INDIRECT_ADDRESS_DATA_LENGTH, CYCLE_DATA_LENGTH, indirect_address))
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      printf("Failed to set indirect address.\n");
       return 1;
     }
-    else
+    // Set velocity and position gains to the defalut value
+    if (syncWriteRegisters(arm, COMM_STATS_INITIALIZE, arm->groupbrake_gain_num, verify_control, VELOCITY_I_GAIN_ADDRESS, 2, GAIN_DATA_LENGTH / 2, &gain[0][0]))
     {
-      printf("DXL#%d has been successfully connected.\n", id_array[i]);
-    }
-  }
-  // Set operating mode
-  for (int i = 0; i < JOINT_NUM; i++)
-  {
-    write1ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], OPERATING_MODE_ADDRESS, (uint8_t)operating_mode_array[i]);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
+      printf("Failed to set gains.\n");
       return 1;
     }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    // Set velocity profile
+    if (syncWriteRegisters(arm, COMM_STATS_INITIALIZE, arm->groupinit_profile_num, verify_control, PROFILE_VELOCITY_ADDRESS, PROFILE_VELOCITY_DATA_LENGTH, 1, profile_velocity))
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      printf("Failed to set profile velocity.\n");
       return 1;
     }
-    else
-    {
-      printf("Operationg mode of DXL#%d has been successfully configured.\n", id_array[i]);
-    }
   }
-  // Set position p gain to the defalut value
-  for (int i = 0; i < JOINT_NUM; i++)
+  // The sync writes return no status packet: read the block again and check that every servo motor took the settings
+  if (readInitRegisters(arm))
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], POSITION_P_GAIN_ADDRESS, (uint16_t)DEFAULT_POSITION_P_GAIN);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    return 1;
   }
-  // Set position i gain to the defalut value
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], POSITION_I_GAIN_ADDRESS, (uint16_t)DEFAULT_POSITION_I_GAIN);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    for (int n = 0; n < setting_num; n++)
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      if (!matchInitRegisters(arm, i, setting[n].address, setting[n].length, setting[n].num, setting[n].value))
+      {
+        printf("[ID:%03d] Failed to set %s.\n", arm->config.id[i], setting[n].name);
+        result = 1;
+      }
     }
   }
-  // Set position d gain to the defalut value
-  for (int i = 0; i < JOINT_NUM; i++)
+  return result;
+}
+
+/**
+ * @fn static void releaseArm(CRANE_X7_ARM *)
+ * @brief Release the group parameters, close the port and free the arm (sdk_mutex must be locked)
+ */
+static void releaseArm(CRANE_X7_ARM *arm)
+{
+  int fd;
+
+  groupBulkReadClearParam(arm->groupread_num);
+  groupSyncWriteClearParam(arm->groupcycle_write_num);
+  groupSyncReadClearParam(arm->groupcycle_read_num);
+  groupSyncReadClearParam(arm->groupinit_read_num);
+  if ((fd = __atomic_exchange_n(&arm->brake_fd, -1, __ATOMIC_ACQ_REL)) >= 0)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], POSITION_D_GAIN_ADDRESS, (uint16_t)DEFAULT_POSITION_D_GAIN);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    close(fd);
   }
-  // Set velocity p gain to the defalut value
-  for (int i = 0; i < JOINT_NUM; i++)
+  closePort(arm->port_num);
+  free(arm);
+}
+
+//// Communication functions for CRANE-X7 ////
+
+/**
+ * @fn void getDefaultCranex7ArmConfig(CRANE_X7_ARM_CONFIG *)
+ * @brief Setting of a CRANE-X7 (serial port: CRANE_X7_SERIAL_PORT or SERIAL_PORT, ID 2 - 9, baud rate and latency timer saved by bus_tuner)
+ * @param[out] *config setting to be given to openCranex7Arm (change serial_port and id for the other arms)
+ */
+void getDefaultCranex7ArmConfig(CRANE_X7_ARM_CONFIG *config)
+{
+  config->serial_port = getenv(SERIAL_PORT_ENV);
+  if (config->serial_port == NULL)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], VELOCITY_P_GAIN_ADDRESS, (uint16_t)DEFAULT_VELOCITY_P_GAIN);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    config->serial_port = SERIAL_PORT;
   }
-  // Set velocity i gain to the defalut value
-  for (int i = 0; i < JOINT_NUM; i++)
+  memcpy(config->id, id_array, sizeof(config->id));
+  memcpy(config->min_angle, min_angle_array, sizeof(config->min_angle));
+  memcpy(config->max_angle, max_angle_array, sizeof(config->max_angle));
+  memcpy(config->home_angle, home_angle_array, sizeof(config->home_angle));
+  config->baudrate = 0;
+  config->latency_timer = -1;
+}
+
+/**
+ * @fn int openCranex7Arm(CRANE_X7_ARM **, const CRANE_X7_ARM_CONFIG *, uint8_t *)
+ * @brief Open the serial port of an arm and initialize its servo motors.
+ *        Each arm has its own port, DynamixelSDK groups and statistics, so different arms can be driven by different threads.
+ *        Open (and close) the arms before their threads start communicating: DynamixelSDK reallocates its tables of ports and groups.
+ * @param[out] **arm opened arm (NULL if failed)
+ * @param[in] *config serial port and servo motors (copied)
+ * @param[in] *operating_mode_array An array containing the operating modes of each servo motor.
+ *                                  NULL: the torque is disabled and the operating modes, indirect addresses, gains and profile velocity are kept
+ *                                  (only the joint state functions may be used, e.g. bus_tuner).
+ * @return Success or failure of initilizetion.
+ */
+int openCranex7Arm(CRANE_X7_ARM **arm, const CRANE_X7_ARM_CONFIG *config, uint8_t *operating_mode_array)
+{
+  CRANE_X7_ARM *new_arm = (CRANE_X7_ARM *)calloc(1, sizeof(CRANE_X7_ARM));
+  uint64_t start = getCommStatsTime();
+  int result = 0;
+
+  *arm = NULL;
+  if (new_arm == NULL)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], VELOCITY_I_GAIN_ADDRESS, (uint16_t)DEFAULT_VELOCITY_I_GAIN);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    printf("Failed to allocate arm of %s\n", config->serial_port);
+    return 1;
   }
-  // Set velocity profile
-  for (int i = 0; i < JOINT_NUM; i++)
+  new_arm->config = *config;
+  new_arm->brake_fd = -1;
+  if ((new_arm->config.baudrate == 0) || (new_arm->config.latency_timer < 0))
+  {
+    BUS_TIMING timing;
+    int saved = (loadBusTiming(config->serial_port, &timing) == 0);
+
+    if (new_arm->config.baudrate == 0)
+      new_arm->config.baudrate = saved ? timing.baudrate : BAUDRATE;
+    if (new_arm->config.latency_timer < 0)
+      new_arm->config.latency_timer = saved ? timing.latency_timer : LATENCY_TIMER;
+  }
+  pthread_mutex_lock(&sdk_mutex);
+  new_arm->port_num = portHandler(config->serial_port);                        // Initialize PortHandler Structs
+  packetHandler();                                                              // Initialize PacketHandler Structs
+  new_arm->groupwrite_num = groupBulkWrite(new_arm->port_num, PROTOCOL_VERSION); // Initialize Groupbulkwrite Structs
+  new_arm->groupread_num = groupBulkRead(new_arm->port_num, PROTOCOL_VERSION);   // Initialize Groupbulkread Structs (reused by every getCranex7ArmJointState call)
+  new_arm->groupcycle_write_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, CYCLE_COMMAND_ADDRESS, CYCLE_COMMAND_DATA_LENGTH); // Initialize Groupsyncwrite Structs for cycleCranex7Arm
+  new_arm->groupcycle_read_num = groupSyncRead(new_arm->port_num, PROTOCOL_VERSION, CYCLE_STATE_ADDRESS, CYCLE_STATE_DATA_LENGTH);      // Initialize Groupsyncread Structs for cycleCranex7Arm
+  new_arm->groupinit_read_num = groupSyncRead(new_arm->port_num, PROTOCOL_VERSION, INIT_READ_ADDRESS, INIT_READ_DATA_LENGTH);           // Initialize Groupsyncread Structs for the registers set here
+  // Initialize Groupsyncwrite Structs for the settings of configureServos (kept in the arm: DynamixelSDK never releases a group)
+  new_arm->groupinit_torque_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, TORQUE_ENABLE_ADDRESS, 1);
+  new_arm->groupinit_mode_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, OPERATING_MODE_ADDRESS, 1);
+  new_arm->groupinit_indirect_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, INDIRECT_ADDRESS_1_ADDRESS, CYCLE_DATA_LENGTH * INDIRECT_ADDRESS_DATA_LENGTH);
+  new_arm->groupinit_profile_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, PROFILE_VELOCITY_ADDRESS, PROFILE_VELOCITY_DATA_LENGTH);
+  new_arm->groupbrake_gain_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, VELOCITY_I_GAIN_ADDRESS, GAIN_DATA_LENGTH);         // Initialize Groupsyncwrite Structs for the gains
+  new_arm->groupbrake_current_num = groupSyncWrite(new_arm->port_num, PROTOCOL_VERSION, GOAL_CURRENT_ADDRESS, GOAL_CURRENT_DATA_LENGTH); // Initialize Groupsyncwrite Structs for brakeCranex7Arm
+
+  for (int i = 0; (i < JOINT_NUM) && !result; i++)
   {
-    write4ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], PROFILE_VELOCITY_ADDRESS, (uint32_t)PROFILE_VELOCITY);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
+    // set bulk read parameter once (present positon, present velosity, present current)
+    if (groupBulkReadAddParam(new_arm->groupread_num, config->id[i], PRESENT_VALUE_ADDRESS, PRESENT_VALUE_DATA_LENGTH) != True)
     {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
+      fprintf(stderr, "[ID:%03d] groupBulkRead addparam failed", config->id[i]);
+      result = 1;
     }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    // set sync write/read parameter of cycleCranex7Arm once (command values are changed every cycle)
+    else if ((groupSyncWriteAddParam(new_arm->groupcycle_write_num, config->id[i], 0, CYCLE_COMMAND_DATA_LENGTH) != True) ||
+             (groupSyncReadAddParam(new_arm->groupcycle_read_num, config->id[i]) != True) ||
+             (groupSyncReadAddParam(new_arm->groupinit_read_num, config->id[i]) != True))
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      fprintf(stderr, "[ID:%03d] cycle parameter set failed", config->id[i]);
+      result = 1;
     }
   }
-  return 0;
+  if (!result)
+  {
+    result = configureServos(new_arm, operating_mode_array);
+  }
+  recordCommLatency(&new_arm->stats, COMM_STATS_INITIALIZE, start, result);
+  if (result)
+  {
+    releaseArm(new_arm);
+  }
+  else
+  {
+    *arm = new_arm;
+  }
+  pthread_mutex_unlock(&sdk_mutex);
+  return result;
 }
 
 /**
- * @fn void setCranex7TorqueEnable(uint8_t)
+ * @fn void setCranex7ArmTorqueEnable(CRANE_X7_ARM *, uint8_t)
  * @brief Function to enable (or disable) servo motor torque
+ * @param[in,out] *arm arm
  * @param[in] torque_enable 1:enable, 0:disable
  * @return Success or failure of enabling.
  */
-int setCranex7TorqueEnable(uint8_t torque_enable)
+int setCranex7ArmTorqueEnable(CRANE_X7_ARM *arm, uint8_t torque_enable)
 {
+  uint64_t start = getCommStatsTime();
+
   // Set torque enable
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    write1ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], TORQUE_ENABLE_ADDRESS, torque_enable);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
+    if (writeRegister(arm, COMM_STATS_TORQUE_ENABLE, i, TORQUE_ENABLE_ADDRESS, 1, torque_enable))
     {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-      return 1;
+      return recordCommLatency(&arm->stats, COMM_STATS_TORQUE_ENABLE, start, 1);
     }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    if (torque_enable)
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-      return 1;
+      printf("Turn on DXL#%d torque \n", arm->config.id[i]);
     }
     else
     {
-      if (torque_enable)
-      {
-        printf("Turn on DXL#%d torque \n", id_array[i]);
-      }
-      else
-      {
-        printf("Turn off DXL#%d torque \n", id_array[i]);
-      }
+      printf("Turn off DXL#%d torque \n", arm->config.id[i]);
     }
   }
-  return 0;
+  return recordCommLatency(&arm->stats, COMM_STATS_TORQUE_ENABLE, start, 0);
 }
 
 /**
- * @fn int setCranex7Angle(double)
- * @brief Function to set command angle
- * @param[in] angle_array[] command angle array
+ * @fn static int bulkWriteGoal(CRANE_X7_ARM *, int, uint16_t, uint16_t, const uint32_t *)
+ * @brief Write the goal register of all servo motors by one bulk write
+ * @param[in,out] *arm arm
+ * @param[in] function public function (COMM_STATS_SET_ANGLE, ...)
+ * @param[in] address address of the goal register
+ * @param[in] length data length of the goal register
+ * @param[in] *goal goal value of each servo motor
  * @return Success or failure.
  */
-int setCranex7Angle(double *angle_array)
+static int bulkWriteGoal(CRANE_X7_ARM *arm, int function, uint16_t address, uint16_t length, const uint32_t *goal)
 {
-  int32_t goal_position[JOINT_NUM] = {0};
+  uint64_t start = getCommStatsTime(), bus_start;
 
+  // set goal data to bulk write parameter
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    goal_position[i] = (int32_t)(rad2dxlvalue(angle_array[i])) + home_angle_array[i];
-    if ((goal_position[i] > max_angle_array[i]) || (min_angle_array[i]) > goal_position[i])
+    if (groupBulkWriteAddParam(arm->groupwrite_num, arm->config.id[i], address, length, goal[i], length) != True)
     {
-      printf("Out of angle range : joint %d \n", i + 1);
+      fprintf(stderr, "[ID:%03d] parameter set failed", arm->config.id[i]);
+      groupBulkWriteClearParam(arm->groupwrite_num);
+      return recordCommLatency(&arm->stats, function, start, 1);
     }
   }
-  // set goal position date to bulk write parameter
+  // transmit goal data
+  bus_start = getCommStatsTime();
+  groupBulkWriteTxPacket(arm->groupwrite_num);
+  recordCommLatency(&arm->stats, COMM_STATS_BULK_WRITE, bus_start, 0);
+  checkTxRxResult(arm, function, COMM_STATS_BULK_WRITE, 0);
+  // clear transmittion data
+  groupBulkWriteClearParam(arm->groupwrite_num);
+  return recordCommLatency(&arm->stats, function, start, 0);
+}
+
+/**
+ * @fn int setCranex7ArmAngle(CRANE_X7_ARM *, double *)
+ * @brief Function to set command angle
+ * @param[in,out] *arm arm
+ * @param[in] angle_array[] command angle array
+ * @return Success or failure.
+ */
+int setCranex7ArmAngle(CRANE_X7_ARM *arm, double *angle_array)
+{
+  uint32_t goal_position[JOINT_NUM];
+
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    addparam_result = groupBulkWriteAddParam(groupwrite_num, id_array[i], GOAL_POSITION_ADDRESS, GOAL_POSITION_DATA_LENGTH, goal_position[i], GOAL_POSITION_DATA_LENGTH);
-    if (addparam_result != True)
-    {
-      fprintf(stderr, "[ID:%03d] parameter set failed", id_array[i]);
-      return 1;
-    }
+    goal_position[i] = (uint32_t)angle2goalposition(arm, i, angle_array[i]);
   }
-  // transmit goal position data
-  groupBulkWriteTxPacket(groupwrite_num);
-  if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-  // clear transmittion data
-  groupBulkWriteClearParam(groupwrite_num);
-  return 0;
+  return bulkWriteGoal(arm, COMM_STATS_SET_ANGLE, GOAL_POSITION_ADDRESS, GOAL_POSITION_DATA_LENGTH, goal_position);
 }
 
 /**
- * @fn int setCranex7AngularVelocity(double)
+ * @fn int setCranex7ArmAngularVelocity(CRANE_X7_ARM *, double *)
  * @brief Function to set command anglular velocity
+ * @param[in,out] *arm arm
  * @param[in] angular_velocity_array[] command anglular velocity array
  * @return Success or failure.
  */
-int setCranex7AngularVelocity(double *angular_velocity_array)
+int setCranex7ArmAngularVelocity(CRANE_X7_ARM *arm, double *angular_velocity_array)
 {
-  int32_t goal_velocity[JOINT_NUM] = {0};
+  uint32_t goal_velocity[JOINT_NUM];
 
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    goal_velocity[i] = (int32_t)(angularvel2dxlvalue(angular_velocity_array[i]));
+    goal_velocity[i] = (uint32_t)(int32_t)(angularvel2dxlvalue(angular_velocity_array[i]));
   }
-  // set goal velosity data to bulk write parameter
-  for (int i = 0; i < JOINT_NUM; i++)
-  {
-    addparam_result = groupBulkWriteAddParam(groupwrite_num, id_array[i], GOAL_VELOCITY_ADDRESS, GOAL_VELOCITY_DATA_LENGTH, goal_velocity[i], GOAL_VELOCITY_DATA_LENGTH);
-    if (addparam_result != True)
-    {
-      fprintf(stderr, "[ID:%03d] parameter set failed", id_array[i]);
-      return 1;
-    }
-  }
-  // transmit goal velosity data
-  groupBulkWriteTxPacket(groupwrite_num);
-  if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-  // clear transmitton data
-  groupBulkWriteClearParam(groupwrite_num);
-  return 0;
+  return bulkWriteGoal(arm, COMM_STATS_SET_ANGULAR_VELOCITY, GOAL_VELOCITY_ADDRESS, GOAL_VELOCITY_DATA_LENGTH, goal_velocity);
 }
 
 /**
- * @fn int setCranex7Torque(double)
+ * @fn int setCranex7ArmTorque(CRANE_X7_ARM *, double *)
  * @brief Function to set command torque
+ * @param[in,out] *arm arm
  * @param[in] torque_array[] command torque array
  * @return Success or failure.
  */
-int setCranex7Torque(double *torque_array)
+int setCranex7ArmTorque(CRANE_X7_ARM *arm, double *torque_array)
 {
-  int16_t goal_current[JOINT_NUM] = {0};
+  uint32_t goal_current[JOINT_NUM];
 
   // convert torque to currrent
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    if (i == XM540_W270_JOINT)
-    {
-      goal_current[i] = (int16_t)current2dxlvalue(torque2currentXM540W270(torque_array[i]));
-    }
-    else
-    {
-      goal_current[i] = (int16_t)current2dxlvalue(torque2currentXM430W350(torque_array[i]));
-    }
+    goal_current[i] = (uint16_t)torque2goalcurrent(i, torque_array[i]);
   }
-  // set goal current to bulk write parameter
+  return bulkWriteGoal(arm, COMM_STATS_SET_TORQUE, GOAL_CURRENT_ADDRESS, GOAL_CURRENT_DATA_LENGTH, goal_current);
+}
+
+/**
+ * @fn int setCranex7ArmProfileVelocity(CRANE_X7_ARM *, double *)
+ * @brief Function to set profile velocity of position control mode (the servo motor limits the speed to the goal position)
+ * @param[in,out] *arm arm
+ * @param[in] angular_velocity_array[] profile velocity array [rad/s] (0: infinite, the goal position is followed directly)
+ * @return Success or failure.
+ */
+int setCranex7ArmProfileVelocity(CRANE_X7_ARM *arm, double *angular_velocity_array)
+{
+  uint64_t start = getCommStatsTime();
+
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    addparam_result = groupBulkWriteAddParam(groupwrite_num, id_array[i], GOAL_CURRENT_ADDRESS, GOAL_CURRENT_DATA_LENGTH, goal_current[i], GOAL_CURRENT_DATA_LENGTH);
-    if (addparam_result != True)
+    if (writeRegister(arm, COMM_STATS_SET_PROFILE_VELOCITY, i, PROFILE_VELOCITY_ADDRESS, 4, (uint32_t)angularvel2dxlvalue(angular_velocity_array[i])))
     {
-      fprintf(stderr, "[ID:%03d] parameter set failed", id_array[i]);
-      return 1;
+      return recordCommLatency(&arm->stats, COMM_STATS_SET_PROFILE_VELOCITY, start, 1);
     }
   }
-  // transmit goal current
-  groupBulkWriteTxPacket(groupwrite_num);
-  if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-  // clear transmittion data
-  groupBulkWriteClearParam(groupwrite_num);
-  return 0;
+  return recordCommLatency(&arm->stats, COMM_STATS_SET_PROFILE_VELOCITY, start, 0);
 }
 
 /**
- * @fn int getCranex7JointState(double *, double *, double *)
+ * @fn int getCranex7ArmJointState(CRANE_X7_ARM *, double *, double *, double *)
  * @brief Function to get joint state
+ * @param[in,out] *arm arm
  * @param[out] angle_array[] present angle array
  * @param[out] angular_velocity_array[] present angular velocity array
  * @param[out] torque_array[] present torque array
  * @return Success or failure.
  */
-int getCranex7JointState(double *angle_array, double *angular_velocity_array, double *torque_array)
+int getCranex7ArmJointState(CRANE_X7_ARM *arm, double *angle_array, double *angular_velocity_array, double *torque_array)
 {
   int32_t present_position[JOINT_NUM] = {0};
   int16_t present_velocity[JOINT_NUM] = {0};
   int16_t present_current[JOINT_NUM] = {0};
+  uint64_t start = getCommStatsTime(), bus_start;
 
-  groupread_num = groupBulkRead(port_num, PROTOCOL_VERSION);
-  // set bulk read parameter (present positon, present velosity, present current)
-  for (int i = 0; i < JOINT_NUM; i++)
-  {
-    addparam_result = groupBulkReadAddParam(groupread_num, id_array[i], PRESENT_VALUE_ADDRESS, PRESENT_VALUE_DATA_LENGTH);
-    if (addparam_result != True)
-    {
-      fprintf(stderr, "[ID:%03d] groupBulkRead addparam failed", id_array[i]);
-      return 1;
-    }
-  }
-  // data request and receive
-  groupBulkReadTxRxPacket(groupread_num);
-  if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
+  // data request and receive (bulk read parameters are registered in openCranex7Arm)
+  bus_start = getCommStatsTime();
+  groupBulkReadTxRxPacket(arm->groupread_num);
+  recordCommLatency(&arm->stats, COMM_STATS_BULK_READ, bus_start, 0);
+  checkTxRxResult(arm, COMM_STATS_GET_JOINT_STATE, COMM_STATS_BULK_READ, 0);
 
   // verification of received data
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    getdata_result = groupBulkReadIsAvailable(groupread_num, id_array[i], PRESENT_VALUE_ADDRESS, PRESENT_VALUE_DATA_LENGTH);
-    if (getdata_result != True)
+    if (groupBulkReadIsAvailable(arm->groupread_num, arm->config.id[i], PRESENT_VALUE_ADDRESS, PRESENT_VALUE_DATA_LENGTH) != True)
     {
-      fprintf(stderr, "[ID:%03d] groupBulkRead getdata trq failed", id_array[i]);
-      return 1;
+      fprintf(stderr, "[ID:%03d] groupBulkRead getdata trq failed", arm->config.id[i]);
+      return recordCommLatency(&arm->stats, COMM_STATS_GET_JOINT_STATE, start, 1);
     }
   }
-  // pick up present position data
-  for (int i = 0; i < JOINT_NUM; i++)
-  {
-    present_position[i] = groupBulkReadGetData(groupread_num, id_array[i], PRESENT_POSITION_ADDRESS, PRESENT_POSITION_DATA_LENGTH);
-  }
-  // pick up present velocity data
+  // pick up present position, velocity and current data
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    present_velocity[i] = groupBulkReadGetData(groupread_num, id_array[i], PRESENT_VELOCITY_ADDRESS, PRESENT_VELOCITY_DATA_LENGTH);
+    present_position[i] = groupBulkReadGetData(arm->groupread_num, arm->config.id[i], PRESENT_POSITION_ADDRESS, PRESENT_POSITION_DATA_LENGTH);
+    present_velocity[i] = groupBulkReadGetData(arm->groupread_num, arm->config.id[i], PRESENT_VELOCITY_ADDRESS, PRESENT_VELOCITY_DATA_LENGTH);
+    present_current[i] = groupBulkReadGetData(arm->groupread_num, arm->config.id[i], PRESENT_CURRENT_ADDRESS, PRESENT_CURRENT_DATA_LENGTH);
   }
-  // pick up present current data
+
+  // convert dynamixel value to physical quantity
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    present_current[i] = groupBulkReadGetData(groupread_num, id_array[i], PRESENT_CURRENT_ADDRESS, PRESENT_CURRENT_DATA_LENGTH);
+    presentvalue2jointstate(arm, i, present_position[i], present_velocity[i], present_current[i],
+                            &angle_array[i], &angular_velocity_array[i], &torque_array[i]);
   }
+  return recordCommLatency(&arm->stats, COMM_STATS_GET_JOINT_STATE, start, 0);
+}
 
-  // convert dynamixel value to physical quantity
+/**
+ * @fn int cycleCranex7Arm(CRANE_X7_ARM *, double *, double *, double *, double *)
+ * @brief Function to send command and get joint state in one bus cycle.
+ *        The command is sent by a sync write (no status packet) immediately followed by a sync read
+ *        of the same indirect data block, so one cycle needs only one round trip.
+ *        The meaning of the command depends on the operating mode of each joint given to openCranex7Arm
+ *        (position mode:angle[rad], velocity mode:angular velocity[rad/s], current mode:torque[Nm]).
+ * @param[in,out] *arm arm
+ * @param[in] command_array[] command array
+ * @param[out] angle_array[] present angle array
+ * @param[out] angular_velocity_array[] present angular velocity array
+ * @param[out] torque_array[] present torque array
+ * @return Success or failure.
+ */
+int cycleCranex7Arm(CRANE_X7_ARM *arm, double *command_array, double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  uint32_t command;
+  int32_t present_position;
+  int16_t present_velocity;
+  int16_t present_current;
+  uint64_t start = getCommStatsTime(), bus_start;
+
+  // update command data of sync write parameter
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    angle_array[i] = dxlvalue2rad((double)(present_position[i] - (int32_t)home_angle_array[i]));
-    angular_velocity_array[i] = dxlvalue2angularvel((double)present_velocity[i]);
-    if (i == XM540_W270_JOINT)
+    if (arm->joint_operating_mode[i] == CURRENT_CONTROL_MODE)
     {
-      torque_array[i] = current2torqueXM540W270(dxlvalue2current((double)present_current[i]));
+      uint16_t goal_current = (uint16_t)torque2goalcurrent(i, command_array[i]);
+      command = ((uint32_t)goal_current << 16) | goal_current; // goal current is mapped twice
+    }
+    else if (arm->joint_operating_mode[i] == VELOCITY_CONTROL_MODE)
+    {
+      command = (uint32_t)(int32_t)angularvel2dxlvalue(command_array[i]);
     }
     else
     {
-      torque_array[i] = current2torqueXM430W350(dxlvalue2current((double)present_current[i]));
+      command = (uint32_t)angle2goalposition(arm, i, command_array[i]);
+    }
+    if (groupSyncWriteChangeParam(arm->groupcycle_write_num, arm->config.id[i], command, CYCLE_COMMAND_DATA_LENGTH, 0) != True)
+    {
+      fprintf(stderr, "[ID:%03d] parameter set failed", arm->config.id[i]);
+      return recordCommLatency(&arm->stats, COMM_STATS_CYCLE, start, 1);
     }
   }
-  return 0;
+  // transmit command (no status packet is returned)
+  bus_start = getCommStatsTime();
+  groupSyncWriteTxPacket(arm->groupcycle_write_num);
+  recordCommLatency(&arm->stats, COMM_STATS_SYNC_WRITE, bus_start, 0);
+  checkTxRxResult(arm, COMM_STATS_CYCLE, COMM_STATS_SYNC_WRITE, 0);
+
+  // request and receive present value
+  bus_start = getCommStatsTime();
+  groupSyncReadTxRxPacket(arm->groupcycle_read_num);
+  recordCommLatency(&arm->stats, COMM_STATS_SYNC_READ, bus_start, 0);
+  checkTxRxResult(arm, COMM_STATS_CYCLE, COMM_STATS_SYNC_READ, 0);
+
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    if (groupSyncReadIsAvailable(arm->groupcycle_read_num, arm->config.id[i], CYCLE_STATE_ADDRESS, CYCLE_STATE_DATA_LENGTH) != True)
+    {
+      fprintf(stderr, "[ID:%03d] groupSyncRead getdata failed", arm->config.id[i]);
+      return recordCommLatency(&arm->stats, COMM_STATS_CYCLE, start, 1);
+    }
+    // the state part has the same layout as PRESENT_VALUE_ADDRESS (current, velocity, position)
+    present_current = groupSyncReadGetData(arm->groupcycle_read_num, arm->config.id[i], CYCLE_STATE_ADDRESS + (PRESENT_CURRENT_ADDRESS - PRESENT_VALUE_ADDRESS), PRESENT_CURRENT_DATA_LENGTH);
+    present_velocity = groupSyncReadGetData(arm->groupcycle_read_num, arm->config.id[i], CYCLE_STATE_ADDRESS + (PRESENT_VELOCITY_ADDRESS - PRESENT_VALUE_ADDRESS), PRESENT_VELOCITY_DATA_LENGTH);
+    present_position = groupSyncReadGetData(arm->groupcycle_read_num, arm->config.id[i], CYCLE_STATE_ADDRESS + (PRESENT_POSITION_ADDRESS - PRESENT_VALUE_ADDRESS), PRESENT_POSITION_DATA_LENGTH);
+    presentvalue2jointstate(arm, i, present_position, present_velocity, present_current,
+                            &angle_array[i], &angular_velocity_array[i], &torque_array[i]);
+  }
+  return recordCommLatency(&arm->stats, COMM_STATS_CYCLE, start, 0);
 }
 
 /**
- * @fn void closeCranex7Port(void)
- * @brief Close port
+ * @fn void brakeCranex7Arm(CRANE_X7_ARM *)
+ * @brief Brake joints (two sync writes, see emergencyBrakeCranex7Arm for a signal handler or another thread)
+ * @param[in,out] *arm arm
  */
-void closeCranex7Port(void)
+void brakeCranex7Arm(CRANE_X7_ARM *arm)
 {
-  // Close port
-  closePort(port_num);
-  printf("close com port\n");
+  uint32_t zero[JOINT_NUM * GAIN_DATA_LENGTH / 2] = {0};
+  uint64_t start = getCommStatsTime();
+
+  //// set position and velocity feedback gains to 0 then joints act like braking (if position or velocity control mode).
+  syncWriteRegisters(arm, COMM_STATS_BRAKE, arm->groupbrake_gain_num, NULL, VELOCITY_I_GAIN_ADDRESS, 2, GAIN_DATA_LENGTH / 2, zero);
+  //// set goal current to 0 then joints act like braking (if current control mode).
+  syncWriteRegisters(arm, COMM_STATS_BRAKE, arm->groupbrake_current_num, NULL, GOAL_CURRENT_ADDRESS, GOAL_CURRENT_DATA_LENGTH, 1, zero);
+  recordCommLatency(&arm->stats, COMM_STATS_BRAKE, start, 0);
 }
 
 /**
- * @fn void brakeCranex7Joint(void)
- * @brief Brake joints
+ * @fn int emergencyBrakeCranex7Arm(CRANE_X7_ARM *)
+ * @brief Brake joints with the packets prepared by openCranex7Arm (the same registers as brakeCranex7Arm).
+ *        Only async-signal-safe system calls are used, so it can be called from a signal handler or a watchdog thread
+ *        while another thread communicates. A write to the port is not interleaved with the packets of DynamixelSDK,
+ *        but the packets are sent EMERGENCY_BRAKE_REPEAT times in case they collide with a status packet on the bus.
+ *        The communication statistics are not recorded.
+ * @param[in] *arm opened arm (not closed during the call)
+ * @return 0: sent, 1: the port is not opened or writing failed
  */
-void brakeCranex7Joint(void)
+int emergencyBrakeCranex7Arm(CRANE_X7_ARM *arm)
 {
+  int fd = __atomic_load_n(&arm->brake_fd, __ATOMIC_ACQUIRE);
+  int saved_errno = errno;
+  struct timespec interval = {0, EMERGENCY_BRAKE_INTERVAL};
+  int result = 0;
 
-  //// set position feedback gain to 0 then joints act like braking (if position control mode).
-  // set position d gain to 0
-  for (int i = 0; i < JOINT_NUM; i++)
+  if (fd < 0)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], POSITION_D_GAIN_ADDRESS, (uint16_t)0);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    return 1;
   }
-  // set position i gain to 0
-  for (int i = 0; i < JOINT_NUM; i++)
+  for (int n = 0; n < EMERGENCY_BRAKE_REPEAT; n++)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], POSITION_I_GAIN_ADDRESS, (uint16_t)0);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    const uint8_t *p = arm->brake_packet;
+    size_t size = arm->brake_packet_length;
+
+    if (n > 0)
+      nanosleep(&interval, NULL);
+    while (size > 0)
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      ssize_t written = write(fd, p, size);
+      if (written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        result = 1;
+        break;
+      }
+      p += written;
+      size -= (size_t)written;
     }
+    tcdrain(fd);
   }
-  // set position p gain to 0
-  for (int i = 0; i < JOINT_NUM; i++)
+  errno = saved_errno;
+  return result;
+}
+
+/**
+ * @fn void getCranex7ArmCommStats(CRANE_X7_ARM *, COMM_STATS *)
+ * @brief Copy the statistics of the arm from openCranex7Arm (or resetCranex7ArmCommStats).
+ *        Call it from the thread of the communication functions of the arm or after the thread is stopped.
+ * @param[in] *arm arm
+ * @param[out] *stats statistics
+ */
+void getCranex7ArmCommStats(CRANE_X7_ARM *arm, COMM_STATS *stats)
+{
+  memcpy(stats, &arm->stats, sizeof(COMM_STATS));
+}
+
+/**
+ * @fn void resetCranex7ArmCommStats(CRANE_X7_ARM *)
+ * @brief Clear the statistics of the arm (e.g. after openCranex7Arm to measure only the control loop)
+ * @param[in,out] *arm arm
+ */
+void resetCranex7ArmCommStats(CRANE_X7_ARM *arm)
+{
+  memset(&arm->stats, 0, sizeof(COMM_STATS));
+}
+
+/**
+ * @fn void getCranex7ArmConfig(CRANE_X7_ARM *, CRANE_X7_ARM_CONFIG *)
+ * @brief Setting of the opened arm (baudrate is the one in use)
+ * @param[in] *arm arm
+ * @param[out] *config setting
+ */
+void getCranex7ArmConfig(CRANE_X7_ARM *arm, CRANE_X7_ARM_CONFIG *config)
+{
+  *config = arm->config;
+}
+
+/**
+ * @fn int setCranex7ArmBusTiming(CRANE_X7_ARM *, uint32_t, uint8_t)
+ * @brief Change the return delay time and the baud rate of all servo motors (broadcast, no status packet) and the baud rate of the port.
+ *        Both are EEPROM registers, so the torque must be disabled and the servo motors keep them after the power is turned off.
+ *        The port uses the new baud rate only until closeCranex7Arm: save it with saveBusTiming (bus_tuner) for openCranex7Arm.
+ * @param[in,out] *arm arm
+ * @param[in] baudrate baud rate [bps] (9600, 57600, 115200, 1M, 2M, 3M, 4M or 4.5M, not 4.5M with dxl_native)
+ * @param[in] return_delay_time delay of the status packet [2us] (0 - 254)
+ * @return 0: success, 1: unsupported baud rate or failure
+ */
+int setCranex7ArmBusTiming(CRANE_X7_ARM *arm, uint32_t baudrate, uint8_t return_delay_time)
+{
+  struct timespec wait = {0, BAUDRATE_CHANGE_WAIT};
+  int baudrate_value = -1;
+
+  for (int i = 0; i < (int)(sizeof(baudrate_array) / sizeof(baudrate_array[0])); i++)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], POSITION_P_GAIN_ADDRESS, (uint16_t)0);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    if (baudrate_array[i] == baudrate)
+      baudrate_value = i;
   }
-  //// set velocity feedback gain to 0 then joints act like braking (if velocity control mode).
-  // set velocity i gain to 0
-  for (int i = 0; i < JOINT_NUM; i++)
+  if (baudrate_value < 0)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], VELOCITY_I_GAIN_ADDRESS, (uint16_t)0);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
-    {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
-    }
+    printf("Unsupported baudrate : %u\n", baudrate);
+    return 1;
+  }
+#ifdef DXL_NATIVE
+  // the servo motors are switched first: a baud rate the port cannot follow would lose them
+  if (!isBaudRateSupported((int)baudrate))
+  {
+    printf("Unsupported baudrate of dxl_native : %u\n", baudrate);
+    return 1;
+  }
+#endif
+  write1ByteTxOnly(arm->port_num, PROTOCOL_VERSION, BROADCAST_ID, RETURN_DELAY_TIME_ADDRESS, return_delay_time);
+  if (checkTxRxResult(arm, COMM_STATS_INITIALIZE, COMM_STATS_REGISTER_WRITE, 0))
+  {
+    return 1;
+  }
+  if (baudrate == arm->config.baudrate)
+  {
+    return 0;
+  }
+  write1ByteTxOnly(arm->port_num, PROTOCOL_VERSION, BROADCAST_ID, BAUD_RATE_ADDRESS, (uint8_t)baudrate_value);
+  if (checkTxRxResult(arm, COMM_STATS_INITIALIZE, COMM_STATS_REGISTER_WRITE, 0))
+  {
+    return 1;
+  }
+  // the packet must leave the port before its baud rate is changed
+  if (__atomic_load_n(&arm->brake_fd, __ATOMIC_ACQUIRE) >= 0)
+  {
+    tcdrain(arm->brake_fd);
+  }
+  nanosleep(&wait, NULL);
+  if (!setBaudRate(arm->port_num, baudrate))
+  {
+    printf("Failed to change the baudrate.\n");
+    return 1;
+  }
+  arm->config.baudrate = baudrate;
+  return 0;
+}
+
+/**
+ * @fn int getCranex7ArmReturnDelayTime(CRANE_X7_ARM *, uint8_t *)
+ * @brief Read the return delay time of each servo motor (one sync read of the control table block of openCranex7Arm)
+ * @param[in,out] *arm arm
+ * @param[out] *return_delay_time_array return delay time of each servo motor [2us]
+ * @return 0: success, 1: communication failure or a servo motor did not respond
+ */
+int getCranex7ArmReturnDelayTime(CRANE_X7_ARM *arm, uint8_t *return_delay_time_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  groupSyncReadTxRxPacket(arm->groupinit_read_num);
+  recordCommLatency(&arm->stats, COMM_STATS_SYNC_READ, start, 0);
+  if (checkTxRxResult(arm, COMM_STATS_INITIALIZE, COMM_STATS_SYNC_READ, 0))
+  {
+    return 1;
   }
-  // set velocity p gain to 0
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], VELOCITY_P_GAIN_ADDRESS, (uint16_t)0);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    if (groupSyncReadIsAvailable(arm->groupinit_read_num, arm->config.id[i], RETURN_DELAY_TIME_ADDRESS, 1) != True)
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      fprintf(stderr, "[ID:%03d] groupSyncRead getdata failed", arm->config.id[i]);
+      return 1;
     }
+    return_delay_time_array[i] = (uint8_t)groupSyncReadGetData(arm->groupinit_read_num, arm->config.id[i], RETURN_DELAY_TIME_ADDRESS, 1);
   }
-  //// set goal current to 0 then joints act like braking (if current control mode).
-  // set goal current to 0
+  return 0;
+}
+
+/**
+ * @fn int setCranex7ArmReturnDelayTime(CRANE_X7_ARM *, const uint8_t *)
+ * @brief Write the return delay time of each servo motor (EEPROM register: the torque must be disabled)
+ * @param[in,out] *arm arm
+ * @param[in] *return_delay_time_array return delay time of each servo motor [2us] (0 - 254)
+ * @return 0: success, 1: communication failure or dynamixel error
+ */
+int setCranex7ArmReturnDelayTime(CRANE_X7_ARM *arm, const uint8_t *return_delay_time_array)
+{
   for (int i = 0; i < JOINT_NUM; i++)
   {
-    write2ByteTxRx(port_num, PROTOCOL_VERSION, id_array[i], GOAL_CURRENT_ADDRESS, (int16_t)0);
-    if ((comm_result = getLastTxRxResult(port_num, PROTOCOL_VERSION)) != COMM_SUCCESS)
-    {
-      printf("%s\n", getTxRxResult(PROTOCOL_VERSION, comm_result));
-    }
-    else if ((dxl_error = getLastRxPacketError(port_num, PROTOCOL_VERSION)) != 0)
+    if (writeRegister(arm, COMM_STATS_INITIALIZE, i, RETURN_DELAY_TIME_ADDRESS, 1, return_delay_time_array[i]))
     {
-      printf("%s\n", getRxPacketError(PROTOCOL_VERSION, dxl_error));
+      return 1;
     }
   }
+  return 0;
+}
+
+/**
+ * @fn void closeCranex7Arm(CRANE_X7_ARM *)
+ * @brief Close port of the arm and free it (the communication latency and error counts are printed)
+ * @param[in] *arm arm
+ */
+void closeCranex7Arm(CRANE_X7_ARM *arm)
+{
+  printCranex7CommStats(&arm->stats);
+  // release group parameters and close port
+  pthread_mutex_lock(&sdk_mutex);
+  releaseArm(arm);
+  pthread_mutex_unlock(&sdk_mutex);
+  printf("close com port\n");
+}
+
+//// Single arm functions (the arm opened by initilizeCranex7) ////
+
+/**
+ * @fn CRANE_X7_ARM *getDefaultCranex7Arm(void)
+ * @brief Arm opened by initilizeCranex7 (e.g. to start its bus thread)
+ * @return arm (NULL before initilizeCranex7 or after closeCranex7Port)
+ */
+CRANE_X7_ARM *getDefaultCranex7Arm(void)
+{
+  return __atomic_load_n(&default_arm, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @fn int initilizeCranex7(uint8_t *)
+ * @brief Initilizetion function of CRANE-X7 (openCranex7Arm with getDefaultCranex7ArmConfig)
+ * @param[in] *operationg_mode An array containing the operating modes of each servo motor.
+ * @return Success or failure of initilizetion.
+ */
+int initilizeCranex7(uint8_t *operating_mode_array)
+{
+  CRANE_X7_ARM_CONFIG config;
+  CRANE_X7_ARM *arm;
+  int result;
+
+  getDefaultCranex7ArmConfig(&config);
+  result = openCranex7Arm(&arm, &config, operating_mode_array);
+  __atomic_store_n(&default_arm, arm, __ATOMIC_RELEASE);
+  return result;
+}
+
+/**
+ * @fn void setCranex7TorqueEnable(uint8_t)
+ * @brief Function to enable (or disable) servo motor torque
+ * @param[in] torque_enable 1:enable, 0:disable
+ * @return Success or failure of enabling.
+ */
+int setCranex7TorqueEnable(uint8_t torque_enable)
+{
+  return (default_arm != NULL) ? setCranex7ArmTorqueEnable(default_arm, torque_enable) : 1;
+}
+
+/**
+ * @fn int setCranex7Angle(double *)
+ * @brief Function to set command angle
+ * @param[in] angle_array[] command angle array
+ * @return Success or failure.
+ */
+int setCranex7Angle(double *angle_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmAngle(default_arm, angle_array) : 1;
+}
+
+/**
+ * @fn int setCranex7AngularVelocity(double *)
+ * @brief Function to set command anglular velocity
+ * @param[in] angular_velocity_array[] command anglular velocity array
+ * @return Success or failure.
+ */
+int setCranex7AngularVelocity(double *angular_velocity_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmAngularVelocity(default_arm, angular_velocity_array) : 1;
+}
+
+/**
+ * @fn int setCranex7Torque(double *)
+ * @brief Function to set command torque
+ * @param[in] torque_array[] command torque array
+ * @return Success or failure.
+ */
+int setCranex7Torque(double *torque_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmTorque(default_arm, torque_array) : 1;
+}
+
+/**
+ * @fn int setCranex7ProfileVelocity(double *)
+ * @brief Function to set profile velocity of position control mode (the servo motor limits the speed to the goal position)
+ * @param[in] angular_velocity_array[] profile velocity array [rad/s] (0: infinite, the goal position is followed directly)
+ * @return Success or failure.
+ */
+int setCranex7ProfileVelocity(double *angular_velocity_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmProfileVelocity(default_arm, angular_velocity_array) : 1;
+}
+
+/**
+ * @fn int getCranex7JointState(double *, double *, double *)
+ * @brief Function to get joint state
+ * @param[out] angle_array[] present angle array
+ * @param[out] angular_velocity_array[] present angular velocity array
+ * @param[out] torque_array[] present torque array
+ * @return Success or failure.
+ */
+int getCranex7JointState(double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  return (default_arm != NULL) ? getCranex7ArmJointState(default_arm, angle_array, angular_velocity_array, torque_array) : 1;
+}
+
+/**
+ * @fn int cycleCranex7(double *, double *, double *, double *)
+ * @brief Function to send command and get joint state in one bus cycle (see cycleCranex7Arm)
+ * @param[in] command_array[] command array
+ * @param[out] angle_array[] present angle array
+ * @param[out] angular_velocity_array[] present angular velocity array
+ * @param[out] torque_array[] present torque array
+ * @return Success or failure.
+ */
+int cycleCranex7(double *command_array, double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  return (default_arm != NULL) ? cycleCranex7Arm(default_arm, command_array, angle_array, angular_velocity_array, torque_array) : 1;
+}
+
+/**
+ * @fn void brakeCranex7Joint(void)
+ * @brief Brake joints (two sync writes, see emergencyBrakeCranex7 for a signal handler or another thread)
+ */
+void brakeCranex7Joint(void)
+{
+  if (default_arm != NULL)
+    brakeCranex7Arm(default_arm);
+}
+
+/**
+ * @fn int emergencyBrakeCranex7(void)
+ * @brief Brake joints from a signal handler or a watchdog thread (see emergencyBrakeCranex7Arm)
+ * @return 0: sent, 1: the port is not opened or writing failed
+ */
+int emergencyBrakeCranex7(void)
+{
+  CRANE_X7_ARM *arm = __atomic_load_n(&default_arm, __ATOMIC_ACQUIRE);
+
+  return (arm != NULL) ? emergencyBrakeCranex7Arm(arm) : 1;
+}
+
+/**
+ * @fn void getCranex7CommStats(COMM_STATS *)
+ * @brief Copy the statistics from initilizeCranex7 (or resetCranex7CommStats).
+ *        Call it from the thread of the communication functions or after the thread is stopped.
+ * @param[out] *stats statistics (all 0 before initilizeCranex7)
+ */
+void getCranex7CommStats(COMM_STATS *stats)
+{
+  if (default_arm != NULL)
+    getCranex7ArmCommStats(default_arm, stats);
+  else
+    memset(stats, 0, sizeof(COMM_STATS));
+}
+
+/**
+ * @fn void resetCranex7CommStats(void)
+ * @brief Clear the statistics (e.g. after initilizeCranex7 to measure only the control loop)
+ */
+void resetCranex7CommStats(void)
+{
+  if (default_arm != NULL)
+    resetCranex7ArmCommStats(default_arm);
+}
+
+/**
+ * @fn void closeCranex7Port(void)
+ * @brief Close port (the communication latency and error counts are printed)
+ */
+void closeCranex7Port(void)
+{
+  CRANE_X7_ARM *arm = __atomic_exchange_n(&default_arm, NULL, __ATOMIC_ACQ_REL);
+
+  if (arm != NULL)
+    closeCranex7Arm(arm);
 }
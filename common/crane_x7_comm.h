@@ -23,10 +23,14 @@
 #define CRANE_X7_CONTROL_H_
 
 #include <stdint.h>
+#include "comm_stats.h"
+#include "arm_parameter.h"
 
 //// Definition of dynamixel ////
 
 // Data address of dynamixel x
+#define BAUD_RATE_ADDRESS (8)
+#define RETURN_DELAY_TIME_ADDRESS (9)
 #define OPERATING_MODE_ADDRESS (11)
 #define TORQUE_ENABLE_ADDRESS (64)
 #define VELOCITY_I_GAIN_ADDRESS (76)
@@ -43,6 +47,8 @@
 #define PRESENT_VELOCITY_ADDRESS (128)
 #define PRESENT_POSITION_ADDRESS (132)
 #define PRESENT_VALUE_ADDRESS (126)
+#define INDIRECT_ADDRESS_1_ADDRESS (168)
+#define INDIRECT_DATA_1_ADDRESS (224)
 
 // Data length
 #define BUS_WATCHDOG_DATA_LENGTH (1)
@@ -54,8 +60,21 @@
 #define PRESENT_CURRENT_DATA_LENGTH (2)
 #define PRESENT_VALUE_DATA_LENGTH (10)
 #define PROFILE_VELOCITY_DATA_LENGTH (4)
+#define INDIRECT_ADDRESS_DATA_LENGTH (2)
+#define GAIN_DATA_LENGTH (10) // velocity i/p gain and position d/i/p gain are contiguous from VELOCITY_I_GAIN_ADDRESS
+
+// Indirect data block used by cycleCranex7 (command and present value are contiguous)
+#define CYCLE_COMMAND_ADDRESS (INDIRECT_DATA_1_ADDRESS)
+#define CYCLE_COMMAND_DATA_LENGTH (4)
+#define CYCLE_STATE_ADDRESS (CYCLE_COMMAND_ADDRESS + CYCLE_COMMAND_DATA_LENGTH)
+#define CYCLE_STATE_DATA_LENGTH (PRESENT_VALUE_DATA_LENGTH)
+#define CYCLE_DATA_LENGTH (CYCLE_COMMAND_DATA_LENGTH + CYCLE_STATE_DATA_LENGTH)
+// Control table block read by initilizeCranex7 (return delay time ... indirect addresses of cycleCranex7)
+#define INIT_READ_ADDRESS (RETURN_DELAY_TIME_ADDRESS)
+#define INIT_READ_DATA_LENGTH (INDIRECT_ADDRESS_1_ADDRESS + CYCLE_DATA_LENGTH * INDIRECT_ADDRESS_DATA_LENGTH - INIT_READ_ADDRESS)
 // Protocol version
 #define PROTOCOL_VERSION (2.0)
+#define SYNC_WRITE_INSTRUCTION (0x83) // instruction of the packets built without DynamixelSDK
 
 // Control value
 #define TORQUE_ENABLE (1)
@@ -69,12 +88,21 @@
 #define DEFAULT_VELOCITY_P_GAIN (100)
 #define DEFAULT_VELOCITY_I_GAIN (1920)
 #define PROFILE_VELOCITY (60)
+#define FACTORY_RETURN_DELAY_TIME (250) // factory setting of the return delay time [2us]
 // Serial port setting
-#define BAUDRATE (3000000)
+#define BAUDRATE (3000000)                 // baud rate if bus_tuner has not saved one for the port
+#define LATENCY_TIMER (1)                  // latency timer if bus_tuner has not saved one for the port [ms] (ftdi_sio: 16 by default)
+#define BAUDRATE_CHANGE_WAIT (10000000)    // time for the servo motors to switch the baud rate [ns]
+#ifndef SERIAL_PORT
 #define SERIAL_PORT "/dev/ttyUSB0" // Check the port which crane-x7 is conected
+#endif
+#define SERIAL_PORT_ENV "CRANE_X7_SERIAL_PORT" // Environment variable to override SERIAL_PORT (e.g. pseudo terminal of dxl_emulator)
+#define VERIFY_INIT_ENV "CRANE_X7_VERIFY_INIT"  // Environment variable to skip the registers which already have the value in initilizeCranex7 ("1")
+// Emergency brake
+#define EMERGENCY_BRAKE_REPEAT (2)          // number of times emergencyBrakeCranex7 sends the packets
+#define EMERGENCY_BRAKE_INTERVAL (1000000)  // interval of the repeat (longer than the status packets of a sync read) [ns]
 
 //// Definition of crane-x7 ////
-#define XM540_W270_JOINT (1) // only 2nd joint servo motor is XM540_W270 (other XM430_W350)
 #ifndef JOINT_NUM
 #define JOINT_NUM (8)
 #endif
@@ -90,14 +118,62 @@
 #define CURRENT_TO_TORQUE_XM430W350 (1.783 * TORQUE_CORRECTION_FACTOR)
 #define CURRENT_TO_TORQUE_XM540W270 (2.409 * TORQUE_CORRECTION_FACTOR)
 
+//// Structure definition ////
+/**
+ * @struct CRANE_X7_ARM_CONFIG
+ * @brief Serial port and servo motors of an arm (getDefaultCranex7ArmConfig)
+ */
+typedef struct
+{
+  const char *serial_port;        // device of the serial port (one port per arm)
+  uint8_t id[JOINT_NUM];          // ID of each servo motor
+  uint32_t min_angle[JOINT_NUM];  // min angle [dynamixel value]
+  uint32_t max_angle[JOINT_NUM];  // max angle [dynamixel value]
+  uint32_t home_angle[JOINT_NUM]; // value at 0 radian posture [dynamixel value]
+  uint32_t baudrate;              // baud rate [bps] (0: saved by bus_tuner for the port, BAUDRATE if not saved)
+  int latency_timer;              // latency timer of the USB serial converter [ms] (0: not changed, -1: saved by bus_tuner for the port, LATENCY_TIMER if not saved)
+} CRANE_X7_ARM_CONFIG;
+
+/**
+ * @struct CRANE_X7_ARM
+ * @brief Arm opened by openCranex7Arm (members are private to the backend, crane_x7_comm.c or crane_x7_sim.c)
+ */
+typedef struct CRANE_X7_ARM CRANE_X7_ARM;
+
 //// Prototype declaration ////
+// Arm context: every arm has its own port and statistics, and each arm can be driven by its own thread
+void getDefaultCranex7ArmConfig(CRANE_X7_ARM_CONFIG *);
+int openCranex7Arm(CRANE_X7_ARM **, const CRANE_X7_ARM_CONFIG *, uint8_t *);
+int setCranex7ArmTorqueEnable(CRANE_X7_ARM *, uint8_t);
+int setCranex7ArmAngle(CRANE_X7_ARM *, double *);
+int setCranex7ArmAngularVelocity(CRANE_X7_ARM *, double *);
+int setCranex7ArmTorque(CRANE_X7_ARM *, double *);
+int setCranex7ArmProfileVelocity(CRANE_X7_ARM *, double *);
+int getCranex7ArmJointState(CRANE_X7_ARM *, double *, double *, double *);
+int cycleCranex7Arm(CRANE_X7_ARM *, double *, double *, double *, double *);
+void brakeCranex7Arm(CRANE_X7_ARM *);
+int emergencyBrakeCranex7Arm(CRANE_X7_ARM *);
+void getCranex7ArmCommStats(CRANE_X7_ARM *, COMM_STATS *);
+void resetCranex7ArmCommStats(CRANE_X7_ARM *);
+void getCranex7ArmConfig(CRANE_X7_ARM *, CRANE_X7_ARM_CONFIG *);
+int setCranex7ArmBusTiming(CRANE_X7_ARM *, uint32_t, uint8_t);
+int getCranex7ArmReturnDelayTime(CRANE_X7_ARM *, uint8_t *);
+int setCranex7ArmReturnDelayTime(CRANE_X7_ARM *, const uint8_t *);
+void closeCranex7Arm(CRANE_X7_ARM *);
+// Single arm (the arm opened by initilizeCranex7 with getDefaultCranex7ArmConfig)
+CRANE_X7_ARM *getDefaultCranex7Arm(void);
 int initilizeCranex7(uint8_t *);
 int setCranex7TorqueEnable(uint8_t);
 int setCranex7Angle(double *);
 int setCranex7AngularVelocity(double *);
 int setCranex7Torque(double *);
+int setCranex7ProfileVelocity(double *);
 int getCranex7JointState(double *, double *, double *);
+int cycleCranex7(double *, double *, double *, double *);
 void brakeCranex7Joint(void);
+int emergencyBrakeCranex7(void);
+void getCranex7CommStats(COMM_STATS *);
+void resetCranex7CommStats(void);
 void closeCranex7Port(void);
 
 #endif
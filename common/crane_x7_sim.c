@@ -0,0 +1,841 @@
+/**
+ * @file crane_x7_sim.c
+ * @brief Offline simulator of the CRANE-X7 (same interface as crane_x7_comm.c)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "crane_x7_comm.h"
+#include "comm_stats.h"
+#include "arm_parameter.h"
+#include "dynamics.h"
+
+//// Simulation setting ////
+#define SIM_DT (0.0005)                     // integration step[s]
+#define SIM_SERVO_PERIOD (0.001)            // control period of dynamixel internal controller[s]
+#define SIM_STEP_ENV "CRANE_X7_SIM_STEP"    // simulated time advanced by each state read[s] (lockstep mode)
+#define SIM_SCALE_ENV "CRANE_X7_SIM_TIME_SCALE" // ratio of simulated time to wall clock time (real time mode)
+#define SIM_MAX_ADVANCE (10.0)              // maximum simulated time advanced at once[s]
+
+//// Motor model (output shaft, 12V) ////
+#define PWM_LIMIT (885)                     // dynamixel PWM value of 100% duty
+#define STALL_TORQUE_XM430W350 (4.1)        // stall torque[Nm]
+#define STALL_TORQUE_XM540W270 (10.6)       // stall torque[Nm]
+#define NO_LOAD_SPEED_XM430W350 (4.817)     // no load speed[rad/s] (46rpm)
+#define NO_LOAD_SPEED_XM540W270 (3.142)     // no load speed[rad/s] (30rpm)
+#define VISCOUS_FRICTION (0.01)             // viscous friction of joint[Nm/(rad/s)]
+
+/**
+ * @struct SIM_JOINT
+ * @brief State of a simulated joint and its servo motor
+ */
+typedef struct
+{
+  double angle;            // joint angle[rad]
+  double angular_velocity; // joint angular velocity[rad/s]
+  double motor_torque;     // torque generated by the servo motor[Nm]
+  uint8_t operating_mode;  // operating mode
+  uint8_t torque_enable;   // torque enable
+  uint8_t return_delay_time; // return delay time[2us] (kept for bus_tuner, no effect on the simulation)
+  double goal_angle;       // goal position[rad]
+  double goal_velocity;    // goal velocity[rad/s]
+  double goal_torque;      // goal current (converted to torque)[Nm]
+  double profile_angle;    // desired position generated by velocity profile[rad]
+  double profile_velocity; // profile velocity[rad/s] (0: infinite)
+  double position_p_gain;  // position p gain
+  double position_i_gain;  // position i gain
+  double position_d_gain;  // position d gain
+  double velocity_p_gain;  // velocity p gain
+  double velocity_i_gain;  // velocity i gain
+  double error_integral;   // integral of error
+  double error_previous;   // error of previous control period
+  double servo_time;       // time from previous control period of dynamixel[s]
+  double pwm;              // PWM output of dynamixel controller
+} SIM_JOINT;
+
+/**
+ * @struct CRANE_X7_ARM
+ * @brief State of a simulated arm
+ */
+struct CRANE_X7_ARM
+{
+  CRANE_X7_ARM_CONFIG config;
+  SIM_JOINT joint[JOINT_NUM];
+  KINEMATICS_CACHE cache; // link frames of the rigid body dynamics
+  JOINT_RANGE joint_range[JOINT_NUM];
+  double time;            // simulated time[s]
+  double step;            // lockstep mode: simulated time advanced by each state read[s]
+  double time_scale;      // real time mode: ratio of simulated time to wall clock time
+  struct timespec start;  // wall clock time of openCranex7Arm
+  int emergency_brake;    // 1: emergencyBrakeCranex7Arm was called, applied by the next simulation step (atomic)
+  COMM_STATS stats;
+};
+
+//// Variable for simulator ////
+static pthread_once_t sim_dynamics_once = PTHREAD_ONCE_INIT; // the link parameters are shared by all arms
+static CRANE_X7_ARM *default_arm = NULL;                      // arm of the single arm functions (atomic)
+
+//// Utility functions ////
+
+/**
+ * @fn static double getElapsedTime(CRANE_X7_ARM *)
+ * @brief Get wall clock time from openCranex7Arm
+ * @return elapsed time[s]
+ */
+static double getElapsedTime(CRANE_X7_ARM *arm)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - arm->start.tv_sec) + (double)(now.tv_nsec - arm->start.tv_nsec) * 1e-9;
+}
+
+/**
+ * @fn static double quantize(double, double)
+ * @brief Round a physical value to the resolution of the dynamixel register
+ */
+static double quantize(double value, double resolution)
+{
+  return (double)((int32_t)(value / resolution)) * resolution;
+}
+
+/**
+ * @fn static double clamp(double, double, double)
+ * @brief Limit value to [min, max]
+ */
+static double clamp(double value, double min, double max)
+{
+  return (value < min) ? min : ((value > max) ? max : value);
+}
+
+//// Servo motor model ////
+
+/**
+ * @fn static void updateServoController(SIM_JOINT *, double)
+ * @brief Update PWM output of the dynamixel internal controller (position or velocity PID)
+ * @param[in,out] *j joint joint index
+ * @param[in] dt elapsed time[s]
+ */
+static void updateServoController(SIM_JOINT *j, double dt)
+{
+  j->servo_time += dt;
+  if (j->servo_time < SIM_SERVO_PERIOD)
+    return;
+  j->servo_time -= SIM_SERVO_PERIOD;
+
+  if (j->operating_mode == POSITION_CONTROL_MODE)
+  {
+    double error;
+    // velocity profile (profile acceleration is 0)
+    if (j->profile_velocity > 0)
+    {
+      double step = j->profile_velocity * SIM_SERVO_PERIOD;
+      j->profile_angle += clamp(j->goal_angle - j->profile_angle, -step, step);
+    }
+    else
+    {
+      j->profile_angle = j->goal_angle;
+    }
+    // position PID (error is expressed as dynamixel value)
+    error = (j->profile_angle - j->angle) / (DXL_VALUE_TO_RADIAN);
+    j->error_integral += error;
+    j->pwm = j->position_p_gain / 128.0 * error + j->position_i_gain / 65536.0 * j->error_integral + j->position_d_gain / 16.0 * (error - j->error_previous);
+    j->error_previous = error;
+  }
+  else if (j->operating_mode == VELOCITY_CONTROL_MODE)
+  {
+    // velocity PI (error is expressed as dynamixel value)
+    double error = (j->goal_velocity - j->angular_velocity) / (DXL_VALUE_TO_ANGULARVEL);
+    j->error_integral += error;
+    j->pwm = j->velocity_p_gain / 128.0 * error + j->velocity_i_gain / 65536.0 * j->error_integral;
+  }
+  j->pwm = clamp(j->pwm, -PWM_LIMIT, PWM_LIMIT);
+}
+
+/**
+ * @fn static double calcServoTorque(const SIM_JOINT *, int)
+ * @brief Torque generated by the servo motor (DC motor model at the output shaft)
+ * @param[in] *j joint
+ * @param[in] joint joint index
+ * @return torque[Nm]
+ */
+static double calcServoTorque(const SIM_JOINT *j, int joint)
+{
+  double stall_torque = (joint == XM540_W270_JOINT) ? STALL_TORQUE_XM540W270 : STALL_TORQUE_XM430W350;
+  double no_load_speed = (joint == XM540_W270_JOINT) ? NO_LOAD_SPEED_XM540W270 : NO_LOAD_SPEED_XM430W350;
+
+  if (!j->torque_enable)
+    return 0;
+  if (j->operating_mode == CURRENT_CONTROL_MODE)
+    return clamp(j->goal_torque, -stall_torque, stall_torque);
+  // duty ratio and back electromotive force (PWM 0 acts as a brake)
+  return stall_torque * (j->pwm / PWM_LIMIT - j->angular_velocity / no_load_speed);
+}
+
+/**
+ * @fn static void brakeSimJoints(CRANE_X7_ARM *)
+ * @brief Set feedback gains and goal current to 0 then joints act like braking
+ */
+static void brakeSimJoints(CRANE_X7_ARM *arm)
+{
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    SIM_JOINT *j = &arm->joint[i];
+    j->position_p_gain = 0;
+    j->position_i_gain = 0;
+    j->position_d_gain = 0;
+    j->velocity_p_gain = 0;
+    j->velocity_i_gain = 0;
+    j->goal_torque = 0;
+  }
+}
+
+/**
+ * @fn static void stepSimulation(CRANE_X7_ARM *, double)
+ * @brief Integrate the dynamics of CRANE-X7 by one step (semi-implicit euler method)
+ * @param[in,out] *arm arm
+ * @param[in] dt integration step[s]
+ */
+static void stepSimulation(CRANE_X7_ARM *arm, double dt)
+{
+  double q[JOINT_NUM], dq[JOINT_NUM], tau[JOINT_NUM], ddq[JOINT_NUM];
+
+  if (__atomic_exchange_n(&arm->emergency_brake, 0, __ATOMIC_ACQ_REL))
+  {
+    brakeSimJoints(arm);
+  }
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    updateServoController(&arm->joint[i], dt);
+    arm->joint[i].motor_torque = calcServoTorque(&arm->joint[i], i);
+    q[i] = arm->joint[i].angle;
+    dq[i] = arm->joint[i].angular_velocity;
+    tau[i] = arm->joint[i].motor_torque - VISCOUS_FRICTION * dq[i];
+  }
+  // joint 1 - 7 : rigid body dynamics of links (articulated body algorithm)
+  forwardDynamics7Dof(&arm->cache, q, dq, tau, ddq);
+  // gripper : only rotor inertia of servo motor
+  for (int i = KINEMATICS_DOF; i < JOINT_NUM; i++)
+  {
+    ddq[i] = tau[i] / ARMATURE_XM430W350;
+  }
+  // integration and mechanical stop
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    SIM_JOINT *j = &arm->joint[i];
+    j->angular_velocity += ddq[i] * dt;
+    j->angle += j->angular_velocity * dt;
+    if ((j->angle < arm->joint_range[i].min) || (j->angle > arm->joint_range[i].max))
+    {
+      j->angle = clamp(j->angle, arm->joint_range[i].min, arm->joint_range[i].max);
+      j->angular_velocity = 0;
+    }
+  }
+  arm->time += dt;
+}
+
+/**
+ * @fn static void advanceSimulation(CRANE_X7_ARM *, double)
+ * @brief Integrate the dynamics until the given simulated time
+ * @param[in,out] *arm arm
+ * @param[in] target_time simulated time[s]
+ */
+static void advanceSimulation(CRANE_X7_ARM *arm, double target_time)
+{
+  if (target_time - arm->time > SIM_MAX_ADVANCE)
+  {
+    target_time = arm->time + SIM_MAX_ADVANCE;
+  }
+  while (arm->time + SIM_DT * 0.5 < target_time)
+  {
+    stepSimulation(arm, SIM_DT);
+  }
+}
+
+/**
+ * @fn static void synchronizeSimulation(CRANE_X7_ARM *, int)
+ * @brief Advance the simulation according to the time mode
+ * @param[in,out] *arm arm
+ * @param[in] state_read 1: called when the joint state is read
+ */
+static void synchronizeSimulation(CRANE_X7_ARM *arm, int state_read)
+{
+  if (arm->step > 0)
+  {
+    if (state_read)
+      advanceSimulation(arm, arm->time + arm->step);
+  }
+  else
+  {
+    advanceSimulation(arm, getElapsedTime(arm) * arm->time_scale);
+  }
+}
+
+/**
+ * @fn static void readJointState(CRANE_X7_ARM *, double *, double *, double *)
+ * @brief Read present value with the resolution of dynamixel
+ */
+static void readJointState(CRANE_X7_ARM *arm, double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    double current_to_torque = (i == XM540_W270_JOINT) ? CURRENT_TO_TORQUE_XM540W270 : CURRENT_TO_TORQUE_XM430W350;
+    angle_array[i] = quantize(arm->joint[i].angle, DXL_VALUE_TO_RADIAN);
+    angular_velocity_array[i] = quantize(arm->joint[i].angular_velocity, DXL_VALUE_TO_ANGULARVEL);
+    torque_array[i] = quantize(arm->joint[i].motor_torque / current_to_torque, DXL_VALUE_TO_CURRENT) * current_to_torque;
+  }
+}
+
+/**
+ * @fn static double limitGoalAngle(CRANE_X7_ARM *, int, double)
+ * @brief Limit goal position to the movable range (with range check)
+ */
+static double limitGoalAngle(CRANE_X7_ARM *arm, int joint, double angle)
+{
+  if ((angle > arm->joint_range[joint].max) || (arm->joint_range[joint].min > angle))
+  {
+    printf("Out of angle range : joint %d \n", joint + 1);
+  }
+  return clamp(quantize(angle, DXL_VALUE_TO_RADIAN), arm->joint_range[joint].min, arm->joint_range[joint].max);
+}
+
+/**
+ * @fn static void initSimDynamics(void)
+ * @brief Load the link parameters of the dynamics once (pthread_once)
+ */
+static void initSimDynamics(void)
+{
+  initDynamics();
+}
+
+//// Communication functions for CRANE-X7 (simulated) ////
+
+/**
+ * @fn void getDefaultCranex7ArmConfig(CRANE_X7_ARM_CONFIG *)
+ * @brief Setting of a CRANE-X7 (the simulator uses only serial_port as the name of the arm)
+ * @param[out] *config setting to be given to openCranex7Arm
+ */
+void getDefaultCranex7ArmConfig(CRANE_X7_ARM_CONFIG *config)
+{
+  memset(config, 0, sizeof(CRANE_X7_ARM_CONFIG));
+  config->serial_port = getenv(SERIAL_PORT_ENV);
+  if (config->serial_port == NULL)
+  {
+    config->serial_port = SERIAL_PORT;
+  }
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    config->id[i] = (uint8_t)(i + 2);
+  }
+  config->latency_timer = -1;
+}
+
+/**
+ * @fn int openCranex7Arm(CRANE_X7_ARM **, const CRANE_X7_ARM_CONFIG *, uint8_t *)
+ * @brief Initilizetion function of a simulated CRANE-X7 (each arm is simulated independently)
+ * @param[out] **arm opened arm (NULL if failed)
+ * @param[in] *config setting of the arm (copied)
+ * @param[in] *operationg_mode An array containing the operating modes of each servo motor (NULL: position control mode).
+ * @return Success or failure of initilizetion.
+ */
+int openCranex7Arm(CRANE_X7_ARM **arm, const CRANE_X7_ARM_CONFIG *config, uint8_t *operating_mode_array)
+{
+  CRANE_X7_ARM *new_arm = (CRANE_X7_ARM *)calloc(1, sizeof(CRANE_X7_ARM));
+  char *env;
+  uint64_t start = getCommStatsTime();
+
+  *arm = NULL;
+  if (new_arm == NULL)
+  {
+    printf("Failed to allocate simulated arm of %s\n", config->serial_port);
+    return 1;
+  }
+  new_arm->config = *config;
+  initKinematicsCache(&new_arm->cache);
+  pthread_once(&sim_dynamics_once, initSimDynamics);
+  getJointRange(new_arm->joint_range);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    SIM_JOINT *j = &new_arm->joint[i];
+    j->angle = clamp(0, new_arm->joint_range[i].min, new_arm->joint_range[i].max);
+    j->goal_angle = j->angle;
+    j->profile_angle = j->angle;
+    j->operating_mode = (operating_mode_array != NULL) ? operating_mode_array[i] : POSITION_CONTROL_MODE;
+    j->torque_enable = TORQUE_DISABLE;
+    j->return_delay_time = FACTORY_RETURN_DELAY_TIME;
+    j->profile_velocity = PROFILE_VELOCITY * DXL_VALUE_TO_ANGULARVEL;
+    j->position_p_gain = DEFAULT_POSITION_P_GAIN;
+    j->position_i_gain = DEFAULT_POSITION_I_GAIN;
+    j->position_d_gain = DEFAULT_POSITION_D_GAIN;
+    j->velocity_p_gain = DEFAULT_VELOCITY_P_GAIN;
+    j->velocity_i_gain = DEFAULT_VELOCITY_I_GAIN;
+  }
+
+  new_arm->time_scale = 1.0;
+  if ((env = getenv(SIM_STEP_ENV)) != NULL)
+  {
+    new_arm->step = atof(env);
+  }
+  if ((env = getenv(SIM_SCALE_ENV)) != NULL && atof(env) > 0)
+  {
+    new_arm->time_scale = atof(env);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &new_arm->start);
+
+  if (new_arm->step > 0)
+    printf("Simulated CRANE-X7 is initialized (lockstep mode : %f s per state read).\n", new_arm->step);
+  else
+    printf("Simulated CRANE-X7 is initialized (time scale : %f).\n", new_arm->time_scale);
+  *arm = new_arm;
+  return recordCommLatency(&new_arm->stats, COMM_STATS_INITIALIZE, start, 0);
+}
+
+/**
+ * @fn int setCranex7ArmTorqueEnable(CRANE_X7_ARM *, uint8_t)
+ * @brief Function to enable (or disable) servo motor torque
+ * @param[in,out] *arm arm
+ * @param[in] torque_enable 1:enable, 0:disable
+ * @return Success or failure of enabling.
+ */
+int setCranex7ArmTorqueEnable(CRANE_X7_ARM *arm, uint8_t torque_enable)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    SIM_JOINT *j = &arm->joint[i];
+    if (torque_enable && !j->torque_enable)
+    {
+      // the velocity profile starts from the present position
+      j->profile_angle = j->angle;
+      j->error_integral = 0;
+      j->error_previous = 0;
+    }
+    j->torque_enable = torque_enable;
+  }
+  printf("Turn %s simulated torque\n", torque_enable ? "on" : "off");
+  return recordCommLatency(&arm->stats, COMM_STATS_TORQUE_ENABLE, start, 0);
+}
+
+/**
+ * @fn int setCranex7ArmAngle(CRANE_X7_ARM *, double *)
+ * @brief Function to set command angle
+ * @param[in,out] *arm arm
+ * @param[in] angle_array[] command angle array
+ * @return Success or failure.
+ */
+int setCranex7ArmAngle(CRANE_X7_ARM *arm, double *angle_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    arm->joint[i].goal_angle = limitGoalAngle(arm, i, angle_array[i]);
+  }
+  return recordCommLatency(&arm->stats, COMM_STATS_SET_ANGLE, start, 0);
+}
+
+/**
+ * @fn int setCranex7ArmAngularVelocity(CRANE_X7_ARM *, double *)
+ * @brief Function to set command anglular velocity
+ * @param[in,out] *arm arm
+ * @param[in] angular_velocity_array[] command anglular velocity array
+ * @return Success or failure.
+ */
+int setCranex7ArmAngularVelocity(CRANE_X7_ARM *arm, double *angular_velocity_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    arm->joint[i].goal_velocity = quantize(angular_velocity_array[i], DXL_VALUE_TO_ANGULARVEL);
+  }
+  return recordCommLatency(&arm->stats, COMM_STATS_SET_ANGULAR_VELOCITY, start, 0);
+}
+
+/**
+ * @fn int setCranex7ArmTorque(CRANE_X7_ARM *, double *)
+ * @brief Function to set command torque
+ * @param[in,out] *arm arm
+ * @param[in] torque_array[] command torque array
+ * @return Success or failure.
+ */
+int setCranex7ArmTorque(CRANE_X7_ARM *arm, double *torque_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    double current_to_torque = (i == XM540_W270_JOINT) ? CURRENT_TO_TORQUE_XM540W270 : CURRENT_TO_TORQUE_XM430W350;
+    arm->joint[i].goal_torque = quantize(torque_array[i] / current_to_torque, DXL_VALUE_TO_CURRENT) * current_to_torque;
+  }
+  return recordCommLatency(&arm->stats, COMM_STATS_SET_TORQUE, start, 0);
+}
+
+/**
+ * @fn int setCranex7ArmProfileVelocity(CRANE_X7_ARM *, double *)
+ * @brief Function to set profile velocity of position control mode
+ * @param[in,out] *arm arm
+ * @param[in] angular_velocity_array[] profile velocity array [rad/s] (0: infinite)
+ * @return Success or failure.
+ */
+int setCranex7ArmProfileVelocity(CRANE_X7_ARM *arm, double *angular_velocity_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    arm->joint[i].profile_velocity = quantize(angular_velocity_array[i], DXL_VALUE_TO_ANGULARVEL);
+  }
+  return recordCommLatency(&arm->stats, COMM_STATS_SET_PROFILE_VELOCITY, start, 0);
+}
+
+/**
+ * @fn int getCranex7ArmJointState(CRANE_X7_ARM *, double *, double *, double *)
+ * @brief Function to get joint state
+ * @param[in,out] *arm arm
+ * @param[out] angle_array[] present angle array
+ * @param[out] angular_velocity_array[] present angular velocity array
+ * @param[out] torque_array[] present torque array
+ * @return Success or failure.
+ */
+int getCranex7ArmJointState(CRANE_X7_ARM *arm, double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 1);
+  readJointState(arm, angle_array, angular_velocity_array, torque_array);
+  return recordCommLatency(&arm->stats, COMM_STATS_GET_JOINT_STATE, start, 0);
+}
+
+/**
+ * @fn int cycleCranex7Arm(CRANE_X7_ARM *, double *, double *, double *, double *)
+ * @brief Function to send command and get joint state in one bus cycle
+ * @param[in,out] *arm arm
+ * @param[in] command_array[] command array (meaning depends on the operating mode of each joint)
+ * @param[out] angle_array[] present angle array
+ * @param[out] angular_velocity_array[] present angular velocity array
+ * @param[out] torque_array[] present torque array
+ * @return Success or failure.
+ */
+int cycleCranex7Arm(CRANE_X7_ARM *arm, double *command_array, double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    SIM_JOINT *j = &arm->joint[i];
+    if (j->operating_mode == CURRENT_CONTROL_MODE)
+    {
+      double current_to_torque = (i == XM540_W270_JOINT) ? CURRENT_TO_TORQUE_XM540W270 : CURRENT_TO_TORQUE_XM430W350;
+      j->goal_torque = quantize(command_array[i] / current_to_torque, DXL_VALUE_TO_CURRENT) * current_to_torque;
+    }
+    else if (j->operating_mode == VELOCITY_CONTROL_MODE)
+    {
+      j->goal_velocity = quantize(command_array[i], DXL_VALUE_TO_ANGULARVEL);
+    }
+    else
+    {
+      j->goal_angle = limitGoalAngle(arm, i, command_array[i]);
+    }
+  }
+  synchronizeSimulation(arm, 1);
+  readJointState(arm, angle_array, angular_velocity_array, torque_array);
+  return recordCommLatency(&arm->stats, COMM_STATS_CYCLE, start, 0);
+}
+
+/**
+ * @fn void brakeCranex7Arm(CRANE_X7_ARM *)
+ * @brief Brake joints
+ * @param[in,out] *arm arm
+ */
+void brakeCranex7Arm(CRANE_X7_ARM *arm)
+{
+  uint64_t start = getCommStatsTime();
+
+  synchronizeSimulation(arm, 0);
+  brakeSimJoints(arm);
+  recordCommLatency(&arm->stats, COMM_STATS_BRAKE, start, 0);
+}
+
+/**
+ * @fn int emergencyBrakeCranex7Arm(CRANE_X7_ARM *)
+ * @brief Brake joints from a signal handler or another thread (applied by the next simulation step)
+ * @param[in,out] *arm opened arm
+ * @return 0
+ */
+int emergencyBrakeCranex7Arm(CRANE_X7_ARM *arm)
+{
+  __atomic_store_n(&arm->emergency_brake, 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/**
+ * @fn void getCranex7ArmCommStats(CRANE_X7_ARM *, COMM_STATS *)
+ * @brief Copy the statistics of the arm from openCranex7Arm (or resetCranex7ArmCommStats)
+ * @param[in] *arm arm
+ * @param[out] *stats statistics
+ */
+void getCranex7ArmCommStats(CRANE_X7_ARM *arm, COMM_STATS *stats)
+{
+  memcpy(stats, &arm->stats, sizeof(COMM_STATS));
+}
+
+/**
+ * @fn void resetCranex7ArmCommStats(CRANE_X7_ARM *)
+ * @brief Clear the statistics of the arm
+ * @param[in,out] *arm arm
+ */
+void resetCranex7ArmCommStats(CRANE_X7_ARM *arm)
+{
+  memset(&arm->stats, 0, sizeof(COMM_STATS));
+}
+
+/**
+ * @fn void getCranex7ArmConfig(CRANE_X7_ARM *, CRANE_X7_ARM_CONFIG *)
+ * @brief Setting of the opened arm
+ * @param[in] *arm arm
+ * @param[out] *config setting
+ */
+void getCranex7ArmConfig(CRANE_X7_ARM *arm, CRANE_X7_ARM_CONFIG *config)
+{
+  *config = arm->config;
+}
+
+/**
+ * @fn int setCranex7ArmBusTiming(CRANE_X7_ARM *, uint32_t, uint8_t)
+ * @brief Change the baud rate and the return delay time (the simulated communication has no timing, only the baud rate is kept)
+ * @param[in,out] *arm arm
+ * @param[in] baudrate baud rate [bps]
+ * @param[in] return_delay_time delay of the status packet [2us]
+ * @return 0
+ */
+int setCranex7ArmBusTiming(CRANE_X7_ARM *arm, uint32_t baudrate, uint8_t return_delay_time)
+{
+  arm->config.baudrate = baudrate;
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    arm->joint[i].return_delay_time = return_delay_time;
+  }
+  return 0;
+}
+
+/**
+ * @fn int getCranex7ArmReturnDelayTime(CRANE_X7_ARM *, uint8_t *)
+ * @brief Return delay time of each simulated servo motor
+ * @param[in] *arm arm
+ * @param[out] *return_delay_time_array return delay time of each servo motor [2us]
+ * @return 0
+ */
+int getCranex7ArmReturnDelayTime(CRANE_X7_ARM *arm, uint8_t *return_delay_time_array)
+{
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    return_delay_time_array[i] = arm->joint[i].return_delay_time;
+  }
+  return 0;
+}
+
+/**
+ * @fn int setCranex7ArmReturnDelayTime(CRANE_X7_ARM *, const uint8_t *)
+ * @brief Change the return delay time of each simulated servo motor (no effect on the simulation)
+ * @param[in,out] *arm arm
+ * @param[in] *return_delay_time_array return delay time of each servo motor [2us]
+ * @return 0
+ */
+int setCranex7ArmReturnDelayTime(CRANE_X7_ARM *arm, const uint8_t *return_delay_time_array)
+{
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    arm->joint[i].return_delay_time = return_delay_time_array[i];
+  }
+  return 0;
+}
+
+/**
+ * @fn void closeCranex7Arm(CRANE_X7_ARM *)
+ * @brief Close the simulated arm and free it (the latency of the simulated communication functions is printed)
+ * @param[in] *arm arm
+ */
+void closeCranex7Arm(CRANE_X7_ARM *arm)
+{
+  printCranex7CommStats(&arm->stats);
+  printf("close simulated com port (simulated time : %f s)\n", arm->time);
+  free(arm);
+}
+
+//// Single arm functions (the arm opened by initilizeCranex7) ////
+
+/**
+ * @fn CRANE_X7_ARM *getDefaultCranex7Arm(void)
+ * @brief Arm opened by initilizeCranex7
+ * @return arm (NULL before initilizeCranex7 or after closeCranex7Port)
+ */
+CRANE_X7_ARM *getDefaultCranex7Arm(void)
+{
+  return __atomic_load_n(&default_arm, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @fn int initilizeCranex7(uint8_t *)
+ * @brief Initilizetion function of simulated CRANE-X7 (openCranex7Arm with getDefaultCranex7ArmConfig)
+ * @param[in] *operationg_mode An array containing the operating modes of each servo motor.
+ * @return Success or failure of initilizetion.
+ */
+int initilizeCranex7(uint8_t *operating_mode_array)
+{
+  CRANE_X7_ARM_CONFIG config;
+  CRANE_X7_ARM *arm;
+  int result;
+
+  getDefaultCranex7ArmConfig(&config);
+  result = openCranex7Arm(&arm, &config, operating_mode_array);
+  __atomic_store_n(&default_arm, arm, __ATOMIC_RELEASE);
+  return result;
+}
+
+/**
+ * @fn int setCranex7TorqueEnable(uint8_t)
+ * @brief Function to enable (or disable) servo motor torque
+ */
+int setCranex7TorqueEnable(uint8_t torque_enable)
+{
+  return (default_arm != NULL) ? setCranex7ArmTorqueEnable(default_arm, torque_enable) : 1;
+}
+
+/**
+ * @fn int setCranex7Angle(double *)
+ * @brief Function to set command angle
+ */
+int setCranex7Angle(double *angle_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmAngle(default_arm, angle_array) : 1;
+}
+
+/**
+ * @fn int setCranex7AngularVelocity(double *)
+ * @brief Function to set command anglular velocity
+ */
+int setCranex7AngularVelocity(double *angular_velocity_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmAngularVelocity(default_arm, angular_velocity_array) : 1;
+}
+
+/**
+ * @fn int setCranex7Torque(double *)
+ * @brief Function to set command torque
+ */
+int setCranex7Torque(double *torque_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmTorque(default_arm, torque_array) : 1;
+}
+
+/**
+ * @fn int setCranex7ProfileVelocity(double *)
+ * @brief Function to set profile velocity of position control mode
+ */
+int setCranex7ProfileVelocity(double *angular_velocity_array)
+{
+  return (default_arm != NULL) ? setCranex7ArmProfileVelocity(default_arm, angular_velocity_array) : 1;
+}
+
+/**
+ * @fn int getCranex7JointState(double *, double *, double *)
+ * @brief Function to get joint state
+ */
+int getCranex7JointState(double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  return (default_arm != NULL) ? getCranex7ArmJointState(default_arm, angle_array, angular_velocity_array, torque_array) : 1;
+}
+
+/**
+ * @fn int cycleCranex7(double *, double *, double *, double *)
+ * @brief Function to send command and get joint state in one bus cycle
+ */
+int cycleCranex7(double *command_array, double *angle_array, double *angular_velocity_array, double *torque_array)
+{
+  return (default_arm != NULL) ? cycleCranex7Arm(default_arm, command_array, angle_array, angular_velocity_array, torque_array) : 1;
+}
+
+/**
+ * @fn void brakeCranex7Joint(void)
+ * @brief Brake joints
+ */
+void brakeCranex7Joint(void)
+{
+  if (default_arm != NULL)
+    brakeCranex7Arm(default_arm);
+}
+
+/**
+ * @fn int emergencyBrakeCranex7(void)
+ * @brief Brake joints from a signal handler or another thread (applied by the next simulation step)
+ * @return 0: requested, 1: not initialized
+ */
+int emergencyBrakeCranex7(void)
+{
+  CRANE_X7_ARM *arm = __atomic_load_n(&default_arm, __ATOMIC_ACQUIRE);
+
+  return (arm != NULL) ? emergencyBrakeCranex7Arm(arm) : 1;
+}
+
+/**
+ * @fn void getCranex7CommStats(COMM_STATS *)
+ * @brief Copy the statistics from initilizeCranex7 (or resetCranex7CommStats)
+ * @param[out] *stats statistics (all 0 before initilizeCranex7)
+ */
+void getCranex7CommStats(COMM_STATS *stats)
+{
+  if (default_arm != NULL)
+    getCranex7ArmCommStats(default_arm, stats);
+  else
+    memset(stats, 0, sizeof(COMM_STATS));
+}
+
+/**
+ * @fn void resetCranex7CommStats(void)
+ * @brief Clear the statistics
+ */
+void resetCranex7CommStats(void)
+{
+  if (default_arm != NULL)
+    resetCranex7ArmCommStats(default_arm);
+}
+
+/**
+ * @fn void closeCranex7Port(void)
+ * @brief Close port (the latency of the simulated communication functions is printed)
+ */
+void closeCranex7Port(void)
+{
+  CRANE_X7_ARM *arm = __atomic_exchange_n(&default_arm, NULL, __ATOMIC_ACQ_REL);
+
+  if (arm != NULL)
+    closeCranex7Arm(arm);
+}
@@ -0,0 +1,1168 @@
+/**
+ * @file dxl_native.c
+ * @brief Dynamixel Protocol 2.0 transport on a termios file descriptor (TRANSPORT=native).
+ *        Only the instructions used by crane_x7_comm.c are implemented (ping, write, reboot, sync read/write, bulk read/write).
+ *        Ports, groups and packet buffers are static: nothing is allocated, and an instruction packet is built
+ *        in the transmit buffer of the port and sent by one write.
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "dxl_native.h"
+
+//// Protocol 2.0 ////
+#define INST_PING (0x01)
+#define INST_WRITE (0x03)
+#define INST_REBOOT (0x08)
+#define INST_STATUS (0x55)
+#define INST_SYNC_READ (0x82)
+#define INST_SYNC_WRITE (0x83)
+#define INST_BULK_READ (0x92)
+#define INST_BULK_WRITE (0x93)
+#define PACKET_ID (4)
+#define PACKET_LENGTH_L (5)
+#define PACKET_LENGTH_H (6)
+#define PACKET_INSTRUCTION (7)       // byte stuffing is applied from here
+#define PACKET_ERROR (8)             // status packet
+#define PACKET_STATUS_PARAMETER (9)  // status packet
+#define PACKET_HEADER_LENGTH (7)     // header, reserved, ID and length
+#define PACKET_MIN_STATUS_LENGTH (11) // header, reserved, ID, length, instruction, error and CRC
+#define PING_STATUS_LENGTH (3)       // model number and firmware version
+
+//// Group type ////
+#define GROUP_SYNC_WRITE (1)
+#define GROUP_SYNC_READ (2)
+#define GROUP_BULK_WRITE (3)
+#define GROUP_BULK_READ (4)
+
+/**
+ * @struct DXL_NATIVE_PORT
+ * @brief Serial port and its packet buffers
+ */
+typedef struct
+{
+  int used;
+  int fd;
+  char name[PATH_MAX];
+  int baudrate;
+  double byte_time;   // transmission time of a byte (start, 8 data and stop bits) [ns]
+  int last_result;    // COMM_SUCCESS, ...
+  uint8_t last_error; // error of the last status packet
+  size_t tx_length;
+  size_t rx_length;   // received bytes in rx
+  size_t rx_start;    // first byte of rx which is not parsed yet
+  uint8_t tx[DXL_NATIVE_TX_SIZE];
+  uint8_t rx[DXL_NATIVE_RX_SIZE];
+} DXL_NATIVE_PORT;
+
+/**
+ * @struct DXL_NATIVE_GROUP
+ * @brief Servo motors and data of a sync or bulk transaction
+ */
+typedef struct
+{
+  int used;
+  int port_num;
+  int type;                                  // GROUP_SYNC_WRITE, ...
+  uint16_t start_address;                    // sync read/write
+  uint16_t data_length;                      // sync read/write
+  int id_num;
+  int last_result;                           // read: 1 if the status packets of all servo motors were received
+  uint8_t id[DXL_NATIVE_MAX_GROUP_IDS];
+  uint16_t address[DXL_NATIVE_MAX_GROUP_IDS]; // start address of each servo motor
+  uint16_t length[DXL_NATIVE_MAX_GROUP_IDS];  // data length of each servo motor
+  uint16_t data_end[DXL_NATIVE_MAX_GROUP_IDS]; // write: bytes set by AddParam
+  uint8_t received[DXL_NATIVE_MAX_GROUP_IDS];  // read: 1 if the status packet was received
+  uint8_t data[DXL_NATIVE_MAX_GROUP_IDS][DXL_NATIVE_MAX_DATA];
+} DXL_NATIVE_GROUP;
+
+//// Variable for the transport ////
+static DXL_NATIVE_PORT dxl_port[DXL_NATIVE_MAX_PORTS];
+static DXL_NATIVE_GROUP dxl_group[DXL_NATIVE_MAX_GROUPS];
+
+// CRC-16 of Protocol 2.0 (polynomial 0x8005, no reflection, initial value 0)
+static const uint16_t crc_table[256] = {
+  0x0000, 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
+  0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027, 0x0022,
+  0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D, 0x8077, 0x0072,
+  0x0050, 0x8055, 0x805F, 0x005A, 0x804B, 0x004E, 0x0044, 0x8041,
+  0x80C3, 0x00C6, 0x00CC, 0x80C9, 0x00D8, 0x80DD, 0x80D7, 0x00D2,
+  0x00F0, 0x80F5, 0x80FF, 0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1,
+  0x00A0, 0x80A5, 0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1,
+  0x8093, 0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
+  0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197, 0x0192,
+  0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE, 0x01A4, 0x81A1,
+  0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB, 0x01FE, 0x01F4, 0x81F1,
+  0x81D3, 0x01D6, 0x01DC, 0x81D9, 0x01C8, 0x81CD, 0x81C7, 0x01C2,
+  0x0140, 0x8145, 0x814F, 0x014A, 0x815B, 0x015E, 0x0154, 0x8151,
+  0x8173, 0x0176, 0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162,
+  0x8123, 0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
+  0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104, 0x8101,
+  0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D, 0x8317, 0x0312,
+  0x0330, 0x8335, 0x833F, 0x033A, 0x832B, 0x032E, 0x0324, 0x8321,
+  0x0360, 0x8365, 0x836F, 0x036A, 0x837B, 0x037E, 0x0374, 0x8371,
+  0x8353, 0x0356, 0x035C, 0x8359, 0x0348, 0x834D, 0x8347, 0x0342,
+  0x03C0, 0x83C5, 0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1,
+  0x83F3, 0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
+  0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7, 0x03B2,
+  0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E, 0x0384, 0x8381,
+  0x0280, 0x8285, 0x828F, 0x028A, 0x829B, 0x029E, 0x0294, 0x8291,
+  0x82B3, 0x02B6, 0x02BC, 0x82B9, 0x02A8, 0x82AD, 0x82A7, 0x02A2,
+  0x82E3, 0x02E6, 0x02EC, 0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2,
+  0x02D0, 0x82D5, 0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1,
+  0x8243, 0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
+  0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264, 0x8261,
+  0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E, 0x0234, 0x8231,
+  0x8213, 0x0216, 0x021C, 0x8219, 0x0208, 0x820D, 0x8207, 0x0202
+};
+
+//// Utility functions ////
+
+/**
+ * @fn static uint64_t getTime(void)
+ * @brief Monotonic time [ns]
+ */
+static uint64_t getTime(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @fn static uint16_t calcCrc(const uint8_t *, size_t)
+ * @brief CRC-16 of the packet (table-driven)
+ */
+static uint16_t calcCrc(const uint8_t *data, size_t length)
+{
+  uint16_t crc = 0;
+
+  for (size_t i = 0; i < length; i++)
+  {
+    crc = (uint16_t)(crc << 8) ^ crc_table[((crc >> 8) ^ data[i]) & 0xFF];
+  }
+  return crc;
+}
+
+/**
+ * @fn static DXL_NATIVE_PORT *getPort(int)
+ * @brief Port of the handle (NULL if invalid)
+ */
+static DXL_NATIVE_PORT *getPort(int port_num)
+{
+  if ((port_num < 0) || (port_num >= DXL_NATIVE_MAX_PORTS) || !dxl_port[port_num].used)
+    return NULL;
+  return &dxl_port[port_num];
+}
+
+/**
+ * @fn static DXL_NATIVE_GROUP *getGroup(int, int)
+ * @brief Group of the handle (NULL if invalid or of another type)
+ */
+static DXL_NATIVE_GROUP *getGroup(int group_num, int type)
+{
+  if ((group_num < 0) || (group_num >= DXL_NATIVE_MAX_GROUPS) || !dxl_group[group_num].used || (dxl_group[group_num].type != type))
+    return NULL;
+  return &dxl_group[group_num];
+}
+
+/**
+ * @fn static int findGroupId(const DXL_NATIVE_GROUP *, uint8_t)
+ * @brief Index of the servo motor in the group (-1 if not added)
+ */
+static int findGroupId(const DXL_NATIVE_GROUP *group, uint8_t id)
+{
+  for (int i = 0; i < group->id_num; i++)
+  {
+    if (group->id[i] == id)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * @fn static int createGroup(int, int, uint16_t, uint16_t)
+ * @brief Take a group from the static pool (released by closePort of the port)
+ * @return group handle (-1 if the pool is exhausted)
+ */
+static int createGroup(int port_num, int type, uint16_t start_address, uint16_t data_length)
+{
+  if (getPort(port_num) == NULL)
+    return -1;
+  for (int i = 0; i < DXL_NATIVE_MAX_GROUPS; i++)
+  {
+    DXL_NATIVE_GROUP *group = &dxl_group[i];
+
+    if (group->used)
+      continue;
+    group->used = 1;
+    group->port_num = port_num;
+    group->type = type;
+    group->start_address = start_address;
+    group->data_length = (data_length > DXL_NATIVE_MAX_DATA) ? DXL_NATIVE_MAX_DATA : data_length;
+    group->id_num = 0;
+    group->last_result = 0;
+    return i;
+  }
+  printf("[dxl_native] No free group (DXL_NATIVE_MAX_GROUPS)\n");
+  return -1;
+}
+
+/**
+ * @fn static int addGroupId(DXL_NATIVE_GROUP *, uint8_t, uint16_t, uint16_t)
+ * @brief Add a servo motor to the group
+ * @return index in the group (-1 if the group is full)
+ */
+static int addGroupId(DXL_NATIVE_GROUP *group, uint8_t id, uint16_t address, uint16_t length)
+{
+  int index = group->id_num;
+
+  if ((index >= DXL_NATIVE_MAX_GROUP_IDS) || (length > DXL_NATIVE_MAX_DATA))
+    return -1;
+  group->id[index] = id;
+  group->address[index] = address;
+  group->length[index] = length;
+  group->data_end[index] = 0;
+  group->received[index] = 0;
+  group->id_num++;
+  return index;
+}
+
+/**
+ * @fn static void setData(uint8_t *, uint32_t, uint16_t)
+ * @brief Store a value in little endian
+ */
+static void setData(uint8_t *data, uint32_t value, uint16_t length)
+{
+  for (int i = 0; i < length && i < 4; i++)
+  {
+    data[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+//// Packet functions ////
+
+/**
+ * @fn static void beginPacket(DXL_NATIVE_PORT *, uint8_t, uint8_t)
+ * @brief Start an instruction packet in the transmit buffer of the port
+ */
+static void beginPacket(DXL_NATIVE_PORT *port, uint8_t id, uint8_t instruction)
+{
+  port->tx[0] = 0xFF;
+  port->tx[1] = 0xFF;
+  port->tx[2] = 0xFD;
+  port->tx[3] = 0x00;
+  port->tx[PACKET_ID] = id;
+  port->tx[PACKET_INSTRUCTION] = instruction;
+  port->tx_length = PACKET_INSTRUCTION + 1;
+}
+
+/**
+ * @fn static void putByte(DXL_NATIVE_PORT *, uint8_t)
+ * @brief Append a parameter byte (FF FF FD is sent as FF FF FD FD: byte stuffing).
+ *        The groups are small enough for DXL_NATIVE_TX_SIZE even if every parameter is stuffed.
+ */
+static void putByte(DXL_NATIVE_PORT *port, uint8_t value)
+{
+  size_t n = port->tx_length;
+
+  port->tx[n++] = value;
+  if ((value == 0xFD) && (n >= PACKET_INSTRUCTION + 3) && (port->tx[n - 2] == 0xFF) && (port->tx[n - 3] == 0xFF))
+  {
+    port->tx[n++] = 0xFD;
+  }
+  port->tx_length = n;
+}
+
+/**
+ * @fn static void putValue(DXL_NATIVE_PORT *, uint32_t, int)
+ * @brief Append a parameter in little endian
+ */
+static void putValue(DXL_NATIVE_PORT *port, uint32_t value, int length)
+{
+  for (int i = 0; i < length; i++)
+  {
+    putByte(port, (uint8_t)(value >> (8 * i)));
+  }
+}
+
+/**
+ * @fn static int sendPacket(DXL_NATIVE_PORT *)
+ * @brief Finish the instruction packet (length and CRC) and write it to the port.
+ *        The status packets left from a previous transaction are discarded.
+ * @return COMM_SUCCESS or COMM_TX_FAIL
+ */
+static int sendPacket(DXL_NATIVE_PORT *port)
+{
+  size_t length = port->tx_length - PACKET_INSTRUCTION + 2; // instruction, parameters and CRC
+  const uint8_t *p = port->tx;
+  size_t size;
+  uint16_t crc;
+
+  port->tx[PACKET_LENGTH_L] = (uint8_t)(length & 0xFF);
+  port->tx[PACKET_LENGTH_H] = (uint8_t)(length >> 8);
+  crc = calcCrc(port->tx, port->tx_length);
+  port->tx[port->tx_length++] = (uint8_t)(crc & 0xFF);
+  port->tx[port->tx_length++] = (uint8_t)(crc >> 8);
+
+  tcflush(port->fd, TCIFLUSH);
+  port->rx_length = 0;
+  port->rx_start = 0;
+  port->last_error = 0;
+  size = port->tx_length;
+  while (size > 0)
+  {
+    ssize_t written = write(port->fd, p, size);
+    if (written < 0)
+    {
+      struct pollfd pfd = {port->fd, POLLOUT, 0};
+
+      if ((errno == EINTR) || ((errno == EAGAIN) && (poll(&pfd, 1, DXL_NATIVE_LATENCY_TIMER) > 0)))
+        continue;
+      return port->last_result = COMM_TX_FAIL;
+    }
+    p += written;
+    size -= (size_t)written;
+  }
+  return port->last_result = COMM_SUCCESS;
+}
+
+/**
+ * @fn static uint64_t getDeadline(DXL_NATIVE_PORT *, size_t)
+ * @brief Deadline of the status packets (same margin as DynamixelSDK: twice the latency timer and 2ms)
+ * @param[in] rx_bytes expected length of the status packets
+ */
+static uint64_t getDeadline(DXL_NATIVE_PORT *port, size_t rx_bytes)
+{
+  return getTime() + (uint64_t)(port->byte_time * (port->tx_length + rx_bytes)) + (DXL_NATIVE_LATENCY_TIMER * 2 + 2) * 1000000ULL;
+}
+
+/**
+ * @fn static int receiveStatus(DXL_NATIVE_PORT *, uint64_t, const uint8_t **, size_t *)
+ * @brief Wait for the next status packet (bytes before a header are skipped)
+ * @param[in,out] *port port
+ * @param[in] deadline [ns]
+ * @param[out] **packet status packet in the receive buffer (valid until the next instruction packet)
+ * @param[out] *packet_length length of the packet
+ * @return COMM_SUCCESS, COMM_RX_TIMEOUT, COMM_RX_CORRUPT or COMM_RX_FAIL
+ */
+static int receiveStatus(DXL_NATIVE_PORT *port, uint64_t deadline, const uint8_t **packet, size_t *packet_length)
+{
+  for (;;)
+  {
+    const uint8_t *p = &port->rx[port->rx_start];
+    size_t available = port->rx_length - port->rx_start;
+    struct pollfd pfd = {port->fd, POLLIN, 0};
+    struct timespec timeout;
+    uint64_t now;
+
+    if ((available >= 4) && !((p[0] == 0xFF) && (p[1] == 0xFF) && (p[2] == 0xFD) && (p[3] == 0x00)))
+    {
+      port->rx_start++;
+      continue;
+    }
+    if (available >= PACKET_HEADER_LENGTH)
+    {
+      size_t total = PACKET_HEADER_LENGTH + (p[PACKET_LENGTH_L] | (p[PACKET_LENGTH_H] << 8));
+
+      if ((total < PACKET_MIN_STATUS_LENGTH) || (total > DXL_NATIVE_RX_SIZE))
+      {
+        port->rx_start++; // not a header
+        continue;
+      }
+      if (available >= total)
+      {
+        port->rx_start += total;
+        if (calcCrc(p, total - 2) != (p[total - 2] | (p[total - 1] << 8)))
+          return COMM_RX_CORRUPT;
+        if (p[PACKET_INSTRUCTION] != INST_STATUS)
+          continue;
+        *packet = p;
+        *packet_length = total;
+        return COMM_SUCCESS;
+      }
+    }
+    // keep the partial packet at the beginning and read more
+    if (port->rx_start > 0)
+    {
+      memmove(port->rx, port->rx + port->rx_start, available);
+      port->rx_length = available;
+      port->rx_start = 0;
+    }
+    now = getTime();
+    if (now >= deadline)
+      return COMM_RX_TIMEOUT;
+    timeout.tv_sec = (time_t)((deadline - now) / 1000000000);
+    timeout.tv_nsec = (deadline - now) % 1000000000;
+    if (ppoll(&pfd, 1, &timeout, NULL) > 0)
+    {
+      ssize_t received = read(port->fd, port->rx + port->rx_length, DXL_NATIVE_RX_SIZE - port->rx_length);
+      if (received > 0)
+        port->rx_length += (size_t)received;
+      else if ((received < 0) && (errno != EAGAIN) && (errno != EINTR))
+        return COMM_RX_FAIL;
+    }
+  }
+}
+
+/**
+ * @fn static size_t copyStatusParameter(const uint8_t *, size_t, uint8_t *, size_t)
+ * @brief Copy the parameters of a status packet removing the byte stuffing
+ * @return number of the copied bytes
+ */
+static size_t copyStatusParameter(const uint8_t *packet, size_t packet_length, uint8_t *data, size_t size)
+{
+  size_t n = 0;
+
+  for (size_t i = PACKET_STATUS_PARAMETER; (i < packet_length - 2) && (n < size); i++)
+  {
+    if ((packet[i] == 0xFD) && (packet[i - 1] == 0xFD) && (packet[i - 2] == 0xFF) && (packet[i - 3] == 0xFF) && (i - 3 >= PACKET_INSTRUCTION))
+      continue;
+    data[n++] = packet[i];
+  }
+  return n;
+}
+
+/**
+ * @fn static int receiveFrom(DXL_NATIVE_PORT *, uint8_t, uint8_t *, size_t)
+ * @brief Receive the status packet of a servo motor
+ * @param[out] *data parameters of the status packet (NULL: not needed)
+ * @param[in] size length of the parameters
+ * @return COMM_SUCCESS, ...
+ */
+static int receiveFrom(DXL_NATIVE_PORT *port, uint8_t id, uint8_t *data, size_t size)
+{
+  uint64_t deadline = getDeadline(port, PACKET_MIN_STATUS_LENGTH + size);
+  const uint8_t *packet;
+  size_t packet_length;
+  int result;
+
+  while ((result = receiveStatus(port, deadline, &packet, &packet_length)) == COMM_SUCCESS)
+  {
+    if (packet[PACKET_ID] != id)
+      continue;
+    port->last_error = packet[PACKET_ERROR];
+    if ((data != NULL) && (copyStatusParameter(packet, packet_length, data, size) != size))
+      result = COMM_RX_CORRUPT;
+    break;
+  }
+  return port->last_result = result;
+}
+
+/**
+ * @fn static int receiveGroup(DXL_NATIVE_PORT *, DXL_NATIVE_GROUP *)
+ * @brief Receive the status packets of all servo motors of a sync or bulk read (in any order)
+ * @return COMM_SUCCESS, ...
+ */
+static int receiveGroup(DXL_NATIVE_PORT *port, DXL_NATIVE_GROUP *group)
+{
+  size_t rx_bytes = 0;
+  int remaining = group->id_num, result = COMM_SUCCESS;
+  const uint8_t *packet;
+  size_t packet_length;
+  uint64_t deadline;
+
+  for (int i = 0; i < group->id_num; i++)
+  {
+    rx_bytes += PACKET_MIN_STATUS_LENGTH + group->length[i];
+  }
+  deadline = getDeadline(port, rx_bytes);
+  while ((remaining > 0) && ((result = receiveStatus(port, deadline, &packet, &packet_length)) == COMM_SUCCESS))
+  {
+    int index = findGroupId(group, packet[PACKET_ID]);
+
+    if ((index < 0) || group->received[index])
+      continue;
+    if (copyStatusParameter(packet, packet_length, group->data[index], group->length[index]) != group->length[index])
+    {
+      result = COMM_RX_CORRUPT;
+      break;
+    }
+    if (packet[PACKET_ERROR] != 0)
+      port->last_error = packet[PACKET_ERROR];
+    group->received[index] = 1;
+    remaining--;
+  }
+  group->last_result = (result == COMM_SUCCESS);
+  return port->last_result = result;
+}
+
+/**
+ * @fn static uint8_t isGroupDataAvailable(DXL_NATIVE_GROUP *, uint8_t, uint16_t, uint16_t, int *)
+ * @brief Check that the data of the servo motor was received by the last read of the group
+ * @param[out] *index index of the servo motor in the group
+ */
+static uint8_t isGroupDataAvailable(DXL_NATIVE_GROUP *group, uint8_t id, uint16_t address, uint16_t data_length, int *index)
+{
+  if ((group == NULL) || !group->last_result || ((*index = findGroupId(group, id)) < 0) || !group->received[*index])
+    return False;
+  if ((address < group->address[*index]) || (address + data_length > group->address[*index] + group->length[*index]))
+    return False;
+  return True;
+}
+
+/**
+ * @fn static uint32_t getGroupData(DXL_NATIVE_GROUP *, uint8_t, uint16_t, uint16_t)
+ * @brief Value of the received data (little endian, 1, 2 or 4 bytes)
+ */
+static uint32_t getGroupData(DXL_NATIVE_GROUP *group, uint8_t id, uint16_t address, uint16_t data_length)
+{
+  uint32_t value = 0;
+  const uint8_t *data;
+  int index;
+
+  if (!isGroupDataAvailable(group, id, address, data_length, &index))
+    return 0;
+  data = &group->data[index][address - group->address[index]];
+  for (int i = (data_length < 4) ? data_length - 1 : 3; i >= 0; i--)
+  {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+/**
+ * @fn static void writeRegister(int, uint8_t, uint16_t, uint32_t, int, int)
+ * @brief Write a register of a servo motor (status 1: wait for the status packet)
+ */
+static void writeRegister(int port_num, uint8_t id, uint16_t address, uint32_t data, int length, int status)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+
+  if (port == NULL)
+    return;
+  beginPacket(port, id, INST_WRITE);
+  putValue(port, address, 2);
+  putValue(port, data, length);
+  if ((sendPacket(port) == COMM_SUCCESS) && status && (id != BROADCAST_ID))
+    receiveFrom(port, id, NULL, 0);
+}
+
+//// Port functions ////
+
+/**
+ * @fn int portHandler(const char *)
+ * @brief Register a serial port
+ * @return port handle (-1 if DXL_NATIVE_MAX_PORTS ports are registered)
+ */
+int portHandler(const char *port_name)
+{
+  for (int i = 0; i < DXL_NATIVE_MAX_PORTS; i++)
+  {
+    DXL_NATIVE_PORT *port = &dxl_port[i];
+
+    if (port->used)
+      continue;
+    port->used = 1;
+    port->fd = -1;
+    snprintf(port->name, sizeof(port->name), "%s", port_name);
+    port->baudrate = DXL_NATIVE_DEFAULT_BAUDRATE;
+    port->last_result = COMM_NOT_AVAILABLE;
+    port->last_error = 0;
+    return i;
+  }
+  printf("[dxl_native] No free port (DXL_NATIVE_MAX_PORTS)\n");
+  return -1;
+}
+
+/**
+ * @fn uint8_t openPort(int)
+ * @brief Open the serial port (DXL_NATIVE_DEFAULT_BAUDRATE until setBaudRate)
+ * @return True or False
+ */
+uint8_t openPort(int port_num)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+
+  if ((port == NULL) || (port->fd >= 0))
+    return False;
+  port->fd = open(port->name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (port->fd < 0)
+    return False;
+  return setBaudRate(port_num, port->baudrate);
+}
+
+/**
+ * @fn void closePort(int)
+ * @brief Close the serial port and release its groups
+ */
+void closePort(int port_num)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+
+  if (port == NULL)
+    return;
+  if (port->fd >= 0)
+    close(port->fd);
+  for (int i = 0; i < DXL_NATIVE_MAX_GROUPS; i++)
+  {
+    if (dxl_group[i].used && (dxl_group[i].port_num == port_num))
+      dxl_group[i].used = 0;
+  }
+  port->fd = -1;
+  port->used = 0;
+}
+
+/**
+ * @fn static int getBaudRateSpeed(int, speed_t *)
+ * @brief termios speed of the baud rate (only the standard speeds: 4.5Mbps of the servo motors needs a custom divisor)
+ * @return 0: success, 1: unsupported baud rate
+ */
+static int getBaudRateSpeed(int baudrate, speed_t *speed)
+{
+  static const struct
+  {
+    int baudrate;
+    speed_t speed;
+  } speed_table[] = {{9600, B9600}, {57600, B57600}, {115200, B115200}, {1000000, B1000000},
+                     {2000000, B2000000}, {3000000, B3000000}, {4000000, B4000000}};
+
+  for (int i = 0; i < (int)(sizeof(speed_table) / sizeof(speed_table[0])); i++)
+  {
+    if (speed_table[i].baudrate == baudrate)
+    {
+      *speed = speed_table[i].speed;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @fn uint8_t isBaudRateSupported(int)
+ * @brief Check the baud rate before the servo motors are switched to it (not in DynamixelSDK)
+ * @param[in] baudrate [bps]
+ * @return True: setBaudRate accepts it, False: unsupported
+ */
+uint8_t isBaudRateSupported(int baudrate)
+{
+  speed_t speed;
+
+  return (getBaudRateSpeed(baudrate, &speed) == 0) ? True : False;
+}
+
+/**
+ * @fn uint8_t setBaudRate(int, const int)
+ * @brief Set the baud rate and the raw mode of the serial port
+ * @param[in] baudrate 9600, 57600, 115200, 1M, 2M, 3M or 4M [bps]
+ * @return True or False
+ */
+uint8_t setBaudRate(int port_num, const int baudrate)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+  struct termios tio;
+  speed_t speed;
+
+  if ((port == NULL) || (port->fd < 0))
+    return False;
+  if (getBaudRateSpeed(baudrate, &speed))
+  {
+    printf("[dxl_native] Unsupported baudrate : %d\n", baudrate);
+    return False;
+  }
+  memset(&tio, 0, sizeof(tio));
+  tio.c_cflag = CS8 | CLOCAL | CREAD;
+  tio.c_iflag = IGNPAR;
+  tio.c_cc[VTIME] = 0;
+  tio.c_cc[VMIN] = 0;
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+  tcflush(port->fd, TCIFLUSH);
+  if (tcsetattr(port->fd, TCSANOW, &tio) != 0)
+    return False;
+  port->baudrate = baudrate;
+  port->byte_time = 10.0 * 1e9 / baudrate;
+  return True;
+}
+
+/**
+ * @fn void packetHandler(void)
+ * @brief Nothing to do (the packet buffers are static)
+ */
+void packetHandler(void)
+{
+}
+
+//// Result functions ////
+
+/**
+ * @fn int getLastTxRxResult(int, int)
+ * @brief Result of the last transaction of the port (COMM_SUCCESS, ...)
+ */
+int getLastTxRxResult(int port_num, int protocol_version)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+
+  return (port != NULL) ? port->last_result : COMM_NOT_AVAILABLE;
+}
+
+/**
+ * @fn uint8_t getLastRxPacketError(int, int)
+ * @brief Error of the last status packet of the port
+ */
+uint8_t getLastRxPacketError(int port_num, int protocol_version)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+
+  return (port != NULL) ? port->last_error : 0;
+}
+
+/**
+ * @fn const char *getTxRxResult(int, int)
+ * @brief Message of the result (same as DynamixelSDK)
+ */
+const char *getTxRxResult(int protocol_version, int result)
+{
+  switch (result)
+  {
+  case COMM_SUCCESS:
+    return "[TxRxResult] Communication success!";
+  case COMM_PORT_BUSY:
+    return "[TxRxResult] Port is in use!";
+  case COMM_TX_FAIL:
+    return "[TxRxResult] Failed transmit instruction packet!";
+  case COMM_RX_FAIL:
+    return "[TxRxResult] Failed get status packet from device!";
+  case COMM_TX_ERROR:
+    return "[TxRxResult] Incorrect instruction packet!";
+  case COMM_RX_WAITING:
+    return "[TxRxResult] Now recieving status packet!";
+  case COMM_RX_TIMEOUT:
+    return "[TxRxResult] There is no status packet!";
+  case COMM_RX_CORRUPT:
+    return "[TxRxResult] Incorrect status packet!";
+  case COMM_NOT_AVAILABLE:
+    return "[TxRxResult] Protocol does not support This function!";
+  default:
+    return "";
+  }
+}
+
+/**
+ * @fn const char *getRxPacketError(int, uint8_t)
+ * @brief Message of the error of the status packet (same as DynamixelSDK)
+ */
+const char *getRxPacketError(int protocol_version, uint8_t error)
+{
+  if (error & 0x80)
+    return "[RxPacketError] Hardware error occurred. Check the error at Control Table (Hardware Error Status)!";
+  switch (error & 0x7F)
+  {
+  case 0:
+    return "";
+  case 1:
+    return "[RxPacketError] Failed to process the instruction packet!";
+  case 2:
+    return "[RxPacketError] Undefined instruction or incorrect instruction!";
+  case 3:
+    return "[RxPacketError] CRC doesn't match!";
+  case 4:
+    return "[RxPacketError] The data value is out of range!";
+  case 5:
+    return "[RxPacketError] The data length does not match as expected!";
+  case 6:
+    return "[RxPacketError] The data value exceeds the limit value!";
+  case 7:
+    return "[RxPacketError] Writing or Reading is not available to target address!";
+  default:
+    return "[RxPacketError] Unknown error code!";
+  }
+}
+
+//// Single servo motor functions ////
+
+/**
+ * @fn void ping(int, int, uint8_t)
+ * @brief Check that the servo motor answers
+ */
+void ping(int port_num, int protocol_version, uint8_t id)
+{
+  pingGetModelNum(port_num, protocol_version, id);
+}
+
+/**
+ * @fn uint16_t pingGetModelNum(int, int, uint8_t)
+ * @brief Model number of the servo motor (0 if it does not answer)
+ */
+uint16_t pingGetModelNum(int port_num, int protocol_version, uint8_t id)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+  uint8_t data[PING_STATUS_LENGTH];
+
+  if (port == NULL)
+    return 0;
+  beginPacket(port, id, INST_PING);
+  if ((sendPacket(port) != COMM_SUCCESS) || (receiveFrom(port, id, data, PING_STATUS_LENGTH) != COMM_SUCCESS))
+    return 0;
+  return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+/**
+ * @fn void reboot(int, int, uint8_t)
+ * @brief Reboot the servo motor
+ */
+void reboot(int port_num, int protocol_version, uint8_t id)
+{
+  DXL_NATIVE_PORT *port = getPort(port_num);
+
+  if (port == NULL)
+    return;
+  beginPacket(port, id, INST_REBOOT);
+  if (sendPacket(port) == COMM_SUCCESS)
+    receiveFrom(port, id, NULL, 0);
+}
+
+void write1ByteTxOnly(int port_num, int protocol_version, uint8_t id, uint16_t address, uint8_t data)
+{
+  writeRegister(port_num, id, address, data, 1, 0);
+}
+
+void write2ByteTxOnly(int port_num, int protocol_version, uint8_t id, uint16_t address, uint16_t data)
+{
+  writeRegister(port_num, id, address, data, 2, 0);
+}
+
+void write4ByteTxOnly(int port_num, int protocol_version, uint8_t id, uint16_t address, uint32_t data)
+{
+  writeRegister(port_num, id, address, data, 4, 0);
+}
+
+void write1ByteTxRx(int port_num, int protocol_version, uint8_t id, uint16_t address, uint8_t data)
+{
+  writeRegister(port_num, id, address, data, 1, 1);
+}
+
+void write2ByteTxRx(int port_num, int protocol_version, uint8_t id, uint16_t address, uint16_t data)
+{
+  writeRegister(port_num, id, address, data, 2, 1);
+}
+
+void write4ByteTxRx(int port_num, int protocol_version, uint8_t id, uint16_t address, uint32_t data)
+{
+  writeRegister(port_num, id, address, data, 4, 1);
+}
+
+//// Sync write functions ////
+
+/**
+ * @fn int groupSyncWrite(int, int, uint16_t, uint16_t)
+ * @brief Create a sync write group of the registers [start_address, start_address + data_length)
+ * @return group handle (-1 if the pool is exhausted)
+ */
+int groupSyncWrite(int port_num, int protocol_version, uint16_t start_address, uint16_t data_length)
+{
+  return createGroup(port_num, GROUP_SYNC_WRITE, start_address, data_length);
+}
+
+/**
+ * @fn uint8_t groupSyncWriteAddParam(int, uint8_t, uint32_t, uint16_t)
+ * @brief Append input_length bytes of data to the servo motor (added at the first call)
+ */
+uint8_t groupSyncWriteAddParam(int group_num, uint8_t id, uint32_t data, uint16_t input_length)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_WRITE);
+  int index;
+
+  if (group == NULL)
+    return False;
+  if ((index = findGroupId(group, id)) < 0)
+    index = addGroupId(group, id, group->start_address, group->data_length);
+  if ((index < 0) || (group->data_end[index] + input_length > group->length[index]))
+    return False;
+  setData(&group->data[index][group->data_end[index]], data, input_length);
+  group->data_end[index] += input_length;
+  return True;
+}
+
+/**
+ * @fn uint8_t groupSyncWriteChangeParam(int, uint8_t, uint32_t, uint16_t, uint16_t)
+ * @brief Overwrite the data of the servo motor from data_pos
+ */
+uint8_t groupSyncWriteChangeParam(int group_num, uint8_t id, uint32_t data, uint16_t input_length, uint16_t data_pos)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_WRITE);
+  int index;
+
+  if ((group == NULL) || ((index = findGroupId(group, id)) < 0) || (data_pos + input_length > group->length[index]))
+    return False;
+  setData(&group->data[index][data_pos], data, input_length);
+  return True;
+}
+
+void groupSyncWriteClearParam(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_WRITE);
+
+  if (group != NULL)
+    group->id_num = 0;
+}
+
+/**
+ * @fn void groupSyncWriteTxPacket(int)
+ * @brief Send the sync write packet (no status packet)
+ */
+void groupSyncWriteTxPacket(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_WRITE);
+  DXL_NATIVE_PORT *port = (group != NULL) ? getPort(group->port_num) : NULL;
+
+  if (port == NULL)
+    return;
+  if (group->id_num == 0)
+  {
+    port->last_result = COMM_NOT_AVAILABLE;
+    return;
+  }
+  beginPacket(port, BROADCAST_ID, INST_SYNC_WRITE);
+  putValue(port, group->start_address, 2);
+  putValue(port, group->data_length, 2);
+  for (int i = 0; i < group->id_num; i++)
+  {
+    putByte(port, group->id[i]);
+    for (int j = 0; j < group->data_length; j++)
+    {
+      putByte(port, group->data[i][j]);
+    }
+  }
+  sendPacket(port);
+}
+
+//// Sync read functions ////
+
+/**
+ * @fn int groupSyncRead(int, int, uint16_t, uint16_t)
+ * @brief Create a sync read group of the registers [start_address, start_address + data_length)
+ * @return group handle (-1 if the pool is exhausted)
+ */
+int groupSyncRead(int port_num, int protocol_version, uint16_t start_address, uint16_t data_length)
+{
+  return createGroup(port_num, GROUP_SYNC_READ, start_address, data_length);
+}
+
+uint8_t groupSyncReadAddParam(int group_num, uint8_t id)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_READ);
+
+  if ((group == NULL) || (findGroupId(group, id) >= 0))
+    return False;
+  return (addGroupId(group, id, group->start_address, group->data_length) >= 0) ? True : False;
+}
+
+void groupSyncReadClearParam(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_READ);
+
+  if (group != NULL)
+  {
+    group->id_num = 0;
+    group->last_result = 0;
+  }
+}
+
+/**
+ * @fn void groupSyncReadTxRxPacket(int)
+ * @brief Send the sync read packet and receive the status packets of all servo motors
+ */
+void groupSyncReadTxRxPacket(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_SYNC_READ);
+  DXL_NATIVE_PORT *port = (group != NULL) ? getPort(group->port_num) : NULL;
+
+  if (port == NULL)
+    return;
+  group->last_result = 0;
+  if (group->id_num == 0)
+  {
+    port->last_result = COMM_NOT_AVAILABLE;
+    return;
+  }
+  beginPacket(port, BROADCAST_ID, INST_SYNC_READ);
+  putValue(port, group->start_address, 2);
+  putValue(port, group->data_length, 2);
+  for (int i = 0; i < group->id_num; i++)
+  {
+    putByte(port, group->id[i]);
+    group->received[i] = 0;
+  }
+  if (sendPacket(port) == COMM_SUCCESS)
+    receiveGroup(port, group);
+}
+
+uint8_t groupSyncReadIsAvailable(int group_num, uint8_t id, uint16_t address, uint16_t data_length)
+{
+  int index;
+
+  return isGroupDataAvailable(getGroup(group_num, GROUP_SYNC_READ), id, address, data_length, &index);
+}
+
+uint32_t groupSyncReadGetData(int group_num, uint8_t id, uint16_t address, uint16_t data_length)
+{
+  return getGroupData(getGroup(group_num, GROUP_SYNC_READ), id, address, data_length);
+}
+
+//// Bulk write functions ////
+
+/**
+ * @fn int groupBulkWrite(int, int)
+ * @brief Create a bulk write group
+ * @return group handle (-1 if the pool is exhausted)
+ */
+int groupBulkWrite(int port_num, int protocol_version)
+{
+  return createGroup(port_num, GROUP_BULK_WRITE, 0, 0);
+}
+
+/**
+ * @fn uint8_t groupBulkWriteAddParam(int, uint8_t, uint16_t, uint16_t, uint32_t, uint16_t)
+ * @brief Append input_length bytes of data to the registers [start_address, start_address + data_length) of the servo motor
+ */
+uint8_t groupBulkWriteAddParam(int group_num, uint8_t id, uint16_t start_address, uint16_t data_length, uint32_t data, uint16_t input_length)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_BULK_WRITE);
+  int index;
+
+  if (group == NULL)
+    return False;
+  if ((index = findGroupId(group, id)) < 0)
+    index = addGroupId(group, id, start_address, data_length);
+  if ((index < 0) || (group->data_end[index] + input_length > group->length[index]))
+    return False;
+  setData(&group->data[index][group->data_end[index]], data, input_length);
+  group->data_end[index] += input_length;
+  return True;
+}
+
+void groupBulkWriteClearParam(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_BULK_WRITE);
+
+  if (group != NULL)
+    group->id_num = 0;
+}
+
+/**
+ * @fn void groupBulkWriteTxPacket(int)
+ * @brief Send the bulk write packet (no status packet)
+ */
+void groupBulkWriteTxPacket(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_BULK_WRITE);
+  DXL_NATIVE_PORT *port = (group != NULL) ? getPort(group->port_num) : NULL;
+
+  if (port == NULL)
+    return;
+  if (group->id_num == 0)
+  {
+    port->last_result = COMM_NOT_AVAILABLE;
+    return;
+  }
+  beginPacket(port, BROADCAST_ID, INST_BULK_WRITE);
+  for (int i = 0; i < group->id_num; i++)
+  {
+    putByte(port, group->id[i]);
+    putValue(port, group->address[i], 2);
+    putValue(port, group->length[i], 2);
+    for (int j = 0; j < group->length[i]; j++)
+    {
+      putByte(port, group->data[i][j]);
+    }
+  }
+  sendPacket(port);
+}
+
+//// Bulk read functions ////
+
+/**
+ * @fn int groupBulkRead(int, int)
+ * @brief Create a bulk read group
+ * @return group handle (-1 if the pool is exhausted)
+ */
+int groupBulkRead(int port_num, int protocol_version)
+{
+  return createGroup(port_num, GROUP_BULK_READ, 0, 0);
+}
+
+uint8_t groupBulkReadAddParam(int group_num, uint8_t id, uint16_t start_address, uint16_t data_length)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_BULK_READ);
+
+  if ((group == NULL) || (findGroupId(group, id) >= 0))
+    return False;
+  return (addGroupId(group, id, start_address, data_length) >= 0) ? True : False;
+}
+
+void groupBulkReadClearParam(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_BULK_READ);
+
+  if (group != NULL)
+  {
+    group->id_num = 0;
+    group->last_result = 0;
+  }
+}
+
+/**
+ * @fn void groupBulkReadTxRxPacket(int)
+ * @brief Send the bulk read packet and receive the status packets of all servo motors
+ */
+void groupBulkReadTxRxPacket(int group_num)
+{
+  DXL_NATIVE_GROUP *group = getGroup(group_num, GROUP_BULK_READ);
+  DXL_NATIVE_PORT *port = (group != NULL) ? getPort(group->port_num) : NULL;
+
+  if (port == NULL)
+    return;
+  group->last_result = 0;
+  if (group->id_num == 0)
+  {
+    port->last_result = COMM_NOT_AVAILABLE;
+    return;
+  }
+  beginPacket(port, BROADCAST_ID, INST_BULK_READ);
+  for (int i = 0; i < group->id_num; i++)
+  {
+    putByte(port, group->id[i]);
+    putValue(port, group->address[i], 2);
+    putValue(port, group->length[i], 2);
+    group->received[i] = 0;
+  }
+  if (sendPacket(port) == COMM_SUCCESS)
+    receiveGroup(port, group);
+}
+
+uint8_t groupBulkReadIsAvailable(int group_num, uint8_t id, uint16_t address, uint16_t data_length)
+{
+  int index;
+
+  return isGroupDataAvailable(getGroup(group_num, GROUP_BULK_READ), id, address, data_length, &index);
+}
+
+uint32_t groupBulkReadGetData(int group_num, uint8_t id, uint16_t address, uint16_t data_length)
+{
+  return getGroupData(getGroup(group_num, GROUP_BULK_READ), id, address, data_length);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file dxl_native.h
+ * @brief Dynamixel Protocol 2.0 transport on a termios file descriptor (TRANSPORT=native).
+ *        The functions used by crane_x7_comm.c have the same names and arguments as the C API of DynamixelSDK,
+ *        so crane_x7_comm.c runs on either of them without changes.
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DXL_NATIVE_H_
+#define DXL_NATIVE_H_
+
+#include <stdint.h>
+
+// Same values as DynamixelSDK
+#define True (1)
+#define False (0)
+#define BROADCAST_ID (0xFE)
+#define COMM_SUCCESS (0)
+#define COMM_PORT_BUSY (-1000)
+#define COMM_TX_FAIL (-1001)
+#define COMM_RX_FAIL (-1002)
+#define COMM_TX_ERROR (-2000)
+#define COMM_RX_WAITING (-3000)
+#define COMM_RX_TIMEOUT (-3001)
+#define COMM_RX_CORRUPT (-3002)
+#define COMM_NOT_AVAILABLE (-9000)
+
+// Static pools (nothing is allocated at run time)
+#define DXL_NATIVE_MAX_PORTS (4)       // ports opened at the same time
+#define DXL_NATIVE_MAX_GROUPS (64)     // groups of all ports (released by closePort)
+#define DXL_NATIVE_MAX_GROUP_IDS (16)  // servo motors of a group
+#define DXL_NATIVE_MAX_DATA (256)      // data length of a servo motor in a group
+#define DXL_NATIVE_TX_SIZE (8192)      // instruction packet buffer of a port (with byte stuffing)
+#define DXL_NATIVE_RX_SIZE (4096)      // status packet buffer of a port
+#define DXL_NATIVE_LATENCY_TIMER (16)  // latency of the USB serial converter assumed by the timeout [ms] (as DynamixelSDK)
+#define DXL_NATIVE_DEFAULT_BAUDRATE (57600)
+
+//// Prototype declaration ////
+// Port
+int portHandler(const char *);
+uint8_t openPort(int);
+void closePort(int);
+uint8_t setBaudRate(int, const int);
+uint8_t isBaudRateSupported(int); // not in DynamixelSDK
+void packetHandler(void);
+// Result of the last transaction of the port
+int getLastTxRxResult(int, int);
+uint8_t getLastRxPacketError(int, int);
+const char *getTxRxResult(int, int);
+const char *getRxPacketError(int, uint8_t);
+// Single servo motor
+void ping(int, int, uint8_t);
+uint16_t pingGetModelNum(int, int, uint8_t);
+void reboot(int, int, uint8_t);
+void write1ByteTxOnly(int, int, uint8_t, uint16_t, uint8_t);
+void write2ByteTxOnly(int, int, uint8_t, uint16_t, uint16_t);
+void write4ByteTxOnly(int, int, uint8_t, uint16_t, uint32_t);
+void write1ByteTxRx(int, int, uint8_t, uint16_t, uint8_t);
+void write2ByteTxRx(int, int, uint8_t, uint16_t, uint16_t);
+void write4ByteTxRx(int, int, uint8_t, uint16_t, uint32_t);
+// Sync write
+int groupSyncWrite(int, int, uint16_t, uint16_t);
+uint8_t groupSyncWriteAddParam(int, uint8_t, uint32_t, uint16_t);
+uint8_t groupSyncWriteChangeParam(int, uint8_t, uint32_t, uint16_t, uint16_t);
+void groupSyncWriteClearParam(int);
+void groupSyncWriteTxPacket(int);
+// Sync read
+int groupSyncRead(int, int, uint16_t, uint16_t);
+uint8_t groupSyncReadAddParam(int, uint8_t);
+void groupSyncReadClearParam(int);
+void groupSyncReadTxRxPacket(int);
+uint8_t groupSyncReadIsAvailable(int, uint8_t, uint16_t, uint16_t);
+uint32_t groupSyncReadGetData(int, uint8_t, uint16_t, uint16_t);
+// Bulk write
+int groupBulkWrite(int, int);
+uint8_t groupBulkWriteAddParam(int, uint8_t, uint16_t, uint16_t, uint32_t, uint16_t);
+void groupBulkWriteClearParam(int);
+void groupBulkWriteTxPacket(int);
+// Bulk read
+int groupBulkRead(int, int);
+uint8_t groupBulkReadAddParam(int, uint8_t, uint16_t, uint16_t);
+void groupBulkReadClearParam(int);
+void groupBulkReadTxRxPacket(int);
+uint8_t groupBulkReadIsAvailable(int, uint8_t, uint16_t, uint16_t);
+uint32_t groupBulkReadGetData(int, uint8_t, uint16_t, uint16_t);
+
+#endif
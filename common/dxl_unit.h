@@ -0,0 +1,37 @@
+/**
+ * @file dxl_unit.h
+ * @brief Unit conversion functions between physical quantities and dynamixel values (no dependency on DynamixelSDK)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DXL_UNIT_H_
+#define DXL_UNIT_H_
+
+//// Prototype declaration ////
+double rad2dxlvalue(double);
+double dxlvalue2rad(double);
+double angularvel2dxlvalue(double);
+double dxlvalue2angularvel(double);
+double current2dxlvalue(double);
+double dxlvalue2current(double);
+double current2torqueXM430W350(double);
+double current2torqueXM540W270(double);
+double torque2currentXM430W350(double);
+double torque2currentXM540W270(double);
+
+#endif
@@ -0,0 +1,583 @@
+/**
+ * @file dynamics.c
+ * @brief Rigid body dynamics of 7 degrees of freedom CRANE-X7 arm
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stddef.h>
+#include "dynamics.h"
+
+#define SPATIAL_DIM (6) // spatial vector: angular part x, y, z and linear part x, y, z (Plucker coordinates at base origin)
+
+static LINK_PARAM link_parameter[LINK_NUM_7DOF];
+static double joint_armature[KINEMATICS_DOF];
+static JOINT_RANGE joint_range[JOINT_NUM];
+
+/**
+ * @struct ROLLOUT_JOB
+ * @brief Arguments of rollouts shared by worker threads
+ */
+typedef struct
+{
+    DYNAMICS_ROLLOUT *rollouts;
+    double duration;
+    double dt;
+    DYNAMICS_POLICY policy;
+    void *user_data;
+} ROLLOUT_JOB;
+
+/**
+ * @fn static double dotVecVec3D(VECTOR_3D, VECTOR_3D)
+ * @brief Inner product of 3 dimentional vectors
+ */
+static double dotVecVec3D(VECTOR_3D VecA, VECTOR_3D VecB)
+{
+    return VecA.x * VecB.x + VecA.y * VecB.y + VecA.z * VecB.z;
+}
+
+/**
+ * @fn static MATRIX_3D getLinkRotation(const KINEMATICS_CACHE *, int)
+ * @brief Rotation matrix of the link frame in base frame
+ */
+static MATRIX_3D getLinkRotation(const KINEMATICS_CACHE *cache, int link)
+{
+    MATRIX_3D rot;
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            rot.a[i][j] = cache->frame[link].a[i][j];
+        }
+    }
+    return rot;
+}
+
+/**
+ * @fn void initDynamics(void)
+ * @brief Load the link parameter (getLinkParam7Dof), the rotor inertia of servo motors and the movable range
+ */
+void initDynamics(void)
+{
+    getLinkParam7Dof(link_parameter);
+    getJointRange(joint_range);
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        joint_armature[i] = (i == XM540_W270_JOINT) ? ARMATURE_XM540W270 : ARMATURE_XM430W350;
+    }
+}
+
+/**
+ * @fn int inverseDynamics7Dof(KINEMATICS_CACHE *, const double *, const double *, const double *, double *)
+ * @brief Joint torque to realize the joint motion by recursive Newton-Euler method (in base frame).
+ *        Gravity is included as the upward acceleration of the base. Rotor inertia of servo motors is included.
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before)
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[in] *angvel joint angular velocities [rad/s] (JOINT_NUM elements)
+ * @param[in] *angacc joint angular accelerations [rad/s^2] (JOINT_NUM elements)
+ * @param[out] *torque joint torques [Nm] (JOINT_NUM elements, 0 for the gripper)
+ * @return 0
+ */
+int inverseDynamics7Dof(KINEMATICS_CACHE *cache, const double *theta, const double *angvel, const double *angacc, double *torque)
+{
+    VECTOR_3D force[KINEMATICS_DOF];  // inertial force of link at center of mass
+    VECTOR_3D moment[KINEMATICS_DOF]; // inertial moment of link around center of mass
+    VECTOR_3D com[KINEMATICS_DOF];    // center of mass from the link origin
+    VECTOR_3D origin[KINEMATICS_DOF + 1];
+    VECTOR_3D w = {0, 0, 0};                       // angular velocity
+    VECTOR_3D dw = {0, 0, 0};                      // angular acceleration
+    VECTOR_3D a = {0, 0, GRAVITY_ACCELERATION};    // acceleration of the link origin
+    VECTOR_3D f = {0, 0, 0}, n = {0, 0, 0};
+
+    forwardKinematics7Dof(cache, theta);
+    for (int i = 0; i <= KINEMATICS_DOF; i++)
+    {
+        getJointPosition(cache, i, &origin[i]);
+    }
+
+    // forward recursion of velocity and acceleration
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        MATRIX_3D rot = getLinkRotation(cache, i);
+        VECTOR_3D wz = mulScoVec3D(angvel[i], cache->axis[i]);
+        VECTOR_3D ac, local, tmp, iw;
+
+        if (i > 0)
+        {
+            VECTOR_3D d = subVecVec3D(origin[i], origin[i - 1]);
+            a = sumVecVec3D(a, sumVecVec3D(crsVecVec3D(dw, d), crsVecVec3D(w, crsVecVec3D(w, d))));
+        }
+        dw = sumVecVec3D(dw, sumVecVec3D(mulScoVec3D(angacc[i], cache->axis[i]), crsVecVec3D(w, wz)));
+        w = sumVecVec3D(w, wz);
+
+        com[i] = mulMatVec3D(rot, link_parameter[i].com);
+        ac = sumVecVec3D(a, sumVecVec3D(crsVecVec3D(dw, com[i]), crsVecVec3D(w, crsVecVec3D(w, com[i]))));
+        force[i] = mulScoVec3D(link_parameter[i].mass, ac);
+        // I dw + w x (I w) with the inertia tensor rotated to base frame: I = R Ilocal R^T
+        mulTransMatVec3DPtr(&rot, &dw, &local);
+        mulMatVec3DPtr(&link_parameter[i].inertia_tensor, &local, &tmp);
+        mulMatVec3DPtr(&rot, &tmp, &moment[i]);
+        mulTransMatVec3DPtr(&rot, &w, &local);
+        mulMatVec3DPtr(&link_parameter[i].inertia_tensor, &local, &tmp);
+        mulMatVec3DPtr(&rot, &tmp, &iw);
+        crsVecVec3DPtr(&w, &iw, &tmp);
+        sumVecVec3DPtr(&moment[i], &tmp, &moment[i]);
+    }
+
+    // backward recursion of force and moment (n is the moment around the link origin)
+    for (int i = KINEMATICS_DOF - 1; i >= 0; i--)
+    {
+        VECTOR_3D d = subVecVec3D(origin[i + 1], origin[i]);
+
+        n = sumVecVec3D(sumVecVec3D(moment[i], crsVecVec3D(com[i], force[i])), sumVecVec3D(n, crsVecVec3D(d, f)));
+        f = sumVecVec3D(force[i], f);
+        torque[i] = dotVecVec3D(cache->axis[i], n) + joint_armature[i] * angacc[i];
+    }
+    for (int i = KINEMATICS_DOF; i < JOINT_NUM; i++)
+    {
+        torque[i] = 0;
+    }
+    return 0;
+}
+
+/**
+ * @fn int calcGravityTorque7Dof(KINEMATICS_CACHE *, const double *, double *)
+ * @brief Joint torque to hold the arm against gravity (same as inverseDynamics7Dof with zero velocity and acceleration).
+ *        Only the mass and the first moment of the links after each joint are accumulated.
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before)
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[out] *torque joint torques [Nm] (JOINT_NUM elements, 0 for the gripper)
+ * @return 0
+ */
+int calcGravityTorque7Dof(KINEMATICS_CACHE *cache, const double *theta, double *torque)
+{
+    double mass = 0;
+    double mx = 0, my = 0; // first moment of mass (z is not needed for gravity along z)
+
+    forwardKinematics7Dof(cache, theta);
+    for (int i = KINEMATICS_DOF - 1; i >= 0; i--)
+    {
+        const MATRIX_4D *T = &cache->frame[i];
+        const VECTOR_3D *c = &link_parameter[i].com;
+        const VECTOR_3D *z = &cache->axis[i];
+        double rx, ry;
+
+        mass += link_parameter[i].mass;
+        mx += link_parameter[i].mass * (T->a[0][0] * c->x + T->a[0][1] * c->y + T->a[0][2] * c->z + T->a[0][3]);
+        my += link_parameter[i].mass * (T->a[1][0] * c->x + T->a[1][1] * c->y + T->a[1][2] * c->z + T->a[1][3]);
+        // moment of (S - m p) x (0, 0, g) around the joint axis
+        rx = mx - mass * T->a[0][3];
+        ry = my - mass * T->a[1][3];
+        torque[i] = GRAVITY_ACCELERATION * (z->x * ry - z->y * rx);
+    }
+    for (int i = KINEMATICS_DOF; i < JOINT_NUM; i++)
+    {
+        torque[i] = 0;
+    }
+    return 0;
+}
+
+//// Forward dynamics ////
+
+/**
+ * @fn static void crossMotion(const double *, const double *, double *)
+ * @brief Spatial cross product of motion vectors (v x m)
+ */
+static void crossMotion(const double *v, const double *m, double *result)
+{
+    result[0] = v[1] * m[2] - v[2] * m[1];
+    result[1] = v[2] * m[0] - v[0] * m[2];
+    result[2] = v[0] * m[1] - v[1] * m[0];
+    result[3] = v[1] * m[5] - v[2] * m[4] + v[4] * m[2] - v[5] * m[1];
+    result[4] = v[2] * m[3] - v[0] * m[5] + v[5] * m[0] - v[3] * m[2];
+    result[5] = v[0] * m[4] - v[1] * m[3] + v[3] * m[1] - v[4] * m[0];
+}
+
+/**
+ * @fn static void crossForce(const double *, const double *, double *)
+ * @brief Spatial cross product of motion vector and force vector (v x* f)
+ */
+static void crossForce(const double *v, const double *f, double *result)
+{
+    result[0] = v[1] * f[2] - v[2] * f[1] + v[4] * f[5] - v[5] * f[4];
+    result[1] = v[2] * f[0] - v[0] * f[2] + v[5] * f[3] - v[3] * f[5];
+    result[2] = v[0] * f[1] - v[1] * f[0] + v[3] * f[4] - v[4] * f[3];
+    result[3] = v[1] * f[5] - v[2] * f[4];
+    result[4] = v[2] * f[3] - v[0] * f[5];
+    result[5] = v[0] * f[4] - v[1] * f[3];
+}
+
+/**
+ * @fn static void mulSpatialMatVec(double [][SPATIAL_DIM], const double *, double *)
+ * @brief Multiply 6x6 matrix and spatial vector
+ */
+static void mulSpatialMatVec(double A[SPATIAL_DIM][SPATIAL_DIM], const double *v, double *result)
+{
+    for (int i = 0; i < SPATIAL_DIM; i++)
+    {
+        result[i] = A[i][0] * v[0] + A[i][1] * v[1] + A[i][2] * v[2] + A[i][3] * v[3] + A[i][4] * v[4] + A[i][5] * v[5];
+    }
+}
+
+/**
+ * @fn static void setSpatialInertia(const KINEMATICS_CACHE *, int, double [][SPATIAL_DIM])
+ * @brief Spatial inertia of the link around the base origin: [Ic - m CC, m C; -m C, m E] (C: skew matrix of center of mass)
+ */
+static void setSpatialInertia(const KINEMATICS_CACHE *cache, int link, double I[SPATIAL_DIM][SPATIAL_DIM])
+{
+    const MATRIX_4D *T = &cache->frame[link];
+    const LINK_PARAM *param = &link_parameter[link];
+    double m = param->mass;
+    double RI[3][3], Ic[3][3], c[3], C[3][3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        c[i] = T->a[i][0] * param->com.x + T->a[i][1] * param->com.y + T->a[i][2] * param->com.z + T->a[i][3];
+        for (int j = 0; j < 3; j++)
+        {
+            RI[i][j] = T->a[i][0] * param->inertia_tensor.a[0][j] + T->a[i][1] * param->inertia_tensor.a[1][j] + T->a[i][2] * param->inertia_tensor.a[2][j];
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            Ic[i][j] = RI[i][0] * T->a[j][0] + RI[i][1] * T->a[j][1] + RI[i][2] * T->a[j][2];
+        }
+    }
+    C[0][0] = 0;
+    C[0][1] = -c[2];
+    C[0][2] = c[1];
+    C[1][0] = c[2];
+    C[1][1] = 0;
+    C[1][2] = -c[0];
+    C[2][0] = -c[1];
+    C[2][1] = c[0];
+    C[2][2] = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            // -m C C = m C C^T
+            I[i][j] = Ic[i][j] + m * (C[i][0] * C[j][0] + C[i][1] * C[j][1] + C[i][2] * C[j][2]);
+            I[i][j + 3] = m * C[i][j];
+            I[i + 3][j] = -m * C[i][j];
+            I[i + 3][j + 3] = (i == j) ? m : 0;
+        }
+    }
+}
+
+/**
+ * @fn static void setMotionSubspace(const KINEMATICS_CACHE *, int, double *)
+ * @brief Motion subspace of revolute joint about the axis z through the point p: S = [z; p x z]
+ */
+static void setMotionSubspace(const KINEMATICS_CACHE *cache, int joint, double *S)
+{
+    const VECTOR_3D *z = &cache->axis[joint];
+    const MATRIX_4D *T = &cache->frame[joint];
+
+    S[0] = z->x;
+    S[1] = z->y;
+    S[2] = z->z;
+    S[3] = T->a[1][3] * z->z - T->a[2][3] * z->y;
+    S[4] = T->a[2][3] * z->x - T->a[0][3] * z->z;
+    S[5] = T->a[0][3] * z->y - T->a[1][3] * z->x;
+}
+
+/**
+ * @fn int forwardDynamics7Dof(KINEMATICS_CACHE *, const double *, const double *, const double *, double *)
+ * @brief Joint acceleration caused by joint torques by articulated body algorithm (O(n), in base frame).
+ *        Gravity and rotor inertia of servo motors are included as in inverseDynamics7Dof.
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before)
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[in] *angvel joint angular velocities [rad/s] (JOINT_NUM elements)
+ * @param[in] *torque joint torques [Nm] (JOINT_NUM elements)
+ * @param[out] *angacc joint angular accelerations [rad/s^2] (JOINT_NUM elements, 0 for the gripper)
+ * @return 0
+ */
+int forwardDynamics7Dof(KINEMATICS_CACHE *cache, const double *theta, const double *angvel, const double *torque, double *angacc)
+{
+    double S[KINEMATICS_DOF][SPATIAL_DIM];                // motion subspace of joints
+    double c[KINEMATICS_DOF][SPATIAL_DIM];                // velocity product acceleration
+    double IA[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM];  // articulated body inertia
+    double pA[KINEMATICS_DOF][SPATIAL_DIM];               // articulated bias force
+    double U[KINEMATICS_DOF][SPATIAL_DIM];
+    double D[KINEMATICS_DOF], u[KINEMATICS_DOF];
+    double v[SPATIAL_DIM] = {0, 0, 0, 0, 0, 0};
+    double a[SPATIAL_DIM] = {0, 0, 0, 0, 0, GRAVITY_ACCELERATION}; // gravity as the upward acceleration of the base
+
+    forwardKinematics7Dof(cache, theta);
+
+    // pass 1: velocity, velocity product and bias force of each link
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        double vJ[SPATIAL_DIM], Iv[SPATIAL_DIM];
+
+        setMotionSubspace(cache, i, S[i]);
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            vJ[k] = S[i][k] * angvel[i];
+            v[k] += vJ[k];
+        }
+        crossMotion(v, vJ, c[i]);
+        setSpatialInertia(cache, i, IA[i]);
+        mulSpatialMatVec(IA[i], v, Iv);
+        crossForce(v, Iv, pA[i]);
+    }
+
+    // pass 2: articulated body inertia from the tip to the base
+    for (int i = KINEMATICS_DOF - 1; i >= 0; i--)
+    {
+        mulSpatialMatVec(IA[i], S[i], U[i]);
+        D[i] = joint_armature[i];
+        u[i] = torque[i];
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            D[i] += S[i][k] * U[i][k];
+            u[i] -= S[i][k] * pA[i][k];
+        }
+        if (i > 0)
+        {
+            double Ia[SPATIAL_DIM][SPATIAL_DIM], Iac[SPATIAL_DIM];
+
+            for (int j = 0; j < SPATIAL_DIM; j++)
+            {
+                for (int k = 0; k < SPATIAL_DIM; k++)
+                {
+                    Ia[j][k] = IA[i][j][k] - U[i][j] * U[i][k] / D[i];
+                    IA[i - 1][j][k] += Ia[j][k];
+                }
+            }
+            mulSpatialMatVec(Ia, c[i], Iac);
+            for (int k = 0; k < SPATIAL_DIM; k++)
+            {
+                pA[i - 1][k] += pA[i][k] + Iac[k] + U[i][k] * u[i] / D[i];
+            }
+        }
+    }
+
+    // pass 3: acceleration from the base to the tip
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        double Ua = 0;
+
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            a[k] += c[i][k];
+            Ua += U[i][k] * a[k];
+        }
+        angacc[i] = (u[i] - Ua) / D[i];
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            a[k] += S[i][k] * angacc[i];
+        }
+    }
+    for (int i = KINEMATICS_DOF; i < JOINT_NUM; i++)
+    {
+        angacc[i] = 0;
+    }
+    return 0;
+}
+
+/**
+ * @fn int stepDynamics7Dof(KINEMATICS_CACHE *, double *, double *, const double *, double)
+ * @brief Integrate the forward dynamics by one step (semi-implicit euler method).
+ *        A joint which reaches the end of the movable range stops there (mechanical stop).
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before)
+ * @param[in,out] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[in,out] *angvel joint angular velocities [rad/s] (JOINT_NUM elements)
+ * @param[in] *torque joint torques [Nm] (JOINT_NUM elements)
+ * @param[in] dt integration step [s]
+ * @return number of joints which reached the end of the movable range
+ */
+int stepDynamics7Dof(KINEMATICS_CACHE *cache, double *theta, double *angvel, const double *torque, double dt)
+{
+    double angacc[JOINT_NUM];
+    int hits = 0;
+
+    forwardDynamics7Dof(cache, theta, angvel, torque, angacc);
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        angvel[i] += angacc[i] * dt;
+        theta[i] += angvel[i] * dt;
+        if ((theta[i] < joint_range[i].min) || (theta[i] > joint_range[i].max))
+        {
+            theta[i] = (theta[i] < joint_range[i].min) ? joint_range[i].min : joint_range[i].max;
+            angvel[i] = 0;
+            hits++;
+        }
+    }
+    return hits;
+}
+
+/**
+ * @fn static void runRollout(int, void *)
+ * @brief Task of thread pool: integrate one rollout
+ */
+static void runRollout(int index, void *user_data)
+{
+    ROLLOUT_JOB *job = (ROLLOUT_JOB *)user_data;
+    DYNAMICS_ROLLOUT *rollout = &job->rollouts[index];
+    KINEMATICS_CACHE cache;
+    int steps = (int)(job->duration / job->dt + 0.5);
+
+    initKinematicsCache(&cache);
+    rollout->limit_hits = 0;
+    for (int n = 0; n < steps; n++)
+    {
+        if (job->policy != NULL)
+            job->policy(rollout, index, n * job->dt, rollout->torque, job->user_data);
+        if (stepDynamics7Dof(&cache, rollout->theta, rollout->angvel, rollout->torque, job->dt) > 0)
+            rollout->limit_hits++;
+    }
+}
+
+/**
+ * @fn int runDynamicsRollouts(THREAD_POOL *, DYNAMICS_ROLLOUT *, int, double, double, DYNAMICS_POLICY, void *)
+ * @brief Integrate many rollouts of forward dynamics in parallel on the thread pool
+ * @param[in,out] *pool thread pool (initThreadPool must be called before)
+ * @param[in,out] *rollouts initial states and torques, overwritten by the final states
+ * @param[in] num number of rollouts
+ * @param[in] duration simulated time of each rollout [s]
+ * @param[in] dt integration step [s]
+ * @param[in] policy function to give joint torques every step (NULL: the torques of the rollout are kept constant)
+ * @param[in] *user_data pointer passed to the policy
+ * @return 0
+ */
+int runDynamicsRollouts(THREAD_POOL *pool, DYNAMICS_ROLLOUT *rollouts, int num, double duration, double dt, DYNAMICS_POLICY policy, void *user_data)
+{
+    ROLLOUT_JOB job = {rollouts, duration, dt, policy, user_data};
+
+    return runThreadPool(pool, num, runRollout, &job);
+}
+
+//// Joint space dynamics ////
+
+/**
+ * @fn static void calcCompositeInertia(const KINEMATICS_CACHE *, double [][SPATIAL_DIM], double [][SPATIAL_DIM][SPATIAL_DIM], double [][SPATIAL_DIM][SPATIAL_DIM], double [][KINEMATICS_DOF])
+ * @brief Composite rigid body algorithm: spatial inertia of each link, composite inertia of the links after each joint and M(q)
+ */
+static void calcCompositeInertia(const KINEMATICS_CACHE *cache, double S[KINEMATICS_DOF][SPATIAL_DIM],
+                                 double I[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM], double Ic[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM],
+                                 double M[KINEMATICS_DOF][KINEMATICS_DOF])
+{
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        setMotionSubspace(cache, i, S[i]);
+        setSpatialInertia(cache, i, I[i]);
+    }
+    for (int i = KINEMATICS_DOF - 1; i >= 0; i--)
+    {
+        double F[SPATIAL_DIM];
+
+        // all spatial quantities are in base frame, so the composite inertia is a plain sum
+        for (int j = 0; j < SPATIAL_DIM; j++)
+        {
+            for (int k = 0; k < SPATIAL_DIM; k++)
+            {
+                Ic[i][j][k] = (i < KINEMATICS_DOF - 1) ? I[i][j][k] + Ic[i + 1][j][k] : I[i][j][k];
+            }
+        }
+        mulSpatialMatVec(Ic[i], S[i], F);
+        for (int j = 0; j <= i; j++)
+        {
+            M[i][j] = S[j][0] * F[0] + S[j][1] * F[1] + S[j][2] * F[2] + S[j][3] * F[3] + S[j][4] * F[4] + S[j][5] * F[5];
+            M[j][i] = M[i][j];
+        }
+        M[i][i] += joint_armature[i];
+    }
+}
+
+/**
+ * @fn int calcMassMatrix7Dof(KINEMATICS_CACHE *, const double *, double [][KINEMATICS_DOF])
+ * @brief Joint space mass matrix M(q) by composite rigid body algorithm (rotor inertia of servo motors is included).
+ *        Link frames are taken from the kinematics cache, so FK, the jacobian and M(q) of the same angles share one kinematics calculation.
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before)
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[out] M mass matrix [kgm^2]
+ * @return 0
+ */
+int calcMassMatrix7Dof(KINEMATICS_CACHE *cache, const double *theta, double M[KINEMATICS_DOF][KINEMATICS_DOF])
+{
+    double S[KINEMATICS_DOF][SPATIAL_DIM];
+    double I[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM], Ic[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM];
+
+    forwardKinematics7Dof(cache, theta);
+    calcCompositeInertia(cache, S, I, Ic, M);
+    return 0;
+}
+
+/**
+ * @fn int calcJointSpaceDynamics7Dof(KINEMATICS_CACHE *, const double *, const double *, JOINT_SPACE_DYNAMICS *)
+ * @brief M(q), C(q, dq) dq and g(q) in one call (for operational space and impedance control).
+ *        The spatial inertias of the links are calculated once and shared by the three terms.
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before)
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[in] *angvel joint angular velocities [rad/s] (JOINT_NUM elements)
+ * @param[out] *dynamics terms of the equation of motion
+ * @return 0
+ */
+int calcJointSpaceDynamics7Dof(KINEMATICS_CACHE *cache, const double *theta, const double *angvel, JOINT_SPACE_DYNAMICS *dynamics)
+{
+    double S[KINEMATICS_DOF][SPATIAL_DIM];
+    double I[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM], Ic[KINEMATICS_DOF][SPATIAL_DIM][SPATIAL_DIM];
+    double f[KINEMATICS_DOF][SPATIAL_DIM]; // force of each link caused by velocity
+    double v[SPATIAL_DIM] = {0, 0, 0, 0, 0, 0};
+    double a[SPATIAL_DIM] = {0, 0, 0, 0, 0, 0};
+    double fsum[SPATIAL_DIM] = {0, 0, 0, 0, 0, 0};
+
+    forwardKinematics7Dof(cache, theta);
+    calcCompositeInertia(cache, S, I, Ic, dynamics->mass_matrix);
+
+    // C(q, dq) dq: Newton-Euler with zero joint acceleration and without gravity
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        double vJ[SPATIAL_DIM], c[SPATIAL_DIM], Iv[SPATIAL_DIM], Ia[SPATIAL_DIM], vIv[SPATIAL_DIM];
+
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            vJ[k] = S[i][k] * angvel[i];
+            v[k] += vJ[k];
+        }
+        crossMotion(v, vJ, c);
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            a[k] += c[k];
+        }
+        mulSpatialMatVec(I[i], v, Iv);
+        mulSpatialMatVec(I[i], a, Ia);
+        crossForce(v, Iv, vIv);
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            f[i][k] = Ia[k] + vIv[k];
+        }
+    }
+    for (int i = KINEMATICS_DOF - 1; i >= 0; i--)
+    {
+        dynamics->coriolis[i] = 0;
+        for (int k = 0; k < SPATIAL_DIM; k++)
+        {
+            fsum[k] += f[i][k];
+            dynamics->coriolis[i] += S[i][k] * fsum[k];
+        }
+        // g(q): composite inertia accelerated upward by gravity, Ic [0, 0, 0, 0, 0, g]
+        dynamics->gravity[i] = GRAVITY_ACCELERATION * (S[i][0] * Ic[i][0][5] + S[i][1] * Ic[i][1][5] + S[i][2] * Ic[i][2][5] +
+                                                       S[i][3] * Ic[i][3][5] + S[i][4] * Ic[i][4][5] + S[i][5] * Ic[i][5][5]);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file dynamics.h
+ * @brief Rigid body dynamics of 7 degrees of freedom CRANE-X7 arm
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNAMICS_H_
+#define DYNAMICS_H_
+
+#include "kinematics.h"
+#include "thread_pool.h"
+
+#define GRAVITY_ACCELERATION (9.80665) // gravitational acceleration[m/s^2]
+#define ARMATURE_XM430W350 (0.012)     // rotor inertia reflected to output shaft[kgm^2]
+#define ARMATURE_XM540W270 (0.030)     // rotor inertia reflected to output shaft[kgm^2]
+
+//// Structure definition ////
+/**
+ * @struct JOINT_SPACE_DYNAMICS
+ * @brief Terms of the equation of motion: M(q) ddq + C(q, dq) dq + g(q) = torque
+ */
+typedef struct
+{
+    double mass_matrix[KINEMATICS_DOF][KINEMATICS_DOF]; // M(q) including rotor inertia of servo motors [kgm^2]
+    double coriolis[KINEMATICS_DOF];                    // C(q, dq) dq: coriolis and centrifugal torques [Nm]
+    double gravity[KINEMATICS_DOF];                     // g(q): gravity torques [Nm]
+} JOINT_SPACE_DYNAMICS;
+
+/**
+ * @struct DYNAMICS_ROLLOUT
+ * @brief State of one rollout of forward dynamics
+ */
+typedef struct
+{
+    double theta[JOINT_NUM];  // joint angles [rad] (initial state, overwritten by the final state)
+    double angvel[JOINT_NUM]; // joint angular velocities [rad/s] (initial state, overwritten by the final state)
+    double torque[JOINT_NUM]; // joint torques [Nm] (constant command, or the last output of the policy)
+    int limit_hits;           // number of steps where a joint reached the end of the movable range
+} DYNAMICS_ROLLOUT;
+
+/**
+ * @brief Policy function to give joint torques during a rollout (e.g. a controller to be tested)
+ * @param[in] *rollout present state of the rollout (rollout->torque holds the previous torques)
+ * @param[in] index index of the rollout
+ * @param[in] time elapsed time from the start of the rollout [s]
+ * @param[out] *torque joint torques [Nm] (JOINT_NUM elements)
+ * @param[in] *user_data pointer passed to runDynamicsRollouts
+ */
+typedef void (*DYNAMICS_POLICY)(const DYNAMICS_ROLLOUT *rollout, int index, double time, double *torque, void *user_data);
+
+//// Prototype declaration ////
+void initDynamics(void);
+int inverseDynamics7Dof(KINEMATICS_CACHE *, const double *, const double *, const double *, double *);
+int calcGravityTorque7Dof(KINEMATICS_CACHE *, const double *, double *);
+int calcMassMatrix7Dof(KINEMATICS_CACHE *, const double *, double[KINEMATICS_DOF][KINEMATICS_DOF]);
+int calcJointSpaceDynamics7Dof(KINEMATICS_CACHE *, const double *, const double *, JOINT_SPACE_DYNAMICS *);
+int forwardDynamics7Dof(KINEMATICS_CACHE *, const double *, const double *, const double *, double *);
+int stepDynamics7Dof(KINEMATICS_CACHE *, double *, double *, const double *, double);
+int runDynamicsRollouts(THREAD_POOL *, DYNAMICS_ROLLOUT *, int, double, double, DYNAMICS_POLICY, void *);
+
+#endif
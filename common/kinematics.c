@@ -0,0 +1,624 @@
+/**
+ * @file kinematics.c
+ * @brief Kinematics of 7 degrees of freedom CRANE-X7 arm
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <time.h>
+#include "kinematics.h"
+
+//// Definition of the serial chain ////
+// rotation axis of each joint in its own link frame (joint 2, 4 and 6 rotate the arm upward with positive angle)
+static const VECTOR_3D joint_axis[KINEMATICS_DOF] = {
+    {0, 0, 1},  //joint 1
+    {0, -1, 0}, //joint 2
+    {1, 0, 0},  //joint 3
+    {0, -1, 0}, //joint 4
+    {1, 0, 0},  //joint 5
+    {0, -1, 0}, //joint 6
+    {1, 0, 0},  //joint 7
+};
+static VECTOR_3D joint_offset[KINEMATICS_DOF]; // position of joint i+1 in link i frame
+static VECTOR_3D tool_offset;                  // position of the end effector in the last link frame
+static JOINT_RANGE joint_range[JOINT_NUM];     // movable range used by inverse kinematics
+static pthread_once_t chain_geometry_once = PTHREAD_ONCE_INIT; // the geometry is shared by all caches and threads
+
+/**
+ * @fn static void loadChainGeometry(void)
+ * @brief Build the joint offsets from the link length of getLinkParam7Dof (once, by initKinematicsCache)
+ */
+static void loadChainGeometry(void)
+{
+    LINK_PARAM link_parameter[LINK_NUM_7DOF];
+
+    getLinkParam7Dof(link_parameter);
+    joint_offset[0].x = joint_offset[0].y = joint_offset[0].z = 0;
+    for (int i = 1; i < KINEMATICS_DOF; i++)
+    {
+        // the 1st link stands along z axis, the others extend along x axis
+        joint_offset[i].x = (i == 1) ? 0 : link_parameter[i - 1].length;
+        joint_offset[i].y = 0;
+        joint_offset[i].z = (i == 1) ? link_parameter[i - 1].length : 0;
+    }
+    tool_offset.x = link_parameter[KINEMATICS_DOF - 1].length;
+    tool_offset.y = 0;
+    tool_offset.z = 0;
+    getJointRange(joint_range);
+}
+
+/**
+ * @fn static void setJointTransform(int, double, MATRIX_4D *)
+ * @brief Homogeneous transform from the parent link frame to the link frame of the joint
+ * @param[in] joint index of joint (0: joint 1)
+ * @param[in] theta joint angle [rad]
+ * @param[out] *transform Trans(offset) * Rot(axis, theta)
+ */
+static void setJointTransform(int joint, double theta, MATRIX_4D *transform)
+{
+    const VECTOR_3D *u = &joint_axis[joint];
+    double s = sin(theta);
+    double c = cos(theta);
+    double v = 1.0 - c;
+
+    // Rodrigues' rotation formula
+    transform->a[0][0] = c + u->x * u->x * v;
+    transform->a[0][1] = u->x * u->y * v - u->z * s;
+    transform->a[0][2] = u->x * u->z * v + u->y * s;
+    transform->a[1][0] = u->y * u->x * v + u->z * s;
+    transform->a[1][1] = c + u->y * u->y * v;
+    transform->a[1][2] = u->y * u->z * v - u->x * s;
+    transform->a[2][0] = u->z * u->x * v - u->y * s;
+    transform->a[2][1] = u->z * u->y * v + u->x * s;
+    transform->a[2][2] = c + u->z * u->z * v;
+    transform->a[0][3] = joint_offset[joint].x;
+    transform->a[1][3] = joint_offset[joint].y;
+    transform->a[2][3] = joint_offset[joint].z;
+    transform->a[3][0] = transform->a[3][1] = transform->a[3][2] = 0;
+    transform->a[3][3] = 1;
+}
+
+/**
+ * @fn static void mulTransform(const MATRIX_4D *, const MATRIX_4D *, MATRIX_4D *)
+ * @brief Multiply homogeneous transforms (the last row is assumed to be [0 0 0 1])
+ */
+static void mulTransform(const MATRIX_4D *A, const MATRIX_4D *B, MATRIX_4D *result)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result->a[i][j] = A->a[i][0] * B->a[0][j] + A->a[i][1] * B->a[1][j] + A->a[i][2] * B->a[2][j];
+        }
+        result->a[i][3] = A->a[i][0] * B->a[0][3] + A->a[i][1] * B->a[1][3] + A->a[i][2] * B->a[2][3] + A->a[i][3];
+    }
+    result->a[3][0] = result->a[3][1] = result->a[3][2] = 0;
+    result->a[3][3] = 1;
+}
+
+/**
+ * @fn void initKinematicsCache(KINEMATICS_CACHE *)
+ * @brief Load the link parameter (only by the first call) and invalidate all cached frames.
+ *        Can be called by any thread while the other threads use their own caches.
+ * @param[out] *cache link frames
+ */
+void initKinematicsCache(KINEMATICS_CACHE *cache)
+{
+    pthread_once(&chain_geometry_once, loadChainGeometry);
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        cache->theta[i] = 0;
+    }
+    cache->valid = 0;
+}
+
+/**
+ * @fn int forwardKinematics7Dof(KINEMATICS_CACHE *, const double *)
+ * @brief Calculate the frame of every link. Only the links after the first changed joint are recomputed.
+ * @param[in,out] *cache link frames
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements, the gripper angle is not used)
+ * @return index of the first recomputed link (KINEMATICS_DOF if nothing was recomputed)
+ */
+int forwardKinematics7Dof(KINEMATICS_CACHE *cache, const double *theta)
+{
+    MATRIX_4D local;
+    int first = cache->valid;
+
+    for (int i = 0; i < first; i++)
+    {
+        if (theta[i] != cache->theta[i])
+        {
+            first = i;
+            break;
+        }
+    }
+
+    for (int i = first; i < KINEMATICS_DOF; i++)
+    {
+        const MATRIX_4D *parent = (i == 0) ? NULL : &cache->frame[i - 1];
+
+        cache->theta[i] = theta[i];
+        setJointTransform(i, theta[i], &local);
+        if (parent == NULL)
+            cache->frame[i] = local;
+        else
+            mulTransform(parent, &local, &cache->frame[i]);
+        // the axis does not change with the rotation about itself
+        cache->axis[i].x = cache->frame[i].a[0][0] * joint_axis[i].x + cache->frame[i].a[0][1] * joint_axis[i].y + cache->frame[i].a[0][2] * joint_axis[i].z;
+        cache->axis[i].y = cache->frame[i].a[1][0] * joint_axis[i].x + cache->frame[i].a[1][1] * joint_axis[i].y + cache->frame[i].a[1][2] * joint_axis[i].z;
+        cache->axis[i].z = cache->frame[i].a[2][0] * joint_axis[i].x + cache->frame[i].a[2][1] * joint_axis[i].y + cache->frame[i].a[2][2] * joint_axis[i].z;
+    }
+
+    if (first < KINEMATICS_DOF)
+    {
+        MATRIX_4D *last = &cache->frame[KINEMATICS_DOF - 1];
+        MATRIX_4D *tool = &cache->frame[KINEMATICS_DOF];
+
+        *tool = *last;
+        for (int i = 0; i < 3; i++)
+        {
+            tool->a[i][3] = last->a[i][0] * tool_offset.x + last->a[i][1] * tool_offset.y + last->a[i][2] * tool_offset.z + last->a[i][3];
+        }
+    }
+    cache->valid = KINEMATICS_DOF;
+    return first;
+}
+
+/**
+ * @fn void getEndEffectorPose(const KINEMATICS_CACHE *, VECTOR_3D *, MATRIX_3D *)
+ * @brief Get position and orientation of the end effector from the cached frames
+ * @param[in] *cache link frames (forwardKinematics7Dof must be called before)
+ * @param[out] *position position [m] (NULL is allowed)
+ * @param[out] *rotation rotation matrix (NULL is allowed)
+ */
+void getEndEffectorPose(const KINEMATICS_CACHE *cache, VECTOR_3D *position, MATRIX_3D *rotation)
+{
+    const MATRIX_4D *tool = &cache->frame[KINEMATICS_DOF];
+
+    if (position != NULL)
+    {
+        position->x = tool->a[0][3];
+        position->y = tool->a[1][3];
+        position->z = tool->a[2][3];
+    }
+    if (rotation != NULL)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                rotation->a[i][j] = tool->a[i][j];
+            }
+        }
+    }
+}
+
+/**
+ * @fn void getJointPosition(const KINEMATICS_CACHE *, int, VECTOR_3D *)
+ * @brief Get position of the joint (KINEMATICS_DOF is the end effector) from the cached frames
+ * @param[in] *cache link frames (forwardKinematics7Dof must be called before)
+ * @param[in] joint index of joint (0: joint 1)
+ * @param[out] *position position [m]
+ */
+void getJointPosition(const KINEMATICS_CACHE *cache, int joint, VECTOR_3D *position)
+{
+    position->x = cache->frame[joint].a[0][3];
+    position->y = cache->frame[joint].a[1][3];
+    position->z = cache->frame[joint].a[2][3];
+}
+
+//// Jacobian ////
+
+/**
+ * @fn void calcJacobian7Dof(const KINEMATICS_CACHE *, double [][KINEMATICS_DOF])
+ * @brief Geometric Jacobian of the end effector in base frame, calculated from the cached link frames in one pass.
+ *        Column i is [z_i x (p_e - p_i); z_i] (z_i: axis of joint i+1, p_i: its position, p_e: end effector position)
+ * @param[in] *cache link frames (forwardKinematics7Dof must be called before)
+ * @param[out] J[][] Jacobian (rows: linear velocity x, y, z [m/s], angular velocity x, y, z [rad/s])
+ */
+void calcJacobian7Dof(const KINEMATICS_CACHE *cache, double J[KINEMATICS_TASK_DIM][KINEMATICS_DOF])
+{
+    const MATRIX_4D *tool = &cache->frame[KINEMATICS_DOF];
+
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        const VECTOR_3D *z = &cache->axis[i];
+        double rx = tool->a[0][3] - cache->frame[i].a[0][3];
+        double ry = tool->a[1][3] - cache->frame[i].a[1][3];
+        double rz = tool->a[2][3] - cache->frame[i].a[2][3];
+
+        J[0][i] = z->y * rz - z->z * ry;
+        J[1][i] = z->z * rx - z->x * rz;
+        J[2][i] = z->x * ry - z->y * rx;
+        J[3][i] = z->x;
+        J[4][i] = z->y;
+        J[5][i] = z->z;
+    }
+}
+
+/**
+ * @fn void calcJacobianFiniteDifference7Dof(const double *, double, double [][KINEMATICS_DOF])
+ * @brief Jacobian by central difference of forward kinematics (for verification, slow)
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[in] step difference of joint angle [rad]
+ * @param[out] J[][] Jacobian (same layout as calcJacobian7Dof)
+ */
+void calcJacobianFiniteDifference7Dof(const double *theta, double step, double J[KINEMATICS_TASK_DIM][KINEMATICS_DOF])
+{
+    KINEMATICS_CACHE plus, minus;
+    double q[JOINT_NUM];
+
+    initKinematicsCache(&plus);
+    initKinematicsCache(&minus);
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        q[i] = theta[i];
+    }
+    for (int k = 0; k < KINEMATICS_DOF; k++)
+    {
+        const MATRIX_4D *Tp = &plus.frame[KINEMATICS_DOF];
+        const MATRIX_4D *Tm = &minus.frame[KINEMATICS_DOF];
+        double dR[3][3];
+
+        q[k] = theta[k] + step;
+        forwardKinematics7Dof(&plus, q);
+        q[k] = theta[k] - step;
+        forwardKinematics7Dof(&minus, q);
+        q[k] = theta[k];
+
+        for (int i = 0; i < 3; i++)
+        {
+            J[i][k] = (Tp->a[i][3] - Tm->a[i][3]) / (2 * step);
+        }
+        // angular velocity from the skew symmetric part of dR/dq * R^T
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                dR[i][j] = ((Tp->a[i][0] - Tm->a[i][0]) * (Tp->a[j][0] + Tm->a[j][0]) + (Tp->a[i][1] - Tm->a[i][1]) * (Tp->a[j][1] + Tm->a[j][1]) + (Tp->a[i][2] - Tm->a[i][2]) * (Tp->a[j][2] + Tm->a[j][2])) / (4 * step);
+            }
+        }
+        J[3][k] = 0.5 * (dR[2][1] - dR[1][2]);
+        J[4][k] = 0.5 * (dR[0][2] - dR[2][0]);
+        J[5][k] = 0.5 * (dR[1][0] - dR[0][1]);
+    }
+}
+
+/**
+ * @fn double checkJacobian7Dof(const double *, double)
+ * @brief Compare calcJacobian7Dof with the finite difference
+ * @param[in] *theta joint angles [rad] (JOINT_NUM elements)
+ * @param[in] step difference of joint angle [rad]
+ * @return maximum absolute difference of the elements
+ */
+double checkJacobian7Dof(const double *theta, double step)
+{
+    KINEMATICS_CACHE cache;
+    double J[KINEMATICS_TASK_DIM][KINEMATICS_DOF], Jfd[KINEMATICS_TASK_DIM][KINEMATICS_DOF];
+    double error = 0;
+
+    initKinematicsCache(&cache);
+    forwardKinematics7Dof(&cache, theta);
+    calcJacobian7Dof(&cache, J);
+    calcJacobianFiniteDifference7Dof(theta, step, Jfd);
+    for (int i = 0; i < KINEMATICS_TASK_DIM; i++)
+    {
+        for (int k = 0; k < KINEMATICS_DOF; k++)
+        {
+            error = (fabs(J[i][k] - Jfd[i][k]) > error) ? fabs(J[i][k] - Jfd[i][k]) : error;
+        }
+    }
+    return error;
+}
+
+//// Numerical inverse kinematics ////
+
+#define IK_MIN_DAMPING (1e-6)
+#define IK_MAX_DAMPING (1e+2)
+
+/**
+ * @fn static double getMonotonicTime(void)
+ * @brief Get present time of CLOCK_MONOTONIC [s]
+ */
+static double getMonotonicTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @fn static double calcPoseError(const KINEMATICS_CACHE *, const VECTOR_3D *, const MATRIX_3D *, double *)
+ * @brief Error between the target and the present end effector pose
+ * @param[out] error[] position error [m] and orientation error as rotation vector [rad] (in base frame)
+ * @return orientation error angle [rad] (0 - pi, 0 without target_rotation)
+ */
+static double calcPoseError(const KINEMATICS_CACHE *cache, const VECTOR_3D *target_position, const MATRIX_3D *target_rotation, double *error)
+{
+    const MATRIX_4D *tool = &cache->frame[KINEMATICS_DOF];
+    double Re[3][3];
+    double cos_angle, angle, scale;
+
+    error[0] = target_position->x - tool->a[0][3];
+    error[1] = target_position->y - tool->a[1][3];
+    error[2] = target_position->z - tool->a[2][3];
+    if (target_rotation == NULL)
+    {
+        error[3] = error[4] = error[5] = 0;
+        return 0;
+    }
+
+    // Re = Rtarget * R^T, the rotation vector is the logarithm of Re
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            Re[i][j] = target_rotation->a[i][0] * tool->a[j][0] + target_rotation->a[i][1] * tool->a[j][1] + target_rotation->a[i][2] * tool->a[j][2];
+        }
+    }
+    cos_angle = (Re[0][0] + Re[1][1] + Re[2][2] - 1.0) * 0.5;
+    cos_angle = (cos_angle > 1.0) ? 1.0 : ((cos_angle < -1.0) ? -1.0 : cos_angle);
+    angle = acos(cos_angle);
+    if (M_PI - angle < 1e-3)
+    {
+        // sin(angle) vanishes near pi: the axis is taken from the symmetric part, a a^T = ((Re + Re^T) / 2 - cos I) / (1 - cos)
+        double B[3][3], norm;
+        int k = 0;
+
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                B[i][j] = ((Re[i][j] + Re[j][i]) * 0.5 - ((i == j) ? cos_angle : 0)) / (1.0 - cos_angle);
+            }
+            k = (B[i][i] > B[k][k]) ? i : k;
+        }
+        norm = sqrt(B[k][k]);
+        error[3] = B[0][k] / norm;
+        error[4] = B[1][k] / norm;
+        error[5] = B[2][k] / norm;
+        // keep the sign of the skew symmetric part so that the error is continuous below the threshold
+        if (error[3] * (Re[2][1] - Re[1][2]) + error[4] * (Re[0][2] - Re[2][0]) + error[5] * (Re[1][0] - Re[0][1]) < 0)
+            scale = -angle;
+        else
+            scale = angle;
+        error[3] *= scale;
+        error[4] *= scale;
+        error[5] *= scale;
+        return angle;
+    }
+    scale = (angle < 1e-6) ? 0.5 : angle / (2.0 * sin(angle));
+    error[3] = scale * (Re[2][1] - Re[1][2]);
+    error[4] = scale * (Re[0][2] - Re[2][0]);
+    error[5] = scale * (Re[1][0] - Re[0][1]);
+    return angle;
+}
+
+/**
+ * @fn static int solveSymmetric(double [][KINEMATICS_TASK_DIM], double *, int)
+ * @brief Solve A x = b by Cholesky decomposition (A is symmetric positive definite and is overwritten)
+ * @param[in,out] b[] right hand side, overwritten by the solution
+ * @return 0: success, 1: A is not positive definite
+ */
+static int solveSymmetric(double A[KINEMATICS_TASK_DIM][KINEMATICS_TASK_DIM], double *b, int n)
+{
+    for (int j = 0; j < n; j++)
+    {
+        double d = A[j][j];
+        for (int k = 0; k < j; k++)
+        {
+            d -= A[j][k] * A[j][k];
+        }
+        if (d <= 0)
+            return 1;
+        A[j][j] = sqrt(d);
+        for (int i = j + 1; i < n; i++)
+        {
+            double v = A[i][j];
+            for (int k = 0; k < j; k++)
+            {
+                v -= A[i][k] * A[j][k];
+            }
+            A[i][j] = v / A[j][j];
+        }
+    }
+    for (int i = 0; i < n; i++)
+    {
+        for (int k = 0; k < i; k++)
+        {
+            b[i] -= A[i][k] * b[k];
+        }
+        b[i] /= A[i][i];
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+        for (int k = i + 1; k < n; k++)
+        {
+            b[i] -= A[k][i] * b[k];
+        }
+        b[i] /= A[i][i];
+    }
+    return 0;
+}
+
+/**
+ * @fn static double weightedNorm2(const double *, int, double)
+ * @brief Squared norm of the pose error with the orientation weight
+ */
+static double weightedNorm2(const double *error, int rows, double weight)
+{
+    double norm = error[0] * error[0] + error[1] * error[1] + error[2] * error[2];
+    if (rows == KINEMATICS_TASK_DIM)
+        norm += weight * weight * (error[3] * error[3] + error[4] * error[4] + error[5] * error[5]);
+    return norm;
+}
+
+/**
+ * @fn void getDefaultIkConfig(IK_CONFIG *)
+ * @brief Fill the setting with default values (fits in a 1 ms control cycle)
+ * @param[out] *config setting of inverse kinematics
+ */
+void getDefaultIkConfig(IK_CONFIG *config)
+{
+    config->max_iterations = 100;
+    config->time_budget = 0.5e-3;
+    config->damping = 1e-3;
+    config->position_tolerance = 1e-5;
+    config->orientation_tolerance = 1e-4;
+    config->orientation_weight = 0.1;
+    config->max_step = 0.2;
+}
+
+/**
+ * @fn int inverseKinematics7Dof(KINEMATICS_CACHE *, const VECTOR_3D *, const MATRIX_3D *, const double *, double *, const IK_CONFIG *, IK_RESULT *)
+ * @brief Solve joint angles for the end effector pose by damped least squares (Levenberg-Marquardt).
+ *        Joint angles are kept in the range of getJointRange. The iteration stops when it converges,
+ *        or reaches the iteration or time budget; the best joint angles found are returned in any case.
+ * @param[in,out] *cache link frames (initKinematicsCache must be called before, holds the frames of the returned joint angles)
+ * @param[in] *target_position target position of the end effector [m]
+ * @param[in] *target_rotation target orientation of the end effector (NULL: position only)
+ * @param[in] *initial_theta initial joint angles [rad] (e.g. the previous solution for warm start)
+ * @param[out] *theta joint angles [rad] (JOINT_NUM elements, the gripper angle is copied from initial_theta)
+ * @param[in] *config setting of inverse kinematics (NULL: default setting)
+ * @param[out] *result iterations and remaining error (NULL is allowed)
+ * @return 0: converged, 1: not converged
+ */
+int inverseKinematics7Dof(KINEMATICS_CACHE *cache, const VECTOR_3D *target_position, const MATRIX_3D *target_rotation, const double *initial_theta, double *theta, const IK_CONFIG *config, IK_RESULT *result)
+{
+    IK_CONFIG default_config;
+    double J[KINEMATICS_TASK_DIM][KINEMATICS_DOF];
+    double A[KINEMATICS_TASK_DIM][KINEMATICS_TASK_DIM];
+    double error[KINEMATICS_TASK_DIM], y[KINEMATICS_TASK_DIM];
+    double trial[JOINT_NUM];
+    double start = getMonotonicTime();
+    int rows = (target_rotation == NULL) ? 3 : KINEMATICS_TASK_DIM;
+    double lambda, norm2, position_error, orientation_error;
+    int iteration, converged = 0;
+
+    if (config == NULL)
+    {
+        getDefaultIkConfig(&default_config);
+        config = &default_config;
+    }
+    lambda = config->damping;
+
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        theta[i] = initial_theta[i];
+    }
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        theta[i] = (theta[i] < joint_range[i].min) ? joint_range[i].min : ((theta[i] > joint_range[i].max) ? joint_range[i].max : theta[i]);
+    }
+    forwardKinematics7Dof(cache, theta);
+    orientation_error = calcPoseError(cache, target_position, target_rotation, error);
+    norm2 = weightedNorm2(error, rows, config->orientation_weight);
+
+    for (iteration = 0; iteration < config->max_iterations; iteration++)
+    {
+        double dq[KINEMATICS_DOF];
+        double step_max = 0, trial_norm2, trial_orientation_error;
+
+        position_error = sqrt(error[0] * error[0] + error[1] * error[1] + error[2] * error[2]);
+        if ((position_error <= config->position_tolerance) && (orientation_error <= config->orientation_tolerance))
+        {
+            converged = 1;
+            break;
+        }
+        if ((config->time_budget > 0) && (getMonotonicTime() - start > config->time_budget))
+            break;
+
+        // dq = W J^T (J W J^T + lambda^2 I)^-1 e, orientation rows are weighted by orientation_weight
+        calcJacobian7Dof(cache, J);
+        for (int i = 0; i < rows; i++)
+        {
+            for (int j = 0; j <= i; j++)
+            {
+                double v = 0;
+                for (int k = 0; k < KINEMATICS_DOF; k++)
+                {
+                    v += J[i][k] * J[j][k];
+                }
+                v *= ((i >= 3) ? config->orientation_weight : 1.0) * ((j >= 3) ? config->orientation_weight : 1.0);
+                A[i][j] = A[j][i] = v;
+            }
+            A[i][i] += lambda * lambda;
+            y[i] = error[i] * ((i >= 3) ? config->orientation_weight : 1.0);
+        }
+        if (solveSymmetric(A, y, rows))
+        {
+            lambda = (lambda * 10 < IK_MAX_DAMPING) ? lambda * 10 : IK_MAX_DAMPING;
+            continue;
+        }
+        for (int k = 0; k < KINEMATICS_DOF; k++)
+        {
+            dq[k] = 0;
+            for (int i = 0; i < rows; i++)
+            {
+                dq[k] += J[i][k] * y[i] * ((i >= 3) ? config->orientation_weight : 1.0);
+            }
+            step_max = (fabs(dq[k]) > step_max) ? fabs(dq[k]) : step_max;
+        }
+
+        // limit the step and keep the joint angles in the movable range
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            trial[i] = theta[i];
+        }
+        for (int k = 0; k < KINEMATICS_DOF; k++)
+        {
+            double q = theta[k] + ((step_max > config->max_step) ? dq[k] * config->max_step / step_max : dq[k]);
+            trial[k] = (q < joint_range[k].min) ? joint_range[k].min : ((q > joint_range[k].max) ? joint_range[k].max : q);
+        }
+
+        // accept the step only if the error decreases (Levenberg-Marquardt damping update)
+        forwardKinematics7Dof(cache, trial);
+        trial_orientation_error = calcPoseError(cache, target_position, target_rotation, y);
+        trial_norm2 = weightedNorm2(y, rows, config->orientation_weight);
+        if (trial_norm2 < norm2)
+        {
+            for (int i = 0; i < KINEMATICS_DOF; i++)
+            {
+                theta[i] = trial[i];
+            }
+            for (int i = 0; i < KINEMATICS_TASK_DIM; i++)
+            {
+                error[i] = y[i];
+            }
+            norm2 = trial_norm2;
+            orientation_error = trial_orientation_error;
+            lambda = (lambda * 0.5 > IK_MIN_DAMPING) ? lambda * 0.5 : IK_MIN_DAMPING;
+        }
+        else
+        {
+            forwardKinematics7Dof(cache, theta);
+            lambda = (lambda * 4 < IK_MAX_DAMPING) ? lambda * 4 : IK_MAX_DAMPING;
+        }
+    }
+
+    if (result != NULL)
+    {
+        result->iterations = iteration;
+        result->position_error = sqrt(error[0] * error[0] + error[1] * error[1] + error[2] * error[2]);
+        result->orientation_error = orientation_error;
+        result->time = getMonotonicTime() - start;
+    }
+    return converged ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file kinematics.h
+ * @brief Kinematics of 7 degrees of freedom CRANE-X7 arm
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KINEMATICS_H_
+#define KINEMATICS_H_
+
+#include "matrix.h"
+#include "arm_parameter.h"
+
+#define KINEMATICS_DOF (LINK_NUM_7DOF) // joint 1 - joint 7 (the gripper is not included)
+#define KINEMATICS_TASK_DIM (6)         // linear velocity x, y, z and angular velocity x, y, z
+
+//// Structure definition ////
+/**
+ * @struct KINEMATICS_CACHE
+ * @brief Link frames of the last forward kinematics.
+ *        Base frame: origin at joint 1, z axis upward, x axis is the arm direction when all joint angles are 0.
+ */
+typedef struct
+{
+    double theta[KINEMATICS_DOF];        // joint angles of the cached frames [rad]
+    MATRIX_4D frame[KINEMATICS_DOF + 1]; // homogeneous transform of link i (origin at joint i+1) in base frame, frame[KINEMATICS_DOF] is the end effector
+    VECTOR_3D axis[KINEMATICS_DOF];      // rotation axis of joint i+1 in base frame
+    int valid;                           // number of links whose frame is up to date (from the base)
+} KINEMATICS_CACHE;
+
+/**
+ * @struct IK_CONFIG
+ * @brief Setting of the numerical inverse kinematics (damped least squares)
+ */
+typedef struct
+{
+    int max_iterations;           // upper limit of iterations
+    double time_budget;           // upper limit of calculation time [s] (0: no limit)
+    double damping;               // initial damping factor (adapted while iterating)
+    double position_tolerance;    // convergence threshold of position error [m]
+    double orientation_tolerance; // convergence threshold of orientation error [rad]
+    double orientation_weight;    // weight of orientation error against position error [m/rad]
+    double max_step;              // upper limit of joint angle change per iteration [rad]
+} IK_CONFIG;
+
+/**
+ * @struct IK_RESULT
+ * @brief Result of the numerical inverse kinematics
+ */
+typedef struct
+{
+    int iterations;           // number of iterations
+    double position_error;    // remaining position error [m]
+    double orientation_error; // remaining orientation error [rad]
+    double time;              // calculation time [s]
+} IK_RESULT;
+
+//// Prototype declaration ////
+void initKinematicsCache(KINEMATICS_CACHE *);
+int forwardKinematics7Dof(KINEMATICS_CACHE *, const double *);
+void getEndEffectorPose(const KINEMATICS_CACHE *, VECTOR_3D *, MATRIX_3D *);
+void getJointPosition(const KINEMATICS_CACHE *, int, VECTOR_3D *);
+void calcJacobian7Dof(const KINEMATICS_CACHE *, double[KINEMATICS_TASK_DIM][KINEMATICS_DOF]);
+void calcJacobianFiniteDifference7Dof(const double *, double, double[KINEMATICS_TASK_DIM][KINEMATICS_DOF]);
+double checkJacobian7Dof(const double *, double);
+void getDefaultIkConfig(IK_CONFIG *);
+int inverseKinematics7Dof(KINEMATICS_CACHE *, const VECTOR_3D *, const MATRIX_3D *, const double *, double *, const IK_CONFIG *, IK_RESULT *);
+
+#endif
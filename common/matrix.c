@@ -21,33 +21,348 @@
 
 #include "matrix.h"
 
+//// Pointer API ////
+// Inputs are passed by const pointer and the result is written through a pointer, so no structure is copied.
+// Element-wise functions accept the same pointer for an input and the result (in place).
+// The result of the other functions is restrict-qualified: use the *InPlace functions to overwrite an input.
+
 /**
- * @fn MATRIX_3D mulMatMat3D(MATRIX_3D*, MATRIX_3D*)
+ * @fn void mulMatMat3DPtr(const MATRIX_3D *, const MATRIX_3D *, MATRIX_3D *)
  * @brief multiple 3x3 matrix and 3x3 matrix
- * @param[in] MATRIX_3D 3x3 matrix
- * @param[in] MATRIX_3D 3x3 matrix
- * @return result of multiplication
+ * @param[in] *MatA 3x3 matrix
+ * @param[in] *MatB 3x3 matrix
+ * @param[out] *result MatA * MatB (must not be MatA or MatB)
  */
-MATRIX_3D mulMatMat3D(MATRIX_3D MatA, MATRIX_3D MatB)
+void mulMatMat3DPtr(const MATRIX_3D *MatA, const MATRIX_3D *MatB, MATRIX_3D *restrict result)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result->a[i][j] = MatA->a[i][0] * MatB->a[0][j] + MatA->a[i][1] * MatB->a[1][j] + MatA->a[i][2] * MatB->a[2][j];
+        }
+    }
+}
+
+/**
+ * @fn void mulMatMat3DInPlace(MATRIX_3D *, const MATRIX_3D *)
+ * @brief multiple 3x3 matrix and 3x3 matrix in place (MatA = MatA * MatB, e.g. chained rotations)
+ * @param[in,out] *MatA 3x3 matrix
+ * @param[in] *MatB 3x3 matrix (can be MatA)
+ */
+void mulMatMat3DInPlace(MATRIX_3D *MatA, const MATRIX_3D *MatB)
 {
     MATRIX_3D result;
 
+    mulMatMat3DPtr(MatA, MatB, &result);
+    *MatA = result;
+}
+
+/**
+ * @fn void mulMatVec3DPtr(const MATRIX_3D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief multiple 3x3 matrix and 3 dimentional vector
+ * @param[in] *MatA 3x3 matrix
+ * @param[in] *VecA 3 dimentional vector
+ * @param[out] *result MatA * VecA (must not be VecA)
+ */
+void mulMatVec3DPtr(const MATRIX_3D *MatA, const VECTOR_3D *VecA, VECTOR_3D *restrict result)
+{
+    result->x = MatA->a[0][0] * VecA->x + MatA->a[0][1] * VecA->y + MatA->a[0][2] * VecA->z;
+    result->y = MatA->a[1][0] * VecA->x + MatA->a[1][1] * VecA->y + MatA->a[1][2] * VecA->z;
+    result->z = MatA->a[2][0] * VecA->x + MatA->a[2][1] * VecA->y + MatA->a[2][2] * VecA->z;
+}
+
+/**
+ * @fn void mulMatVec3DInPlace(const MATRIX_3D *, VECTOR_3D *)
+ * @brief multiple 3x3 matrix and 3 dimentional vector in place (VecA = MatA * VecA)
+ * @param[in] *MatA 3x3 matrix
+ * @param[in,out] *VecA 3 dimentional vector
+ */
+void mulMatVec3DInPlace(const MATRIX_3D *MatA, VECTOR_3D *VecA)
+{
+    VECTOR_3D result;
+
+    mulMatVec3DPtr(MatA, VecA, &result);
+    *VecA = result;
+}
+
+/**
+ * @fn void mulTransMatVec3DPtr(const MATRIX_3D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief multiple transposed 3x3 matrix and 3 dimentional vector without transposing the matrix
+ * @param[in] *MatA 3x3 matrix (e.g. rotation matrix)
+ * @param[in] *VecA 3 dimentional vector
+ * @param[out] *result transpose(MatA) * VecA (must not be VecA)
+ */
+void mulTransMatVec3DPtr(const MATRIX_3D *MatA, const VECTOR_3D *VecA, VECTOR_3D *restrict result)
+{
+    result->x = MatA->a[0][0] * VecA->x + MatA->a[1][0] * VecA->y + MatA->a[2][0] * VecA->z;
+    result->y = MatA->a[0][1] * VecA->x + MatA->a[1][1] * VecA->y + MatA->a[2][1] * VecA->z;
+    result->z = MatA->a[0][2] * VecA->x + MatA->a[1][2] * VecA->y + MatA->a[2][2] * VecA->z;
+}
+
+/**
+ * @fn void mulAddMatVec3DPtr(const MATRIX_3D *, const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief multiply-add of 3x3 matrix and 3 dimentional vectors (e.g. rotation and translation of a point)
+ * @param[in] *MatA 3x3 matrix
+ * @param[in] *VecA 3 dimentional vector
+ * @param[in] *VecB 3 dimentional vector
+ * @param[out] *result MatA * VecA + VecB (must not be VecA or VecB)
+ */
+void mulAddMatVec3DPtr(const MATRIX_3D *MatA, const VECTOR_3D *VecA, const VECTOR_3D *VecB, VECTOR_3D *restrict result)
+{
+    result->x = MatA->a[0][0] * VecA->x + MatA->a[0][1] * VecA->y + MatA->a[0][2] * VecA->z + VecB->x;
+    result->y = MatA->a[1][0] * VecA->x + MatA->a[1][1] * VecA->y + MatA->a[1][2] * VecA->z + VecB->y;
+    result->z = MatA->a[2][0] * VecA->x + MatA->a[2][1] * VecA->y + MatA->a[2][2] * VecA->z + VecB->z;
+}
+
+/**
+ * @fn void mulScoMat3DPtr(double, const MATRIX_3D *, MATRIX_3D *)
+ * @brief multiple scolar value and 3x3 matrix
+ * @param[in] c scolar value
+ * @param[in] *MatA 3x3 matrix
+ * @param[out] *result c * MatA (can be MatA)
+ */
+void mulScoMat3DPtr(double c, const MATRIX_3D *MatA, MATRIX_3D *result)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result->a[i][j] = c * MatA->a[i][j];
+        }
+    }
+}
+
+/**
+ * @fn void mulScoVec3DPtr(double, const VECTOR_3D *, VECTOR_3D *)
+ * @brief multiple scolar value and 3 dimentional vector
+ * @param[in] c scolar value
+ * @param[in] *VecA 3 dimentional vector
+ * @param[out] *result c * VecA (can be VecA)
+ */
+void mulScoVec3DPtr(double c, const VECTOR_3D *VecA, VECTOR_3D *result)
+{
+    result->x = c * VecA->x;
+    result->y = c * VecA->y;
+    result->z = c * VecA->z;
+}
+
+/**
+ * @fn void mulAddScoVec3DPtr(double, const VECTOR_3D *, VECTOR_3D *)
+ * @brief multiply-add of scolar value and 3 dimentional vector (accumulation)
+ * @param[in] c scolar value
+ * @param[in] *VecA 3 dimentional vector
+ * @param[in,out] *result result + c * VecA
+ */
+void mulAddScoVec3DPtr(double c, const VECTOR_3D *VecA, VECTOR_3D *result)
+{
+    result->x += c * VecA->x;
+    result->y += c * VecA->y;
+    result->z += c * VecA->z;
+}
+
+/**
+ * @fn void crsVecVec3DPtr(const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief cross product of 3 dimentional vector and 3 dimentional vector
+ * @param[in] *VecA 3 dimentional vector
+ * @param[in] *VecB 3 dimentional vector
+ * @param[out] *result VecA x VecB (must not be VecA or VecB)
+ */
+void crsVecVec3DPtr(const VECTOR_3D *VecA, const VECTOR_3D *VecB, VECTOR_3D *restrict result)
+{
+    result->x = VecA->y * VecB->z - VecA->z * VecB->y;
+    result->y = VecA->z * VecB->x - VecA->x * VecB->z;
+    result->z = VecA->x * VecB->y - VecA->y * VecB->x;
+}
+
+/**
+ * @fn void sumMatMat3DPtr(const MATRIX_3D *, const MATRIX_3D *, MATRIX_3D *)
+ * @brief summation of 3x3 matrix and 3x3 matrix
+ * @param[in] *MatA 3x3 matrix
+ * @param[in] *MatB 3x3 matrix
+ * @param[out] *result MatA + MatB (can be MatA or MatB)
+ */
+void sumMatMat3DPtr(const MATRIX_3D *MatA, const MATRIX_3D *MatB, MATRIX_3D *result)
+{
     for (int i = 0; i < 3; i++)
     {
         for (int j = 0; j < 3; j++)
         {
-            result.a[i][j] = 0;
-            for (int k = 0; k < 3; k++)
-            {
-                result.a[i][j] += MatA.a[i][k] * MatB.a[k][j];
-            }
+            result->a[i][j] = MatA->a[i][j] + MatB->a[i][j];
         }
     }
+}
+
+/**
+ * @fn void sumVecVec3DPtr(const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief summation of 3 dimentional vector and 3 dimentional vector
+ * @param[in] *VecA 3 dimentional vector
+ * @param[in] *VecB 3 dimentional vector
+ * @param[out] *result VecA + VecB (can be VecA or VecB)
+ */
+void sumVecVec3DPtr(const VECTOR_3D *VecA, const VECTOR_3D *VecB, VECTOR_3D *result)
+{
+    result->x = VecA->x + VecB->x;
+    result->y = VecA->y + VecB->y;
+    result->z = VecA->z + VecB->z;
+}
+
+/**
+ * @fn void subVecVec3DPtr(const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief subtraction of 3 dimentional vector and 3 dimentional vector
+ * @param[in] *VecA 3 dimentional vector
+ * @param[in] *VecB 3 dimentional vector
+ * @param[out] *result VecA - VecB (can be VecA or VecB)
+ */
+void subVecVec3DPtr(const VECTOR_3D *VecA, const VECTOR_3D *VecB, VECTOR_3D *result)
+{
+    result->x = VecA->x - VecB->x;
+    result->y = VecA->y - VecB->y;
+    result->z = VecA->z - VecB->z;
+}
+
+/**
+ * @fn void transeposeMat3DPtr(const MATRIX_3D *, MATRIX_3D *)
+ * @brief transpose 3x3 matrix
+ * @param[in] *MatA 3x3 matrix
+ * @param[out] *result transpose of MatA (must not be MatA)
+ */
+void transeposeMat3DPtr(const MATRIX_3D *MatA, MATRIX_3D *restrict result)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result->a[i][j] = MatA->a[j][i];
+        }
+    }
+}
+
+/**
+ * @fn void transeposeMat3DInPlace(MATRIX_3D *)
+ * @brief transpose 3x3 matrix in place
+ * @param[in,out] *MatA 3x3 matrix
+ */
+void transeposeMat3DInPlace(MATRIX_3D *MatA)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = i + 1; j < 3; j++)
+        {
+            double tmp = MatA->a[i][j];
+            MatA->a[i][j] = MatA->a[j][i];
+            MatA->a[j][i] = tmp;
+        }
+    }
+}
+
+/**
+ * @fn int inverseMat3DPtr(const MATRIX_3D *, MATRIX_3D *)
+ * @brief inverse of 3x3 matrix
+ * @param[in] *MatA 3x3 matrix
+ * @param[out] *InvA inversed matrix (must not be MatA, not changed if MatA is singular)
+ * @return Success or failure
+ */
+int inverseMat3DPtr(const MATRIX_3D *MatA, MATRIX_3D *restrict InvA)
+{
+    const double(*a)[3] = MatA->a;
+    double detMatA = a[0][0] * a[1][1] * a[2][2] + a[0][1] * a[1][2] * a[2][0] + a[0][2] * a[1][0] * a[2][1] - a[0][2] * a[1][1] * a[2][0] - a[0][1] * a[1][0] * a[2][2] - a[0][0] * a[1][2] * a[2][1];
+    if (detMatA == 0)
+        return 0;
+
+    InvA->a[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) / detMatA;
+    InvA->a[0][1] = -(a[0][1] * a[2][2] - a[0][2] * a[2][1]) / detMatA;
+    InvA->a[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) / detMatA;
+    InvA->a[1][0] = -(a[1][0] * a[2][2] - a[1][2] * a[2][0]) / detMatA;
+    InvA->a[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) / detMatA;
+    InvA->a[1][2] = -(a[0][0] * a[1][2] - a[0][2] * a[1][0]) / detMatA;
+    InvA->a[2][0] = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) / detMatA;
+    InvA->a[2][1] = -(a[0][0] * a[2][1] - a[0][1] * a[2][0]) / detMatA;
+    InvA->a[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) / detMatA;
+
+    return 1;
+}
+
+/**
+ * @fn void mulMatMat4DPtr(const MATRIX_4D *, const MATRIX_4D *, MATRIX_4D *)
+ * @brief multiple 4x4 matrix and 4x4 matrix
+ * @param[in] *MatA 4x4 matrix
+ * @param[in] *MatB 4x4 matrix
+ * @param[out] *result MatA * MatB (must not be MatA or MatB)
+ */
+void mulMatMat4DPtr(const MATRIX_4D *MatA, const MATRIX_4D *MatB, MATRIX_4D *restrict result)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            result->a[i][j] = MatA->a[i][0] * MatB->a[0][j] + MatA->a[i][1] * MatB->a[1][j] + MatA->a[i][2] * MatB->a[2][j] + MatA->a[i][3] * MatB->a[3][j];
+        }
+    }
+}
+
+/**
+ * @fn void mulMatMat4DInPlace(MATRIX_4D *, const MATRIX_4D *)
+ * @brief multiple 4x4 matrix and 4x4 matrix in place (MatA = MatA * MatB, e.g. chained homogeneous transforms)
+ * @param[in,out] *MatA 4x4 matrix
+ * @param[in] *MatB 4x4 matrix (can be MatA)
+ */
+void mulMatMat4DInPlace(MATRIX_4D *MatA, const MATRIX_4D *MatB)
+{
+    MATRIX_4D result;
+
+    mulMatMat4DPtr(MatA, MatB, &result);
+    *MatA = result;
+}
+
+/**
+ * @fn void mulMatVec4DPtr(const MATRIX_4D *, const VECTOR_4D *, VECTOR_4D *)
+ * @brief multiple 4x4 matrix and 4 dimentional vector
+ * @param[in] *MatA 4x4 matrix
+ * @param[in] *VecA 4 dimentional vector
+ * @param[out] *result MatA * VecA (must not be VecA)
+ */
+void mulMatVec4DPtr(const MATRIX_4D *MatA, const VECTOR_4D *VecA, VECTOR_4D *restrict result)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        result->x[i] = MatA->a[i][0] * VecA->x[0] + MatA->a[i][1] * VecA->x[1] + MatA->a[i][2] * VecA->x[2] + MatA->a[i][3] * VecA->x[3];
+    }
+}
+
+/**
+ * @fn void transformPoint4DPtr(const MATRIX_4D *, const VECTOR_3D *, VECTOR_3D *)
+ * @brief transform a point by a homogeneous transformation matrix (the bottom row is assumed to be 0 0 0 1)
+ * @param[in] *MatA 4x4 homogeneous transformation matrix
+ * @param[in] *VecA point
+ * @param[out] *result rotation * VecA + translation (must not be VecA)
+ */
+void transformPoint4DPtr(const MATRIX_4D *MatA, const VECTOR_3D *VecA, VECTOR_3D *restrict result)
+{
+    result->x = MatA->a[0][0] * VecA->x + MatA->a[0][1] * VecA->y + MatA->a[0][2] * VecA->z + MatA->a[0][3];
+    result->y = MatA->a[1][0] * VecA->x + MatA->a[1][1] * VecA->y + MatA->a[1][2] * VecA->z + MatA->a[1][3];
+    result->z = MatA->a[2][0] * VecA->x + MatA->a[2][1] * VecA->y + MatA->a[2][2] * VecA->z + MatA->a[2][3];
+}
+
+//// By-value API (thin wrappers of the pointer API) ////
+
+/**
+ * @fn MATRIX_3D mulMatMat3D(MATRIX_3D, MATRIX_3D)
+ * @brief multiple 3x3 matrix and 3x3 matrix
+ * @param[in] MATRIX_3D 3x3 matrix
+ * @param[in] MATRIX_3D 3x3 matrix
+ * @return result of multiplication
+ */
+MATRIX_3D mulMatMat3D(MATRIX_3D MatA, MATRIX_3D MatB)
+{
+    MATRIX_3D result;
+
+    mulMatMat3DPtr(&MatA, &MatB, &result);
     return result;
 };
 
 /**
- * @fn VECTOR_3D mulMatVec3D(MATRIX_3D*, VECTOR_3D*)
+ * @fn VECTOR_3D mulMatVec3D(MATRIX_3D, VECTOR_3D)
  * @brief multiple 3x3 matrix and 3 dimentional vector
  * @param[in] MATRIX_3D 3x3 matrix
  * @param[in] VECTOR_3D 3 dimentional vector
@@ -57,15 +372,12 @@ VECTOR_3D mulMatVec3D(MATRIX_3D MatA, VECTOR_3D VecA)
 {
     VECTOR_3D result;
 
-    result.x = MatA.a[0][0] * VecA.x + MatA.a[0][1] * VecA.y + MatA.a[0][2] * VecA.z;
-    result.y = MatA.a[1][0] * VecA.x + MatA.a[1][1] * VecA.y + MatA.a[1][2] * VecA.z;
-    result.z = MatA.a[2][0] * VecA.x + MatA.a[2][1] * VecA.y + MatA.a[2][2] * VecA.z;
-
+    mulMatVec3DPtr(&MatA, &VecA, &result);
     return result;
 };
 
 /**
- * @fn MATRIX_3D mulScoMat3D(double, MATRIX_3D*)
+ * @fn MATRIX_3D mulScoMat3D(double, MATRIX_3D)
  * @brief multiple scolar value and 3x3 matrix
  * @param[in] double scolar value
  * @param[in] MATRIX_3D 3x3 matrix
@@ -75,19 +387,12 @@ MATRIX_3D mulScoMat3D(double c, MATRIX_3D MatA)
 {
     MATRIX_3D result;
 
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            result.a[i][j] = c * MatA.a[i][j];
-        }
-    }
-
+    mulScoMat3DPtr(c, &MatA, &result);
     return result;
 };
 
 /**
- * @fn VECTOR_3D mulScoVec3D(double, VECTOR_3D *)
+ * @fn VECTOR_3D mulScoVec3D(double, VECTOR_3D)
  * @brief multiple scolar value and 3 dimentional vector
  * @param[in] double scolar value
  * @param[in] VECTOR_3D 3 dimentional vector
@@ -97,15 +402,12 @@ VECTOR_3D mulScoVec3D(double c, VECTOR_3D VecA)
 {
     VECTOR_3D result;
 
-    result.x = c * VecA.x;
-    result.y = c * VecA.y;
-    result.z = c * VecA.z;
-
+    mulScoVec3DPtr(c, &VecA, &result);
     return result;
 };
 
 /**
- * @fn VECTOR_3D crsVecVec3D(VECTOR_3D *, VECTOR_3D *)
+ * @fn VECTOR_3D crsVecVec3D(VECTOR_3D, VECTOR_3D)
  * @brief cross product of 3 dimentional vector and 3 dimentional vector
  * @param[in] VECTOR_3D 3 dimentional vector
  * @param[in] VECTOR_3D 3 dimentional vector
@@ -115,15 +417,12 @@ VECTOR_3D crsVecVec3D(VECTOR_3D VecA, VECTOR_3D VecB)
 {
     VECTOR_3D result;
 
-    result.x = VecA.y * VecB.z - VecA.z * VecB.y;
-    result.y = VecA.z * VecB.x - VecA.x * VecB.z;
-    result.z = VecA.x * VecB.y - VecA.y * VecB.x;
-
+    crsVecVec3DPtr(&VecA, &VecB, &result);
     return result;
 };
 
 /**
- * @fn MATRIX_3D sumMatMat3D(MATRIX_3D *, MATRIX_3D *)
+ * @fn MATRIX_3D sumMatMat3D(MATRIX_3D, MATRIX_3D)
  * @brief summation of 3x3 matrix and 3x3 matrix
  * @param[in] MATRIX_3D 3x3 matrix
  * @param[in] MATRIX_3D 3x3 matrix
@@ -133,19 +432,12 @@ MATRIX_3D sumMatMat3D(MATRIX_3D MatA, MATRIX_3D MatB)
 {
     MATRIX_3D result;
 
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            result.a[i][j] = MatA.a[i][j] + MatB.a[i][j];
-        }
-    }
-
+    sumMatMat3DPtr(&MatA, &MatB, &result);
     return result;
 };
 
 /**
- * @fn VECTOR_3D sumVecVec3D(VECTOR_3D *, VECTOR_3D *)
+ * @fn VECTOR_3D sumVecVec3D(VECTOR_3D, VECTOR_3D)
  * @brief summation of 3 dimentional vector and 3 dimentional vector
  * @param[in] VECTOR_3D 3 dimentional vector
  * @param[in] VECTOR_3D 3 dimentional vector
@@ -155,15 +447,12 @@ VECTOR_3D sumVecVec3D(VECTOR_3D VecA, VECTOR_3D VecB)
 {
     VECTOR_3D result;
 
-    result.x = VecA.x + VecB.x;
-    result.y = VecA.y + VecB.y;
-    result.z = VecA.z + VecB.z;
-
+    sumVecVec3DPtr(&VecA, &VecB, &result);
     return result;
 };
 
 /**
- * @fn VECTOR_3D subVecVec3D(VECTOR_3D *, VECTOR_3D *)
+ * @fn VECTOR_3D subVecVec3D(VECTOR_3D, VECTOR_3D)
  * @brief subtraction of 3 dimentional vector and 3 dimentional vector
  * @param[in] VECTOR_3D 3 dimentional vector
  * @param[in] VECTOR_3D 3 dimentional vector
@@ -173,62 +462,38 @@ VECTOR_3D subVecVec3D(VECTOR_3D VecA, VECTOR_3D VecB)
 {
     VECTOR_3D result;
 
-    result.x = VecA.x - VecB.x;
-    result.y = VecA.y - VecB.y;
-    result.z = VecA.z - VecB.z;
-
+    subVecVec3DPtr(&VecA, &VecB, &result);
     return result;
 };
 
 /**
- * @fn MATRIX_3D transeposeMat3D(MATRIX_3D *)
+ * @fn MATRIX_3D transeposeMat3D(MATRIX_3D)
  * @brief transpose 3x3 matrix
- * @param[in] VECTOR_3D 3 dimentional vector
+ * @param[in] MATRIX_3D 3x3 matrix
  * @return result of transpose
  */
 MATRIX_3D transeposeMat3D(MATRIX_3D MatA)
 {
     MATRIX_3D result;
 
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            result.a[i][j] = MatA.a[j][i];
-        }
-    }
-
+    transeposeMat3DPtr(&MatA, &result);
     return result;
 };
 
 /**
- * @fn int inverseMat3D(MATRIX_3D *, MATRIX_3D *)
- * @brief summation of 3x3 matrix and 3x3 matrix
+ * @fn int inverseMat3D(MATRIX_3D, MATRIX_3D *)
+ * @brief inverse of 3x3 matrix
  * @param[in] MATRIX_3D 3x3 matrix
  * @param[out] MATRIX_3D* inversed matrix
  * @return Success or failure
  */
 int inverseMat3D(MATRIX_3D MatA, MATRIX_3D *InvA)
 {
-    double detMatA = MatA.a[0][0] * MatA.a[1][1] * MatA.a[2][2] + MatA.a[0][1] * MatA.a[1][2] * MatA.a[2][0] + MatA.a[0][2] * MatA.a[1][0] * MatA.a[2][1] - MatA.a[0][2] * MatA.a[1][1] * MatA.a[2][0] - MatA.a[0][1] * MatA.a[1][0] * MatA.a[2][2] - MatA.a[0][0] * MatA.a[1][2] * MatA.a[2][1];
-    if (detMatA == 0)
-        return 0;
-
-    InvA->a[0][0] = (MatA.a[1][1] * MatA.a[2][2] - MatA.a[1][2] * MatA.a[2][1]) / detMatA;
-    InvA->a[0][1] = -(MatA.a[0][1] * MatA.a[2][2] - MatA.a[0][2] * MatA.a[2][1]) / detMatA;
-    InvA->a[0][2] = (MatA.a[0][1] * MatA.a[1][2] - MatA.a[0][2] * MatA.a[1][1]) / detMatA;
-    InvA->a[1][0] = -(MatA.a[1][0] * MatA.a[2][2] - MatA.a[1][2] * MatA.a[2][1]) / detMatA;
-    InvA->a[1][1] = (MatA.a[0][0] * MatA.a[2][2] - MatA.a[0][2] * MatA.a[2][0]) / detMatA;
-    InvA->a[1][2] = -(MatA.a[0][0] * MatA.a[1][2] - MatA.a[0][2] * MatA.a[1][0]) / detMatA;
-    InvA->a[2][0] = (MatA.a[1][0] * MatA.a[2][1] - MatA.a[1][1] * MatA.a[2][0]) / detMatA;
-    InvA->a[2][1] = -(MatA.a[0][0] * MatA.a[2][1] - MatA.a[0][1] * MatA.a[2][0]) / detMatA;
-    InvA->a[2][2] = (MatA.a[0][0] * MatA.a[1][1] - MatA.a[0][1] * MatA.a[1][0]) / detMatA;
-
-    return 1;
+    return inverseMat3DPtr(&MatA, InvA);
 }
 
 /**
- * @fn MATRIX_4D mulMatMat4D(MATRIX_4D *, MATRIX_4D *)
+ * @fn MATRIX_4D mulMatMat4D(MATRIX_4D, MATRIX_4D)
  * @brief multiple 4x4 matrix and 4x4 matrix
  * @param[in] MATRIX_4D 4x4 matrix
  * @param[in] MATRIX_4D 4x4 matrix
@@ -238,22 +503,12 @@ MATRIX_4D mulMatMat4D(MATRIX_4D MatA, MATRIX_4D MatB)
 {
     MATRIX_4D result;
 
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j < 4; j++)
-        {
-            result.a[i][j] = 0;
-            for (int k = 0; k < 4; k++)
-            {
-                result.a[i][j] += MatA.a[i][k] * MatB.a[k][j];
-            }
-        }
-    }
+    mulMatMat4DPtr(&MatA, &MatB, &result);
     return result;
 };
 
 /**
- * @fn VECTOR_4D mulMatVec4D(MATRIX_4D *, VECTOR_4D *)
+ * @fn VECTOR_4D mulMatVec4D(MATRIX_4D, VECTOR_4D)
  * @brief multiple 4x4 matrix and 4 dimentional vector
  * @param[in] MATRIX_4D 4x4 matrix
  * @param[in] VECTOR_4D 4 dimentional vector
@@ -263,13 +518,6 @@ VECTOR_4D mulMatVec4D(MATRIX_4D MatA, VECTOR_4D VecA)
 {
     VECTOR_4D result;
 
-    for (int i = 0; i < 4; i++)
-    {
-        result.x[i] = 0;
-        for (int j = 0; j < 4; j++)
-        {
-            result.x[i] += MatA.a[i][j] * VecA.x[j];
-        }
-    }
+    mulMatVec4DPtr(&MatA, &VecA, &result);
     return result;
 };
@@ -62,6 +62,28 @@ typedef struct
 } MATRIX_4D;
 
 //// Prototype declaration ////
+// Pointer API (no copy of the structures, see matrix.c for the aliasing rules)
+void mulMatMat3DPtr(const MATRIX_3D *, const MATRIX_3D *, MATRIX_3D *restrict);
+void mulMatMat3DInPlace(MATRIX_3D *, const MATRIX_3D *);
+void mulMatVec3DPtr(const MATRIX_3D *, const VECTOR_3D *, VECTOR_3D *restrict);
+void mulMatVec3DInPlace(const MATRIX_3D *, VECTOR_3D *);
+void mulTransMatVec3DPtr(const MATRIX_3D *, const VECTOR_3D *, VECTOR_3D *restrict);
+void mulAddMatVec3DPtr(const MATRIX_3D *, const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *restrict);
+void mulScoMat3DPtr(double, const MATRIX_3D *, MATRIX_3D *);
+void mulScoVec3DPtr(double, const VECTOR_3D *, VECTOR_3D *);
+void mulAddScoVec3DPtr(double, const VECTOR_3D *, VECTOR_3D *);
+void crsVecVec3DPtr(const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *restrict);
+void sumMatMat3DPtr(const MATRIX_3D *, const MATRIX_3D *, MATRIX_3D *);
+void sumVecVec3DPtr(const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *);
+void subVecVec3DPtr(const VECTOR_3D *, const VECTOR_3D *, VECTOR_3D *);
+void transeposeMat3DPtr(const MATRIX_3D *, MATRIX_3D *restrict);
+void transeposeMat3DInPlace(MATRIX_3D *);
+int inverseMat3DPtr(const MATRIX_3D *, MATRIX_3D *restrict);
+void mulMatMat4DPtr(const MATRIX_4D *, const MATRIX_4D *, MATRIX_4D *restrict);
+void mulMatMat4DInPlace(MATRIX_4D *, const MATRIX_4D *);
+void mulMatVec4DPtr(const MATRIX_4D *, const VECTOR_4D *, VECTOR_4D *restrict);
+void transformPoint4DPtr(const MATRIX_4D *, const VECTOR_3D *, VECTOR_3D *restrict);
+// By-value API (wrappers of the pointer API)
 MATRIX_3D mulMatMat3D(MATRIX_3D, MATRIX_3D);
 VECTOR_3D mulMatVec3D(MATRIX_3D, VECTOR_3D);
 MATRIX_3D mulScoMat3D(double, MATRIX_3D);
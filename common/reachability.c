@@ -0,0 +1,473 @@
+/**
+ * @file reachability.c
+ * @brief Precomputed reachability grid of the end effector position with seed joint angles for inverse kinematics
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "reachability.h"
+
+#define FNV_OFFSET_BASIS (14695981039346656037ULL)
+#define FNV_PRIME (1099511628211ULL)
+#define REACH_SEED_NUM (4)
+#define REACH_FORWARD_SEED_NUM (2)
+#define REACH_MAX_ITERATIONS (200)
+#define REACH_POSITION_TOLERANCE (1e-5) // [m]
+
+/**
+ * @struct REACH_GRID_JOB
+ * @brief Arguments of the thread pool task of buildReachGrid (one task for a row of the grid along x)
+ */
+typedef struct
+{
+    const REACH_GRID_HEADER *header;
+    REACH_GRID_CELL *cell;
+    KINEMATICS_CACHE cache; // initialized cache copied by every task
+    IK_CONFIG ik_config;
+    VECTOR_3D shoulder;     // position of joint 2 [m]
+    double reach;           // upper limit of the distance from joint 2 to the end effector [m]
+} REACH_GRID_JOB;
+
+/**
+ * @fn static uint64_t hashBytes(uint64_t, const void *, size_t)
+ * @brief FNV-1a hash of a memory block
+ */
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *byte = (const unsigned char *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= byte[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @fn static void setGridGeometry(REACH_GRID_HEADER *, const REACH_GRID_CONFIG *)
+ * @brief Number of grid points and origin of the box of the setting
+ */
+static void setGridGeometry(REACH_GRID_HEADER *header, const REACH_GRID_CONFIG *config)
+{
+    const double min[3] = {config->min.x, config->min.y, config->min.z};
+    const double max[3] = {config->max.x, config->max.y, config->max.z};
+
+    for (int k = 0; k < 3; k++)
+    {
+        header->size[k] = (int32_t)floor((max[k] - min[k]) / config->resolution + 1e-9) + 1;
+        header->origin[k] = min[k];
+    }
+    header->resolution = config->resolution;
+}
+
+/**
+ * @fn static float calcManipulability(const KINEMATICS_CACHE *)
+ * @brief Manipulability of the end effector position sqrt(det(Jv Jv^T)) from the cached link frames
+ */
+static float calcManipulability(const KINEMATICS_CACHE *cache)
+{
+    double J[KINEMATICS_TASK_DIM][KINEMATICS_DOF];
+    double A[3][3] = {{0}};
+    double det;
+
+    calcJacobian7Dof(cache, J);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            for (int k = 0; k < KINEMATICS_DOF; k++)
+            {
+                A[i][j] += J[i][k] * J[j][k];
+            }
+        }
+    }
+    det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    return (float)sqrt(fmax(det, 0));
+}
+
+/**
+ * @fn static void solveRow(int, void *)
+ * @brief Thread pool task: solve the grid points of a row along x (the previous point of the row is also tried as a seed)
+ */
+static void solveRow(int index, void *user_data)
+{
+    REACH_GRID_JOB *job = (REACH_GRID_JOB *)user_data;
+    const REACH_GRID_HEADER *header = job->header;
+    const int y = index % header->size[1], z = index / header->size[1];
+    REACH_GRID_CELL *row = &job->cell[(size_t)index * header->size[0]];
+    KINEMATICS_CACHE cache = job->cache;
+    double previous[JOINT_NUM] = {0};
+    int warm = 0;
+
+    for (int x = 0; x < header->size[0]; x++)
+    {
+        VECTOR_3D target = {header->origin[0] + x * header->resolution, header->origin[1] + y * header->resolution, header->origin[2] + z * header->resolution};
+        double dx = target.x - job->shoulder.x, dy = target.y - job->shoulder.y, dz = target.z - job->shoulder.z;
+        double front = atan2(target.y, target.x), back = atan2(-target.y, -target.x);
+        // reaching forward low, forward high, over the top backward and backward low with the elbow twisted by joint 3
+        const double seed[REACH_SEED_NUM][JOINT_NUM] = {{front, 0.4, 0, -1.2, 0, 0, 0, 0},
+                                                        {front, 1.2, 0, -1.6, 0, 0, 0, 0},
+                                                        {back, 2.6, 0, -1.2, 0, 0, 0, 0},
+                                                        {back, 3.0, 2.0, -0.8, 0, 0, 0, 0}};
+        double theta[JOINT_NUM];
+        int reached = 0;
+
+        // no need to solve the points beyond the stretched arm
+        if (sqrt(dx * dx + dy * dy + dz * dz) <= job->reach)
+        {
+            // the forward seeds come first so that the seeds are natural postures, then the previous point of the row
+            for (int n = 0; (n < REACH_SEED_NUM) && !reached; n++)
+            {
+                if ((n == REACH_FORWARD_SEED_NUM) && warm)
+                    reached = (inverseKinematics7Dof(&cache, &target, NULL, previous, theta, &job->ik_config, NULL) == 0);
+                if (!reached)
+                    reached = (inverseKinematics7Dof(&cache, &target, NULL, seed[n], theta, &job->ik_config, NULL) == 0);
+            }
+        }
+        if (reached)
+        {
+            for (int i = 0; i < KINEMATICS_DOF; i++)
+            {
+                row[x].seed[i] = (float)theta[i];
+            }
+            row[x].manipulability = calcManipulability(&cache);
+            memcpy(previous, theta, sizeof(previous));
+        }
+        else
+        {
+            memset(row[x].seed, 0, sizeof(row[x].seed));
+            row[x].manipulability = REACH_GRID_UNREACHABLE;
+        }
+        warm = reached;
+    }
+}
+
+/**
+ * @fn void getDefaultReachGridConfig(REACH_GRID_CONFIG *)
+ * @brief Box covering the whole workspace of CRANE-X7 at 2 cm resolution
+ * @param[out] *config setting of the grid
+ */
+void getDefaultReachGridConfig(REACH_GRID_CONFIG *config)
+{
+    config->min.x = -0.52;
+    config->min.y = -0.52;
+    config->min.z = -0.46;
+    config->max.x = 0.52;
+    config->max.y = 0.52;
+    config->max.z = 0.58;
+    config->resolution = 0.02;
+}
+
+/**
+ * @fn uint64_t calcLinkParamHash(void)
+ * @brief Hash of the link parameters and the joint range (arm_parameter.c), the key of the grid file.
+ *        A grid file built with different parameters is rebuilt by openReachGrid.
+ * @return hash value
+ */
+uint64_t calcLinkParamHash(void)
+{
+    LINK_PARAM base, link_3dof[LINK_NUM_3DOF], link_7dof[LINK_NUM_7DOF];
+    JOINT_RANGE range[JOINT_NUM];
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    getLinkParamBase(&base);
+    getLinkParam3Dof(link_3dof);
+    getLinkParam7Dof(link_7dof);
+    getJointRange(range);
+    hash = hashBytes(hash, &base, sizeof(base));
+    hash = hashBytes(hash, link_3dof, sizeof(link_3dof));
+    hash = hashBytes(hash, link_7dof, sizeof(link_7dof));
+    hash = hashBytes(hash, range, sizeof(range));
+    return hash;
+}
+
+/**
+ * @fn int buildReachGrid(REACH_GRID *, const REACH_GRID_CONFIG *, THREAD_POOL *)
+ * @brief Solve position only inverse kinematics at every grid point on the thread pool.
+ *        Only the joint range is considered (collision of the links is not checked).
+ * @param[out] *grid built grid (closeReachGrid must be called after use)
+ * @param[in] *config setting of the grid (getDefaultReachGridConfig)
+ * @param[in,out] *pool thread pool (initThreadPool must be called before)
+ * @return 0: success, 1: failure
+ */
+int buildReachGrid(REACH_GRID *grid, const REACH_GRID_CONFIG *config, THREAD_POOL *pool)
+{
+    REACH_GRID_HEADER geometry, *header;
+    REACH_GRID_CELL *cell;
+    REACH_GRID_JOB job;
+    double zero[JOINT_NUM] = {0};
+    size_t cell_num;
+
+    memset(grid, 0, sizeof(REACH_GRID));
+    if ((config->resolution <= 0) || (config->max.x < config->min.x) || (config->max.y < config->min.y) || (config->max.z < config->min.z))
+    {
+        printf("Invalid reachability grid setting\n");
+        return 1;
+    }
+    memset(&geometry, 0, sizeof(geometry));
+    setGridGeometry(&geometry, config);
+    cell_num = (size_t)geometry.size[0] * geometry.size[1] * geometry.size[2];
+    grid->data_size = sizeof(REACH_GRID_HEADER) + cell_num * sizeof(REACH_GRID_CELL);
+    grid->data = malloc(grid->data_size);
+    if (grid->data == NULL)
+    {
+        printf("Failed to allocate reachability grid (%zu cells)\n", cell_num);
+        return 1;
+    }
+    header = (REACH_GRID_HEADER *)grid->data;
+    cell = (REACH_GRID_CELL *)(header + 1);
+    *header = geometry;
+    memcpy(header->magic, REACH_GRID_MAGIC, sizeof(header->magic));
+    header->version = REACH_GRID_VERSION;
+    header->cell_size = sizeof(REACH_GRID_CELL);
+    header->param_hash = calcLinkParamHash();
+
+    // the stretched arm gives the upper limit of the distance from joint 2
+    job.header = header;
+    job.cell = cell;
+    initKinematicsCache(&job.cache);
+    forwardKinematics7Dof(&job.cache, zero);
+    getJointPosition(&job.cache, 1, &job.shoulder);
+    job.reach = 0;
+    for (int i = 1; i < KINEMATICS_DOF; i++)
+    {
+        VECTOR_3D p, q;
+
+        getJointPosition(&job.cache, i, &p);
+        getJointPosition(&job.cache, i + 1, &q);
+        job.reach += sqrt(pow(q.x - p.x, 2) + pow(q.y - p.y, 2) + pow(q.z - p.z, 2));
+    }
+    getDefaultIkConfig(&job.ik_config);
+    job.ik_config.max_iterations = REACH_MAX_ITERATIONS;
+    job.ik_config.time_budget = 0; // the result must not depend on the load of the machine
+    job.ik_config.position_tolerance = REACH_POSITION_TOLERANCE;
+    runThreadPool(pool, header->size[1] * header->size[2], solveRow, &job);
+
+    for (size_t n = 0; n < cell_num; n++)
+    {
+        if (cell[n].manipulability != REACH_GRID_UNREACHABLE)
+            header->reachable_num++;
+    }
+    grid->header = header;
+    grid->cell = cell;
+    grid->mapped = 0;
+    return 0;
+}
+
+/**
+ * @fn int saveReachGrid(const REACH_GRID *, const char *)
+ * @brief Write the grid to a file. The file is replaced atomically, so other processes never map a partial file.
+ * @param[in] *grid grid
+ * @param[in] *filename path of the grid file
+ * @return 0: success, 1: failure
+ */
+int saveReachGrid(const REACH_GRID *grid, const char *filename)
+{
+    char temporary[4096];
+    FILE *fp;
+    int result = 0;
+
+    snprintf(temporary, sizeof(temporary), "%s.%d.tmp", filename, (int)getpid());
+    fp = fopen(temporary, "wb");
+    if (fp == NULL)
+    {
+        printf("Failed to open %s\n", temporary);
+        return 1;
+    }
+    if (fwrite(grid->data, 1, grid->data_size, fp) != grid->data_size)
+        result = 1;
+    if (fclose(fp) != 0)
+        result = 1;
+    if ((result == 0) && (rename(temporary, filename) != 0))
+        result = 1;
+    if (result)
+    {
+        printf("Failed to write %s\n", filename);
+        unlink(temporary);
+    }
+    return result;
+}
+
+/**
+ * @fn int loadReachGrid(REACH_GRID *, const char *, const REACH_GRID_CONFIG *)
+ * @brief Map the grid file into memory (read only, pages are loaded on the first lookup)
+ * @param[out] *grid mapped grid (closeReachGrid must be called after use)
+ * @param[in] *filename path of the grid file
+ * @param[in] *config setting the grid must match (NULL: any grid)
+ * @return 0: success, 1: no valid file, or the file was built with other parameters or setting
+ */
+int loadReachGrid(REACH_GRID *grid, const char *filename, const REACH_GRID_CONFIG *config)
+{
+    const REACH_GRID_HEADER *header;
+    struct stat status;
+    int fd;
+
+    memset(grid, 0, sizeof(REACH_GRID));
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return 1;
+    if ((fstat(fd, &status) != 0) || (status.st_size < (off_t)sizeof(REACH_GRID_HEADER)))
+    {
+        close(fd);
+        printf("Invalid reachability grid file %s\n", filename);
+        return 1;
+    }
+    grid->data_size = (size_t)status.st_size;
+    grid->data = mmap(NULL, grid->data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (grid->data == MAP_FAILED)
+    {
+        memset(grid, 0, sizeof(REACH_GRID));
+        printf("Failed to map %s\n", filename);
+        return 1;
+    }
+    grid->mapped = 1;
+    header = (const REACH_GRID_HEADER *)grid->data;
+
+    if ((memcmp(header->magic, REACH_GRID_MAGIC, sizeof(header->magic)) != 0) || (header->version != REACH_GRID_VERSION) ||
+        (header->cell_size != sizeof(REACH_GRID_CELL)) || (header->size[0] <= 0) || (header->size[1] <= 0) || (header->size[2] <= 0) ||
+        (grid->data_size != sizeof(REACH_GRID_HEADER) + (size_t)header->size[0] * header->size[1] * header->size[2] * sizeof(REACH_GRID_CELL)))
+    {
+        printf("Invalid reachability grid file %s\n", filename);
+        closeReachGrid(grid);
+        return 1;
+    }
+    if (header->param_hash != calcLinkParamHash())
+    {
+        printf("Reachability grid file %s was built with other link parameters\n", filename);
+        closeReachGrid(grid);
+        return 1;
+    }
+    if (config != NULL)
+    {
+        REACH_GRID_HEADER expected;
+
+        setGridGeometry(&expected, config);
+        if (memcmp(expected.size, header->size, sizeof(expected.size)) || memcmp(expected.origin, header->origin, sizeof(expected.origin)) ||
+            (expected.resolution != header->resolution))
+        {
+            printf("Reachability grid file %s was built with other grid setting\n", filename);
+            closeReachGrid(grid);
+            return 1;
+        }
+    }
+    grid->header = header;
+    grid->cell = (const REACH_GRID_CELL *)(header + 1);
+    return 0;
+}
+
+/**
+ * @fn int openReachGrid(REACH_GRID *, const char *, const REACH_GRID_CONFIG *, THREAD_POOL *)
+ * @brief Map the grid file, or build the grid and save it when the file is missing or out of date
+ * @param[out] *grid grid (closeReachGrid must be called after use)
+ * @param[in] *filename path of the grid file
+ * @param[in] *config setting of the grid (getDefaultReachGridConfig)
+ * @param[in,out] *pool thread pool to build the grid (initThreadPool must be called before)
+ * @return 0: success, 1: failure
+ */
+int openReachGrid(REACH_GRID *grid, const char *filename, const REACH_GRID_CONFIG *config, THREAD_POOL *pool)
+{
+    if (loadReachGrid(grid, filename, config) == 0)
+        return 0;
+    printf("Building reachability grid %s\n", filename);
+    if (buildReachGrid(grid, config, pool))
+        return 1;
+    if (saveReachGrid(grid, filename) == 0)
+    {
+        // use the mapped file as other processes do
+        REACH_GRID built = *grid;
+
+        if (loadReachGrid(grid, filename, config) == 0)
+        {
+            closeReachGrid(&built);
+            return 0;
+        }
+        *grid = built;
+    }
+    return 0;
+}
+
+/**
+ * @fn void closeReachGrid(REACH_GRID *)
+ * @brief Unmap or free the grid
+ * @param[in,out] *grid grid
+ */
+void closeReachGrid(REACH_GRID *grid)
+{
+    if (grid->data != NULL)
+    {
+        if (grid->mapped)
+            munmap(grid->data, grid->data_size);
+        else
+            free(grid->data);
+    }
+    memset(grid, 0, sizeof(REACH_GRID));
+}
+
+/**
+ * @fn const REACH_GRID_CELL *lookupReachGrid(const REACH_GRID *, const VECTOR_3D *)
+ * @brief Cell of the grid point nearest to the position
+ * @param[in] *grid grid
+ * @param[in] *position end effector position [m] (base frame of kinematics.h)
+ * @return cell, NULL if the position is outside of the grid
+ */
+const REACH_GRID_CELL *lookupReachGrid(const REACH_GRID *grid, const VECTOR_3D *position)
+{
+    const REACH_GRID_HEADER *header = grid->header;
+    const double p[3] = {position->x, position->y, position->z};
+    size_t index = 0;
+
+    for (int k = 2; k >= 0; k--)
+    {
+        double i = floor((p[k] - header->origin[k]) / header->resolution + 0.5);
+
+        if ((i < 0) || (i >= header->size[k]))
+            return NULL;
+        index = index * header->size[k] + (size_t)i;
+    }
+    return &grid->cell[index];
+}
+
+/**
+ * @fn int getReachGridSeed(const REACH_GRID *, const VECTOR_3D *, double *)
+ * @brief Initial joint angles of inverse kinematics (inverseKinematics7Dof) for the position
+ * @param[in] *grid grid
+ * @param[in] *position end effector position [m] (base frame of kinematics.h)
+ * @param[out] *theta joint angles of the nearest grid point [rad] (KINEMATICS_DOF elements are written, the gripper is kept)
+ * @return 0: the nearest grid point is reachable, 1: unreachable or outside of the grid (theta is not changed)
+ */
+int getReachGridSeed(const REACH_GRID *grid, const VECTOR_3D *position, double *theta)
+{
+    const REACH_GRID_CELL *cell = lookupReachGrid(grid, position);
+
+    if ((cell == NULL) || (cell->manipulability == REACH_GRID_UNREACHABLE))
+        return 1;
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+        theta[i] = cell->seed[i];
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file reachability.h
+ * @brief Precomputed reachability grid of the end effector position with seed joint angles for inverse kinematics
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REACHABILITY_H_
+#define REACHABILITY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "kinematics.h"
+#include "thread_pool.h"
+
+#define REACH_GRID_MAGIC "CX7REACH"
+#define REACH_GRID_VERSION (1)
+#define REACH_GRID_UNREACHABLE (-1.0f) // manipulability of the cells which the end effector cannot reach
+
+//// Structure definition ////
+/**
+ * @struct REACH_GRID_CONFIG
+ * @brief Workspace box and resolution of the grid (base frame of kinematics.h)
+ */
+typedef struct
+{
+    VECTOR_3D min;     // lower corner of the box [m]
+    VECTOR_3D max;     // upper corner of the box [m]
+    double resolution; // distance between grid points [m]
+} REACH_GRID_CONFIG;
+
+/**
+ * @struct REACH_GRID_HEADER
+ * @brief Header of the grid file (the cells follow it, byte order of the host)
+ */
+typedef struct
+{
+    char magic[8];          // REACH_GRID_MAGIC
+    uint32_t version;       // REACH_GRID_VERSION
+    uint32_t cell_size;     // sizeof(REACH_GRID_CELL)
+    uint64_t param_hash;    // calcLinkParamHash of the parameters the grid was built with
+    int32_t size[3];        // number of grid points along x, y and z
+    int32_t reserved;
+    double origin[3];       // position of the grid point (0, 0, 0) [m]
+    double resolution;      // distance between grid points [m]
+    uint64_t reachable_num; // number of reachable cells
+} REACH_GRID_HEADER;
+
+/**
+ * @struct REACH_GRID_CELL
+ * @brief Result of position only inverse kinematics at a grid point
+ */
+typedef struct
+{
+    float seed[KINEMATICS_DOF]; // joint angles reaching the grid point [rad] (0 if unreachable)
+    float manipulability;       // sqrt(det(Jv Jv^T)) of the seed [m^3], REACH_GRID_UNREACHABLE if unreachable
+} REACH_GRID_CELL;
+
+/**
+ * @struct REACH_GRID
+ * @brief Grid opened by buildReachGrid or loadReachGrid
+ */
+typedef struct
+{
+    const REACH_GRID_HEADER *header;
+    const REACH_GRID_CELL *cell; // cell[(z * size[1] + y) * size[0] + x]
+    void *data;                  // header and cells
+    size_t data_size;            // [byte]
+    int mapped;                  // 1: data is mapped from the file, 0: data is allocated
+} REACH_GRID;
+
+//// Prototype declaration ////
+void getDefaultReachGridConfig(REACH_GRID_CONFIG *);
+uint64_t calcLinkParamHash(void);
+int buildReachGrid(REACH_GRID *, const REACH_GRID_CONFIG *, THREAD_POOL *);
+int saveReachGrid(const REACH_GRID *, const char *);
+int loadReachGrid(REACH_GRID *, const char *, const REACH_GRID_CONFIG *);
+int openReachGrid(REACH_GRID *, const char *, const REACH_GRID_CONFIG *, THREAD_POOL *);
+void closeReachGrid(REACH_GRID *);
+const REACH_GRID_CELL *lookupReachGrid(const REACH_GRID *, const VECTOR_3D *);
+int getReachGridSeed(const REACH_GRID *, const VECTOR_3D *, double *);
+
+#endif
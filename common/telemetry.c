@@ -0,0 +1,232 @@
+/**
+ * @file telemetry.c
+ * @brief Joint state recorder of every control cycle (lock-free ring buffer drained to a binary file by a background thread)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "telemetry.h"
+
+/**
+ * @fn static int writeAll(int, const void *, size_t)
+ * @brief Write the whole memory block to the file
+ * @return 0: success, 1: failure
+ */
+static int writeAll(int fd, const void *data, size_t size)
+{
+  const char *p = (const char *)data;
+
+  while (size > 0)
+  {
+    ssize_t written = write(fd, p, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return 1;
+    }
+    p += written;
+    size -= (size_t)written;
+  }
+  return 0;
+}
+
+/**
+ * @fn static void *drainThread(void *)
+ * @brief Background thread: write the committed records directly from the ring buffer every TELEMETRY_DRAIN_PERIOD
+ */
+static void *drainThread(void *arg)
+{
+  TELEMETRY *telemetry = (TELEMETRY *)arg;
+  struct timespec period = {0, (long)(TELEMETRY_DRAIN_PERIOD * 1e9)};
+  uint64_t tail = telemetry->tail;
+
+  while (1)
+  {
+    // records committed before closeTelemetry are written before the thread exits
+    int stopping = __atomic_load_n(&telemetry->stopping, __ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&telemetry->head, __ATOMIC_ACQUIRE);
+
+    while (tail < head)
+    {
+      uint64_t start = tail & (telemetry->capacity - 1);
+      uint64_t span = head - tail;
+
+      // the ring buffer wraps around: write up to its end first
+      if (span > telemetry->capacity - start)
+        span = telemetry->capacity - start;
+      if (!telemetry->write_error && writeAll(telemetry->fd, &telemetry->ring[start], span * sizeof(TELEMETRY_RECORD)))
+        telemetry->write_error = 1;
+      tail += span;
+      __atomic_store_n(&telemetry->tail, tail, __ATOMIC_RELEASE);
+    }
+    if (stopping)
+      break;
+    nanosleep(&period, NULL);
+  }
+  return NULL;
+}
+
+/**
+ * @fn int openTelemetry(TELEMETRY *, const char *, int)
+ * @brief Create the telemetry file, allocate the ring buffer and start the background thread
+ * @param[out] *telemetry recorder
+ * @param[in] *filename path of the telemetry file (overwritten)
+ * @param[in] capacity number of records of the ring buffer (rounded up to a power of 2, 0: TELEMETRY_DEFAULT_CAPACITY)
+ * @return 0: success, 1: failure
+ */
+int openTelemetry(TELEMETRY *telemetry, const char *filename, int capacity)
+{
+  TELEMETRY_HEADER header;
+  struct timespec now;
+
+  memset(telemetry, 0, sizeof(TELEMETRY));
+  telemetry->capacity = 1;
+  while (telemetry->capacity < (uint64_t)((capacity > 0) ? capacity : TELEMETRY_DEFAULT_CAPACITY))
+  {
+    telemetry->capacity <<= 1;
+  }
+  // touch every page now, so that the control thread never causes a page fault of the ring buffer
+  telemetry->ring = (TELEMETRY_RECORD *)malloc(telemetry->capacity * sizeof(TELEMETRY_RECORD));
+  if (telemetry->ring == NULL)
+  {
+    printf("Failed to allocate telemetry buffer (%" PRIu64 " records)\n", telemetry->capacity);
+    return 1;
+  }
+  memset(telemetry->ring, 0, telemetry->capacity * sizeof(TELEMETRY_RECORD));
+
+  telemetry->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (telemetry->fd < 0)
+  {
+    printf("Failed to open %s : %s\n", filename, strerror(errno));
+    free(telemetry->ring);
+    return 1;
+  }
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+  header.version = TELEMETRY_VERSION;
+  header.record_size = sizeof(TELEMETRY_RECORD);
+  header.joint_num = JOINT_NUM;
+  clock_gettime(CLOCK_REALTIME, &now);
+  header.start_time = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+  if (writeAll(telemetry->fd, &header, sizeof(header)) || (pthread_create(&telemetry->thread, NULL, drainThread, telemetry) != 0))
+  {
+    printf("Failed to start telemetry of %s\n", filename);
+    close(telemetry->fd);
+    free(telemetry->ring);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @fn TELEMETRY_RECORD *reserveTelemetryRecord(TELEMETRY *)
+ * @brief Control thread: the next record in the ring buffer to be filled in place (no allocation, no system call)
+ * @param[in,out] *telemetry recorder
+ * @return record to be filled and committed by commitTelemetryRecord, NULL if the ring buffer is full (the record is dropped)
+ */
+TELEMETRY_RECORD *reserveTelemetryRecord(TELEMETRY *telemetry)
+{
+  uint64_t head = telemetry->head;
+
+  if (head - __atomic_load_n(&telemetry->tail, __ATOMIC_ACQUIRE) >= telemetry->capacity)
+  {
+    telemetry->dropped++;
+    return NULL;
+  }
+  return &telemetry->ring[head & (telemetry->capacity - 1)];
+}
+
+/**
+ * @fn void commitTelemetryRecord(TELEMETRY *)
+ * @brief Control thread: pass the record filled after reserveTelemetryRecord to the background thread
+ * @param[in,out] *telemetry recorder
+ */
+void commitTelemetryRecord(TELEMETRY *telemetry)
+{
+  __atomic_store_n(&telemetry->head, telemetry->head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @fn int recordTelemetry(TELEMETRY *, uint64_t, double, const double *, const double *, const double *, const double *)
+ * @brief Control thread: record the command and the joint state of a cycle (e.g. the arrays of getCranex7JointState)
+ * @param[in,out] *telemetry recorder
+ * @param[in] cycle cycle count
+ * @param[in] time time of the cycle [s]
+ * @param[in] *command_array command (JOINT_NUM elements, NULL: recorded as 0)
+ * @param[in] *angle_array present angle [rad] (JOINT_NUM elements)
+ * @param[in] *angular_velocity_array present angular velocity [rad/s] (JOINT_NUM elements)
+ * @param[in] *torque_array present torque [Nm] (JOINT_NUM elements)
+ * @return 0: recorded, 1: dropped because the ring buffer is full
+ */
+int recordTelemetry(TELEMETRY *telemetry, uint64_t cycle, double time, const double *command_array,
+                    const double *angle_array, const double *angular_velocity_array, const double *torque_array)
+{
+  TELEMETRY_RECORD *record = reserveTelemetryRecord(telemetry);
+
+  if (record == NULL)
+    return 1;
+  record->time = time;
+  record->cycle = cycle;
+  if (command_array != NULL)
+    memcpy(record->command, command_array, sizeof(record->command));
+  else
+    memset(record->command, 0, sizeof(record->command));
+  memcpy(record->angle, angle_array, sizeof(record->angle));
+  memcpy(record->angvel, angular_velocity_array, sizeof(record->angvel));
+  memcpy(record->torque, torque_array, sizeof(record->torque));
+  commitTelemetryRecord(telemetry);
+  return 0;
+}
+
+/**
+ * @fn int closeTelemetry(TELEMETRY *)
+ * @brief Write the rest of the records, complete the header and close the file (the control thread must not record any more)
+ * @param[in,out] *telemetry recorder
+ * @return 0: success, 1: failure of writing the file
+ */
+int closeTelemetry(TELEMETRY *telemetry)
+{
+  TELEMETRY_HEADER header;
+  int result;
+
+  __atomic_store_n(&telemetry->stopping, 1, __ATOMIC_RELEASE);
+  pthread_join(telemetry->thread, NULL);
+
+  result = telemetry->write_error;
+  if (!result && (pread(telemetry->fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)))
+  {
+    header.records = telemetry->tail;
+    header.dropped = telemetry->dropped;
+    result = (pwrite(telemetry->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header));
+  }
+  if (close(telemetry->fd) != 0)
+    result = 1;
+  printf("Telemetry : %" PRIu64 " records, %" PRIu64 " dropped%s\n", telemetry->tail, telemetry->dropped,
+         result ? " (failed to write the file)" : "");
+  free(telemetry->ring);
+  telemetry->ring = NULL;
+  return result;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file telemetry.h
+ * @brief Joint state recorder of every control cycle (lock-free ring buffer drained to a binary file by a background thread)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include "crane_x7_comm.h"
+
+#define TELEMETRY_MAGIC "CX7TELEM"
+#define TELEMETRY_VERSION (1)
+#define TELEMETRY_DEFAULT_CAPACITY (8192) // records in the ring buffer (8 s at 1 kHz)
+#define TELEMETRY_DRAIN_PERIOD (0.02)     // period of the background thread to write the records [s]
+#define TELEMETRY_ENV "CRANE_X7_TELEMETRY" // Environment variable to give the file of the demos to record
+#define TELEMETRY_CACHE_LINE (64)
+
+//// Structure definition ////
+/**
+ * @struct TELEMETRY_HEADER
+ * @brief Header of the telemetry file (the records follow it, byte order of the host)
+ */
+typedef struct
+{
+  char magic[8];        // TELEMETRY_MAGIC
+  uint32_t version;     // TELEMETRY_VERSION
+  uint32_t record_size; // sizeof(TELEMETRY_RECORD)
+  uint32_t joint_num;   // JOINT_NUM
+  uint32_t reserved;
+  int64_t start_time;   // wall clock time of openTelemetry (CLOCK_REALTIME) [ns]
+  uint64_t records;     // number of records in the file (written by closeTelemetry)
+  uint64_t dropped;     // number of records dropped because the ring buffer was full (written by closeTelemetry)
+} TELEMETRY_HEADER;
+
+/**
+ * @struct TELEMETRY_RECORD
+ * @brief Command and measured joint state of a control cycle
+ */
+typedef struct
+{
+  double time;               // time of the cycle (e.g. the time of the control loop callback) [s]
+  uint64_t cycle;            // cycle count
+  double command[JOINT_NUM]; // command (angle[rad], angular velocity[rad/s] or torque[Nm] depending on the operating mode)
+  double angle[JOINT_NUM];   // present angle [rad]
+  double angvel[JOINT_NUM];  // present angular velocity [rad/s]
+  double torque[JOINT_NUM];  // present torque [Nm]
+} TELEMETRY_RECORD;
+
+/**
+ * @struct TELEMETRY
+ * @brief Recorder (members are private to telemetry.c)
+ */
+typedef struct
+{
+  TELEMETRY_RECORD *ring; // preallocated ring buffer
+  uint64_t capacity;      // number of records of the ring buffer (power of 2)
+  uint64_t head __attribute__((aligned(TELEMETRY_CACHE_LINE))); // records committed by the control thread (atomic)
+  uint64_t dropped;                                             // (control thread)
+  uint64_t tail __attribute__((aligned(TELEMETRY_CACHE_LINE))); // records written to the file (atomic)
+  int fd;
+  int stopping;    // 1: the background thread writes the rest and exits (atomic)
+  int write_error; // 1: writing the file failed (background thread)
+  pthread_t thread;
+} TELEMETRY;
+
+//// Prototype declaration ////
+int openTelemetry(TELEMETRY *, const char *, int);
+TELEMETRY_RECORD *reserveTelemetryRecord(TELEMETRY *);
+void commitTelemetryRecord(TELEMETRY *);
+int recordTelemetry(TELEMETRY *, uint64_t, double, const double *, const double *, const double *, const double *);
+int closeTelemetry(TELEMETRY *);
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file thread_pool.c
+ * @brief Fixed size pool of worker threads for data parallel jobs
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <stdio.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+/**
+ * @fn static void processTasks(THREAD_POOL *, THREAD_POOL_TASK, void *, int)
+ * @brief Take task indices one by one until the job is exhausted
+ */
+static void processTasks(THREAD_POOL *pool, THREAD_POOL_TASK task, void *user_data, int num)
+{
+  int index;
+
+  while ((index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < num)
+  {
+    task(index, user_data);
+  }
+}
+
+/**
+ * @fn static void *workerThread(void *)
+ * @brief Main function of worker threads
+ */
+static void *workerThread(void *arg)
+{
+  THREAD_POOL *pool = (THREAD_POOL *)arg;
+  int generation = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  while (1)
+  {
+    THREAD_POOL_TASK task;
+    void *user_data;
+    int num;
+
+    while ((pool->generation == generation) && !pool->closing)
+    {
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+    if (pool->closing)
+      break;
+    generation = pool->generation;
+    task = pool->task;
+    user_data = pool->user_data;
+    num = pool->num;
+    pthread_mutex_unlock(&pool->mutex);
+
+    processTasks(pool, task, user_data, num);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->active == 0)
+      pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+/**
+ * @fn int getThreadPoolDefaultSize(void)
+ * @brief Number of worker threads to use all online CPUs (the caller of runThreadPool is counted)
+ */
+int getThreadPoolDefaultSize(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus < 1)
+    cpus = 1;
+  if (cpus > THREAD_POOL_MAX_THREADS)
+    cpus = THREAD_POOL_MAX_THREADS;
+  return (int)cpus - 1;
+}
+
+/**
+ * @fn int initThreadPool(THREAD_POOL *, int)
+ * @brief Start worker threads
+ * @param[out] *pool thread pool
+ * @param[in] threads number of worker threads (0: the caller processes all tasks)
+ * @return 0: success, 1: failure
+ */
+int initThreadPool(THREAD_POOL *pool, int threads)
+{
+  if ((threads < 0) || (threads > THREAD_POOL_MAX_THREADS))
+  {
+    printf("Number of threads must be 0 - %d\n", THREAD_POOL_MAX_THREADS);
+    return 1;
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pool->task = NULL;
+  pool->user_data = NULL;
+  pool->num = 0;
+  pool->next = 0;
+  pool->generation = 0;
+  pool->active = 0;
+  pool->closing = 0;
+  for (pool->threads = 0; pool->threads < threads; pool->threads++)
+  {
+    if (pthread_create(&pool->thread[pool->threads], NULL, workerThread, pool) != 0)
+    {
+      printf("Failed to create worker thread\n");
+      closeThreadPool(pool);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @fn int runThreadPool(THREAD_POOL *, int, THREAD_POOL_TASK, void *)
+ * @brief Call task(index, user_data) for index = 0 to num - 1 on the pool and the calling thread.
+ *        Returns after all tasks are finished. Tasks must not depend on the order of execution.
+ * @param[in,out] *pool thread pool
+ * @param[in] num number of tasks
+ * @param[in] task task function
+ * @param[in] *user_data pointer passed to the task function
+ * @return 0
+ */
+int runThreadPool(THREAD_POOL *pool, int num, THREAD_POOL_TASK task, void *user_data)
+{
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->user_data = user_data;
+  pool->num = num;
+  pool->next = 0;
+  pool->active = pool->threads;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  processTasks(pool, task, user_data, num);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->active > 0)
+  {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return 0;
+}
+
+/**
+ * @fn void closeThreadPool(THREAD_POOL *)
+ * @brief Stop and join worker threads
+ * @param[in,out] *pool thread pool
+ */
+void closeThreadPool(THREAD_POOL *pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+  pool->closing = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int i = 0; i < pool->threads; i++)
+  {
+    pthread_join(pool->thread[i], NULL);
+  }
+  pool->threads = 0;
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file thread_pool.h
+ * @brief Fixed size pool of worker threads for data parallel jobs
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <pthread.h>
+
+#define THREAD_POOL_MAX_THREADS (64)
+
+/**
+ * @brief Task function called once for every index of a job
+ * @param[in] index index of the task (0 to num - 1)
+ * @param[in] *user_data pointer passed to runThreadPool
+ */
+typedef void (*THREAD_POOL_TASK)(int index, void *user_data);
+
+//// Structure definition ////
+/**
+ * @struct THREAD_POOL
+ * @brief Worker threads and the job being processed (members are private to thread_pool.c)
+ */
+typedef struct
+{
+  pthread_t thread[THREAD_POOL_MAX_THREADS];
+  int threads;          // number of worker threads (the caller of runThreadPool also works)
+  pthread_mutex_t mutex;
+  pthread_cond_t start; // signaled when a job is posted or the pool is closed
+  pthread_cond_t done;  // signaled when a worker finishes its part of the job
+  THREAD_POOL_TASK task;
+  void *user_data;
+  int num;              // number of tasks of the job
+  int next;             // next task index to be taken (atomic)
+  int generation;       // incremented for every job
+  int active;           // number of workers still processing the job
+  int closing;          // 1: workers exit
+} THREAD_POOL;
+
+//// Prototype declaration ////
+int initThreadPool(THREAD_POOL *, int);
+int runThreadPool(THREAD_POOL *, int, THREAD_POOL_TASK, void *);
+void closeThreadPool(THREAD_POOL *);
+int getThreadPoolDefaultSize(void);
+
+#endif
@@ -0,0 +1,283 @@
+/**
+ * @file trajectory.c
+ * @brief Jerk limited joint trajectory through waypoints
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "trajectory.h"
+
+#define TRAJECTORY_MIN_DELTA (1e-9) // joint angle change regarded as no motion [rad]
+
+//// Default limits (XM430-W350, joint 2 is XM540-W270) ////
+#define MAX_ANGVEL_XM430W350 (3.0)   // about 60% of no load speed [rad/s]
+#define MAX_ANGVEL_XM540W270 (2.0)   // about 60% of no load speed [rad/s]
+#define MAX_ANGACC_XM430W350 (20.0)  // [rad/s^2]
+#define MAX_ANGACC_XM540W270 (10.0)  // joint 2 also holds the arm against gravity [rad/s^2]
+#define MAX_JERK_XM430W350 (300.0)   // [rad/s^3]
+#define MAX_JERK_XM540W270 (150.0)   // [rad/s^3]
+
+/**
+ * @struct TRAJECTORY_RUNNER
+ * @brief Arguments of the control loop callback of runTrajectory
+ */
+typedef struct
+{
+    const TRAJECTORY *trajectory;
+    TRAJECTORY_OUTPUT output;
+    int result;
+} TRAJECTORY_RUNNER;
+
+/**
+ * @fn void getDefaultTrajectoryLimit(TRAJECTORY_LIMIT *)
+ * @brief Default limits of joint motion (well inside the capability of the servo motors)
+ * @param[out] *limit limits of joint motion
+ */
+void getDefaultTrajectoryLimit(TRAJECTORY_LIMIT *limit)
+{
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        limit->angvel[i] = (i == XM540_W270_JOINT) ? MAX_ANGVEL_XM540W270 : MAX_ANGVEL_XM430W350;
+        limit->angacc[i] = (i == XM540_W270_JOINT) ? MAX_ANGACC_XM540W270 : MAX_ANGACC_XM430W350;
+        limit->jerk[i] = (i == XM540_W270_JOINT) ? MAX_JERK_XM540W270 : MAX_JERK_XM430W350;
+    }
+}
+
+/**
+ * @fn static void planSegment(TRAJECTORY_SEGMENT *, double, double, double)
+ * @brief Time optimal rest to rest S-curve profile of the path parameter s: 0 -> 1
+ * @param[out] *segment segment to store the profile
+ * @param[in] v maximum velocity of s [1/s]
+ * @param[in] a maximum acceleration of s [1/s^2]
+ * @param[in] j maximum jerk of s [1/s^3]
+ */
+static void planSegment(TRAJECTORY_SEGMENT *segment, double v, double a, double j)
+{
+    const double sign[TRAJECTORY_PHASE_NUM] = {1, 0, -1, 0, -1, 0, 1};
+    double tj, ta, tv = 0; // duration of jerk phase, constant acceleration phase and cruise phase
+    double duration[TRAJECTORY_PHASE_NUM];
+    double s = 0, ds = 0, dds = 0, time = 0;
+
+    // accelerate to the maximum velocity
+    if (v * j >= a * a)
+    {
+        tj = a / j;
+        ta = v / a - tj;
+    }
+    else
+    {
+        tj = sqrt(v / j);
+        ta = 0;
+    }
+    if (v * (2 * tj + ta) <= 1.0)
+    {
+        tv = (1.0 - v * (2 * tj + ta)) / v;
+    }
+    else
+    {
+        // the maximum velocity is not reached: distance of acceleration and deceleration a (tj + ta) (2 tj + ta) = 1
+        tj = a / j;
+        ta = (-3 * tj + sqrt(tj * tj + 4.0 / a)) / 2;
+        if (ta < 0)
+        {
+            // the maximum acceleration is not reached either: 2 j tj^3 = 1
+            tj = cbrt(1.0 / (2 * j));
+            ta = 0;
+        }
+    }
+    duration[0] = duration[2] = duration[4] = duration[6] = tj;
+    duration[1] = duration[5] = ta;
+    duration[3] = tv;
+
+    for (int i = 0; i < TRAJECTORY_PHASE_NUM; i++)
+    {
+        double t = duration[i];
+
+        segment->phase_time[i] = time;
+        segment->s[i] = s;
+        segment->ds[i] = ds;
+        segment->dds[i] = dds;
+        segment->jerk[i] = sign[i] * j;
+        s += ds * t + dds * t * t / 2 + segment->jerk[i] * t * t * t / 6;
+        ds += dds * t + segment->jerk[i] * t * t / 2;
+        dds += segment->jerk[i] * t;
+        time += t;
+    }
+    segment->duration = time;
+}
+
+/**
+ * @fn int planTrajectory(TRAJECTORY *, double [][JOINT_NUM], int, const TRAJECTORY_LIMIT *)
+ * @brief Plan a synchronized jerk limited trajectory through waypoints.
+ *        All joints start and stop together on a straight line in joint space between waypoints,
+ *        and each segment is the shortest S-curve profile within the limits of all joints.
+ * @param[out] *trajectory planned trajectory
+ * @param[in] waypoint joint angles of waypoints [rad] (waypoint[0] is the start posture)
+ * @param[in] num number of waypoints (2 - TRAJECTORY_MAX_WAYPOINTS)
+ * @param[in] *limit limits of joint motion (getDefaultTrajectoryLimit)
+ * @return 0: success, 1: invalid waypoints
+ */
+int planTrajectory(TRAJECTORY *trajectory, double waypoint[][JOINT_NUM], int num, const TRAJECTORY_LIMIT *limit)
+{
+    JOINT_RANGE range[JOINT_NUM];
+
+    if ((num < 2) || (num > TRAJECTORY_MAX_WAYPOINTS))
+    {
+        printf("Number of waypoints must be 2 - %d (%d)\n", TRAJECTORY_MAX_WAYPOINTS, num);
+        return 1;
+    }
+    getJointRange(range);
+    for (int n = 0; n < num; n++)
+    {
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            if ((waypoint[n][i] < range[i].min) || (waypoint[n][i] > range[i].max))
+            {
+                printf("Waypoint %d is out of the movable range (joint %d : %f [rad])\n", n, i + 1, waypoint[n][i]);
+                return 1;
+            }
+        }
+    }
+
+    trajectory->segment_num = num - 1;
+    trajectory->duration = 0;
+    for (int n = 0; n < num - 1; n++)
+    {
+        TRAJECTORY_SEGMENT *segment = &trajectory->segment[n];
+        double v = INFINITY, a = INFINITY, j = INFINITY;
+
+        // limits of the path parameter are given by the joint whose limit is the tightest for its motion
+        for (int i = 0; i < JOINT_NUM; i++)
+        {
+            double d;
+
+            segment->start[i] = waypoint[n][i];
+            segment->delta[i] = waypoint[n + 1][i] - waypoint[n][i];
+            d = fabs(segment->delta[i]);
+            if (d > TRAJECTORY_MIN_DELTA)
+            {
+                v = fmin(v, limit->angvel[i] / d);
+                a = fmin(a, limit->angacc[i] / d);
+                j = fmin(j, limit->jerk[i] / d);
+            }
+        }
+        if (isinf(v))
+        {
+            // no motion
+            for (int k = 0; k < TRAJECTORY_PHASE_NUM; k++)
+            {
+                segment->phase_time[k] = segment->s[k] = segment->ds[k] = segment->dds[k] = segment->jerk[k] = 0;
+            }
+            segment->duration = 0;
+        }
+        else
+        {
+            planSegment(segment, v, a, j);
+        }
+        segment->start_time = trajectory->duration;
+        trajectory->duration += segment->duration;
+    }
+    return 0;
+}
+
+/**
+ * @fn int evaluateTrajectory(const TRAJECTORY *, double, double *, double *, double *)
+ * @brief Joint angles, angular velocities and angular accelerations of the trajectory at the given time
+ * @param[in] *trajectory planned trajectory
+ * @param[in] time time from the start of the trajectory [s]
+ * @param[out] *angle joint angles [rad] (JOINT_NUM elements)
+ * @param[out] *angvel joint angular velocities [rad/s] (JOINT_NUM elements, NULL: not needed)
+ * @param[out] *angacc joint angular accelerations [rad/s^2] (JOINT_NUM elements, NULL: not needed)
+ * @return 0: moving, 1: the trajectory is finished (the last waypoint is given)
+ */
+int evaluateTrajectory(const TRAJECTORY *trajectory, double time, double *angle, double *angvel, double *angacc)
+{
+    const TRAJECTORY_SEGMENT *segment;
+    double s = 1, ds = 0, dds = 0;
+    int n = 0, k = TRAJECTORY_PHASE_NUM - 1;
+    int finished = (time >= trajectory->duration);
+
+    while ((n < trajectory->segment_num - 1) && (time >= trajectory->segment[n + 1].start_time))
+    {
+        n++;
+    }
+    segment = &trajectory->segment[n];
+    if (!finished)
+    {
+        double t = fmax(time - segment->start_time, 0);
+
+        while ((k > 0) && (t < segment->phase_time[k]))
+        {
+            k--;
+        }
+        t -= segment->phase_time[k];
+        s = segment->s[k] + segment->ds[k] * t + segment->dds[k] * t * t / 2 + segment->jerk[k] * t * t * t / 6;
+        ds = segment->ds[k] + segment->dds[k] * t + segment->jerk[k] * t * t / 2;
+        dds = segment->dds[k] + segment->jerk[k] * t;
+    }
+    for (int i = 0; i < JOINT_NUM; i++)
+    {
+        angle[i] = segment->start[i] + segment->delta[i] * s;
+        if (angvel != NULL)
+            angvel[i] = segment->delta[i] * ds;
+        if (angacc != NULL)
+            angacc[i] = segment->delta[i] * dds;
+    }
+    return finished;
+}
+
+/**
+ * @fn static int trajectoryCallback(uint64_t, double, void *)
+ * @brief Control loop callback: send the setpoint of the trajectory every control period
+ */
+static int trajectoryCallback(uint64_t cycle, double time, void *user_data)
+{
+    TRAJECTORY_RUNNER *runner = (TRAJECTORY_RUNNER *)user_data;
+    double angle[JOINT_NUM];
+    int finished = evaluateTrajectory(runner->trajectory, time, angle, NULL, NULL);
+
+    if (runner->output(angle))
+    {
+        runner->result = 1;
+        return 1;
+    }
+    return finished;
+}
+
+/**
+ * @fn int runTrajectory(const TRAJECTORY *, CONTROL_LOOP_CONFIG *, TRAJECTORY_OUTPUT, CONTROL_LOOP_STATS *)
+ * @brief Stream the setpoints of the trajectory at the control rate until the last waypoint is sent.
+ *        The profile velocity of the servo motors should be 0 (setCranex7ProfileVelocity) so that they follow the setpoints directly.
+ * @param[in] *trajectory planned trajectory
+ * @param[in] *config setting of the control loop (getDefaultControlLoopConfig)
+ * @param[in] output function to send the setpoint (e.g. setCranex7Angle)
+ * @param[out] *stats timing statistics of the control loop (NULL: not needed)
+ * @return 0: success, 1: failure of the control loop or the output
+ */
+int runTrajectory(const TRAJECTORY *trajectory, CONTROL_LOOP_CONFIG *config, TRAJECTORY_OUTPUT output, CONTROL_LOOP_STATS *stats)
+{
+    TRAJECTORY_RUNNER runner = {trajectory, output, 0};
+
+    if (runControlLoop(config, trajectoryCallback, &runner, stats))
+    {
+        return 1;
+    }
+    return runner.result;
+}
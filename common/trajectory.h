@@ -0,0 +1,85 @@
+/**
+ * @file trajectory.h
+ * @brief Jerk limited joint trajectory through waypoints
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+#include "arm_parameter.h"
+#include "control_loop.h"
+
+#define TRAJECTORY_MAX_WAYPOINTS (32)
+#define TRAJECTORY_PHASE_NUM (7) // jerk up, constant acceleration, jerk down, cruise, jerk down, constant deceleration, jerk up
+
+//// Structure definition ////
+/**
+ * @struct TRAJECTORY_LIMIT
+ * @brief Upper limits of joint motion used for planning
+ */
+typedef struct
+{
+    double angvel[JOINT_NUM]; // maximum angular velocity [rad/s]
+    double angacc[JOINT_NUM]; // maximum angular acceleration [rad/s^2]
+    double jerk[JOINT_NUM];   // maximum angular jerk [rad/s^3]
+} TRAJECTORY_LIMIT;
+
+/**
+ * @struct TRAJECTORY_SEGMENT
+ * @brief Synchronized motion of all joints between two waypoints.
+ *        The joints move on a straight line in joint space: angle = start + delta * s(t), s: 0 -> 1 with S-curve profile.
+ */
+typedef struct
+{
+    double start[JOINT_NUM];                 // joint angles at the start waypoint [rad]
+    double delta[JOINT_NUM];                 // joint angle change to the next waypoint [rad]
+    double start_time;                       // start time of the segment from the start of the trajectory [s]
+    double duration;                         // duration of the segment [s]
+    double phase_time[TRAJECTORY_PHASE_NUM]; // start time of each phase from the start of the segment [s]
+    double s[TRAJECTORY_PHASE_NUM];          // path parameter at the start of each phase
+    double ds[TRAJECTORY_PHASE_NUM];         // velocity of path parameter at the start of each phase [1/s]
+    double dds[TRAJECTORY_PHASE_NUM];        // acceleration of path parameter at the start of each phase [1/s^2]
+    double jerk[TRAJECTORY_PHASE_NUM];       // jerk of path parameter in each phase [1/s^3]
+} TRAJECTORY_SEGMENT;
+
+/**
+ * @struct TRAJECTORY
+ * @brief Trajectory through waypoints (the arm stops at every waypoint)
+ */
+typedef struct
+{
+    int segment_num;
+    double duration; // total duration [s]
+    TRAJECTORY_SEGMENT segment[TRAJECTORY_MAX_WAYPOINTS - 1];
+} TRAJECTORY;
+
+/**
+ * @brief Function to send the setpoint of joint angles (e.g. setCranex7Angle)
+ * @param[in] *angle_array joint angles [rad] (JOINT_NUM elements)
+ * @return 0: success, otherwise: failure (the trajectory is stopped)
+ */
+typedef int (*TRAJECTORY_OUTPUT)(double *angle_array);
+
+//// Prototype declaration ////
+void getDefaultTrajectoryLimit(TRAJECTORY_LIMIT *);
+int planTrajectory(TRAJECTORY *, double[][JOINT_NUM], int, const TRAJECTORY_LIMIT *);
+int evaluateTrajectory(const TRAJECTORY *, double, double *, double *, double *);
+int runTrajectory(const TRAJECTORY *, CONTROL_LOOP_CONFIG *, TRAJECTORY_OUTPUT, CONTROL_LOOP_STATS *);
+
+#endif
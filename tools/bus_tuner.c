@@ -0,0 +1,111 @@
+/**
+ * @file bus_tuner.c
+ * @brief Find the fastest reliable baud rate and return delay time of the serial bus of CRANE-X7 and save them (bus_timing.c)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../common/bus_timing.h"
+
+/**
+ * @fn static int parseBaudrates(char *, BUS_TIMING_SWEEP *)
+ * @brief Baud rates of the sweep from a comma separated list (e.g. 1000000,3000000)
+ * @return 0: success, 1: invalid list
+ */
+static int parseBaudrates(char *list, BUS_TIMING_SWEEP *sweep)
+{
+  char *token, *save = NULL;
+
+  sweep->baudrate_num = 0;
+  for (token = strtok_r(list, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save))
+  {
+    if (sweep->baudrate_num >= BUS_TIMING_MAX_SETTINGS)
+      return 1;
+    sweep->baudrate[sweep->baudrate_num++] = (uint32_t)strtoul(token, NULL, 10);
+  }
+  return (sweep->baudrate_num == 0);
+}
+
+static void printUsage(const char *name)
+{
+  printf("usage: %s [-n trials] [-b baudrate,...] [-l latency timer [ms]]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+  CRANE_X7_ARM_CONFIG config;
+  BUS_TIMING_SWEEP sweep;
+  BUS_TIMING best;
+  CRANE_X7_ARM *arm;
+  int opt, result;
+
+  getDefaultCranex7ArmConfig(&config);
+  getDefaultBusTimingSweep(&sweep);
+  while ((opt = getopt(argc, argv, "n:b:l:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      sweep.trials = atoi(optarg);
+      break;
+    case 'b':
+      if (parseBaudrates(optarg, &sweep))
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'l':
+      config.latency_timer = atoi(optarg);
+      break;
+    default:
+      printUsage(argv[0]);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+  if (sweep.trials <= 0)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  // the torque stays disabled: the baud rate and the return delay time are EEPROM registers
+  // (openCranex7Arm also sets ASYNC_LOW_LATENCY and the latency timer, the other settings of the servo motors are kept)
+  if (openCranex7Arm(&arm, &config, NULL))
+  {
+    return 1;
+  }
+  printf("Bulk read of the present value of %d servo motors on %s, %d times per setting\n", JOINT_NUM, config.serial_port, sweep.trials);
+  result = tuneCranex7Bus(arm, &sweep, &best);
+  if (result == 0)
+  {
+    printf("Fastest reliable setting : baudrate %u [bps], return delay time %d [us], p99 %.1f [us]\n",
+           best.baudrate, best.return_delay_time * 2, best.p99 * 1e-3);
+    result = saveBusTiming(config.serial_port, &best);
+  }
+  else
+  {
+    printf("No reliable setting was found\n");
+  }
+  closeCranex7Arm(arm);
+  return result;
+}
@@ -0,0 +1,633 @@
+/**
+ * @file dxl_emulator.c
+ * @brief Dynamixel Protocol 2.0 servo emulator on a pseudo terminal (stand-in of CRANE-X7 for bus benchmarks)
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "../common/crane_x7_comm.h"
+
+//// Definition of Protocol 2.0 ////
+#define INST_PING (0x01)
+#define INST_READ (0x02)
+#define INST_WRITE (0x03)
+#define INST_REBOOT (0x08)
+#define INST_STATUS (0x55)
+#define INST_SYNC_READ (0x82)
+#define INST_SYNC_WRITE (0x83)
+#define INST_BULK_READ (0x92)
+#define INST_BULK_WRITE (0x93)
+#define BROADCAST_ID (0xFE)
+#define ERROR_INSTRUCTION (0x02)
+#define ERROR_DATA_RANGE (0x04)
+#define ERROR_ACCESS (0x07)
+#define PACKET_HEADER_LENGTH (7) // FF FF FD 00 ID LEN_L LEN_H
+#define MAX_PACKET_LENGTH (1024)
+
+//// Definition of emulated servo motors ////
+#define FIRST_ID (2)
+#define SERVO_NUM (JOINT_NUM) // ID 2 - 9
+#define CONTROL_TABLE_SIZE (512)
+#define MODEL_NUMBER_ADDRESS (0)
+#define ID_ADDRESS (7)
+#define RETURN_DELAY_TIME_ADDRESS (9)
+#define INDIRECT_ADDRESS_NUM (28)
+#define MODEL_NUMBER_XM430W350 (1020)
+#define MODEL_NUMBER_XM540W270 (1120)
+#define FIRMWARE_VERSION (45)
+#define DEFAULT_RETURN_DELAY_TIME (0) // [2us]
+
+/**
+ * @struct EMULATOR_CONFIG
+ * @brief Fault injection setting
+ */
+typedef struct
+{
+  double byte_latency_us;  // latency added per transmitted byte[us]
+  double packet_loss_rate; // probability that a status packet is not returned [0, 1]
+  double corrupt_rate;     // probability that a status packet is sent with a wrong CRC [0, 1]
+} EMULATOR_CONFIG;
+
+/**
+ * @struct EMULATOR_STATS
+ * @brief Counters of emulator
+ */
+typedef struct
+{
+  unsigned long rx_packets;     // received instruction packets
+  unsigned long rx_crc_errors;  // instruction packets with wrong CRC
+  unsigned long tx_packets;     // returned status packets
+  unsigned long tx_dropped;     // status packets dropped by fault injection
+  unsigned long tx_corrupted;   // status packets corrupted by fault injection
+} EMULATOR_STATS;
+
+//// Variable for emulator ////
+static uint8_t control_table[SERVO_NUM][CONTROL_TABLE_SIZE];
+static double present_position[SERVO_NUM]; // present position with sub-pulse resolution[dynamixel value]
+static uint16_t crc_table[256];
+static EMULATOR_CONFIG config = {0, 0, 0};
+static EMULATOR_STATS stats = {0};
+static struct timespec last_update;
+static volatile sig_atomic_t running = 1;
+static unsigned int random_seed = 1; // seed of rand_r for the packet loss and the corruption
+
+//// Utility functions ////
+
+/**
+ * @fn static void initCrcTable(void)
+ * @brief Build the table of CRC-16 (polynomial 0x8005) used by Protocol 2.0
+ */
+static void initCrcTable(void)
+{
+  for (int i = 0; i < 256; i++)
+  {
+    uint16_t crc = (uint16_t)(i << 8);
+    for (int j = 0; j < 8; j++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+    }
+    crc_table[i] = crc;
+  }
+}
+
+/**
+ * @fn static uint16_t calcCrc(const uint8_t *, int)
+ * @brief Calculate CRC-16 of Protocol 2.0
+ */
+static uint16_t calcCrc(const uint8_t *data, int length)
+{
+  uint16_t crc = 0;
+  for (int i = 0; i < length; i++)
+  {
+    crc = (uint16_t)((crc << 8) ^ crc_table[((crc >> 8) ^ data[i]) & 0xFF]);
+  }
+  return crc;
+}
+
+/**
+ * @fn static uint32_t getTableValue(int, uint16_t, int)
+ * @brief Read little endian value from the control table
+ */
+static uint32_t getTableValue(int servo, uint16_t address, int length)
+{
+  uint32_t value = 0;
+  for (int i = length - 1; i >= 0; i--)
+  {
+    value = (value << 8) | control_table[servo][address + i];
+  }
+  return value;
+}
+
+/**
+ * @fn static void setTableValue(int, uint16_t, int, uint32_t)
+ * @brief Write little endian value to the control table
+ */
+static void setTableValue(int servo, uint16_t address, int length, uint32_t value)
+{
+  for (int i = 0; i < length; i++)
+  {
+    control_table[servo][address + i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+/**
+ * @fn static int findServo(uint8_t)
+ * @brief Get index of emulated servo motor from ID
+ * @return index, or -1 if the ID is not emulated
+ */
+static int findServo(uint8_t id)
+{
+  if ((id < FIRST_ID) || (id >= FIRST_ID + SERVO_NUM))
+    return -1;
+  return id - FIRST_ID;
+}
+
+/**
+ * @fn static uint16_t resolveAddress(int, uint16_t)
+ * @brief Resolve indirect data address to the address mapped by indirect address
+ */
+static uint16_t resolveAddress(int servo, uint16_t address)
+{
+  if ((address >= INDIRECT_DATA_1_ADDRESS) && (address < INDIRECT_DATA_1_ADDRESS + INDIRECT_ADDRESS_NUM))
+  {
+    uint16_t mapped = (uint16_t)getTableValue(servo, INDIRECT_ADDRESS_1_ADDRESS + (address - INDIRECT_DATA_1_ADDRESS) * INDIRECT_ADDRESS_DATA_LENGTH, INDIRECT_ADDRESS_DATA_LENGTH);
+    if ((mapped < CONTROL_TABLE_SIZE) && ((mapped < INDIRECT_DATA_1_ADDRESS) || (mapped >= INDIRECT_DATA_1_ADDRESS + INDIRECT_ADDRESS_NUM)))
+      return mapped;
+  }
+  return address;
+}
+
+//// Servo motor model ////
+
+/**
+ * @fn static void initServo(void)
+ * @brief Initialize control tables with the factory setting of CRANE-X7
+ */
+static void initServo(void)
+{
+  memset(control_table, 0, sizeof(control_table));
+  for (int i = 0; i < SERVO_NUM; i++)
+  {
+    setTableValue(i, MODEL_NUMBER_ADDRESS, 2, (i == XM540_W270_JOINT) ? MODEL_NUMBER_XM540W270 : MODEL_NUMBER_XM430W350);
+    setTableValue(i, 6, 1, FIRMWARE_VERSION);
+    setTableValue(i, ID_ADDRESS, 1, FIRST_ID + i);
+    setTableValue(i, RETURN_DELAY_TIME_ADDRESS, 1, DEFAULT_RETURN_DELAY_TIME);
+    setTableValue(i, OPERATING_MODE_ADDRESS, 1, POSITION_CONTROL_MODE);
+    setTableValue(i, POSITION_P_GAIN_ADDRESS, 2, DEFAULT_POSITION_P_GAIN);
+    setTableValue(i, VELOCITY_P_GAIN_ADDRESS, 2, DEFAULT_VELOCITY_P_GAIN);
+    setTableValue(i, VELOCITY_I_GAIN_ADDRESS, 2, DEFAULT_VELOCITY_I_GAIN);
+    for (int j = 0; j < INDIRECT_ADDRESS_NUM; j++)
+    {
+      setTableValue(i, INDIRECT_ADDRESS_1_ADDRESS + j * INDIRECT_ADDRESS_DATA_LENGTH, INDIRECT_ADDRESS_DATA_LENGTH, INDIRECT_DATA_1_ADDRESS + j);
+    }
+    present_position[i] = (i == 1) ? 1024 : 2048;
+    setTableValue(i, PRESENT_POSITION_ADDRESS, PRESENT_POSITION_DATA_LENGTH, (uint32_t)(int32_t)present_position[i]);
+    setTableValue(i, GOAL_POSITION_ADDRESS, GOAL_POSITION_DATA_LENGTH, (uint32_t)(int32_t)present_position[i]);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &last_update);
+}
+
+/**
+ * @fn static void updateServo(void)
+ * @brief Move present values toward the goal (position mode follows the profile velocity)
+ */
+static void updateServo(void)
+{
+  struct timespec now;
+  double dt;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  dt = (double)(now.tv_sec - last_update.tv_sec) + (double)(now.tv_nsec - last_update.tv_nsec) * 1e-9;
+  last_update = now;
+
+  for (int i = 0; i < SERVO_NUM; i++)
+  {
+    double velocity = 0; // [dynamixel value/s]
+    if (getTableValue(i, TORQUE_ENABLE_ADDRESS, 1) == TORQUE_ENABLE)
+    {
+      uint8_t mode = (uint8_t)getTableValue(i, OPERATING_MODE_ADDRESS, 1);
+      if (mode == POSITION_CONTROL_MODE)
+      {
+        double goal = (double)(int32_t)getTableValue(i, GOAL_POSITION_ADDRESS, GOAL_POSITION_DATA_LENGTH);
+        double profile = (double)getTableValue(i, PROFILE_VELOCITY_ADDRESS, PROFILE_VELOCITY_DATA_LENGTH) * DXL_VALUE_TO_ANGULARVEL / DXL_VALUE_TO_RADIAN;
+        double step = goal - present_position[i];
+        if ((profile > 0) && (step > profile * dt))
+          step = profile * dt;
+        else if ((profile > 0) && (step < -profile * dt))
+          step = -profile * dt;
+        present_position[i] += step;
+        velocity = (dt > 0) ? step / dt : 0;
+      }
+      else if (mode == VELOCITY_CONTROL_MODE)
+      {
+        velocity = (double)(int32_t)getTableValue(i, GOAL_VELOCITY_ADDRESS, GOAL_VELOCITY_DATA_LENGTH) * DXL_VALUE_TO_ANGULARVEL / DXL_VALUE_TO_RADIAN;
+        present_position[i] += velocity * dt;
+      }
+      setTableValue(i, PRESENT_CURRENT_ADDRESS, PRESENT_CURRENT_DATA_LENGTH,
+                    (mode == CURRENT_CONTROL_MODE) ? getTableValue(i, GOAL_CURRENT_ADDRESS, GOAL_CURRENT_DATA_LENGTH) : 0);
+    }
+    setTableValue(i, PRESENT_POSITION_ADDRESS, PRESENT_POSITION_DATA_LENGTH, (uint32_t)(int32_t)present_position[i]);
+    setTableValue(i, PRESENT_VELOCITY_ADDRESS, PRESENT_VELOCITY_DATA_LENGTH, (uint32_t)(int32_t)(velocity * DXL_VALUE_TO_RADIAN / DXL_VALUE_TO_ANGULARVEL));
+  }
+}
+
+/**
+ * @fn static uint8_t readServo(int, uint16_t, uint16_t, uint8_t *)
+ * @brief Read data from the control table (indirect data is resolved byte by byte)
+ * @return error field of status packet
+ */
+static uint8_t readServo(int servo, uint16_t address, uint16_t length, uint8_t *data)
+{
+  if (address + length > CONTROL_TABLE_SIZE)
+    return ERROR_DATA_RANGE;
+  for (int i = 0; i < length; i++)
+  {
+    data[i] = control_table[servo][resolveAddress(servo, address + i)];
+  }
+  return 0;
+}
+
+/**
+ * @fn static uint8_t writeServo(int, uint16_t, uint16_t, const uint8_t *)
+ * @brief Write data to the control table (indirect data is resolved byte by byte)
+ * @return error field of status packet
+ */
+static uint8_t writeServo(int servo, uint16_t address, uint16_t length, const uint8_t *data)
+{
+  if (address + length > CONTROL_TABLE_SIZE)
+    return ERROR_DATA_RANGE;
+  if ((address <= ID_ADDRESS) && (address + length > ID_ADDRESS))
+    return ERROR_ACCESS; // changing ID is not emulated
+  for (int i = 0; i < length; i++)
+  {
+    control_table[servo][resolveAddress(servo, address + i)] = data[i];
+  }
+  return 0;
+}
+
+//// Packet functions ////
+
+/**
+ * @fn static void sleepMicroseconds(double)
+ * @brief Sleep for the given time[us]
+ */
+static void sleepMicroseconds(double us)
+{
+  struct timespec ts;
+  if (us <= 0)
+    return;
+  ts.tv_sec = (time_t)(us / 1e6);
+  ts.tv_nsec = (long)((us - ts.tv_sec * 1e6) * 1e3);
+  nanosleep(&ts, NULL);
+}
+
+/**
+ * @fn static void sendStatus(int, int, uint8_t, const uint8_t *, uint16_t)
+ * @brief Send status packet (with byte stuffing, return delay time and fault injection)
+ * @param[in] fd file descriptor of pseudo terminal master
+ * @param[in] servo index of servo motor
+ * @param[in] error error field
+ * @param[in] *param parameters
+ * @param[in] param_length length of parameters
+ */
+static void sendStatus(int fd, int servo, uint8_t error, const uint8_t *param, uint16_t param_length)
+{
+  uint8_t packet[MAX_PACKET_LENGTH];
+  int length = PACKET_HEADER_LENGTH;
+  uint16_t crc;
+
+  packet[0] = 0xFF;
+  packet[1] = 0xFF;
+  packet[2] = 0xFD;
+  packet[3] = 0x00;
+  packet[4] = (uint8_t)(FIRST_ID + servo);
+  packet[length++] = INST_STATUS;
+  packet[length++] = error;
+  for (int i = 0; i < param_length && length < MAX_PACKET_LENGTH - 4; i++)
+  {
+    packet[length++] = param[i];
+    // byte stuffing (FF FF FD -> FF FF FD FD)
+    if ((packet[length - 1] == 0xFD) && (packet[length - 2] == 0xFF) && (packet[length - 3] == 0xFF))
+      packet[length++] = 0xFD;
+  }
+  packet[5] = (uint8_t)((length - 5) & 0xFF); // instruction, error, parameters and CRC
+  packet[6] = (uint8_t)((length - 5) >> 8);
+  crc = calcCrc(packet, length);
+  packet[length++] = (uint8_t)(crc & 0xFF);
+  packet[length++] = (uint8_t)(crc >> 8);
+
+  // return delay time [2us] and per byte latency
+  sleepMicroseconds(getTableValue(servo, RETURN_DELAY_TIME_ADDRESS, 1) * 2.0 + config.byte_latency_us * length);
+  if ((double)rand_r(&random_seed) / RAND_MAX < config.packet_loss_rate)
+  {
+    stats.tx_dropped++;
+    return;
+  }
+  if ((double)rand_r(&random_seed) / RAND_MAX < config.corrupt_rate)
+  {
+    packet[length - 1] ^= 0xFF;
+    stats.tx_corrupted++;
+  }
+  if (write(fd, packet, length) == length)
+  {
+    stats.tx_packets++;
+  }
+}
+
+/**
+ * @fn static void processInstruction(int, uint8_t, uint8_t, const uint8_t *, uint16_t)
+ * @brief Execute instruction packet and return status packets
+ * @param[in] fd file descriptor of pseudo terminal master
+ * @param[in] id ID of instruction packet
+ * @param[in] instruction instruction
+ * @param[in] *param parameters (byte stuffing is removed)
+ * @param[in] param_length length of parameters
+ */
+static void processInstruction(int fd, uint8_t id, uint8_t instruction, const uint8_t *param, uint16_t param_length)
+{
+  uint8_t data[MAX_PACKET_LENGTH];
+  int servo = findServo(id);
+
+  updateServo();
+  switch (instruction)
+  {
+  case INST_PING:
+    for (int i = 0; i < SERVO_NUM; i++)
+    {
+      if ((id == BROADCAST_ID) || (i == servo))
+      {
+        data[0] = control_table[i][MODEL_NUMBER_ADDRESS];
+        data[1] = control_table[i][MODEL_NUMBER_ADDRESS + 1];
+        data[2] = control_table[i][6];
+        sendStatus(fd, i, 0, data, 3);
+      }
+    }
+    break;
+  case INST_READ:
+    if ((servo >= 0) && (param_length == 4))
+    {
+      uint16_t address = param[0] | (param[1] << 8);
+      uint16_t length = param[2] | (param[3] << 8);
+      uint8_t error = readServo(servo, address, length, data);
+      sendStatus(fd, servo, error, data, error ? 0 : length);
+    }
+    break;
+  case INST_WRITE:
+    if (param_length >= 2)
+    {
+      uint16_t address = param[0] | (param[1] << 8);
+      for (int i = 0; i < SERVO_NUM; i++)
+      {
+        if ((id == BROADCAST_ID) || (i == servo))
+        {
+          uint8_t error = writeServo(i, address, param_length - 2, param + 2);
+          if (id != BROADCAST_ID)
+            sendStatus(fd, i, error, NULL, 0);
+        }
+      }
+    }
+    break;
+  case INST_REBOOT:
+    if (servo >= 0)
+    {
+      setTableValue(servo, TORQUE_ENABLE_ADDRESS, 1, TORQUE_DISABLE);
+      sendStatus(fd, servo, 0, NULL, 0);
+    }
+    break;
+  case INST_SYNC_READ:
+    if (param_length >= 4)
+    {
+      uint16_t address = param[0] | (param[1] << 8);
+      uint16_t length = param[2] | (param[3] << 8);
+      for (int i = 4; i < param_length; i++)
+      {
+        int target = findServo(param[i]);
+        if (target >= 0)
+        {
+          uint8_t error = readServo(target, address, length, data);
+          sendStatus(fd, target, error, data, error ? 0 : length);
+        }
+      }
+    }
+    break;
+  case INST_SYNC_WRITE:
+    if (param_length >= 4)
+    {
+      uint16_t address = param[0] | (param[1] << 8);
+      uint16_t length = param[2] | (param[3] << 8);
+      for (int i = 4; i + 1 + length <= param_length; i += 1 + length)
+      {
+        int target = findServo(param[i]);
+        if (target >= 0)
+          writeServo(target, address, length, param + i + 1);
+      }
+    }
+    break;
+  case INST_BULK_READ:
+    for (int i = 0; i + 5 <= param_length; i += 5)
+    {
+      int target = findServo(param[i]);
+      uint16_t address = param[i + 1] | (param[i + 2] << 8);
+      uint16_t length = param[i + 3] | (param[i + 4] << 8);
+      if (target >= 0)
+      {
+        uint8_t error = readServo(target, address, length, data);
+        sendStatus(fd, target, error, data, error ? 0 : length);
+      }
+    }
+    break;
+  case INST_BULK_WRITE:
+    for (int i = 0; i + 5 <= param_length;)
+    {
+      int target = findServo(param[i]);
+      uint16_t address = param[i + 1] | (param[i + 2] << 8);
+      uint16_t length = param[i + 3] | (param[i + 4] << 8);
+      if (i + 5 + length > param_length)
+        break;
+      if (target >= 0)
+        writeServo(target, address, length, param + i + 5);
+      i += 5 + length;
+    }
+    break;
+  default:
+    if (servo >= 0)
+      sendStatus(fd, servo, ERROR_INSTRUCTION, NULL, 0);
+    break;
+  }
+}
+
+/**
+ * @fn static int parsePacket(int, uint8_t *, int)
+ * @brief Find instruction packets in the receive buffer and execute them
+ * @param[in] fd file descriptor of pseudo terminal master
+ * @param[in,out] *buffer receive buffer
+ * @param[in] length length of received data
+ * @return length of data left in the buffer
+ */
+static int parsePacket(int fd, uint8_t *buffer, int length)
+{
+  uint8_t param[MAX_PACKET_LENGTH];
+  int head = 0;
+
+  while (length - head >= PACKET_HEADER_LENGTH + 3)
+  {
+    uint8_t *packet = buffer + head;
+    int packet_length, param_length = 0;
+
+    if ((packet[0] != 0xFF) || (packet[1] != 0xFF) || (packet[2] != 0xFD) || (packet[3] != 0x00))
+    {
+      head++;
+      continue;
+    }
+    packet_length = PACKET_HEADER_LENGTH + (packet[5] | (packet[6] << 8));
+    if (packet_length > MAX_PACKET_LENGTH)
+    {
+      head++;
+      continue;
+    }
+    if (length - head < packet_length)
+      break; // wait for the rest of the packet
+
+    stats.rx_packets++;
+    if (calcCrc(packet, packet_length - 2) != (packet[packet_length - 2] | (packet[packet_length - 1] << 8)))
+    {
+      stats.rx_crc_errors++;
+      head += packet_length;
+      continue;
+    }
+    // remove byte stuffing from parameters
+    for (int i = PACKET_HEADER_LENGTH + 1; i < packet_length - 2; i++)
+    {
+      param[param_length++] = packet[i];
+      if ((packet[i] == 0xFD) && (i >= 2) && (packet[i - 1] == 0xFF) && (packet[i - 2] == 0xFF) && (i + 1 < packet_length - 2) && (packet[i + 1] == 0xFD))
+        i++;
+    }
+    processInstruction(fd, packet[4], packet[7], param, (uint16_t)param_length);
+    head += packet_length;
+  }
+  memmove(buffer, buffer + head, length - head);
+  return length - head;
+}
+
+/**
+ * @fn static void stopEmulator(int)
+ * @brief Signal handler
+ */
+static void stopEmulator(int signal)
+{
+  running = 0;
+}
+
+int main(int argc, char **argv)
+{
+  uint8_t buffer[MAX_PACKET_LENGTH * 2];
+  int buffered = 0;
+  int master, slave, opt;
+  const char *link_path = NULL;
+  struct termios tio;
+  struct sigaction action;
+
+  while ((opt = getopt(argc, argv, "l:d:c:s:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'l':
+      config.byte_latency_us = atof(optarg);
+      break;
+    case 'd':
+      config.packet_loss_rate = atof(optarg);
+      break;
+    case 'c':
+      config.corrupt_rate = atof(optarg);
+      break;
+    case 's':
+      link_path = optarg;
+      break;
+    default:
+      printf("usage: %s [-l latency per byte[us]] [-d packet loss rate] [-c packet corruption rate] [-s symlink path]\n", argv[0]);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  // open pseudo terminal
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if ((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0))
+  {
+    printf("Failed to open pseudo terminal : %s\n", strerror(errno));
+    return 1;
+  }
+  // keep the slave side open so that the master does not get EIO while no client is connected
+  slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if (slave >= 0)
+  {
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+  }
+  if (link_path != NULL)
+  {
+    unlink(link_path);
+    if (symlink(ptsname(master), link_path) != 0)
+    {
+      printf("Failed to create symlink %s : %s\n", link_path, strerror(errno));
+      return 1;
+    }
+  }
+  printf("Dynamixel emulator (ID %d - %d) is listening on %s\n", FIRST_ID, FIRST_ID + SERVO_NUM - 1, link_path ? link_path : ptsname(master));
+  printf("Run the program with %s=%s\n", SERIAL_PORT_ENV, link_path ? link_path : ptsname(master));
+  fflush(stdout);
+
+  initCrcTable();
+  initServo();
+  // without SA_RESTART so that blocking read() returns on Ctrl-C
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stopEmulator;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  while (running)
+  {
+    int length = read(master, buffer + buffered, sizeof(buffer) - buffered);
+    if (length < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    buffered = parsePacket(master, buffer, buffered + length);
+    if (buffered == (int)sizeof(buffer))
+      buffered = 0; // discard garbage
+  }
+
+  printf("\nrx packets %lu (crc error %lu), tx packets %lu (dropped %lu, corrupted %lu)\n",
+         stats.rx_packets, stats.rx_crc_errors, stats.tx_packets, stats.tx_dropped, stats.tx_corrupted);
+  if (link_path != NULL)
+    unlink(link_path);
+  close(slave);
+  close(master);
+  return 0;
+}
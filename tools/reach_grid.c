@@ -0,0 +1,182 @@
+/**
+ * @file reach_grid.c
+ * @brief Build the reachability grid of CRANE-X7 (cached in a file) and answer feasibility queries of end effector positions
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../common/reachability.h"
+
+#define DEFAULT_GRID_FILE "crane_x7_reach.grid"
+#define LOOKUP_CALLS (1000000)
+
+/**
+ * @fn static double getTime(void)
+ * @brief Monotonic time [s]
+ */
+static double getTime(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * @fn static void printSummary(const REACH_GRID *, double)
+ * @brief Size of the grid and time to look up a point
+ */
+static void printSummary(const REACH_GRID *grid, double open_time)
+{
+  const REACH_GRID_HEADER *header = grid->header;
+  const size_t cell_num = (size_t)header->size[0] * header->size[1] * header->size[2];
+  double start, lookup_time;
+  unsigned int state = 1;
+  int reachable = 0;
+
+  start = getTime();
+  for (int n = 0; n < LOOKUP_CALLS; n++)
+  {
+    VECTOR_3D p;
+
+    // pseudo random points in the box (linear congruential generator, cheaper than the lookup)
+    state = state * 1664525u + 1013904223u;
+    p.x = header->origin[0] + (state >> 8) * (1.0 / (1 << 24)) * (header->size[0] - 1) * header->resolution;
+    state = state * 1664525u + 1013904223u;
+    p.y = header->origin[1] + (state >> 8) * (1.0 / (1 << 24)) * (header->size[1] - 1) * header->resolution;
+    state = state * 1664525u + 1013904223u;
+    p.z = header->origin[2] + (state >> 8) * (1.0 / (1 << 24)) * (header->size[2] - 1) * header->resolution;
+    const REACH_GRID_CELL *cell = lookupReachGrid(grid, &p);
+    reachable += (cell != NULL) && (cell->manipulability != REACH_GRID_UNREACHABLE);
+  }
+  lookup_time = (getTime() - start) / LOOKUP_CALLS;
+
+  printf("grid : %d x %d x %d points (%.3f [m]), origin (%.3f, %.3f, %.3f) [m]\n", header->size[0], header->size[1], header->size[2],
+         header->resolution, header->origin[0], header->origin[1], header->origin[2]);
+  printf("  reachable %" PRIu64 " / %zu points, %zu [byte], link parameter hash %016" PRIx64 "\n", header->reachable_num, cell_num,
+         grid->data_size, header->param_hash);
+  printf("  %s in %.3f [ms], lookup %.1f [ns/point] (%d of %d random points reachable)\n", grid->mapped ? "mapped" : "built",
+         open_time * 1e3, lookup_time * 1e9, reachable, LOOKUP_CALLS);
+}
+
+/**
+ * @fn static void answerQueries(const REACH_GRID *)
+ * @brief Read "x y z" lines from stdin and print reachability, manipulability and joint angles refined from the seed of the grid
+ */
+static void answerQueries(const REACH_GRID *grid)
+{
+  KINEMATICS_CACHE cache;
+  IK_CONFIG ik_config;
+  VECTOR_3D p;
+  int points = 0, reachable = 0, iterations = 0;
+
+  initKinematicsCache(&cache);
+  getDefaultIkConfig(&ik_config);
+  while (scanf("%lf %lf %lf", &p.x, &p.y, &p.z) == 3)
+  {
+    const REACH_GRID_CELL *cell = lookupReachGrid(grid, &p);
+    double seed[JOINT_NUM] = {0}, theta[JOINT_NUM];
+    IK_RESULT result;
+
+    points++;
+    if (getReachGridSeed(grid, &p, seed) || inverseKinematics7Dof(&cache, &p, NULL, seed, theta, &ik_config, &result))
+    {
+      // the nearest grid point is unreachable, or the point lies just outside of the boundary
+      printf("%.4f %.4f %.4f 0\n", p.x, p.y, p.z);
+      continue;
+    }
+    reachable++;
+    iterations += result.iterations;
+    printf("%.4f %.4f %.4f 1 %.5f", p.x, p.y, p.z, cell->manipulability);
+    for (int i = 0; i < KINEMATICS_DOF; i++)
+    {
+      printf(" %.4f", theta[i]);
+    }
+    printf("\n");
+  }
+  printf("# %d / %d points reachable, %.2f iterations of inverse kinematics from the grid seed on average\n", reachable, points,
+         reachable ? (double)iterations / reachable : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+  const char *filename = DEFAULT_GRID_FILE;
+  int threads = getThreadPoolDefaultSize(), rebuild = 0, query = 0, opt;
+  REACH_GRID_CONFIG config;
+  REACH_GRID grid;
+  THREAD_POOL pool;
+  double start;
+
+  getDefaultReachGridConfig(&config);
+  while ((opt = getopt(argc, argv, "f:r:j:bqh")) != -1)
+  {
+    switch (opt)
+    {
+    case 'f':
+      filename = optarg;
+      break;
+    case 'r':
+      config.resolution = atof(optarg);
+      break;
+    case 'j':
+      threads = atoi(optarg);
+      break;
+    case 'b':
+      rebuild = 1;
+      break;
+    case 'q':
+      query = 1;
+      break;
+    default:
+      printf("usage: %s [-f grid file] [-r resolution[m]] [-j threads] [-b (rebuild)] [-q (query points \"x y z\" from stdin)]\n", argv[0]);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+  if (initThreadPool(&pool, threads))
+  {
+    return 1;
+  }
+
+  start = getTime();
+  if (rebuild)
+  {
+    if (buildReachGrid(&grid, &config, &pool) || saveReachGrid(&grid, filename))
+    {
+      closeThreadPool(&pool);
+      return 1;
+    }
+  }
+  else if (openReachGrid(&grid, filename, &config, &pool))
+  {
+    closeThreadPool(&pool);
+    return 1;
+  }
+  printSummary(&grid, getTime() - start);
+  if (query)
+  {
+    answerQueries(&grid);
+  }
+  closeReachGrid(&grid);
+  closeThreadPool(&pool);
+  return 0;
+}
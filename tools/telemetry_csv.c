@@ -0,0 +1,142 @@
+/**
+ * @file telemetry_csv.c
+ * @brief Convert a telemetry file of telemetry.c to CSV and summarize the timing of the recorded cycles
+ * @author RT Corporation
+ * @date 2019-2020
+ * @copyright License: Apache License, Version 2.0
+ */
+// Copyright 2020 RT Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//// Header files ////
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../common/telemetry.h"
+
+/**
+ * @fn static void printColumns(FILE *, const char *)
+ * @brief Column names of a joint array (e.g. angle1, ..., angle8)
+ */
+static void printColumns(FILE *out, const char *name)
+{
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    fprintf(out, ",%s%d", name, i + 1);
+  }
+}
+
+/**
+ * @fn static void printValues(FILE *, const double *)
+ * @brief Values of a joint array
+ */
+static void printValues(FILE *out, const double *value)
+{
+  for (int i = 0; i < JOINT_NUM; i++)
+  {
+    fprintf(out, ",%.9g", value[i]);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *output = NULL;
+  FILE *in, *out = stdout;
+  TELEMETRY_HEADER header;
+  TELEMETRY_RECORD record;
+  uint64_t records = 0, skipped_cycles = 0, previous_cycle = 0;
+  double previous_time = 0, max_interval = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "o:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'o':
+      output = optarg;
+      break;
+    default:
+      printf("usage: %s [-o csv file] telemetry file\n", argv[0]);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+  if (optind >= argc)
+  {
+    printf("usage: %s [-o csv file] telemetry file\n", argv[0]);
+    return 1;
+  }
+
+  in = fopen(argv[optind], "rb");
+  if (in == NULL)
+  {
+    fprintf(stderr, "Failed to open %s\n", argv[optind]);
+    return 1;
+  }
+  if ((fread(&header, sizeof(header), 1, in) != 1) || (memcmp(header.magic, TELEMETRY_MAGIC, sizeof(header.magic)) != 0) ||
+      (header.version != TELEMETRY_VERSION) || (header.record_size != sizeof(TELEMETRY_RECORD)) || (header.joint_num != JOINT_NUM))
+  {
+    fprintf(stderr, "%s is not a telemetry file of this version\n", argv[optind]);
+    fclose(in);
+    return 1;
+  }
+  if (output != NULL)
+  {
+    out = fopen(output, "w");
+    if (out == NULL)
+    {
+      fprintf(stderr, "Failed to open %s\n", output);
+      fclose(in);
+      return 1;
+    }
+  }
+
+  fprintf(out, "cycle,time");
+  printColumns(out, "command");
+  printColumns(out, "angle");
+  printColumns(out, "angvel");
+  printColumns(out, "torque");
+  fprintf(out, "\n");
+  // the records written before a crash are also converted (the header is completed only by closeTelemetry)
+  while (fread(&record, sizeof(record), 1, in) == 1)
+  {
+    if (records > 0)
+    {
+      if (record.cycle > previous_cycle + 1)
+        skipped_cycles += record.cycle - previous_cycle - 1;
+      if (record.time - previous_time > max_interval)
+        max_interval = record.time - previous_time;
+    }
+    fprintf(out, "%" PRIu64 ",%.6f", record.cycle, record.time);
+    printValues(out, record.command);
+    printValues(out, record.angle);
+    printValues(out, record.angvel);
+    printValues(out, record.torque);
+    fprintf(out, "\n");
+    previous_cycle = record.cycle;
+    previous_time = record.time;
+    records++;
+  }
+  fclose(in);
+  if ((out != stdout) && (fclose(out) != 0))
+  {
+    fprintf(stderr, "Failed to write %s\n", output);
+    return 1;
+  }
+
+  fprintf(stderr, "%" PRIu64 " records (header: %" PRIu64 " records, %" PRIu64 " dropped), %" PRIu64 " cycles not recorded, max interval %.3f [ms]\n",
+          records, header.records, header.dropped,
+          skipped_cycles, max_interval * 1e3);
+  return 0;
+}